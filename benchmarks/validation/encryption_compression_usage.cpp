@@ -10,9 +10,15 @@
 #include <iomanip>
 #include <filesystem>
 
+const char *cipherSuiteName(CipherSuite suite)
+{
+    return suite == CipherSuite::ChaCha20Poly1305 ? "chacha20-poly1305" : "aes-256-gcm";
+}
+
 struct BenchmarkResult
 {
     bool useEncryption;
+    CipherSuite cipherSuite;
     int compressionLevel;
     double executionTime;
     size_t totalEntries;
@@ -25,20 +31,22 @@ struct BenchmarkResult
     LatencyStats latencyStats;
 };
 
-BenchmarkResult runBenchmark(const LoggingConfig &baseConfig, bool useEncryption, int compressionLevel,
+BenchmarkResult runBenchmark(const LoggingConfig &baseConfig, bool useEncryption, CipherSuite cipherSuite,
+                             int compressionLevel,
                              const std::vector<BatchWithDestination> &batches,
                              int numProducerThreads, int entriesPerProducer)
 {
     LoggingConfig config = baseConfig;
     config.basePath = "./encryption_compression_usage";
     config.useEncryption = useEncryption;
+    config.cipherSuite = cipherSuite;
     config.compressionLevel = compressionLevel;
 
     cleanupLogDirectory(config.basePath);
 
     size_t totalDataSizeBytes = calculateTotalDataSize(batches, numProducerThreads);
     double totalDataSizeGiB = static_cast<double>(totalDataSizeBytes) / (1024 * 1024 * 1024);
-    std::cout << "Benchmark with Encryption: " << (useEncryption ? "Enabled" : "Disabled")
+    std::cout << "Benchmark with Encryption: " << (useEncryption ? cipherSuiteName(cipherSuite) : "Disabled")
               << ", Compression: " << (compressionLevel != 0 ? "Enabled" : "Disabled")
               << " - Total data to be written: " << totalDataSizeBytes
               << " bytes (" << totalDataSizeGiB << " GiB)" << std::endl;
@@ -86,6 +94,7 @@ BenchmarkResult runBenchmark(const LoggingConfig &baseConfig, bool useEncryption
 
     return BenchmarkResult{
         useEncryption,
+        cipherSuite,
         compressionLevel,
         elapsedSeconds,
         totalEntries,
@@ -101,7 +110,7 @@ BenchmarkResult runBenchmark(const LoggingConfig &baseConfig, bool useEncryption
 // Write CSV header
 void writeCSVHeader(std::ofstream &csvFile)
 {
-    csvFile << "encryption_enabled,compression_level,execution_time_seconds,total_entries,"
+    csvFile << "encryption_enabled,cipher_suite,compression_level,execution_time_seconds,total_entries,"
             << "throughput_entries_per_sec,total_data_size_bytes,final_storage_size_bytes,logical_throughput_gib_per_sec,"
             << "physical_throughput_gib_per_sec,write_amplification,avg_latency_ms,median_latency_ms,"
             << "max_latency_ms,latency_count\n";
@@ -111,6 +120,7 @@ void writeCSVHeader(std::ofstream &csvFile)
 void writeCSVRow(std::ofstream &csvFile, const BenchmarkResult &result)
 {
     csvFile << (result.useEncryption ? "true" : "false") << ","
+            << (result.useEncryption ? cipherSuiteName(result.cipherSuite) : "none") << ","
             << result.compressionLevel << ","
             << std::fixed << std::setprecision(6) << result.executionTime << ","
             << result.totalEntries << ","
@@ -128,6 +138,7 @@ void writeCSVRow(std::ofstream &csvFile, const BenchmarkResult &result)
 
 void runEncryptionCompressionBenchmark(const LoggingConfig &baseConfig,
                                        const std::vector<bool> &encryptionSettings,
+                                       const std::vector<CipherSuite> &cipherSuites,
                                        const std::vector<int> &compressionLevels,
                                        const std::vector<BatchWithDestination> &batches,
                                        int numProducers, int entriesPerProducer,
@@ -145,32 +156,41 @@ void runEncryptionCompressionBenchmark(const LoggingConfig &baseConfig,
 
     writeCSVHeader(csvFile);
 
-    int totalCombinations = encryptionSettings.size() * compressionLevels.size();
+    // Unencrypted runs don't depend on the suite, so they run once per level.
+    int totalCombinations = 0;
+    for (bool useEncryption : encryptionSettings)
+        totalCombinations += (useEncryption ? cipherSuites.size() : 1) * compressionLevels.size();
     std::cout << "Running encryption/compression benchmark with " << totalCombinations << " configurations..." << std::endl;
     std::cout << "Results will be saved to: " << csvFilename << std::endl;
 
     int currentTest = 0;
     for (bool useEncryption : encryptionSettings)
     {
-        for (int compressionLevel : compressionLevels)
+        const std::vector<CipherSuite> suites = useEncryption ? cipherSuites
+                                                              : std::vector<CipherSuite>{CipherSuite::Aes256Gcm};
+        for (CipherSuite cipherSuite : suites)
         {
-            currentTest++;
-            std::cout << "\nProgress: " << currentTest << "/" << totalCombinations
-                      << " - Testing Encryption: " << (useEncryption ? "Enabled" : "Disabled")
-                      << ", Compression: " << compressionLevel << "..." << std::endl;
-
-            BenchmarkResult result = runBenchmark(baseConfig, useEncryption, compressionLevel, batches, numProducers, entriesPerProducer);
-            results.push_back(result);
-
-            // Write result to CSV immediately
-            writeCSVRow(csvFile, result);
-            csvFile.flush(); // Ensure data is written in case of early termination
-
-            // Print progress summary
-            std::cout << "  Completed: " << std::fixed << std::setprecision(2)
-                      << result.throughputEntries << " entries/s, "
-                      << std::fixed << std::setprecision(3) << result.logicalThroughputGiB << " GiB/s, "
-                      << "write amp: " << std::fixed << std::setprecision(3) << result.writeAmplification << std::endl;
+            for (int compressionLevel : compressionLevels)
+            {
+                currentTest++;
+                std::cout << "\nProgress: " << currentTest << "/" << totalCombinations
+                          << " - Testing Encryption: " << (useEncryption ? cipherSuiteName(cipherSuite) : "Disabled")
+                          << ", Compression: " << compressionLevel << "..." << std::endl;
+
+                BenchmarkResult result = runBenchmark(baseConfig, useEncryption, cipherSuite, compressionLevel,
+                                                      batches, numProducers, entriesPerProducer);
+                results.push_back(result);
+
+                // Write result to CSV immediately
+                writeCSVRow(csvFile, result);
+                csvFile.flush(); // Ensure data is written in case of early termination
+
+                // Print progress summary
+                std::cout << "  Completed: " << std::fixed << std::setprecision(2)
+                          << result.throughputEntries << " entries/s, "
+                          << std::fixed << std::setprecision(3) << result.logicalThroughputGiB << " GiB/s, "
+                          << "write amp: " << std::fixed << std::setprecision(3) << result.writeAmplification << std::endl;
+            }
         }
     }
 
@@ -179,7 +199,7 @@ void runEncryptionCompressionBenchmark(const LoggingConfig &baseConfig,
 
     // Still print summary table to console for immediate review
     std::cout << "\n============== ENCRYPTION/COMPRESSION LEVEL BENCHMARK SUMMARY ==============" << std::endl;
-    std::cout << std::left << std::setw(12) << "Encryption"
+    std::cout << std::left << std::setw(20) << "Encryption"
               << std::setw(15) << "Comp. Level"
               << std::setw(15) << "Exec. Time (s)"
               << std::setw(20) << "Input Size (bytes)"
@@ -194,7 +214,7 @@ void runEncryptionCompressionBenchmark(const LoggingConfig &baseConfig,
     // Display results for each configuration
     for (const auto &result : results)
     {
-        std::cout << std::left << std::setw(12) << (result.useEncryption ? "True" : "False")
+        std::cout << std::left << std::setw(20) << (result.useEncryption ? cipherSuiteName(result.cipherSuite) : "none")
                   << std::setw(15) << result.compressionLevel
                   << std::fixed << std::setprecision(2) << std::setw(15) << result.executionTime
                   << std::setw(20) << result.totalDataSizeBytes
@@ -231,6 +251,7 @@ int main()
 
     const std::vector<int> compressionLevels = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
     const std::vector<bool> encryptionSettings = {false, true};
+    const std::vector<CipherSuite> cipherSuites = {CipherSuite::Aes256Gcm, CipherSuite::ChaCha20Poly1305};
 
     std::cout << "Generating batches with pre-determined destinations for all threads...";
     std::vector<BatchWithDestination> batches = generateBatches(entriesPerProducer, numSpecificFiles, producerBatchSize, payloadSize);
@@ -238,6 +259,7 @@ int main()
 
     runEncryptionCompressionBenchmark(baseConfig,
                                       encryptionSettings,
+                                      cipherSuites,
                                       compressionLevels,
                                       batches,
                                       numProducers,
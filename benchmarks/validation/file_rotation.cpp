@@ -266,5 +266,19 @@ int main()
         payloadSize,
         "file_rotation_benchmark_results.csv");
 
+    // Same sweep on the io_uring backend, where rotation's fsync+close runs in the
+    // background instead of stalling the rotating writer.
+    LoggingConfig uringConfig = baseConfig;
+    uringConfig.storageBackend = StorageBackend::IoUring;
+    runFileRotationComparison(
+        uringConfig,
+        segmentSizesMB,
+        numProducers,
+        entriesPerProducer,
+        numSpecificFiles,
+        producerBatchSize,
+        payloadSize,
+        "file_rotation_io_uring_benchmark_results.csv");
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,199 @@
+#include "BenchmarkUtils.hpp"
+#include "LoggingManager.hpp"
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <atomic>
+#include <optional>
+#include <iomanip>
+#include <filesystem>
+#include <ctime>
+
+// Enqueue-to-disk latency: a probe thread appends one entry to its own target and
+// polls that target's segment file until the blob lands, while background producers
+// generate load at a fixed rate on the default target.
+
+struct BenchmarkResult
+{
+    LatencyStats latencyStats;
+    double p99Ms;
+    double cpuSeconds;
+};
+
+const char *strategyName(WriterIdleStrategy strategy)
+{
+    switch (strategy)
+    {
+    case WriterIdleStrategy::BusySpin:
+        return "busy_spin";
+    case WriterIdleStrategy::SpinYield:
+        return "spin_yield";
+    case WriterIdleStrategy::Park:
+        return "park";
+    }
+    return "unknown";
+}
+
+std::optional<std::filesystem::path> findSegment(const std::string &dir, const std::string &target)
+{
+    for (const auto &entry : std::filesystem::directory_iterator(dir))
+    {
+        if (entry.is_regular_file() && entry.path().filename().string().rfind(target + "_", 0) == 0)
+        {
+            return entry.path();
+        }
+    }
+    return std::nullopt;
+}
+
+size_t segmentSize(const std::string &dir, const std::string &target)
+{
+    std::error_code ec;
+    auto path = findSegment(dir, target);
+    if (!path)
+        return 0;
+    auto size = std::filesystem::file_size(*path, ec);
+    return ec ? 0 : static_cast<size_t>(size);
+}
+
+double processCpuSeconds()
+{
+    return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+}
+
+BenchmarkResult runIdleStrategyBenchmark(const LoggingConfig &baseConfig,
+                                         WriterIdleStrategy strategy,
+                                         int backgroundProducers,
+                                         int backgroundEntriesPerSecond,
+                                         int probes,
+                                         std::chrono::milliseconds probeInterval)
+{
+    LoggingConfig config = baseConfig;
+    config.basePath = std::string("./logs/idle_") + strategyName(strategy);
+    config.writerIdleStrategy = strategy;
+    cleanupLogDirectory(config.basePath);
+
+    const std::string probeTarget = "latency_probe";
+
+    LoggingManager loggingManager(config);
+    loggingManager.start();
+    const double cpuBefore = processCpuSeconds();
+
+    std::atomic<bool> stopBackground{false};
+    std::vector<std::thread> background;
+    for (int p = 0; p < backgroundProducers; ++p)
+    {
+        background.emplace_back([&]()
+                                {
+            auto token = loggingManager.createProducerToken();
+            const auto period = std::chrono::nanoseconds(1000000000LL / std::max(1, backgroundEntriesPerSecond));
+            auto next = std::chrono::steady_clock::now();
+            while (!stopBackground.load(std::memory_order_relaxed))
+            {
+                loggingManager.append(LogEntry(LogEntry::ActionType::READ, "user/bg/profile",
+                                               "controller_1", "processor_1", "user_bg"),
+                                      token);
+                next += period;
+                std::this_thread::sleep_until(next);
+            } });
+    }
+
+    LatencyCollector collector;
+    collector.reserve(probes);
+    auto probeToken = loggingManager.createProducerToken();
+
+    for (int i = 0; i < probes; ++i)
+    {
+        const size_t sizeBefore = segmentSize(config.basePath, probeTarget);
+        auto start = std::chrono::steady_clock::now();
+        loggingManager.append(LogEntry(LogEntry::ActionType::UPDATE, "user/probe/profile",
+                                       "controller_1", "processor_1", "user_probe"),
+                              probeToken, probeTarget);
+
+        while (segmentSize(config.basePath, probeTarget) == sizeBefore)
+        {
+            std::this_thread::yield();
+        }
+        collector.addMeasurement(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start));
+
+        std::this_thread::sleep_for(probeInterval);
+    }
+
+    stopBackground.store(true);
+    for (auto &t : background)
+    {
+        t.join();
+    }
+    const double cpuSeconds = processCpuSeconds() - cpuBefore;
+
+    loggingManager.stop();
+    cleanupLogDirectory(config.basePath);
+
+    std::vector<std::chrono::nanoseconds> sorted = collector.getMeasurements();
+    std::sort(sorted.begin(), sorted.end());
+    double p99Ms = sorted.empty() ? 0.0 : static_cast<double>(sorted[(sorted.size() * 99) / 100].count()) / 1e6;
+
+    return BenchmarkResult{calculateLatencyStats(collector), p99Ms, cpuSeconds};
+}
+
+int main()
+{
+    // system parameters
+    LoggingConfig baseConfig;
+    baseConfig.baseFilename = "default";
+    baseConfig.maxSegmentSize = 50 * 1024 * 1024; // 50 MB
+    baseConfig.maxAttempts = 5;
+    baseConfig.baseRetryDelay = std::chrono::milliseconds(1);
+    baseConfig.queueCapacity = 65536;
+    baseConfig.maxExplicitProducers = 16;
+    baseConfig.batchSize = 512;
+    baseConfig.numWriterThreads = 8;
+    baseConfig.appendTimeout = std::chrono::minutes(1);
+    baseConfig.useEncryption = true;
+    baseConfig.compressionLevel = 1;
+    // benchmark parameters
+    const int backgroundProducers = 4;
+    const int probes = 2000;
+    const auto probeInterval = std::chrono::milliseconds(1);
+    const std::vector<int> backgroundRates = {0, 1000, 10000}; // entries/sec per producer
+    const std::vector<WriterIdleStrategy> strategies = {
+        WriterIdleStrategy::BusySpin, WriterIdleStrategy::SpinYield, WriterIdleStrategy::Park};
+
+    std::ofstream csvFile("idle_strategy_benchmark.csv");
+    csvFile << "strategy,background_rate,avg_latency_ms,median_latency_ms,p99_latency_ms,max_latency_ms,cpu_seconds\n";
+
+    std::cout << std::left << std::setw(14) << "Strategy"
+              << std::setw(14) << "BG rate/s"
+              << std::setw(14) << "Avg (ms)"
+              << std::setw(14) << "Median (ms)"
+              << std::setw(14) << "P99 (ms)"
+              << std::setw(14) << "Max (ms)"
+              << std::setw(14) << "CPU (s)" << std::endl;
+
+    for (int rate : backgroundRates)
+    {
+        for (auto strategy : strategies)
+        {
+            BenchmarkResult r = runIdleStrategyBenchmark(baseConfig, strategy, rate > 0 ? backgroundProducers : 0,
+                                                         rate, probes, probeInterval);
+            csvFile << strategyName(strategy) << "," << rate << ","
+                    << std::fixed << std::setprecision(6) << r.latencyStats.avgMs << ","
+                    << r.latencyStats.medianMs << "," << r.p99Ms << "," << r.latencyStats.maxMs << ","
+                    << r.cpuSeconds << "\n";
+            csvFile.flush();
+
+            std::cout << std::left << std::setw(14) << strategyName(strategy)
+                      << std::setw(14) << rate
+                      << std::setw(14) << std::fixed << std::setprecision(3) << r.latencyStats.avgMs
+                      << std::setw(14) << r.latencyStats.medianMs
+                      << std::setw(14) << r.p99Ms
+                      << std::setw(14) << r.latencyStats.maxMs
+                      << std::setw(14) << r.cpuSeconds << std::endl;
+        }
+    }
+
+    return 0;
+}
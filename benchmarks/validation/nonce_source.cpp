@@ -0,0 +1,133 @@
+#include "Crypto.hpp"
+#include "KeyRing.hpp"
+#include "NonceSequence.hpp"
+#include <openssl/rand.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Microbenchmark for the per-blob IV source: RAND_bytes (shared DRBG, locked)
+// versus the NonceSequence counter. Measures the IV call alone and a full small-blob
+// seal, since with small batches IV generation is a visible part of each seal.
+
+struct BenchmarkResult
+{
+    std::string source;
+    std::string operation;
+    int threads;
+    double nsPerOp;
+    double opsPerSec;
+};
+
+// Runs `op` opsPerThread times on each of numThreads threads and reports wall time per op.
+template <typename MakeOp>
+BenchmarkResult run(const std::string &source, const std::string &operation,
+                    int numThreads, size_t opsPerThread, MakeOp makeOp)
+{
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t)
+    {
+        threads.emplace_back([&]()
+                             {
+            auto op = makeOp();
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            for (size_t i = 0; i < opsPerThread; ++i)
+                op(); });
+    }
+    while (ready.load() < numThreads)
+        std::this_thread::yield();
+
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto &thread : threads)
+        thread.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const double totalOps = static_cast<double>(opsPerThread) * numThreads;
+    return BenchmarkResult{source, operation, numThreads,
+                           elapsed.count() * 1e9 / totalOps, totalOps / elapsed.count()};
+}
+
+int main()
+{
+    const size_t opsPerThread = 200000;
+    const size_t blobSize = 256;
+    const std::vector<int> threadCounts = {1, 4, 16, 64, 96};
+    const std::string stateDir = "./nonce_source_benchmark";
+
+    std::filesystem::remove_all(stateDir);
+    std::filesystem::create_directories(stateDir);
+
+    KeyRing ring(KeyRing::DEFAULT_KEY_ID, std::vector<uint8_t>(Crypto::KEY_SIZE, 0x42));
+    auto counter = std::make_shared<NonceSequence>(stateDir + "/nonce.state");
+    const std::vector<uint8_t> plaintext(blobSize, 0xAB);
+    const std::string target = "bench_target";
+
+    std::vector<BenchmarkResult> results;
+    for (int threads : threadCounts)
+    {
+        std::cout << "Running with " << threads << " threads..." << std::endl;
+
+        results.push_back(run("random", "iv", threads, opsPerThread, []()
+                              { return []()
+                                { uint8_t iv[Crypto::GCM_IV_SIZE];
+                                  RAND_bytes(iv, sizeof(iv)); }; }));
+        results.push_back(run("counter", "iv", threads, opsPerThread, [&]()
+                              { return [&]()
+                                { uint8_t iv[Crypto::GCM_IV_SIZE];
+                                  counter->next(iv); }; }));
+
+        for (bool useCounter : {false, true})
+        {
+            results.push_back(run(useCounter ? "counter" : "random", "seal_" + std::to_string(blobSize) + "B",
+                                  threads, opsPerThread / 4, [&]()
+                                  {
+                auto crypto = std::make_shared<Crypto>();
+                if (useCounter)
+                    crypto->setNonceSource(counter);
+                auto out = std::make_shared<std::vector<uint8_t>>();
+                return [&, crypto, out]()
+                { crypto->encrypt(plaintext.data(), plaintext.size(), ring, *out, 0,
+                                  reinterpret_cast<const uint8_t *>(target.data()), target.size()); }; }));
+        }
+    }
+
+    std::ofstream csvFile("nonce_source_benchmark_results.csv");
+    csvFile << "nonce_source,operation,threads,ns_per_op,ops_per_sec\n";
+    for (const auto &r : results)
+    {
+        csvFile << r.source << "," << r.operation << "," << r.threads << ","
+                << std::fixed << std::setprecision(2) << r.nsPerOp << "," << r.opsPerSec << "\n";
+    }
+
+    std::cout << "\n============== NONCE SOURCE BENCHMARK SUMMARY ==============" << std::endl;
+    std::cout << std::left << std::setw(10) << "Source"
+              << std::setw(14) << "Operation"
+              << std::setw(10) << "Threads"
+              << std::setw(14) << "ns/op"
+              << std::setw(16) << "ops/s" << std::endl;
+    std::cout << "------------------------------------------------------------" << std::endl;
+    for (const auto &r : results)
+    {
+        std::cout << std::left << std::setw(10) << r.source
+                  << std::setw(14) << r.operation
+                  << std::setw(10) << r.threads
+                  << std::fixed << std::setprecision(1) << std::setw(14) << r.nsPerOp
+                  << std::setprecision(0) << std::setw(16) << r.opsPerSec << std::endl;
+    }
+    std::cout << "============================================================" << std::endl;
+
+    std::filesystem::remove_all(stateDir);
+    return 0;
+}
@@ -1,5 +1,6 @@
 #include "BenchmarkUtils.hpp"
 #include "LoggingManager.hpp"
+#include "CpuAffinity.hpp"
 #include <iostream>
 #include <fstream>
 #include <thread>
@@ -235,14 +236,32 @@ int main()
 
     std::vector<int> writerThreadCounts = {1, 2, 4, 8, 12, 16, 20, 24, 28, 32, 40, 48, 56, 64};
 
-    runScalabilityBenchmark(baseConfig,
-                            writerThreadCounts,
-                            baseProducerThreads,
-                            baseEntriesPerProducer,
-                            numSpecificFiles,
-                            producerBatchSize,
-                            payloadSize,
-                            "scaling_concurrency_benchmark_results.csv");
+    std::cout << "Detected NUMA nodes: " << cpu_affinity::nodes().size() << std::endl;
+
+    // Same sweep once per writer layout, so placement effects show up as separate curves.
+    const std::vector<std::pair<WriterPlacement, std::string>> layouts = {
+        {WriterPlacement::Unpinned, "unpinned"},
+        {WriterPlacement::SpreadNodes, "spread"},
+        {WriterPlacement::CompactNodes, "compact"}};
+
+    for (const auto &[placement, name] : layouts)
+    {
+        LoggingConfig config = baseConfig;
+        config.writerPlacement = placement;
+        // Shards exist (and can be bound) only with target-affine dispatch; every
+        // layout uses it so the curves differ in placement alone.
+        config.targetAffineDispatch = true;
+        config.bindQueueShardsToNodes = placement != WriterPlacement::Unpinned;
+        std::cout << "\n=== Writer placement: " << name << " ===" << std::endl;
+        runScalabilityBenchmark(config,
+                                writerThreadCounts,
+                                baseProducerThreads,
+                                baseEntriesPerProducer,
+                                numSpecificFiles,
+                                producerBatchSize,
+                                payloadSize,
+                                "scaling_concurrency_" + name + "_benchmark_results.csv");
+    }
 
     return 0;
 }
\ No newline at end of file
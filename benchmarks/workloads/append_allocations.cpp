@@ -0,0 +1,145 @@
+#include "BenchmarkUtils.hpp"
+#include "InternedString.hpp"
+#include "LoggingManager.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Heap allocations made by the calling thread. Counted in the global operator
+// new, so the producer's figures leave out whatever the writers allocate.
+static thread_local size_t t_allocations = 0;
+static thread_local size_t t_allocatedBytes = 0;
+
+void *operator new(size_t size)
+{
+    ++t_allocations;
+    t_allocatedBytes += size;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+struct Result
+{
+    const char *method;
+    const char *target;
+    double allocationsPerAppend;
+    double bytesPerAppend;
+    double entriesPerSecond;
+};
+
+int main()
+{
+    LoggingConfig config;
+    config.basePath = "./logs";
+    config.baseFilename = "default";
+    config.queueCapacity = 20000;
+    config.batchSize = 1000;
+    config.numWriterThreads = 4;
+    config.appendTimeout = std::chrono::minutes(2);
+    config.useEncryption = true;
+    config.compressionLevel = 4;
+
+    constexpr int warmupEntries = 100000;
+    constexpr int measuredEntries = 500000;
+    constexpr size_t payloadSize = 1024;
+    constexpr int distinctIds = 16;
+    const std::optional<std::string> namedTarget = "accounts";
+
+    cleanupLogDirectory(config.basePath);
+
+    std::vector<std::string> controllers, processors;
+    std::vector<InternedString> internedControllers, internedProcessors;
+    for (int i = 0; i < distinctIds; ++i)
+    {
+        controllers.push_back("controller_" + std::to_string(i) + "_european_operations");
+        processors.push_back("processor_" + std::to_string(i) + "_analytics_pipeline");
+        internedControllers.emplace_back(controllers.back());
+        internedProcessors.emplace_back(processors.back());
+    }
+    std::vector<std::string> locations;
+    for (int i = 0; i < 256; ++i)
+        locations.push_back("/data/customers/region_" + std::to_string(i % 8) + "/record_" + std::to_string(i));
+    const std::vector<uint8_t> payload(payloadSize, 0x5A);
+    const std::string subject = "subject_0042";
+
+    LoggingManager loggingManager(config);
+    loggingManager.start();
+    auto token = loggingManager.createProducerToken();
+
+    // What a caller holding std::strings and a payload vector does today.
+    auto appendStrings = [&](int i, const std::optional<std::string> &target)
+    {
+        loggingManager.append(LogEntry(LogEntry::ActionType::READ, locations[i % locations.size()],
+                                       controllers[i % distinctIds], processors[i % distinctIds], subject,
+                                       payload),
+                              token, target);
+    };
+    // Interned IDs and pooled buffers.
+    auto appendPooled = [&](int i, const std::optional<std::string> &target)
+    {
+        loggingManager.append(LogEntry::make(LogEntry::ActionType::READ, locations[i % locations.size()],
+                                             internedControllers[i % distinctIds],
+                                             internedProcessors[i % distinctIds], subject,
+                                             payload.data(), payload.size()),
+                              token, target);
+    };
+
+    std::vector<Result> results;
+    auto run = [&](const char *method, const std::optional<std::string> &target, auto appendOne)
+    {
+        for (int i = 0; i < warmupEntries; ++i)
+            appendOne(i, target);
+
+        const size_t allocationsBefore = t_allocations;
+        const size_t bytesBefore = t_allocatedBytes;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < measuredEntries; ++i)
+            appendOne(i, target);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        results.push_back({method, target ? target->c_str() : "<default>",
+                           static_cast<double>(t_allocations - allocationsBefore) / measuredEntries,
+                           static_cast<double>(t_allocatedBytes - bytesBefore) / measuredEntries,
+                           measuredEntries / elapsed.count()});
+    };
+
+    run("std::string", std::nullopt, appendStrings);
+    run("make+interned", std::nullopt, appendPooled);
+    run("std::string", namedTarget, appendStrings);
+    run("make+interned", namedTarget, appendPooled);
+
+    loggingManager.stop();
+
+    std::cout << "\n============== Producer Allocations Per Append ==============\n";
+    std::cout << std::left << std::setw(16) << "Method"
+              << std::setw(12) << "Target"
+              << std::right << std::setw(14) << "Allocs/append"
+              << std::setw(14) << "Bytes/append"
+              << std::setw(16) << "Entries/s" << "\n";
+    std::cout << std::string(72, '-') << "\n";
+    for (const auto &result : results)
+    {
+        std::cout << std::left << std::setw(16) << result.method
+                  << std::setw(12) << result.target
+                  << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(14) << result.allocationsPerAppend
+                  << std::setprecision(1)
+                  << std::setw(14) << result.bytesPerAppend
+                  << std::setprecision(0)
+                  << std::setw(16) << result.entriesPerSecond << "\n";
+    }
+    std::cout << "=============================================================\n";
+
+    cleanupLogDirectory(config.basePath);
+    return 0;
+}
@@ -1,62 +1,216 @@
 #include "BenchmarkUtils.hpp"
+#include "Codec.hpp"
 #include "Compression.hpp"
+#include "CompressionDictionary.hpp"
 #include "LogEntry.hpp"
 #include <chrono>
 #include <cstdint>
 #include <iomanip>
 #include <iostream>
 #include <random>
+#include <utility>
 #include <vector>
 
 struct Result
 {
+    const char *codec;
     int level;
     size_t uncompressedSize;
     size_t compressedSize;
     double compressionRatio;
-    long long durationMs;
+    double compressMBps;
+    double decompressMBps;
 };
 
+static double mbPerSecond(size_t bytes, int iterations, std::chrono::high_resolution_clock::duration elapsed)
+{
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    return seconds > 0 ? (static_cast<double>(bytes) * iterations) / (1024.0 * 1024.0) / seconds : 0.0;
+}
+
 int main()
 {
     constexpr size_t batchSize = 1000;
-    const std::vector<int> compressionLevels = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    constexpr int iterations = 20;
+    const std::vector<std::pair<CompressionCodec, std::vector<int>>> codecLevels = {
+        {CompressionCodec::Zlib, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9}},
+        {CompressionCodec::Zstd, {1, 3, 6, 9, 12, 15, 19}},
+        {CompressionCodec::Lz4, {1, 3, 6, 9, 12}},
+    };
     std::vector<Result> results;
 
-    for (int level : compressionLevels)
+    // Generate one batch with batchSize entries, no specific destinations; every
+    // codec and level sees the same bytes.
+    std::vector<BatchWithDestination> batches = generateBatches(batchSize, 0, batchSize, 4096);
+    std::vector<uint8_t> serializedEntries = LogEntry::serializeBatch(std::move(batches[0].first));
+    const size_t uncompressedSize = serializedEntries.size();
+
+    Compression compression;
+    std::vector<uint8_t> compressed;
+    std::vector<uint8_t> decompressed;
+    for (const auto &[codec, levels] : codecLevels)
     {
-        // Generate one batch with batchSize entries, no specific destinations
-        std::vector<BatchWithDestination> batches = generateBatches(batchSize, 0, batchSize, 4096);
-        std::vector<LogEntry> entries = std::move(batches[0].first);
+        const char *name = codec == CompressionCodec::Zstd  ? "zstd"
+                           : codec == CompressionCodec::Lz4 ? "lz4"
+                                                            : "zlib";
+        if (!Codec::compiledIn(codec))
+        {
+            std::cout << name << " support was not compiled in, skipping\n";
+            continue;
+        }
 
-        // Serialize the entries
-        std::vector<uint8_t> serializedEntries = LogEntry::serializeBatch(std::move(entries));
-        size_t uncompressedSize = serializedEntries.size();
+        for (int level : levels)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < iterations; ++i)
+            {
+                compressed.clear();
+                compression.compress(serializedEntries.data(), serializedEntries.size(), compressed, level, codec);
+            }
+            auto compressTime = std::chrono::high_resolution_clock::now() - start;
 
-        // Measure compression time
-        auto start = std::chrono::high_resolution_clock::now();
-        std::vector<uint8_t> compressed = Compression{}.compress(std::move(serializedEntries), level);
-        auto end = std::chrono::high_resolution_clock::now();
+            start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < iterations; ++i)
+            {
+                decompressed = compression.decompress(std::vector<uint8_t>(compressed));
+            }
+            auto decompressTime = std::chrono::high_resolution_clock::now() - start;
 
-        size_t compressedSize = compressed.size();
-        double compressionRatio = static_cast<double>(uncompressedSize) / compressedSize;
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+            if (decompressed != serializedEntries)
+            {
+                std::cerr << name << " level " << level << ": round trip mismatch\n";
+                return 1;
+            }
 
-        results.push_back({level, uncompressedSize, compressedSize, compressionRatio, duration});
+            size_t compressedSize = compressed.size();
+            results.push_back({name, level, uncompressedSize, compressedSize,
+                               static_cast<double>(uncompressedSize) / compressedSize,
+                               mbPerSecond(uncompressedSize, iterations, compressTime),
+                               mbPerSecond(uncompressedSize, iterations, decompressTime)});
+        }
     }
 
     // Print results
     std::cout << std::fixed << std::setprecision(2);
-    std::cout << "Level | Uncompressed (B) | Compressed (B) | Ratio | Time (ms)\n";
-    std::cout << "------|------------------|----------------|-------|----------\n";
+    std::cout << "Codec | Level | Uncompressed (B) | Compressed (B) | Ratio | Compress (MB/s) | Decompress (MB/s)\n";
+    std::cout << "------|-------|------------------|----------------|-------|-----------------|------------------\n";
     for (const auto &r : results)
     {
-        std::cout << std::setw(5) << r.level << " | "
+        std::cout << std::setw(5) << r.codec << " | "
+                  << std::setw(5) << r.level << " | "
                   << std::setw(16) << r.uncompressedSize << " | "
                   << std::setw(14) << r.compressedSize << " | "
                   << std::setw(5) << r.compressionRatio << " | "
-                  << std::setw(9) << r.durationMs << "\n";
+                  << std::setw(15) << r.compressMBps << " | "
+                  << std::setw(17) << r.decompressMBps << "\n";
+    }
+
+    // Batch encodings: the same entries in each layout. Throughput is per byte of
+    // the row encoding, so every column measures the same work.
+    std::cout << "\nBatch encoding (same " << batchSize << " entries)\n";
+    {
+        std::vector<LogEntry> entries = generateBatches(batchSize, 0, batchSize, 4096)[0].first;
+        const std::vector<uint8_t> rows = LogEntry::serializeBatch(std::vector<LogEntry>(entries));
+        const std::vector<uint8_t> compact =
+            LogEntry::serializeBatch(std::vector<LogEntry>(entries), BatchEncoding::Compact);
+        const std::vector<uint8_t> columnar = LogEntry::serializeBatch(std::move(entries), BatchEncoding::Columnar);
+        for (const auto *encoded : {&compact, &columnar})
+        {
+            if (LogEntry::serializeBatch(LogEntry::deserializeBatch(std::vector<uint8_t>(*encoded))) != rows)
+            {
+                std::cerr << "batch encoding round trip mismatch\n";
+                return 1;
+            }
+        }
+        std::cout << "Uncompressed: Rows " << rows.size() << " B, Compact " << compact.size()
+                  << " B, Columnar " << columnar.size() << " B\n";
+        std::cout << "Codec | Level | Rows (B) | Compact (B) | Columnar (B) | Rows ratio | Compact ratio | Columnar ratio | Rows (MB/s) | Compact (MB/s) | Columnar (MB/s)\n";
+        std::cout << "------|-------|----------|-------------|--------------|------------|---------------|----------------|-------------|----------------|----------------\n";
+
+        for (const auto &[codec, level] : {std::pair<CompressionCodec, int>{CompressionCodec::Zlib, 1},
+                                           std::pair<CompressionCodec, int>{CompressionCodec::Zlib, 6},
+                                           std::pair<CompressionCodec, int>{CompressionCodec::Zlib, 9},
+                                           std::pair<CompressionCodec, int>{CompressionCodec::Zstd, 3},
+                                           std::pair<CompressionCodec, int>{CompressionCodec::Lz4, 1}})
+        {
+            if (!Codec::compiledIn(codec))
+                continue;
+            size_t sizes[3];
+            double mbps[3];
+            const std::vector<uint8_t> *inputs[3] = {&rows, &compact, &columnar};
+            for (int k = 0; k < 3; ++k)
+            {
+                auto start = std::chrono::high_resolution_clock::now();
+                for (int i = 0; i < iterations; ++i)
+                    compression.compress(inputs[k]->data(), inputs[k]->size(), compressed, level, codec);
+                mbps[k] = mbPerSecond(rows.size(), iterations, std::chrono::high_resolution_clock::now() - start);
+                sizes[k] = compressed.size();
+            }
+            std::cout << std::setw(5) << (codec == CompressionCodec::Zstd  ? "zstd"
+                                          : codec == CompressionCodec::Lz4 ? "lz4"
+                                                                           : "zlib")
+                      << " | " << std::setw(5) << level << " | "
+                      << std::setw(8) << sizes[0] << " | "
+                      << std::setw(11) << sizes[1] << " | "
+                      << std::setw(12) << sizes[2] << " | "
+                      << std::setw(10) << static_cast<double>(rows.size()) / sizes[0] << " | "
+                      << std::setw(13) << static_cast<double>(rows.size()) / sizes[1] << " | "
+                      << std::setw(14) << static_cast<double>(rows.size()) / sizes[2] << " | "
+                      << std::setw(11) << mbps[0] << " | "
+                      << std::setw(14) << mbps[1] << " | "
+                      << std::setw(15) << mbps[2] << "\n";
+        }
+    }
+
+    // Small batches: compressed from scratch they barely shrink; a dictionary trained
+    // on other batches of the same workload supplies the repeated context.
+    constexpr int dictionaryEntries = 4000;
+    std::cout << "\nSmall batches, trained 16 KiB dictionary (average compressed bytes per batch)\n";
+    std::cout << "Codec | Batch | Uncompressed (B) | Plain (B) | Dictionary (B) | Plain ratio | Dictionary ratio\n";
+    std::cout << "------|-------|------------------|-----------|----------------|-------------|-----------------\n";
+    for (int smallBatch : {1, 4, 16, 64})
+    {
+        std::vector<std::vector<uint8_t>> training;
+        std::vector<std::vector<uint8_t>> evaluation;
+        std::vector<BatchWithDestination> smallBatches = generateBatches(dictionaryEntries, 0, smallBatch, 64);
+        for (size_t i = 0; i < smallBatches.size(); ++i)
+        {
+            (i % 2 ? evaluation : training).push_back(LogEntry::serializeBatch(std::move(smallBatches[i].first)));
+        }
+
+        auto registry = std::make_shared<DictionaryRegistry>();
+        const CompressionDictionary *dictionary = registry->find(registry->add(DictionaryRegistry::train(training)));
+        compression.setDictionaries(registry);
+
+        for (const auto &[codec, level] : {std::pair<CompressionCodec, int>{CompressionCodec::Zlib, 6},
+                                           std::pair<CompressionCodec, int>{CompressionCodec::Zstd, 3}})
+        {
+            if (!Codec::compiledIn(codec))
+                continue;
+            size_t rawBytes = 0, plainBytes = 0, dictionaryBytes = 0;
+            for (const auto &batch : evaluation)
+            {
+                rawBytes += batch.size();
+                compression.compress(batch.data(), batch.size(), compressed, level, codec);
+                plainBytes += compressed.size();
+                compression.compress(batch.data(), batch.size(), compressed, level, codec, dictionary);
+                dictionaryBytes += compressed.size();
+                if (compression.decompress(std::vector<uint8_t>(compressed)) != batch)
+                {
+                    std::cerr << "dictionary round trip mismatch\n";
+                    return 1;
+                }
+            }
+            const double n = static_cast<double>(evaluation.size());
+            std::cout << std::setw(5) << (codec == CompressionCodec::Zstd ? "zstd" : "zlib") << " | "
+                      << std::setw(5) << smallBatch << " | "
+                      << std::setw(16) << rawBytes / n << " | "
+                      << std::setw(9) << plainBytes / n << " | "
+                      << std::setw(14) << dictionaryBytes / n << " | "
+                      << std::setw(11) << static_cast<double>(rawBytes) / plainBytes << " | "
+                      << std::setw(16) << static_cast<double>(rawBytes) / dictionaryBytes << "\n";
+        }
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -244,5 +244,27 @@ int main()
                                    payloadSize,
                                    "diverse_filepaths_benchmark_results.csv");
 
+    // Same sweep with each target pinned to one writer's queue shard.
+    LoggingConfig affineConfig = config;
+    affineConfig.targetAffineDispatch = true;
+    runFilepathDiversityComparison(affineConfig,
+                                   numFilesVariants,
+                                   numProducers,
+                                   entriesPerProducer,
+                                   producerBatchSize,
+                                   payloadSize,
+                                   "diverse_filepaths_affine_benchmark_results.csv");
+
+    // io_uring backend: registered files and background close on LRU eviction.
+    LoggingConfig uringConfig = config;
+    uringConfig.storageBackend = StorageBackend::IoUring;
+    runFilepathDiversityComparison(uringConfig,
+                                   numFilesVariants,
+                                   numProducers,
+                                   entriesPerProducer,
+                                   producerBatchSize,
+                                   payloadSize,
+                                   "diverse_filepaths_io_uring_benchmark_results.csv");
+
     return 0;
 }
\ No newline at end of file
@@ -15,9 +15,12 @@ set(VALIDATION_BENCHMARKS
     encryption_compression_usage
     file_rotation
     queue_capacity
+    idle_strategy
+    nonce_source
 )
 
 set(WORKLOAD_BENCHMARKS
+    append_allocations
     compression_ratio
     diverse_filepaths
     large_batches
@@ -6,6 +6,48 @@ message(STATUS "Using OpenSSL version: ${OPENSSL_VERSION}")
 message(STATUS "Using GTest version: ${GTEST_VERSION}")
 message(STATUS "Using ZLIB version: ${ZLIB_VERSION_STRING}")
 
+# io_uring storage backend: raw syscalls against the kernel UAPI header, no liburing.
+option(ENABLE_IO_URING "Build the io_uring storage backend if linux/io_uring.h is available" ON)
+if(ENABLE_IO_URING)
+    include(CheckIncludeFile)
+    check_include_file(linux/io_uring.h HAVE_LINUX_IO_URING_H)
+endif()
+if(HAVE_LINUX_IO_URING_H)
+    message(STATUS "io_uring storage backend: enabled")
+else()
+    message(STATUS "io_uring storage backend: disabled")
+endif()
+
+# zstd compression codec: optional, zlib stays the default and is always built.
+option(ENABLE_ZSTD "Build the zstd compression codec if libzstd is available" ON)
+if(ENABLE_ZSTD)
+    find_path(ZSTD_INCLUDE_DIR zstd.h)
+    find_library(ZSTD_LIBRARY NAMES zstd)
+    if(ZSTD_INCLUDE_DIR AND ZSTD_LIBRARY)
+        set(HAVE_ZSTD ON)
+    endif()
+endif()
+if(HAVE_ZSTD)
+    message(STATUS "zstd compression codec: enabled (${ZSTD_LIBRARY})")
+else()
+    message(STATUS "zstd compression codec: disabled")
+endif()
+
+# LZ4 compression codec (frame format): optional, for targets that favour latency over ratio.
+option(ENABLE_LZ4 "Build the LZ4 compression codec if liblz4 is available" ON)
+if(ENABLE_LZ4)
+    find_path(LZ4_INCLUDE_DIR lz4frame.h)
+    find_library(LZ4_LIBRARY NAMES lz4)
+    if(LZ4_INCLUDE_DIR AND LZ4_LIBRARY)
+        set(HAVE_LZ4 ON)
+    endif()
+endif()
+if(HAVE_LZ4)
+    message(STATUS "LZ4 compression codec: enabled (${LZ4_LIBRARY})")
+else()
+    message(STATUS "LZ4 compression codec: disabled")
+endif()
+
 include_directories(include)
 
 add_subdirectory(external/concurrentqueue EXCLUDE_FROM_ALL)
@@ -1,12 +1,28 @@
 set(LIBRARY_SOURCES
     src/LogEntry.cpp
+    src/LogEntryView.cpp
+    src/InternedString.cpp
+    src/EntryStoragePool.cpp
     src/Logger.cpp
+    src/AppendTicket.cpp
     src/BufferQueue.cpp
     src/Compression.cpp
+    src/ZlibCodec.cpp
+    src/ZstdCodec.cpp
+    src/Lz4Codec.cpp
+    src/CompressionDictionary.cpp
+    src/CompressionController.cpp
     src/Crypto.cpp
     src/SeqnumAllocator.cpp
+    src/CpuAffinity.cpp
+    src/WorkerPool.cpp
+    src/KeyRing.cpp
+    src/NonceSequence.cpp
+    src/MerkleTree.cpp
     src/Writer.cpp
+    src/IoStage.cpp
     src/SegmentedStorage.cpp
+    src/IoUring.cpp
     src/LoggingManager.cpp
     src/LogExporter.cpp
     benchmarks/BenchmarkUtils.cpp
@@ -21,5 +37,21 @@ target_link_libraries(GDPR_Logging_lib
     ZLIB::ZLIB
 )
 
+if(HAVE_LINUX_IO_URING_H)
+    target_compile_definitions(GDPR_Logging_lib PUBLIC GDPR_LOGGING_HAVE_IO_URING)
+endif()
+
+if(HAVE_ZSTD)
+    target_compile_definitions(GDPR_Logging_lib PUBLIC GDPR_LOGGING_HAVE_ZSTD)
+    target_include_directories(GDPR_Logging_lib PRIVATE ${ZSTD_INCLUDE_DIR})
+    target_link_libraries(GDPR_Logging_lib PRIVATE ${ZSTD_LIBRARY})
+endif()
+
+if(HAVE_LZ4)
+    target_compile_definitions(GDPR_Logging_lib PUBLIC GDPR_LOGGING_HAVE_LZ4)
+    target_include_directories(GDPR_Logging_lib PRIVATE ${LZ4_INCLUDE_DIR})
+    target_link_libraries(GDPR_Logging_lib PRIVATE ${LZ4_LIBRARY})
+endif()
+
 target_include_directories(GDPR_Logging_lib PUBLIC ${CMAKE_CURRENT_SOURCE_DIR}/include)
 target_include_directories(GDPR_Logging_lib PUBLIC external/concurrentqueue)
\ No newline at end of file
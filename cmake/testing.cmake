@@ -10,6 +10,7 @@ set(TEST_SOURCES
     tests/unit/test_Writer.cpp
     tests/unit/test_SegmentedStorage.cpp
     tests/unit/test_LoggingManager.cpp
+    tests/unit/test_IoStage.cpp
     # integration tests
     tests/integration/test_CompressionCrypto.cpp
     tests/integration/test_WriterQueue.cpp
@@ -41,6 +42,15 @@ add_test_suite(test_crypto tests/unit/test_Crypto.cpp)
 add_test_suite(test_writer tests/unit/test_Writer.cpp)
 add_test_suite(test_segmented_storage tests/unit/test_SegmentedStorage.cpp)
 add_test_suite(test_logging_manager tests/unit/test_LoggingManager.cpp)
+add_test_suite(test_io_stage tests/unit/test_IoStage.cpp)
+add_test_suite(test_cpu_affinity tests/unit/test_CpuAffinity.cpp)
+add_test_suite(test_worker_pool tests/unit/test_WorkerPool.cpp)
+add_test_suite(test_key_ring tests/unit/test_KeyRing.cpp)
+add_test_suite(test_nonce_sequence tests/unit/test_NonceSequence.cpp)
+add_test_suite(test_merkle_tree tests/unit/test_MerkleTree.cpp)
+add_test_suite(test_compression_dictionary tests/unit/test_CompressionDictionary.cpp)
+add_test_suite(test_compression_controller tests/unit/test_CompressionController.cpp)
+add_test_suite(test_interned_string tests/unit/test_InternedString.cpp)
 # integration tests
 add_test_suite(test_compression_crypto tests/integration/test_CompressionCrypto.cpp)
 add_test_suite(test_writer_queue tests/integration/test_WriterQueue.cpp)
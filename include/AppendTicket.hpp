@@ -0,0 +1,72 @@
+#ifndef APPEND_TICKET_HPP
+#define APPEND_TICKET_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Handle returned by LoggingManager::appendAsync. Resolves once the blob holding
+// the entry (or, for a batch, every entry) has been written to its segment; under
+// DurabilityMode::GroupCommit that write includes the fdatasync.
+class AppendTicket
+{
+public:
+    enum class Status
+    {
+        Pending,
+        Persisted,
+        Failed, // rejected by the queue, or the blob holding it could not be written
+    };
+
+    // Shared between the ticket and every queued item it covers. Completing costs one
+    // atomic store per ticket; the mutex is only touched if someone is blocked in wait().
+    class State
+    {
+    public:
+        explicit State(size_t entries = 1) : m_remaining(entries) {}
+
+        // One covered entry finished; the last one decides the final status.
+        void complete(bool persisted);
+        // Resolve as Failed right away, whatever is still outstanding.
+        void abandon();
+
+        Status status() const { return m_status.load(std::memory_order_acquire); }
+        Status waitFor(std::chrono::milliseconds timeout);
+
+    private:
+        void finish(Status status);
+
+        std::atomic<Status> m_status{Status::Pending};
+        std::atomic<size_t> m_remaining;
+        std::atomic<bool> m_failed{false};
+        std::atomic<size_t> m_waiters{0};
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+    };
+
+    AppendTicket() = default;
+    explicit AppendTicket(std::shared_ptr<State> state) : m_state(std::move(state)) {}
+
+    bool valid() const { return m_state != nullptr; }
+    Status status() const { return m_state ? m_state->status() : Status::Failed; }
+    bool isDone() const { return status() != Status::Pending; }
+
+    // Blocks until the ticket resolves, or returns Pending on timeout.
+    Status wait() const { return waitFor(std::chrono::milliseconds::max()); }
+    Status waitFor(std::chrono::milliseconds timeout) const
+    {
+        return m_state ? m_state->waitFor(timeout) : Status::Failed;
+    }
+
+    // Writer side: resolves the tickets of every entry in one blob, then clears `states`.
+    static void completeAll(std::vector<std::shared_ptr<State>> &states, bool persisted);
+
+private:
+    std::shared_ptr<State> m_state;
+};
+
+#endif
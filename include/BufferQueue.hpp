@@ -4,37 +4,118 @@
 #include "QueueItem.hpp"
 #include "concurrentqueue.h"
 #include <atomic>
+#include <cstdint>
 #include <vector>
 #include <memory>
 #include <condition_variable>
+#include <mutex>
 #include <chrono>
+#include <optional>
+#include <string>
 
+// One or more independent sub-queues ("shards"). With a single shard every
+// consumer drains the same queue; with N shards items are routed by target
+// filename, so all entries for one target land in one shard and a consumer that
+// owns that shard sees them in producer order.
 class BufferQueue
 {
+private:
+    struct Shard
+    {
+        explicit Shard(size_t capacity, size_t maxExplicitProducers)
+            : queue(capacity, maxExplicitProducers, 0) {}
+
+        moodycamel::ConcurrentQueue<QueueItem> queue;
+
+        // Consumer parking. Producers only take parkMutex when parkedConsumers is
+        // non-zero, so the enqueue fast path stays lock-free while writers are busy.
+        std::mutex parkMutex;
+        std::condition_variable parkCv;
+        std::atomic<size_t> parkedConsumers{0};
+        uint64_t wakeEpoch = 0; // guarded by parkMutex
+    };
+
 public:
-    using ProducerToken = moodycamel::ProducerToken;
-    using ConsumerToken = moodycamel::ConsumerToken;
+    // Holds one moodycamel token per shard, created lazily on the first enqueue
+    // into that shard so N producers x M shards doesn't register N*M producers up front.
+    class ProducerToken
+    {
+    public:
+        ProducerToken(ProducerToken &&) = default;
+        ProducerToken &operator=(ProducerToken &&) = default;
+
+    private:
+        friend class BufferQueue;
+        explicit ProducerToken(size_t numShards) : m_tokens(numShards) {}
+        std::vector<std::unique_ptr<moodycamel::ProducerToken>> m_tokens;
+    };
+
+    class ConsumerToken
+    {
+    public:
+        ConsumerToken(ConsumerToken &&) = default;
+        ConsumerToken &operator=(ConsumerToken &&) = default;
+        size_t shard() const { return m_shard; }
+
+    private:
+        friend class BufferQueue;
+        ConsumerToken(size_t shard, moodycamel::ConsumerToken token)
+            : m_shard(shard), m_token(std::move(token)) {}
+        size_t m_shard;
+        moodycamel::ConsumerToken m_token;
+    };
 
 private:
-    moodycamel::ConcurrentQueue<QueueItem> m_queue;
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    size_t m_shardCapacity;
+    std::atomic<bool> m_closed{false};
 
 public:
-    explicit BufferQueue(size_t capacity, size_t maxExplicitProducers);
+    // `capacity` is split evenly across shards. If shardCpus is non-empty, shard i is
+    // constructed on a thread pinned to shardCpus[i % size], so its preallocated
+    // blocks are first-touched on that CPU's NUMA node.
+    explicit BufferQueue(size_t capacity, size_t maxExplicitProducers, size_t numShards = 1,
+                         const std::vector<std::vector<int>> &shardCpus = {});
+
+    ProducerToken createProducerToken() { return ProducerToken(m_shards.size()); }
+    // Consumers only ever dequeue from `shard`.
+    ConsumerToken createConsumerToken(size_t shard = 0);
 
-    ProducerToken createProducerToken() { return ProducerToken(m_queue); }
-    ConsumerToken createConsumerToken() { return ConsumerToken(m_queue); }
+    size_t shardCount() const { return m_shards.size(); }
+    size_t shardFor(const std::optional<std::string> &targetFilename) const;
 
     bool enqueueBlocking(QueueItem item,
                          ProducerToken &token,
                          std::chrono::milliseconds timeout = std::chrono::milliseconds::max());
+    // Items bound for different shards are enqueued shard by shard. A batch with a
+    // share larger than its shard's capacity is rejected up front. `timeout` bounds
+    // the wait for the first share; once it is queued, later shares keep waiting for
+    // room for up to COMMITTED_SHARE_GRACE past `timeout`, or until close(). If one
+    // still does not fit, returns false with the earlier shares queued; `enqueued`
+    // (if given) receives how many items went in, so the caller can fail the rest.
     bool enqueueBatchBlocking(std::vector<QueueItem> items,
                               ProducerToken &token,
-                              std::chrono::milliseconds timeout = std::chrono::milliseconds::max());
+                              std::chrono::milliseconds timeout = std::chrono::milliseconds::max(),
+                              size_t *enqueued = nullptr);
     bool tryDequeue(QueueItem &item, ConsumerToken &token);
     size_t tryDequeueBatch(std::vector<QueueItem> &items, size_t maxItems, ConsumerToken &token);
     bool flush();
     size_t size() const;
 
+    // Blocks until a producer enqueues into the token's shard, wakeConsumers() is
+    // called, or `timeout` elapses. Returns immediately if the shard already looks
+    // non-empty.
+    void waitForItems(ConsumerToken &token, std::chrono::microseconds timeout);
+    // Wakes every parked consumer, e.g. so a stopping Writer notices m_running.
+    void wakeConsumers();
+
+    // Consumers are gone (or going): later shares of a committed batch stop waiting
+    // for room. reopen() undoes it when consumers start again.
+    void close() { m_closed.store(true, std::memory_order_release); }
+    void reopen() { m_closed.store(false, std::memory_order_release); }
+
+    static constexpr std::chrono::milliseconds COMMITTED_SHARE_GRACE{1000};
+
     // delete copy/move
     BufferQueue(const BufferQueue &) = delete;
     BufferQueue &operator=(const BufferQueue &) = delete;
@@ -42,8 +123,11 @@ public:
     BufferQueue &operator=(BufferQueue &&) = delete;
 
 private:
-    bool enqueue(QueueItem item, ProducerToken &token);
-    bool enqueueBatch(std::vector<QueueItem> items, ProducerToken &token);
+    moodycamel::ProducerToken &tokenFor(ProducerToken &token, size_t shard);
+    bool enqueueBulkBlocking(size_t shard, std::vector<QueueItem> &items, ProducerToken &token,
+                             std::chrono::steady_clock::time_point start,
+                             std::chrono::milliseconds timeout);
+    void notifyConsumers(Shard &shard, bool all);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,6 +1,7 @@
 #ifndef BYTE_ORDER_HPP
 #define BYTE_ORDER_HPP
 
+#include <cstddef>
 #include <cstdint>
 
 // Little-endian byte helpers so the on-disk wire format is host-independent.
@@ -57,6 +58,50 @@ inline uint64_t readLE64(const uint8_t *src) noexcept
            (static_cast<uint64_t>(src[6]) << 48) |
            (static_cast<uint64_t>(src[7]) << 56);
 }
+
+// LEB128: seven bits per byte, least significant group first, high bit set on
+// every byte but the last.
+inline constexpr size_t MAX_VARINT_SIZE = 10;
+
+// Returns the number of bytes written (at most MAX_VARINT_SIZE).
+inline size_t writeVarint(uint8_t *dst, uint64_t v) noexcept
+{
+    size_t n = 0;
+    while (v >= 0x80)
+    {
+        dst[n++] = static_cast<uint8_t>(v) | 0x80;
+        v >>= 7;
+    }
+    dst[n++] = static_cast<uint8_t>(v);
+    return n;
+}
+
+// Advances src past the varint. False if it runs past `end` or overflows 64 bits.
+inline bool readVarint(const uint8_t *&src, const uint8_t *end, uint64_t &v) noexcept
+{
+    v = 0;
+    for (unsigned shift = 0; shift < 64 && src < end; shift += 7)
+    {
+        const uint8_t byte = *src++;
+        if (shift == 63 && byte > 1)
+            return false;
+        v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// Maps small negative and positive deltas to small varints.
+inline uint64_t zigzagEncode(int64_t v) noexcept
+{
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+inline int64_t zigzagDecode(uint64_t v) noexcept
+{
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
 } // namespace byteorder
 
 #endif
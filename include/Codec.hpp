@@ -0,0 +1,48 @@
+#ifndef CODEC_HPP
+#define CODEC_HPP
+
+#include "CompressionDictionary.hpp"
+#include "Config.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// One compression algorithm behind Compression. Implementations keep their
+// (de)compression state across calls and are not thread-safe.
+class Codec
+{
+public:
+    using OutputSink = std::function<void(const uint8_t *data, size_t size)>;
+
+    virtual ~Codec() = default;
+
+    // Appends the compressed form of [data, data + size) to `out`, primed with
+    // `dictionary` unless it is null or the codec has no dictionary support.
+    virtual void compress(const uint8_t *data, size_t size, std::vector<uint8_t> &out, int level,
+                          const CompressionDictionary *dictionary) = 0;
+    // False if compress ignores its dictionary; Compression then records none.
+    virtual bool supportsDictionaries() const { return true; }
+
+    // Incremental decompression of one stream, compressed with `dictionary` (null
+    // for none): output reaches `sink` in pieces as input arrives. Throws
+    // std::runtime_error on corrupt input, on more than maxDecompressedSize bytes
+    // of output, or on input past the end of the stream.
+    virtual void beginDecompress(const CompressionDictionary *dictionary) = 0;
+    virtual void decompressChunk(const uint8_t *data, size_t size, const OutputSink &sink,
+                                 size_t maxDecompressedSize) = 0;
+    // Throws unless the stream ended exactly at the last byte fed.
+    virtual void endDecompress() = 0;
+
+    // False if the codec was not compiled into this build.
+    static bool compiledIn(CompressionCodec codec);
+    // Throws std::runtime_error for a codec that is not compiled in.
+    static std::unique_ptr<Codec> create(CompressionCodec codec);
+};
+
+std::unique_ptr<Codec> makeZlibCodec();
+std::unique_ptr<Codec> makeZstdCodec();
+std::unique_ptr<Codec> makeLz4Codec();
+
+#endif
@@ -1,17 +1,28 @@
 #ifndef COMPRESSION_HPP
 #define COMPRESSION_HPP
 
+#include "Codec.hpp"
+#include "Config.hpp"
 #include "LogEntry.hpp"
 #include <vector>
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <zlib.h>
 
-// Holds persistent deflate/inflate z_streams; not thread-safe. One instance per writer thread.
+// Front end over the Codecs; holds one persistent instance of each codec it has
+// used. Not thread-safe. One instance per writer thread.
+//
+// A compressed payload is [u8 CompressionCodec][codec stream], or, compressed with a
+// dictionary, [u8 CompressionCodec | PAYLOAD_FLAG_DICTIONARY][u32 dictionary ID][codec
+// stream]. Payloads from before codec IDs existed are a bare zlib stream, whose first
+// byte (CMF) always has 8 in its low nibble; no codec ID does, so all kinds decompress.
 class Compression
 {
 public:
     // Zip-bomb guard for decompress.
     static constexpr size_t DEFAULT_MAX_DECOMPRESSED_SIZE = 100 * 1024 * 1024;
+    static constexpr uint8_t PAYLOAD_FLAG_DICTIONARY = 0x80;
 
     Compression();
     ~Compression();
@@ -21,20 +32,48 @@ public:
     Compression(Compression &&) = delete;
     Compression &operator=(Compression &&) = delete;
 
-    std::vector<uint8_t> compress(std::vector<uint8_t> &&data, int level = Z_DEFAULT_COMPRESSION);
+    // Throws std::runtime_error if `codec` is not compiled in (see Codec::compiledIn).
+    // A `dictionary` is recorded by ID (and ignored by codecs without dictionary
+    // support); it must stay unchanged while this instance is in use.
+    std::vector<uint8_t> compress(std::vector<uint8_t> &&data, int level = Z_DEFAULT_COMPRESSION,
+                                  CompressionCodec codec = CompressionCodec::Zlib,
+                                  const CompressionDictionary *dictionary = nullptr);
     void compress(const uint8_t *data, size_t size, std::vector<uint8_t> &out,
-                  int level = Z_DEFAULT_COMPRESSION);
+                  int level = Z_DEFAULT_COMPRESSION,
+                  CompressionCodec codec = CompressionCodec::Zlib,
+                  const CompressionDictionary *dictionary = nullptr);
 
+    // Where decompression looks up the dictionary IDs payloads name; a payload
+    // naming one it cannot find throws std::runtime_error.
+    void setDictionaries(std::shared_ptr<const DictionaryRegistry> dictionaries);
+
+    // The codec and dictionary are taken from the payload.
     std::vector<uint8_t> decompress(std::vector<uint8_t> &&compressedData,
                                     size_t maxDecompressedSize = DEFAULT_MAX_DECOMPRESSED_SIZE);
     void decompress(const uint8_t *data, size_t size, std::vector<uint8_t> &out,
                     size_t maxDecompressedSize = DEFAULT_MAX_DECOMPRESSED_SIZE);
 
+    // Incremental decompression for readers that cannot hold the whole input: call
+    // beginDecompress, feed the compressed bytes in any split through
+    // decompressChunk (output reaches `sink` in pieces of at most 32 KiB), then
+    // endDecompress, which throws unless the stream ended exactly there.
+    using OutputSink = Codec::OutputSink;
+    void beginDecompress();
+    void decompressChunk(const uint8_t *data, size_t size, const OutputSink &sink,
+                         size_t maxDecompressedSize = DEFAULT_MAX_DECOMPRESSED_SIZE);
+    void endDecompress();
+
 private:
-    z_stream m_deflateStream{};
-    z_stream m_inflateStream{};
-    int m_deflateLevel = 0; // 0 = uninitialized; otherwise the level bound to m_deflateStream
-    bool m_inflateInitialized = false;
+    Codec &codec(CompressionCodec id);
+
+    std::unique_ptr<Codec> m_zlib;
+    std::unique_ptr<Codec> m_zstd;
+    std::unique_ptr<Codec> m_lz4;
+    std::shared_ptr<const DictionaryRegistry> m_dictionaries;
+    // Streaming: picked by the payload header; null until all of it has arrived.
+    Codec *m_streamCodec = nullptr;
+    uint8_t m_header[1 + sizeof(uint32_t)] = {};
+    size_t m_headerSize = 0;
 };
 
 #endif
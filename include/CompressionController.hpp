@@ -0,0 +1,52 @@
+#ifndef COMPRESSION_CONTROLLER_HPP
+#define COMPRESSION_CONTROLLER_HPP
+
+#include "Config.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Feedback loop between queue pressure and compression cost. Step 0 is the
+// configured codec and level; each further step is cheaper (roughly halving the
+// distance to minLevel, then the policy's pressureCodec, if any). Writers report
+// the queue size and read the current step before compressing a blob.
+//
+// One instance is shared by all writers; observe() and current() are lock-free.
+class CompressionController
+{
+public:
+    struct Setting
+    {
+        CompressionCodec codec;
+        int level;
+    };
+
+    // Throws std::invalid_argument unless 1 <= policy.minLevel <= level, the
+    // watermarks satisfy 0 <= low < high <= 1, and queueCapacity > 0.
+    CompressionController(CompressionCodec codec, int level, const AdaptiveCompressionPolicy &policy,
+                          size_t queueCapacity);
+
+    CompressionController(const CompressionController &) = delete;
+    CompressionController &operator=(const CompressionController &) = delete;
+
+    // One sample of the queue size. Moves at most one step per adjustInterval, so
+    // several writers sampling the same spike step down once, not once each.
+    void observe(size_t queueSize,
+                 std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+    Setting current() const { return m_ladder[m_step.load(std::memory_order_relaxed)]; }
+    size_t step() const { return m_step.load(std::memory_order_relaxed); }
+    const std::vector<Setting> &ladder() const { return m_ladder; }
+
+private:
+    std::vector<Setting> m_ladder;
+    const size_t m_highMark; // queue sizes, from the policy's fractions
+    const size_t m_lowMark;
+    const std::chrono::steady_clock::duration m_adjustInterval;
+    std::atomic<size_t> m_step{0};
+    std::atomic<int64_t> m_lastChange; // steady_clock ticks
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef COMPRESSION_DICTIONARY_HPP
+#define COMPRESSION_DICTIONARY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+class KeyRing;
+
+// Preset content a codec is primed with, so a small batch can refer back to the
+// controller IDs, locations and payload shapes every batch repeats. A compressed
+// payload records `id`; the reader must prime its codec with the same bytes.
+struct CompressionDictionary
+{
+    uint32_t id;
+    std::vector<uint8_t> bytes;
+};
+
+// The dictionaries a log directory's blobs may reference, kept in FILENAME inside
+// the directory so the exporter needs no configuration. With a key ring the file is
+// sealed like a blob (dictionaries are trained on entries and hold their data).
+// IDs are never reused, so adding dictionaries keeps older blobs readable.
+//
+// Populated before the writers start and read-only afterwards.
+class DictionaryRegistry
+{
+public:
+    static constexpr const char *FILENAME = "dictionaries.reg";
+
+    // Builds a dictionary of at most maxSize bytes from sample batches (serialized
+    // LogEntry batches, uncompressed). Uses zstd's trainer when it is compiled in
+    // and accepts the samples; otherwise keeps the most recent sample bytes as raw
+    // content, which zlib's 32 KiB window uses the same way. Throws
+    // std::runtime_error if there is nothing to train on.
+    static std::vector<uint8_t> train(const std::vector<std::vector<uint8_t>> &samples,
+                                      size_t maxSize = 16 * 1024);
+
+    // ID of the dictionary holding exactly `bytes`, adding it under a fresh ID if
+    // there is none. Throws std::invalid_argument for an empty dictionary.
+    uint32_t add(std::vector<uint8_t> bytes);
+    const CompressionDictionary *find(uint32_t id) const;
+    bool empty() const { return m_dictionaries.empty(); }
+
+    // Target classes: targets whose name starts with `prefix` compress with
+    // dictionary `id`. The longest matching prefix wins; "" matches every target.
+    // Not persisted: only the writer side needs them.
+    void assign(std::string prefix, uint32_t id);
+    const CompressionDictionary *forTarget(const std::string &targetName) const;
+
+    // FILENAME under `dir`, opened with `keys` (null: a plaintext file). A missing
+    // file loads as an empty registry. Throws std::runtime_error on a malformed file
+    // and TamperDetectedException if the sealed file fails verification.
+    static std::shared_ptr<DictionaryRegistry> load(const std::string &dir, const KeyRing *keys);
+    // Replaces FILENAME under `dir` atomically; sealed with the active key of `keys`.
+    void save(const std::string &dir, const KeyRing *keys) const;
+
+private:
+    std::vector<std::unique_ptr<CompressionDictionary>> m_dictionaries; // stable addresses
+    std::vector<std::pair<std::string, uint32_t>> m_assignments;
+};
+
+#endif
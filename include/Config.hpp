@@ -3,6 +3,112 @@
 
 #include <string>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+
+// How a Writer waits when tryDequeueBatch comes back empty.
+enum class WriterIdleStrategy
+{
+    BusySpin,  // lowest wakeup latency, burns a core per idle writer
+    SpinYield, // spin briefly, then std::this_thread::yield()
+    Park,      // block on the queue until a producer signals
+};
+
+// When SegmentedStorage makes written blobs durable beyond rotation, eviction,
+// flush() and shutdown (which always fsync).
+enum class DurabilityMode
+{
+    None,        // leave it to the page cache
+    Periodic,    // a background thread fdatasyncs dirty files every syncInterval
+    GroupCommit, // a write returns only once its bytes are fdatasync'ed; writers
+                 // that finish a pwrite together share one sync per file
+};
+
+struct DurabilityPolicy
+{
+    DurabilityMode mode = DurabilityMode::None;
+    std::chrono::milliseconds syncInterval = std::chrono::milliseconds(100); // Periodic only
+};
+
+// How SegmentedStorage talks to the kernel. IoUring needs a build with
+// GDPR_LOGGING_HAVE_IO_URING and a kernel that allows io_uring_setup; if either
+// is missing, storage logs a warning and falls back to Pwrite.
+enum class StorageBackend
+{
+    Pwrite,  // synchronous pwrite/fsync/open per call
+    IoUring, // writes, syncs and opens go through a shared ring with registered files,
+             // but the caller still waits for each one; only retired segments are
+             // fsync'ed and closed in the background
+};
+
+// Where writer threads run. Each writer pins itself before allocating its scratch
+// buffers, zlib and OpenSSL state, so that memory is first-touched node-locally.
+enum class WriterPlacement
+{
+    Unpinned,     // let the scheduler decide
+    CpuList,      // writer i on CPU writerCpuList[i % n]
+    SpreadNodes,  // writer i on any CPU of NUMA node i % nodes (round-robin across sockets)
+    CompactNodes, // one CPU per writer, filling node 0 before node 1, ...
+};
+
+// AEAD used to seal new blobs. Readers take the suite from each blob's header,
+// so a directory may mix suites. The values are written to disk.
+enum class CipherSuite : uint8_t
+{
+    Aes256Gcm = 0,        // fastest with AES-NI / ARMv8 crypto extensions
+    ChaCha20Poly1305 = 1, // constant-time in software; for hosts without AES acceleration
+};
+
+// Where each blob's 96-bit IV comes from (see NonceSequence).
+enum class NonceStrategy
+{
+    Random,  // RAND_bytes per blob
+    Counter, // shared counter whose reserved range is persisted, so no DRBG lock per blob
+};
+
+// Compressor for new blobs. Each compressed payload starts with this ID, so a
+// directory may mix codecs. Zstd and Lz4 need a build with GDPR_LOGGING_HAVE_ZSTD /
+// GDPR_LOGGING_HAVE_LZ4; without it LoggingManager logs a warning and falls back to
+// Zlib. The values are written to disk.
+enum class CompressionCodec : uint8_t
+{
+    Zlib = 1, // deflate, levels 1-9
+    Zstd = 2, // levels 1-22; far cheaper per byte than zlib at a similar ratio
+    Lz4 = 3,  // levels 1-2 fast, 3-12 LZ4-HC; lowest CPU cost, worst ratio
+};
+
+// Layout of the serialized batch that gets compressed and sealed. Readers detect
+// it per batch, so a directory may mix layouts. The values are written to disk.
+enum class BatchEncoding : uint8_t
+{
+    Rows = 0,     // entry after entry, every field length-prefixed (the original format)
+    Columnar = 1, // field by field: dictionary-coded IDs, front-coded locations,
+                  // delta timestamps, payloads last; smaller and faster to compress
+    Compact = 2,  // row format v2: varint lengths, 1-byte action type, timestamps
+                  // relative to the batch; entries still readable in place
+};
+
+// Adaptive compression (see CompressionController): writers sample how full the
+// queue is and step new blobs down a ladder of cheaper settings while it stays at
+// or above highWatermark, and back up once it falls to lowWatermark, at most one
+// step per adjustInterval. The ladder runs from compressionLevel down to minLevel
+// and, with pressureCodec set, ends in that codec at pressureLevel. Each payload
+// records its codec and every level decodes alike, so export is unaffected.
+struct AdaptiveCompressionPolicy
+{
+    bool enabled = false;
+    int minLevel = 1;
+    double highWatermark = 0.75; // queue fill, 0..1
+    double lowWatermark = 0.25;
+    std::chrono::milliseconds adjustInterval = std::chrono::milliseconds(50);
+    std::optional<CompressionCodec> pressureCodec; // e.g. Lz4 for the last resort
+    int pressureLevel = 1;
+};
+
+class KeyRing;
 
 struct LoggingConfig
 {
@@ -11,11 +117,61 @@ struct LoggingConfig
     // queue
     size_t queueCapacity = 8192;
     size_t maxExplicitProducers = 16;
+    // Shard the queue per writer and route each target to one shard, so a target's
+    // entries are batched by a single writer (larger blobs, producer order kept).
+    bool targetAffineDispatch = false;
     // writers
+    // Batch policy: a writer accumulates entries per target and turns them into one
+    // blob once the group holds batchSize entries or maxBatchBytes serialized bytes,
+    // or its oldest entry has waited maxBatchLinger — whichever comes first.
+    // maxBatchBytes = 0 disables the byte bound; maxBatchLinger = 0 flushes every
+    // dequeue immediately. batchSize also caps a single dequeue.
     size_t batchSize = 100;
+    size_t maxBatchBytes = 0;
+    std::chrono::milliseconds maxBatchLinger = std::chrono::milliseconds(0);
     size_t numWriterThreads = 2;
     bool useEncryption = true;
-    int compressionLevel = 9; // 0 disables compression; 1-9 are zlib levels
+    BatchEncoding batchEncoding = BatchEncoding::Compact;
+    int compressionLevel = 9; // 0 disables compression; otherwise a level of compressionCodec
+    CompressionCodec compressionCodec = CompressionCodec::Zlib;
+    // Preset dictionaries for small batches (zlib and zstd; LZ4 compresses without).
+    // Maps a target-name prefix to a dictionary file, e.g. one written from
+    // DictionaryRegistry::train; "" matches every target and the longest prefix wins.
+    // The dictionaries are recorded in the log directory, so export needs no config.
+    std::map<std::string, std::string> compressionDictionaries;
+    AdaptiveCompressionPolicy adaptiveCompression; // ignored if compressionLevel is 0
+    // Chunked AES-GCM: a blob larger than encryptionChunkSize bytes is sealed as
+    // chunks of that size, encrypted (and, on export, decrypted) in parallel on a
+    // pool of cryptoThreads helpers shared by all writers. 0 keeps one tag per blob.
+    size_t encryptionChunkSize = 0;
+    size_t cryptoThreads = 2;
+    // exportLogs scans segments and decodes blobs on this many helper threads, in
+    // addition to the calling one; 0 decodes on the calling thread only.
+    size_t exportThreads = 0;
+    CipherSuite cipherSuite = CipherSuite::Aes256Gcm;
+    NonceStrategy nonceStrategy = NonceStrategy::Random;
+    // Counter only: file holding the reserved counter bound; empty = <basePath>/nonce.state.
+    // Must survive as long as any key in use, or nonces may repeat after a restart.
+    std::string nonceStateFile;
+    // Merkle checkpoints (encryption only): every merkleCheckpointInterval blobs per
+    // target, and once before the seal, a checkpoint batch commits to the Merkle root
+    // over all of the target's blobs so far. 0 disables them.
+    size_t merkleCheckpointInterval = 0;
+    // Keys for sealing (active key) and export (any key a blob names). Null uses
+    // the placeholder key; LoggingManager::rotateKey switches keys online.
+    std::shared_ptr<KeyRing> keyRing;
+    WriterIdleStrategy writerIdleStrategy = WriterIdleStrategy::Park;
+    // pipelined writer: writers only serialize/compress/encrypt and hand blobs to
+    // numIoThreads dedicated I/O threads through a ring of ioRingCapacity slots
+    bool usePipelinedWriter = false;
+    size_t numIoThreads = 2;
+    size_t ioRingCapacity = 1024;
+    // placement (Linux only)
+    WriterPlacement writerPlacement = WriterPlacement::Unpinned;
+    std::string writerCpuList; // cpulist syntax, e.g. "0-3,8"; WriterPlacement::CpuList only
+    // With targetAffineDispatch, build each queue shard on its writer's CPUs so the
+    // shard's memory lands on that writer's node.
+    bool bindQueueShardsToNodes = false;
     // segmented storage
     std::string basePath = "./logs";
     std::string baseFilename = "default";
@@ -23,6 +179,9 @@ struct LoggingConfig
     size_t maxAttempts = 10;
     std::chrono::milliseconds baseRetryDelay = std::chrono::milliseconds(1);
     size_t maxOpenFiles = 512;
+    DurabilityPolicy durability;
+    StorageBackend storageBackend = StorageBackend::Pwrite;
+    unsigned ioUringQueueDepth = 256;
 };
 
 #endif
\ No newline at end of file
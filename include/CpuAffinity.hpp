@@ -0,0 +1,32 @@
+#ifndef CPU_AFFINITY_HPP
+#define CPU_AFFINITY_HPP
+
+#include "Config.hpp"
+#include <string>
+#include <vector>
+
+// CPU/NUMA placement helpers for writer threads and queue shards. Linux only;
+// elsewhere nodes() reports a single node and pinning is a no-op that returns false.
+// There is no libnuma dependency: node-local memory comes from first touch, i.e.
+// a thread pins itself before allocating the state it will use.
+namespace cpu_affinity
+{
+// Parses a Linux cpulist ("0-3,8,10-11"). Throws std::invalid_argument on bad input.
+std::vector<int> parseCpuList(const std::string &list);
+
+// CPUs of each NUMA node that this process may run on. Falls back to a single
+// node holding every allowed CPU when sysfs has no node information.
+std::vector<std::vector<int>> nodes();
+
+// CPU set for each of numWriters writers; an empty set means unpinned.
+std::vector<std::vector<int>> planWriterCpus(WriterPlacement placement,
+                                             const std::string &cpuList,
+                                             size_t numWriters,
+                                             const std::vector<std::vector<int>> &nodeCpus);
+
+// Restricts the calling thread to `cpus`. Returns false if `cpus` is empty or the
+// kernel rejects the mask.
+bool pinCurrentThread(const std::vector<int> &cpus);
+} // namespace cpu_affinity
+
+#endif
@@ -1,13 +1,20 @@
 #ifndef CRYPTO_HPP
 #define CRYPTO_HPP
 
+#include "Config.hpp"
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <functional>
+#include <istream>
 #include <memory>
 #include <stdexcept>
 #include <openssl/evp.h>
 
+class KeyRing;
+class NonceSequence;
+class WorkerPool;
+
 // Distinct from std::runtime_error so callers can react to tag failure specifically.
 class TamperDetectedException : public std::runtime_error
 {
@@ -17,10 +24,6 @@ public:
 
 class Crypto
 {
-private:
-    EVP_CIPHER_CTX *m_encryptCtx;
-    EVP_CIPHER_CTX *m_decryptCtx;
-
 public:
     Crypto();
     ~Crypto();
@@ -30,6 +33,31 @@ public:
     static constexpr size_t GCM_TAG_SIZE = 16;
     static constexpr size_t SEQNUM_SIZE = 8;
 
+    // Set in the blob's u32 length field when the body starts with an extended
+    // header; the low 31 bits still give the body size, so blobSize() works for both.
+    static constexpr uint32_t EXTENDED_BLOB_FLAG = 0x80000000u;
+    // 1: chunk AAD is [index]; 2: [index][last-chunk flag]. Both are readable.
+    static constexpr uint8_t BLOB_FORMAT_VERSION = 2;
+    // Extended header flag: a u32 key ID follows the chunk fields.
+    static constexpr uint8_t BLOB_FLAG_KEY_ID = 0x01;
+    // Extended header flag: a u8 CipherSuite follows (after the key ID, if any).
+    // Without it the blob is AES-256-GCM.
+    static constexpr uint8_t BLOB_FLAG_CIPHER_SUITE = 0x02;
+    // [u8 version][u8 flags][u32 chunkSize][u32 chunkCount], then the flagged fields
+    static constexpr size_t EXTENDED_HEADER_SIZE = 2 * sizeof(uint8_t) + 2 * sizeof(uint32_t);
+    static constexpr size_t MAX_EXTENDED_HEADER_SIZE = EXTENDED_HEADER_SIZE + sizeof(uint32_t) + sizeof(uint8_t);
+
+    // Both suites take a 32-byte key, a 12-byte nonce and produce a 16-byte tag,
+    // so every size constant above applies to either.
+    static const EVP_CIPHER *cipherFor(CipherSuite suite);
+
+    // Total on-disk size of a blob whose first four bytes hold `lengthField`.
+    static size_t blobSize(uint32_t lengthField);
+
+    // Where encrypt takes each blob's IV from: RAND_bytes when null (the default),
+    // otherwise the shared counter. Readers take the IV from the blob either way.
+    void setNonceSource(std::shared_ptr<NonceSequence> nonces) { m_nonces = std::move(nonces); }
+
     // Convenience overloads: seqnum=0 and empty target name (no tamper binding).
     std::vector<uint8_t> encrypt(std::vector<uint8_t> &&plaintext,
                                  const std::vector<uint8_t> &key);
@@ -43,23 +71,107 @@ public:
                  uint64_t seqnum,
                  const uint8_t *targetName, size_t targetNameLen);
 
+    // Chunked variant for large batches: plaintexts longer than chunkSize are split
+    // into chunkSize segments, each sealed with its own nonce (derived from the
+    // blob's random IV) and tag, and encrypted in parallel on `pool` (nullptr =
+    // on the calling thread). Every chunk's AAD carries the blob AAD, the extended
+    // header (so the chunk count), the chunk index and a last-chunk flag, so
+    // dropping, reordering or splicing chunks fails verification. chunkSize = 0 or a short plaintext
+    // produces the single-tag format above.
+    void encrypt(const uint8_t *plaintext, size_t plaintextLen,
+                 const std::vector<uint8_t> &key,
+                 std::vector<uint8_t> &out,
+                 uint64_t seqnum,
+                 const uint8_t *targetName, size_t targetNameLen,
+                 size_t chunkSize, WorkerPool *pool);
+
+    // Seals with the ring's active key through its cached per-thread context. A key
+    // other than KeyRing::DEFAULT_KEY_ID, or a suite other than AES-256-GCM, is
+    // recorded in an extended header.
+    void encrypt(const uint8_t *plaintext, size_t plaintextLen,
+                 const KeyRing &keys,
+                 std::vector<uint8_t> &out,
+                 uint64_t seqnum,
+                 const uint8_t *targetName, size_t targetNameLen,
+                 size_t chunkSize = 0, WorkerPool *pool = nullptr,
+                 CipherSuite suite = CipherSuite::Aes256Gcm);
+
     std::vector<uint8_t> decrypt(const std::vector<uint8_t> &encryptedData,
                                  const std::vector<uint8_t> &key);
 
     // Reads seqnum from the blob header and reconstructs AAD from seqnum + targetName.
-    // Throws TamperDetectedException on any tag mismatch.
+    // Throws TamperDetectedException on any tag mismatch. Chunked blobs are verified
+    // and decrypted chunk-parallel on `pool` when one is given.
     std::vector<uint8_t> decrypt(const std::vector<uint8_t> &encryptedData,
                                  const std::vector<uint8_t> &key,
-                                 const uint8_t *targetName, size_t targetNameLen);
+                                 const uint8_t *targetName, size_t targetNameLen,
+                                 WorkerPool *pool = nullptr);
+
+    // Picks the key and suite named in the blob header (DEFAULT_KEY_ID and
+    // AES-256-GCM if it names none).
+    std::vector<uint8_t> decrypt(const std::vector<uint8_t> &encryptedData,
+                                 const KeyRing &keys,
+                                 const uint8_t *targetName, size_t targetNameLen,
+                                 WorkerPool *pool = nullptr);
+
+    // Span variants of the two above: open the blob at [encryptedData, +encryptedLen)
+    // into `out`, reusing its capacity, so a caller that keeps `out` across blobs
+    // allocates nothing per blob. An empty input yields an empty `out`.
+    void decrypt(const uint8_t *encryptedData, size_t encryptedLen,
+                 const std::vector<uint8_t> &key,
+                 const uint8_t *targetName, size_t targetNameLen,
+                 std::vector<uint8_t> &out, WorkerPool *pool = nullptr);
+    void decrypt(const uint8_t *encryptedData, size_t encryptedLen,
+                 const KeyRing &keys,
+                 const uint8_t *targetName, size_t targetNameLen,
+                 std::vector<uint8_t> &out, WorkerPool *pool = nullptr);
+
+    // Incremental open of the blob starting at the current position of `in`. An
+    // extended blob is read, verified and handed to `sink` chunk by chunk, in
+    // windows of one chunk per pool thread plus one opened in parallel, so the
+    // working set (buffers kept across calls) is bounded by the window, not the
+    // blob. A single-tag blob can only be verified whole and is buffered. `sink`
+    // never sees unverified bytes, but a tamper in chunk k is only detected after
+    // earlier windows were delivered. Throws like decrypt, and std::runtime_error
+    // on a short read.
+    using PlaintextSink = std::function<void(const uint8_t *data, size_t size)>;
+    void decryptStream(std::istream &in, const KeyRing &keys,
+                       const uint8_t *targetName, size_t targetNameLen,
+                       const PlaintextSink &sink, WorkerPool *pool = nullptr);
 
     static bool peekSeqnum(const uint8_t *encryptedData, size_t encryptedLen,
                            uint64_t &outSeqnum);
     static bool peekSeqnum(const std::vector<uint8_t> &encryptedData,
                            uint64_t &outSeqnum);
 
+    // Contiguous copy of the blob AAD (the cipher paths feed it without building one).
     static std::vector<uint8_t> buildAad(uint64_t seqnum,
                                          const uint8_t *targetName,
                                          size_t targetNameLen);
+
+private:
+    // Keyed (IV-less) context for the calling thread; chunks may run on pool threads.
+    using ContextFor = std::function<EVP_CIPHER_CTX *(uint32_t keyId, CipherSuite suite, bool forEncrypt)>;
+
+    static void seal(const uint8_t *plaintext, size_t plaintextLen,
+                     const ContextFor &contextFor, uint32_t keyId, CipherSuite suite,
+                     std::vector<uint8_t> &out,
+                     uint64_t seqnum,
+                     const uint8_t *targetName, size_t targetNameLen,
+                     size_t chunkSize, WorkerPool *pool, NonceSequence *nonces);
+    static void open(const uint8_t *encryptedData, size_t encryptedLen,
+                     const ContextFor &contextFor,
+                     const uint8_t *targetName, size_t targetNameLen,
+                     std::vector<uint8_t> &out, WorkerPool *pool);
+    static void openExtended(const uint8_t *encryptedData, size_t encryptedLen,
+                             const ContextFor &contextFor,
+                             const uint8_t *targetName, size_t targetNameLen,
+                             std::vector<uint8_t> &out, WorkerPool *pool);
+
+    std::shared_ptr<NonceSequence> m_nonces;
+    // decryptStream scratch, reused across blobs.
+    std::vector<uint8_t> m_streamIn;
+    std::vector<uint8_t> m_streamOut;
 };
 
 #endif
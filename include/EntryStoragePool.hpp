@@ -0,0 +1,34 @@
+#ifndef ENTRY_STORAGE_POOL_HPP
+#define ENTRY_STORAGE_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Slab of recycled heap buffers for LogEntry's location, subject and payload.
+// Writers give back the buffers of entries they have serialized and
+// LogEntry::make() takes them, so in steady state neither producers nor writers
+// call malloc per entry.
+//
+// Each thread keeps two magazines of up to MAGAZINE_SIZE buffers and trades
+// whole magazines with a shared depot, so the depot's lock is taken about once
+// per MAGAZINE_SIZE buffers. Buffers larger than MAX_RETAINED_CAPACITY are
+// freed rather than kept and the depot holds at most MAX_DEPOT_MAGAZINES full
+// magazines, which bounds the memory held. Thread-safe.
+class EntryStoragePool
+{
+public:
+    static constexpr size_t MAGAZINE_SIZE = 16;
+    static constexpr size_t MAX_RETAINED_CAPACITY = 16 * 1024;
+    static constexpr size_t MAX_DEPOT_MAGAZINES = 256;
+
+    // An empty buffer, with whatever capacity its previous owner left it.
+    static std::string takeString();
+    static std::vector<uint8_t> takeBytes();
+
+    static void give(std::string &&buffer);
+    static void give(std::vector<uint8_t> &&buffer);
+};
+
+#endif
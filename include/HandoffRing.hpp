@@ -0,0 +1,115 @@
+#ifndef HANDOFF_RING_HPP
+#define HANDOFF_RING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+// Bounded lock-free MPMC ring (Vyukov's sequence-numbered cells). Used to hand
+// finished blobs from the CPU stage to the I/O stage without a shared lock.
+// Capacity is rounded up to a power of two.
+template <typename T>
+class HandoffRing
+{
+public:
+    explicit HandoffRing(size_t capacity)
+    {
+        if (capacity == 0)
+            throw std::invalid_argument("HandoffRing: capacity must be > 0");
+        size_t rounded = 1;
+        while (rounded < capacity)
+            rounded <<= 1;
+        m_mask = rounded - 1;
+        m_cells.reset(new Cell[rounded]);
+        for (size_t i = 0; i < rounded; ++i)
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    HandoffRing(const HandoffRing &) = delete;
+    HandoffRing &operator=(const HandoffRing &) = delete;
+
+    // Leaves `item` untouched when the ring is full.
+    bool tryPush(T &&item)
+    {
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true)
+        {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(item);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T &item)
+    {
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true)
+        {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        item = std::move(cell->value);
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t capacity() const { return m_mask + 1; }
+
+    // Approximate; only meaningful when producers and consumers are quiescent.
+    size_t sizeApprox() const
+    {
+        size_t enq = m_enqueuePos.load(std::memory_order_relaxed);
+        size_t deq = m_dequeuePos.load(std::memory_order_relaxed);
+        return enq >= deq ? enq - deq : 0;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask = 0;
+    // Separate cache lines so producers and consumers don't false-share.
+    alignas(64) std::atomic<size_t> m_enqueuePos{0};
+    alignas(64) std::atomic<size_t> m_dequeuePos{0};
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef INTERNED_STRING_HPP
+#define INTERNED_STRING_HPP
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// Handle to a process-wide canonical copy of a string. Equal strings intern to
+// the same handle, so copying and comparing are pointer operations and an
+// entry carrying one costs no allocation.
+//
+// Meant for small, repeating vocabularies such as controller and processor IDs:
+// interned strings are never freed. Interning a string already seen allocates
+// nothing; each thread keeps a small cache of recent lookups, so the common
+// case does not touch the shared table's locks either. Thread-safe.
+class InternedString
+{
+public:
+    // The empty string.
+    InternedString();
+    explicit InternedString(std::string_view value);
+
+    const std::string &str() const { return *m_value; }
+    operator const std::string &() const { return *m_value; }
+    std::string_view view() const { return *m_value; }
+    size_t size() const { return m_value->size(); }
+    bool empty() const { return m_value->empty(); }
+
+    friend bool operator==(InternedString a, InternedString b) { return a.m_value == b.m_value; }
+    friend bool operator!=(InternedString a, InternedString b) { return a.m_value != b.m_value; }
+
+    // Distinct strings interned so far, including the empty string.
+    static size_t internedCount();
+
+private:
+    const std::string *m_value;
+};
+
+namespace std
+{
+template <>
+struct hash<InternedString>
+{
+    size_t operator()(InternedString s) const noexcept { return hash<const void *>{}(&s.str()); }
+};
+} // namespace std
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef IO_STAGE_HPP
+#define IO_STAGE_HPP
+
+#include "HandoffRing.hpp"
+#include "AppendTicket.hpp"
+#include "SegmentedStorage.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Finished (serialized/compressed/encrypted) blobs for one target, written back to
+// back with a single gather write.
+struct IoRequest
+{
+    // What one blob carries; checkpoint blobs carry nothing.
+    struct BlobShare
+    {
+        size_t entries = 0;
+        size_t completions = 0;
+    };
+
+    std::optional<std::string> targetFilename;
+    std::vector<std::vector<uint8_t>> blobs;
+    size_t entryCount = 0; // across all blobs
+    // appendAsync tickets of entries in these blobs, resolved after the write.
+    std::vector<std::shared_ptr<AppendTicket::State>> completions;
+    // One per blob, in blob order, so a write that stops part-way fails only what
+    // it did not write. Left empty, the request succeeds or fails as a whole.
+    std::vector<BlobShare> shares;
+
+    // Resolves the tickets after a write that got the first `blobsWritten` blobs
+    // on disk, and returns the number of entries lost. Clears `completions`.
+    size_t settle(size_t blobsWritten);
+};
+
+// I/O half of the pipelined writer. Writer threads run the CPU stages and submit
+// blobs here; a small pool of I/O threads drains the ring into SegmentedStorage,
+// so a slow pwrite or rotation fsync never stalls compression and vice versa.
+// Spent blob buffers flow back through a second ring for the CPU stage to reuse.
+class IoStage
+{
+public:
+    IoStage(std::shared_ptr<SegmentedStorage> storage,
+            size_t numThreads,
+            size_t ringCapacity);
+    ~IoStage();
+
+    IoStage(const IoStage &) = delete;
+    IoStage &operator=(const IoStage &) = delete;
+
+    void start();
+    // Drains every submitted request before joining the I/O threads.
+    void stop();
+
+    // Blocks (spin, then back off) while the ring is full; that is the
+    // pipeline's backpressure on the CPU stage.
+    void submit(IoRequest &&request);
+
+    // Hands back a previously written blob buffer (cleared, capacity kept) if one
+    // is available, so the CPU stage can avoid reallocating its scratch space.
+    bool takeSpentBuffer(std::vector<uint8_t> &out);
+
+    // Entries whose blob failed to write.
+    size_t droppedEntries() const { return m_droppedEntries.load(std::memory_order_acquire); }
+
+private:
+    void run();
+    void waitForWork();
+
+    std::shared_ptr<SegmentedStorage> m_storage;
+    const size_t m_numThreads;
+    HandoffRing<IoRequest> m_ring;
+    HandoffRing<std::vector<uint8_t>> m_spentBuffers;
+    std::vector<std::thread> m_threads;
+    std::atomic<bool> m_running{false};
+    std::atomic<size_t> m_droppedEntries{0};
+
+    // Same parking scheme as BufferQueue: submitters only lock when a consumer sleeps.
+    std::mutex m_parkMutex;
+    std::condition_variable m_parkCv;
+    std::atomic<size_t> m_parkedThreads{0};
+    uint64_t m_wakeEpoch = 0; // guarded by m_parkMutex
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef IO_URING_HPP
+#define IO_URING_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+// Minimal io_uring wrapper used by SegmentedStorage's io_uring backend. Talks to
+// the kernel through the raw syscalls (no liburing dependency) and is only
+// functional when built with GDPR_LOGGING_HAVE_IO_URING; otherwise, or if the
+// kernel refuses io_uring_setup or lacks one of the opcodes used here (openat,
+// write, writev, fsync), the constructor throws std::runtime_error.
+//
+// Any number of threads may submit. Every call except fsyncAndCloseAsync waits
+// for its own completion, so the caller blocks in io_uring_enter about as long as
+// it would in the plain syscall; while waiting it reaps the completion queue on
+// behalf of everyone, so concurrent writers share io_uring_enter calls.
+class IoUring
+{
+public:
+    IoUring(unsigned entries, size_t fileSlots);
+    ~IoUring();
+
+    IoUring(const IoUring &) = delete;
+    IoUring &operator=(const IoUring &) = delete;
+
+    static bool compiledIn();
+
+    // Registered-file table. registerFile returns the slot to pass to the calls
+    // below, or -1 if the table is full (callers then fall back to the plain fd).
+    int registerFile(int fd);
+    void unregisterFile(int slot);
+
+    // Block the caller until the operation completes; throw std::runtime_error on failure.
+    void writeFull(int fd, int slot, const uint8_t *buf, size_t count, off_t offset);
+    void writevFull(int fd, int slot, const struct iovec *iov, size_t iovcnt, off_t offset);
+    void fdatasync(int fd, int slot);
+    int openat(const char *path, int flags, mode_t mode);
+
+    // Queues an fsync of `fd` and closes it once that completes, without waiting.
+    void fsyncAndCloseAsync(int fd);
+    // Waits for every fsyncAndCloseAsync issued so far.
+    void drain();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+#endif
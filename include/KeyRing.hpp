@@ -0,0 +1,52 @@
+#ifndef KEY_RING_HPP
+#define KEY_RING_HPP
+
+#include "Config.hpp"
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+#include <openssl/evp.h>
+
+// Encryption keys by key ID, plus the active ID new blobs are sealed with. Keys
+// are never removed, so blobs sealed before a rotation stay readable.
+//
+// Each thread keeps its own EVP contexts with the key schedule already expanded,
+// one per (ring, key, suite, direction); sealing a blob then only sets a fresh IV on
+// the cached context instead of re-running EVP_*Init_ex with the raw key.
+class KeyRing
+{
+public:
+    // Blobs without a key ID field (the single-tag format) were sealed with this key.
+    static constexpr uint32_t DEFAULT_KEY_ID = 0;
+
+    KeyRing();
+    KeyRing(uint32_t keyId, std::vector<uint8_t> key);
+
+    KeyRing(const KeyRing &) = delete;
+    KeyRing &operator=(const KeyRing &) = delete;
+
+    // Throws std::invalid_argument on a wrong key size or a reused ID with different bytes.
+    void addKey(uint32_t keyId, std::vector<uint8_t> key);
+    // Throws std::invalid_argument if keyId was never added.
+    void setActiveKey(uint32_t keyId);
+    uint32_t activeKeyId() const { return m_activeKeyId.load(std::memory_order_acquire); }
+    bool hasKey(uint32_t keyId) const;
+
+    // Calling thread's context for keyId, keyed but without an IV; callers only
+    // pass the IV to EVP_{En,De}cryptInit_ex. Throws std::runtime_error for an
+    // unknown key ID.
+    EVP_CIPHER_CTX *encryptContext(uint32_t keyId, CipherSuite suite = CipherSuite::Aes256Gcm) const;
+    EVP_CIPHER_CTX *decryptContext(uint32_t keyId, CipherSuite suite = CipherSuite::Aes256Gcm) const;
+
+private:
+    EVP_CIPHER_CTX *context(uint32_t keyId, CipherSuite suite, bool forEncrypt) const;
+
+    const uint64_t m_id; // distinguishes rings in the per-thread context caches
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<uint32_t, std::vector<uint8_t>> m_keys;
+    std::atomic<uint32_t> m_activeKeyId{DEFAULT_KEY_ID};
+};
+
+#endif
@@ -1,11 +1,17 @@
 #ifndef LOG_ENTRY_HPP
 #define LOG_ENTRY_HPP
 
+#include "Config.hpp"
+#include "InternedString.hpp"
 #include <string>
+#include <string_view>
 #include <chrono>
 #include <vector>
 #include <memory>
 #include <cstdint>
+#include <functional>
+
+class LogEntryView;
 
 class LogEntry
 {
@@ -14,6 +20,9 @@ public:
     static constexpr size_t MAX_STRING_SIZE = 1 * 1024 * 1024;
     static constexpr size_t MAX_PAYLOAD_SIZE = 16 * 1024 * 1024;
     static constexpr size_t MAX_ENTRY_SIZE = 32 * 1024 * 1024;
+    // A batch in any encoding but Rows starts with this where Rows has its entry
+    // count (no Rows batch holds 2^32 - 1 entries), followed by a BatchEncoding byte.
+    static constexpr uint32_t BATCH_ENCODING_MARKER = 0xFFFFFFFF;
 
     enum class ActionType
     {
@@ -32,6 +41,27 @@ public:
              std::string dataSubjectId,
              std::vector<uint8_t> payload = std::vector<uint8_t>());
 
+    LogEntry(ActionType actionType,
+             std::string dataLocation,
+             InternedString dataControllerId,
+             InternedString dataProcessorId,
+             std::string dataSubjectId,
+             std::vector<uint8_t> payload = std::vector<uint8_t>());
+
+    // Allocation-free in steady state: copies into buffers recycled through
+    // EntryStoragePool rather than fresh ones. Prefer this on hot append paths.
+    static LogEntry make(ActionType actionType,
+                         std::string_view dataLocation,
+                         InternedString dataControllerId,
+                         InternedString dataProcessorId,
+                         std::string_view dataSubjectId,
+                         const uint8_t *payload = nullptr,
+                         size_t payloadSize = 0);
+
+    // Returns the buffers of spent entries (e.g. already serialized) to
+    // EntryStoragePool and clears `entries`.
+    static void recycle(std::vector<LogEntry> &entries);
+
     std::vector<uint8_t> serialize() &&;
     std::vector<uint8_t> serialize() const &;
     // Append into a caller-owned buffer; no heap allocation if `out` has enough capacity.
@@ -40,29 +70,109 @@ public:
     size_t serializedSize() const;
     bool deserialize(std::vector<uint8_t> &&data);
 
-    static std::vector<uint8_t> serializeBatch(std::vector<LogEntry> &&entries);
+    static std::vector<uint8_t> serializeBatch(std::vector<LogEntry> &&entries,
+                                               BatchEncoding encoding = BatchEncoding::Rows);
     // Overwrites `out`.
-    static void serializeBatch(std::vector<LogEntry> &&entries, std::vector<uint8_t> &out);
+    static void serializeBatch(std::vector<LogEntry> &&entries, std::vector<uint8_t> &out,
+                               BatchEncoding encoding = BatchEncoding::Rows);
+    // Reads every encoding.
     static std::vector<LogEntry> deserializeBatch(std::vector<uint8_t> &&batchData);
 
+    // Incremental counterpart of deserializeBatch for a batch that arrives in
+    // pieces: buffers at most one entry and hands each complete entry to onEntry.
+    // Unlike deserializeBatch it throws std::runtime_error on malformed input, and
+    // finish() throws unless exactly the announced number of entries arrived.
+    // Compact batches stream the same way. Columnar batches are buffered whole, up
+    // to Compression::DEFAULT_MAX_DECOMPRESSED_SIZE, and decoded by finish().
+    class BatchDecoder
+    {
+    public:
+        explicit BatchDecoder(std::function<void(LogEntry &&)> onEntry);
+
+        // Hands out views instead of entries, valid only during the call. A row
+        // entry that arrives within one feed() is viewed in place, without copying.
+        static BatchDecoder forViews(std::function<void(const LogEntryView &)> onView);
+
+        void feed(const uint8_t *data, size_t size);
+        void finish();
+
+    private:
+        BatchDecoder() = default;
+        // What follows a count of BATCH_ENCODING_MARKER.
+        enum class Marked : uint8_t
+        {
+            No,
+            Header,  // m_pending holds the marker and the header read so far
+            Compact, // header parsed; m_pending holds at most one partial entry
+            Whole,   // any other encoding: m_pending buffers the whole batch
+        };
+
+        void emit(const LogEntryView &view);
+        void emitEntry(const uint8_t *data, size_t size);
+        void emitCompactEntry(const uint8_t *data, size_t size);
+        void appendMarked(const uint8_t *data, size_t size);
+        void feedMarked(const uint8_t *data, size_t size);
+
+        std::function<void(LogEntry &&)> m_onEntry; // one of these two is set
+        std::function<void(const LogEntryView &)> m_onView;
+        std::vector<uint8_t> m_pending;
+        size_t m_needed = sizeof(uint32_t); // bytes m_pending must reach
+        bool m_haveCount = false;
+        bool m_inEntry = false; // m_pending holds entry bytes, not a size field
+        Marked m_marked = Marked::No;
+        uint64_t m_remaining = 0;
+        int64_t m_baseMillis = 0; // Compact only
+    };
+
     ActionType getActionType() const { return m_actionType; }
     std::string getDataLocation() const { return m_dataLocation; }
-    std::string getDataControllerId() const { return m_dataControllerId; }
-    std::string getDataProcessorId() const { return m_dataProcessorId; }
+    std::string getDataControllerId() const { return m_dataControllerId.str(); }
+    std::string getDataProcessorId() const { return m_dataProcessorId.str(); }
     std::string getDataSubjectId() const { return m_dataSubjectId; }
     std::chrono::system_clock::time_point getTimestamp() const { return m_timestamp; }
     const std::vector<uint8_t> &getPayload() const { return m_payload; }
 
 private:
+    // A controller or processor ID. Shares the table's copy when the caller passed
+    // an InternedString; any other ID is owned, so IDs from the std::string
+    // constructor or from decoding never grow the process-wide intern table.
+    class Id
+    {
+    public:
+        Id() = default;
+        explicit Id(std::string owned) : m_owned(std::move(owned)) {}
+        explicit Id(const InternedString &interned) : m_interned(&interned.str()) {}
+
+        const std::string &str() const { return m_interned ? *m_interned : m_owned; }
+        std::string_view view() const { return str(); }
+        size_t size() const { return str().size(); }
+
+    private:
+        const std::string *m_interned = nullptr; // never freed
+        std::string m_owned;
+    };
+
+    static void serializeColumnar(std::vector<LogEntry> &&entries, std::vector<uint8_t> &out);
+    static void serializeCompact(const std::vector<LogEntry> &entries, std::vector<uint8_t> &out);
+    // `data` follows BATCH_ENCODING_MARKER. Throws std::runtime_error on malformed input.
+    static void decodeMarkedBatch(const uint8_t *data, size_t size,
+                                  const std::function<void(LogEntry &&)> &onEntry);
+    static void decodeColumnar(const uint8_t *data, size_t size,
+                               const std::function<void(LogEntry &&)> &onEntry);
+    static void decodeCompact(const uint8_t *data, size_t size,
+                              const std::function<void(LogEntry &&)> &onEntry);
+
+    friend class LogEntryView;
+    friend class LogEntryBatchView;
+
     void appendToVector(std::vector<uint8_t> &vec, const void *data, size_t size) const;
     void appendStringToVector(std::vector<uint8_t> &vec, const std::string &str) const;
     void appendStringToVector(std::vector<uint8_t> &vec, std::string &&str);
-    bool extractStringFromVector(std::vector<uint8_t> &vec, size_t &offset, std::string &str);
 
     ActionType m_actionType;
     std::string m_dataLocation;
-    std::string m_dataControllerId;
-    std::string m_dataProcessorId;
+    Id m_dataControllerId;
+    Id m_dataProcessorId;
     std::string m_dataSubjectId;
     std::chrono::system_clock::time_point m_timestamp;
     std::vector<uint8_t> m_payload;
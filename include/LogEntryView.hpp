@@ -0,0 +1,111 @@
+#ifndef LOG_ENTRY_VIEW_HPP
+#define LOG_ENTRY_VIEW_HPP
+
+#include "LogEntry.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+// Non-owning view of one entry: the strings and payload point into the buffer
+// the entry was parsed from (or into the LogEntry it was made from), which must
+// outlive the view. Reading a field never allocates.
+class LogEntryView
+{
+public:
+    LogEntryView() = default;
+    explicit LogEntryView(const LogEntry &entry);
+
+    // Parses one entry in the row wire format (see LogEntry::serialize), with the
+    // same checks as LogEntry::deserialize. Returns false on malformed input.
+    bool parse(const uint8_t *data, size_t size);
+    // Parses one entry of a Compact batch at `pos` and advances past it;
+    // `baseMillis` is the batch's base timestamp. Returns false on malformed input.
+    bool parseCompact(const uint8_t *&pos, const uint8_t *end, int64_t baseMillis);
+    // The entry count and base timestamp that open a Compact batch (after the
+    // marker and encoding byte).
+    static bool parseCompactHeader(const uint8_t *&pos, const uint8_t *end, uint64_t &count,
+                                   int64_t &baseMillis);
+
+    LogEntry::ActionType getActionType() const { return m_actionType; }
+    std::string_view getDataLocation() const { return m_dataLocation; }
+    std::string_view getDataControllerId() const { return m_dataControllerId; }
+    std::string_view getDataProcessorId() const { return m_dataProcessorId; }
+    std::string_view getDataSubjectId() const { return m_dataSubjectId; }
+    std::chrono::system_clock::time_point getTimestamp() const { return m_timestamp; }
+    const uint8_t *getPayloadData() const { return m_payload; }
+    size_t getPayloadSize() const { return m_payloadSize; }
+
+    // An owning copy.
+    LogEntry toLogEntry() const;
+
+private:
+    LogEntry::ActionType m_actionType = LogEntry::ActionType::CREATE;
+    std::string_view m_dataLocation;
+    std::string_view m_dataControllerId;
+    std::string_view m_dataProcessorId;
+    std::string_view m_dataSubjectId;
+    std::chrono::system_clock::time_point m_timestamp;
+    const uint8_t *m_payload = nullptr;
+    size_t m_payloadSize = 0;
+};
+
+// The entries of a whole serialized batch, as views into its buffer, which must
+// outlive this object. Rows and Compact batches are parsed lazily while
+// iterating; the iterator throws std::runtime_error when it reaches a malformed
+// entry (or, for Compact, trailing bytes). Columnar batches cannot be viewed in
+// place: they are decoded up front (throwing std::runtime_error if malformed)
+// and the views point into the decoded copy.
+class LogEntryBatchView
+{
+public:
+    class Iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = LogEntryView;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const LogEntryView *;
+        using reference = const LogEntryView &;
+
+        reference operator*() const { return m_current; }
+        pointer operator->() const { return &m_current; }
+        Iterator &operator++();
+        bool operator==(const Iterator &other) const { return m_index == other.m_index; }
+        bool operator!=(const Iterator &other) const { return m_index != other.m_index; }
+
+    private:
+        friend class LogEntryBatchView;
+        Iterator(const LogEntryBatchView *batch, size_t index, const uint8_t *position);
+        void settle(); // loads the entry at m_index, if any
+
+        const LogEntryBatchView *m_batch;
+        size_t m_index;
+        const uint8_t *m_position; // next entry (its size field, for Rows)
+        LogEntryView m_current;
+    };
+
+    // Throws std::runtime_error if `data` does not start with a well-formed batch header.
+    LogEntryBatchView(const uint8_t *data, size_t size);
+
+    // Moving would leave views of decoded entries dangling.
+    LogEntryBatchView(const LogEntryBatchView &) = delete;
+    LogEntryBatchView &operator=(const LogEntryBatchView &) = delete;
+
+    // Entry count as announced by the batch header.
+    size_t size() const { return m_count; }
+    Iterator begin() const;
+    Iterator end() const;
+
+private:
+    BatchEncoding m_encoding = BatchEncoding::Rows;
+    const uint8_t *m_first = nullptr; // first entry, Rows and Compact only
+    const uint8_t *m_end = nullptr;
+    size_t m_count = 0;
+    int64_t m_baseMillis = 0;        // Compact only
+    std::vector<LogEntry> m_decoded; // Columnar only
+};
+
+#endif
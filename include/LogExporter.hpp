@@ -2,8 +2,11 @@
 #define LOG_EXPORTER_HPP
 
 #include "LogEntry.hpp"
+#include "WorkerPool.hpp"
+#include "KeyRing.hpp"
 #include <chrono>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
@@ -20,15 +23,28 @@ struct ExportFilter
 class LogExporter
 {
 public:
-    LogExporter(std::string basePath, bool useEncryption, int compressionLevel);
+    // Chunked blobs are decrypted chunk-parallel on `cryptoPool` when given. Each
+    // blob is opened with the key its header names; a null ring means the placeholder key.
+    // With a `decodePool`, segments are scanned and blobs decoded on its threads
+    // (each with its own Crypto and Compression); output and checks stay in order.
+    LogExporter(std::string basePath, bool useEncryption, int compressionLevel,
+                std::shared_ptr<WorkerPool> cryptoPool = nullptr,
+                std::shared_ptr<KeyRing> keyRing = nullptr,
+                std::shared_ptr<WorkerPool> decodePool = nullptr);
 
     // Walks all *.log segment files under basePath, reverses the Writer
     // pipeline (decrypt -> [decompress] -> deserialize), applies `filter`,
-    // and writes NDJSON (one entry per line) to `outputPath`.
+    // and writes NDJSON (one entry per line) to `outputPath`. Blobs are streamed
+    // from disk chunk by chunk, so memory use depends on the chunk size and the
+    // number of blobs, not on batch or segment size. A decode pool additionally
+    // buffers the NDJSON of a few blobs per thread until they are written in order,
+    // so there every blob's decompressed size is capped (a larger one fails the
+    // export like any other decode error).
     //
     // Returns false and removes any partial output file if:
     //   - useEncryption was false at construction (unframed format unsupported)
     //   - a segment blob fails AES-GCM tag verification (tamper)
+    //   - a Merkle checkpoint batch's root does not match the blobs before it
     //   - any I/O or parse error occurs
     bool exportToNDJSON(const std::string &outputPath, const ExportFilter &filter);
 
@@ -36,6 +52,9 @@ private:
     std::string m_basePath;
     bool m_useEncryption;
     int m_compressionLevel;
+    std::shared_ptr<WorkerPool> m_cryptoPool;
+    std::shared_ptr<KeyRing> m_keyRing;
+    std::shared_ptr<WorkerPool> m_decodePool; // null = decode on the calling thread
 };
 
 #endif
@@ -23,12 +23,16 @@ public:
                     std::chrono::milliseconds appendTimeout = std::chrono::milliseconds::max());
 
     BufferQueue::ProducerToken createProducerToken();
+    // `completion`, if set, rides along with the queued item(s) so the writer can
+    // resolve the caller's AppendTicket.
     bool append(LogEntry entry,
                 BufferQueue::ProducerToken &token,
-                const std::optional<std::string> &filename = std::nullopt);
+                const std::optional<std::string> &filename = std::nullopt,
+                std::shared_ptr<AppendTicket::State> completion = nullptr);
     bool appendBatch(std::vector<LogEntry> entries,
                      BufferQueue::ProducerToken &token,
-                     const std::optional<std::string> &filename = std::nullopt);
+                     const std::optional<std::string> &filename = std::nullopt,
+                     std::shared_ptr<AppendTicket::State> completion = nullptr);
 
     bool reset();
 
@@ -7,6 +7,14 @@
 #include "SegmentedStorage.hpp"
 #include "SeqnumAllocator.hpp"
 #include "Writer.hpp"
+#include "IoStage.hpp"
+#include "WorkerPool.hpp"
+#include "KeyRing.hpp"
+#include "NonceSequence.hpp"
+#include "MerkleTree.hpp"
+#include "CompressionDictionary.hpp"
+#include "CompressionController.hpp"
+#include "AppendTicket.hpp"
 #include "LogEntry.hpp"
 #include <memory>
 #include <vector>
@@ -33,6 +41,21 @@ public:
                      BufferQueue::ProducerToken &token,
                      const std::optional<std::string> &filename = std::nullopt);
 
+    // Like append/appendBatch, but the returned ticket resolves once the entry (every
+    // entry, for a batch) has been written out. A rejected append resolves as Failed.
+    AppendTicket appendAsync(LogEntry entry,
+                             BufferQueue::ProducerToken &token,
+                             const std::optional<std::string> &filename = std::nullopt);
+    AppendTicket appendBatchAsync(std::vector<LogEntry> entries,
+                                  BufferQueue::ProducerToken &token,
+                                  const std::optional<std::string> &filename = std::nullopt);
+
+    // Adds `key` under keyId (if new) and seals every later blob with it. Earlier
+    // blobs keep their key ID, so export still needs the ring to hold the old keys.
+    // Throws std::invalid_argument like KeyRing::addKey.
+    void rotateKey(uint32_t keyId, std::vector<uint8_t> key);
+    std::shared_ptr<KeyRing> keyRing() const { return m_keyRing; }
+
     bool exportLogs(const std::string &outputPath,
                     std::chrono::system_clock::time_point fromTimestamp = std::chrono::system_clock::time_point(),
                     std::chrono::system_clock::time_point toTimestamp = std::chrono::system_clock::time_point(),
@@ -42,6 +65,13 @@ private:
     std::shared_ptr<BufferQueue> m_queue;
     std::shared_ptr<SegmentedStorage> m_storage;
     std::shared_ptr<SeqnumAllocator> m_seqnumAllocator;
+    std::shared_ptr<IoStage> m_ioStage; // null unless usePipelinedWriter
+    std::shared_ptr<WorkerPool> m_cryptoPool; // null unless chunked encryption has helpers
+    std::shared_ptr<KeyRing> m_keyRing;
+    std::shared_ptr<NonceSequence> m_nonces; // null unless NonceStrategy::Counter
+    std::shared_ptr<merkle::MerkleAccumulator> m_merkleLog; // null unless checkpoints are on
+    std::shared_ptr<const DictionaryRegistry> m_dictionaries; // null unless dictionaries are configured
+    std::shared_ptr<CompressionController> m_compressionController; // null unless adaptive compression is on
     std::vector<std::unique_ptr<Writer>> m_writers;
     std::atomic<bool> m_running{false};
     std::atomic<bool> m_acceptingEntries{false};
@@ -52,8 +82,17 @@ private:
 
     size_t m_numWriterThreads;
     size_t m_batchSize;
+    size_t m_maxBatchBytes;
+    std::chrono::milliseconds m_maxBatchLinger;
     bool m_useEncryption;
+    BatchEncoding m_batchEncoding;
     int m_compressionLevel;
+    CompressionCodec m_compressionCodec;
+    size_t m_encryptionChunkSize;
+    size_t m_exportThreads;
+    CipherSuite m_cipherSuite;
+    WriterIdleStrategy m_writerIdleStrategy;
+    std::vector<std::vector<int>> m_writerCpus; // per writer; empty = unpinned
     std::string m_basePath;
     std::string m_baseFilename;
 };
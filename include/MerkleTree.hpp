@@ -0,0 +1,133 @@
+#ifndef MERKLE_TREE_HPP
+#define MERKLE_TREE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class SeqnumAllocator;
+
+// RFC 9162-style Merkle tree over a target's blobs: leaf i is SHA-256(0x00 || blob
+// with seqnum i as written to disk), interior nodes are SHA-256(0x01 || left || right).
+// Checkpoint batches carry the root over a prefix of leaves, so one blob can be
+// shown to belong to a sealed log with log2(n) hashes instead of every blob.
+namespace merkle
+{
+using Hash = std::array<uint8_t, 32>;
+
+// Incremental SHA-256 of one leaf, for blobs read in pieces.
+class LeafHasher
+{
+public:
+    LeafHasher();
+    ~LeafHasher();
+    LeafHasher(const LeafHasher &) = delete;
+    LeafHasher &operator=(const LeafHasher &) = delete;
+
+    void update(const uint8_t *data, size_t size);
+    // Returns the leaf hash and resets for the next leaf.
+    Hash finish();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+Hash leafHash(const uint8_t *data, size_t size);
+Hash nodeHash(const Hash &left, const Hash &right);
+
+// Root of the first `count` leaves (count > 0).
+Hash rootOf(const std::vector<Hash> &leaves, size_t count);
+
+// Audit path for leaf `index` in the tree over the first `treeSize` leaves.
+std::vector<Hash> inclusionProof(const std::vector<Hash> &leaves, size_t treeSize, size_t index);
+bool verifyInclusion(const Hash &leaf, uint64_t index, uint64_t treeSize,
+                     const std::vector<Hash> &proof, const Hash &root);
+
+// Right edge of a tree that grows by appending leaves: one root per perfect
+// subtree, so O(log n) memory and amortized O(1) hashing per leaf.
+class Frontier
+{
+public:
+    void append(const Hash &leaf);
+    uint64_t size() const { return m_size; }
+    // Root of all leaves appended so far (size() > 0).
+    Hash root() const;
+
+private:
+    std::vector<std::pair<uint64_t, Hash>> m_subtrees; // (leaf count, root), largest first
+    uint64_t m_size = 0;
+};
+
+// Plaintext of a checkpoint batch: the root over leaves [0, leafCount). Like the
+// seal marker, the embedded control bytes cannot start a serialized batch.
+inline constexpr uint8_t CHECKPOINT_MAGIC[] = {
+    'M', 'R', 'K', 'L', 0x00, 0x01, 'G', 'D', 'P', 'R'};
+inline constexpr size_t CHECKPOINT_MAGIC_LEN = sizeof(CHECKPOINT_MAGIC);
+inline constexpr size_t CHECKPOINT_SIZE = CHECKPOINT_MAGIC_LEN + sizeof(uint64_t) + sizeof(Hash);
+
+struct Checkpoint
+{
+    uint64_t seqnum; // of the checkpoint batch itself
+    uint64_t leafCount;
+    Hash root;
+};
+
+std::vector<uint8_t> encodeCheckpoint(uint64_t leafCount, const Hash &root);
+// False unless `data` is exactly a checkpoint plaintext.
+bool decodeCheckpoint(const uint8_t *data, size_t size, uint64_t &leafCount, Hash &root);
+
+// Per-target trees fed by all writers. Blobs finish out of seqnum order, so leaves
+// wait in a small map until the prefix before them is complete.
+class MerkleAccumulator
+{
+public:
+    // A checkpoint is due every `interval` leaves per target (> 0).
+    explicit MerkleAccumulator(size_t interval);
+
+    // Records the leaf of data batch `seqnum`. Every `interval` data batches, allocates
+    // a checkpoint seqnum from `seqnums` (under the same lock, so checkpoint seqnums
+    // and leaf counts increase together) and returns the checkpoint over the complete
+    // prefix; the caller writes it and reports its leaf through addCheckpoint.
+    std::optional<Checkpoint> add(const std::string &target, uint64_t seqnum, const Hash &leaf,
+                                  SeqnumAllocator &seqnums);
+    // Records a checkpoint batch's own leaf; never triggers another checkpoint.
+    void addCheckpoint(const std::string &target, uint64_t seqnum, const Hash &leaf);
+
+    // Checkpoint over the complete prefix, at a freshly allocated seqnum; nullopt
+    // if the target has no leaves yet. Used once writers are stopped.
+    std::optional<Checkpoint> finalCheckpoint(const std::string &target, SeqnumAllocator &seqnums);
+
+    // Reports that `seqnum` was allocated but its batch will never be written (it
+    // failed to build). The prefix can then never complete, so the target stops
+    // checkpointing: its waiting leaves are freed and later ones are ignored.
+    void abandon(const std::string &target, uint64_t seqnum);
+    // Leaves held back by a gap in `target`'s prefix.
+    size_t waitingLeaves(const std::string &target);
+
+private:
+    struct TargetTree
+    {
+        Frontier frontier;
+        std::map<uint64_t, Hash> waiting; // leaves past a gap in the prefix
+        uint64_t sinceCheckpoint = 0; // data batches
+        bool abandoned = false;       // a seqnum will never arrive; no more checkpoints
+    };
+
+    static void append(TargetTree &tree, uint64_t seqnum, const Hash &leaf);
+
+    const size_t m_interval;
+    std::mutex m_mutex;
+    std::unordered_map<std::string, TargetTree> m_trees;
+};
+} // namespace merkle
+
+#endif
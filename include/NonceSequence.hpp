@@ -0,0 +1,47 @@
+#ifndef NONCE_SEQUENCE_HPP
+#define NONCE_SEQUENCE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// Deterministic nonce source for Crypto: a 64-bit counter, written little-endian
+// into the first eight IV bytes, followed by four zero bytes that chunked blobs
+// XOR their chunk index into. One instance is shared by all writers; next() is a
+// fetch_add, so sealing a blob no longer takes the OpenSSL DRBG lock.
+//
+// Uniqueness across restarts:
+//   - with a state file, counters are reserved in blocks whose upper bound is
+//     persisted (write, fsync, rename) before any value in the block is used, and
+//     a restart resumes above the persisted bound. Values reserved but unused
+//     before a crash are skipped, never reissued.
+//   - without one, the upper 32 bits are a random per-instance prefix and the
+//     instance throws once its 2^32 counters are used up; reuse then needs two
+//     instances to draw the same prefix under the same key.
+class NonceSequence
+{
+public:
+    static constexpr uint64_t RESERVE_BLOCK = 1u << 16;
+
+    // Empty stateFile = random prefix. Throws std::runtime_error if the state file
+    // exists but cannot be read or written.
+    explicit NonceSequence(std::string stateFile = "");
+
+    NonceSequence(const NonceSequence &) = delete;
+    NonceSequence &operator=(const NonceSequence &) = delete;
+
+    // Writes a fresh 12-byte IV. Thread-safe.
+    void next(uint8_t *iv);
+
+private:
+    void reserveThrough(uint64_t value);
+
+    const std::string m_stateFile;
+    uint64_t m_limit = 0; // random-prefix mode: first value past this instance's range
+    std::atomic<uint64_t> m_next{0};
+    std::atomic<uint64_t> m_reserved{0}; // state-file mode: values below this are on disk
+    std::mutex m_reserveMutex;
+};
+
+#endif
@@ -1,7 +1,11 @@
 #ifndef PLACEHOLDER_CRYPTO_MATERIAL_HPP
 #define PLACEHOLDER_CRYPTO_MATERIAL_HPP
 
+#include "Crypto.hpp"
+#include "KeyRing.hpp"
 #include <cstdint>
+#include <memory>
+#include <vector>
 
 // Placeholder AES-256-GCM key used by Writer when encrypting, and by
 // LogExporter / round-trip tests when decrypting. Key management is out of
@@ -13,6 +17,14 @@
 namespace placeholder_crypto
 {
 constexpr uint8_t KEY_BYTE = 0x42;
+
+// Ring holding the placeholder key as KeyRing::DEFAULT_KEY_ID; used whenever no
+// ring is configured.
+inline std::shared_ptr<KeyRing> makeKeyRing()
+{
+    return std::make_shared<KeyRing>(KeyRing::DEFAULT_KEY_ID,
+                                     std::vector<uint8_t>(Crypto::KEY_SIZE, KEY_BYTE));
+}
 } // namespace placeholder_crypto
 
 #endif
@@ -2,6 +2,8 @@
 #define QUEUE_ITEM_HPP
 
 #include "LogEntry.hpp"
+#include "AppendTicket.hpp"
+#include <memory>
 #include <optional>
 #include <string>
 
@@ -9,12 +11,17 @@ struct QueueItem
 {
     LogEntry entry;
     std::optional<std::string> targetFilename = std::nullopt;
+    // Set only for appendAsync; resolved by whoever writes the blob holding this entry.
+    std::shared_ptr<AppendTicket::State> completion;
 
     QueueItem() = default;
     QueueItem(LogEntry &&logEntry)
         : entry(std::move(logEntry)), targetFilename(std::nullopt) {}
     QueueItem(LogEntry &&logEntry, const std::optional<std::string> &filename)
         : entry(std::move(logEntry)), targetFilename(filename) {}
+    QueueItem(LogEntry &&logEntry, const std::optional<std::string> &filename,
+              std::shared_ptr<AppendTicket::State> completionState)
+        : entry(std::move(logEntry)), targetFilename(filename), completion(std::move(completionState)) {}
 
     QueueItem(const QueueItem &) = default;
     QueueItem(QueueItem &&) = default;
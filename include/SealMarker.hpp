@@ -5,7 +5,7 @@
 #include <cstdint>
 
 // Plaintext of the per-target seal batch written on clean shutdown. Its seqnum
-// equals the count of data batches for that target, so the exporter can detect
+// equals the count of earlier batches for that target, so the exporter can detect
 // tail truncation. The embedded control bytes ensure this can't collide with
 // a LogEntry::serializeBatch prefix.
 namespace seal_marker
@@ -11,10 +11,15 @@
 #include <unordered_map>
 #include <fcntl.h>  // for open flags
 #include <unistd.h> // for close, pwrite, fsync
+#include <sys/uio.h> // for iovec, pwritev
+#include <climits>   // for IOV_MAX
 #include <chrono>
 #include <thread>
 #include <stdexcept>
 #include <list>
+#include <condition_variable>
+#include "Config.hpp"
+#include "IoUring.hpp"
 
 class SegmentedStorage
 {
@@ -24,7 +29,10 @@ public:
                      size_t maxSegmentSize = 100 * 1024 * 1024, // 100 MB default
                      size_t maxAttempts = 5,
                      std::chrono::milliseconds baseRetryDelay = std::chrono::milliseconds(1),
-                     size_t maxOpenFiles = 512);
+                     size_t maxOpenFiles = 512,
+                     DurabilityPolicy durability = {},
+                     StorageBackend backend = StorageBackend::Pwrite,
+                     unsigned ioUringQueueDepth = 256);
 
     ~SegmentedStorage();
 
@@ -33,8 +41,24 @@ public:
     size_t writeToFile(const std::string &filename, std::vector<uint8_t> &&data);
     // Pointer/size overload so the caller keeps ownership of the buffer.
     size_t writeToFile(const std::string &filename, const uint8_t *data, size_t size);
+    // Gather write: the buffers land back to back in one segment, with a single
+    // offset reservation and one pwritev. If together they exceed maxSegmentSize
+    // they are written one by one instead, since a blob never straddles segments.
+    // If it throws, *buffersWritten (when given) counts the leading buffers that
+    // were fully written (and, under GroupCommit, synced) before the failure.
+    size_t writev(const struct iovec *iov, size_t iovcnt, size_t *buffersWritten = nullptr);
+    size_t writevToFile(const std::string &filename, const struct iovec *iov, size_t iovcnt,
+                        size_t *buffersWritten = nullptr);
     void flush();
 
+    // Number of fdatasync rounds issued by the durability policy (not counting
+    // rotation/eviction/flush syncs). With group commit this is usually far below
+    // the number of writes.
+    size_t syncRounds() const { return m_syncRounds.load(std::memory_order_relaxed); }
+
+    // The backend actually in use (IoUring may have fallen back to Pwrite).
+    StorageBackend backend() const { return m_uring ? StorageBackend::IoUring : StorageBackend::Pwrite; }
+
 private:
     std::string m_basePath;
     std::string m_baseFilename;
@@ -42,10 +66,14 @@ private:
     size_t m_maxAttempts;
     std::chrono::milliseconds m_baseRetryDelay;
     size_t m_maxOpenFiles;
+    DurabilityPolicy m_durability;
+    std::atomic<size_t> m_syncRounds{0};
+    std::unique_ptr<IoUring> m_uring; // null for the pwrite backend
 
     struct CacheEntry
     {
         int fd{-1};
+        int fileSlot{-1}; // io_uring registered-file slot for fd, or -1
         std::atomic<size_t> segmentIndex{0};
         std::atomic<size_t> currentOffset{0};
         // Bumped by rotateSegment; writers compare their pre-reservation value to detect
@@ -53,6 +81,18 @@ private:
         std::atomic<size_t> generation{0};
         std::string currentSegmentPath;
         mutable std::shared_mutex fileMutex; // shared for pwrite, exclusive for rotate/flush
+        // Set (under exclusive fileMutex) when eviction closed fd without a successful
+        // fsync; writes already on it can then never be acknowledged as durable.
+        bool closeSyncFailed = false;
+
+        // Group commit. Every completed pwrite takes a ticket from writtenSeq; a sync
+        // round covers all tickets issued before it started. One writer leads the
+        // round while later arrivals wait on syncCv and are released together.
+        std::atomic<uint64_t> writtenSeq{0};
+        std::mutex syncMutex;
+        std::condition_variable syncCv;
+        uint64_t durableSeq = 0;     // guarded by syncMutex
+        bool syncInProgress = false; // guarded by syncMutex
     };
 
     class LRUCache
@@ -67,6 +107,7 @@ private:
         // Drop the cache reference without touching the fd. Callers that have already
         // closed the fd (partial rotation) use this so the next get() rebuilds state.
         void invalidate(const std::string &filename);
+        std::vector<std::shared_ptr<CacheEntry>> snapshot() const;
 
     private:
         size_t m_capacity;
@@ -87,6 +128,25 @@ private:
 
     LRUCache m_cache;
 
+    // Periodic mode only.
+    std::thread m_syncThread;
+    std::mutex m_syncThreadMutex;
+    std::condition_variable m_syncThreadCv;
+    bool m_stopSyncThread = false; // guarded by m_syncThreadMutex
+    void periodicSyncLoop();
+
+    // Blocks until every write with a ticket <= `ticket` is on stable storage.
+    void awaitDurable(CacheEntry &entry, uint64_t ticket);
+
+    // Backend dispatch. Callers hold fileMutex as for the raw fd calls.
+    void openSegmentFile(CacheEntry &entry, const std::string &path);
+    void writeSegmentFile(const CacheEntry &entry, const struct iovec *iov, size_t iovcnt, off_t offset);
+    void syncSegmentData(const CacheEntry &entry);
+    // fsync + close entry.fd. With io_uring (and no group commit relying on the
+    // old segment being synced) this is queued and returns immediately.
+    // bestEffort closes the fd even if fsync fails, recording it in closeSyncFailed.
+    void closeSegmentFile(CacheEntry &entry, bool bestEffort);
+
     std::string rotateSegment(const std::string &filename, std::shared_ptr<CacheEntry> entry);
     std::string generateSegmentPath(const std::string &filename, size_t segmentIndex) const;
     size_t getFileSize(const std::string &path) const;
@@ -137,6 +197,38 @@ private:
         return total;
     }
 
+    size_t pwritevFull(int fd, const struct iovec *iov, size_t iovcnt, off_t offset)
+    {
+        // Local copy so a short write can be resumed by trimming the front entry.
+        std::vector<struct iovec> pending(iov, iov + iovcnt);
+        size_t index = 0;
+        size_t total = 0;
+        while (index < pending.size())
+        {
+            const int batch = static_cast<int>(std::min<size_t>(pending.size() - index, IOV_MAX));
+            ssize_t written = ::pwritev(fd, &pending[index], batch, offset + total);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                throw std::runtime_error("pwritev failed");
+            }
+            total += written;
+            while (written > 0 && index < pending.size())
+            {
+                size_t step = std::min<size_t>(written, pending[index].iov_len);
+                pending[index].iov_base = static_cast<uint8_t *>(pending[index].iov_base) + step;
+                pending[index].iov_len -= step;
+                written -= step;
+                if (pending[index].iov_len == 0)
+                    ++index;
+            }
+            while (index < pending.size() && pending[index].iov_len == 0)
+                ++index;
+        }
+        return total;
+    }
+
     void fsyncRetry(int fd)
     {
         retryWithBackoff([&]()
@@ -144,6 +236,14 @@ private:
             if (::fsync(fd) < 0) throw std::runtime_error("fsync failed");
             return 0; });
     }
+
+    void fdatasyncRetry(int fd)
+    {
+        retryWithBackoff([&]()
+                         {
+            if (::fdatasync(fd) < 0) throw std::runtime_error("fdatasync failed");
+            return 0; });
+    }
 };
 
 #endif
\ No newline at end of file
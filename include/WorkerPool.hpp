@@ -0,0 +1,59 @@
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of helper threads shared by every writer (and the exporter) for
+// data-parallel work such as encrypting the chunks of one large blob. The caller
+// of parallelFor works on its own job too, so a pool with zero threads still
+// makes progress and a busy pool never deadlocks a writer.
+class WorkerPool
+{
+public:
+    explicit WorkerPool(size_t numThreads);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    // Runs fn(i) for every i in [0, count) and returns once all calls finished.
+    // If any call throws, the remaining indices are skipped and the first
+    // exception is rethrown in the caller.
+    void parallelFor(size_t count, const std::function<void(size_t)> &fn);
+
+    size_t size() const { return m_threads.size(); }
+
+private:
+    struct Job
+    {
+        const std::function<void(size_t)> *fn;
+        size_t count;
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> finished{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable doneCv;
+    };
+
+    void run();
+    // Claims and runs indices of `job` until none are left.
+    static void work(Job &job);
+
+    std::vector<std::thread> m_threads;
+    std::deque<std::shared_ptr<Job>> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stop = false;
+};
+
+#endif
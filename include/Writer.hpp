@@ -3,26 +3,63 @@
 
 #include <thread>
 #include <atomic>
+#include <chrono>
 #include <memory>
 #include <string>
 #include <vector>
+#include "Config.hpp"
 #include "QueueItem.hpp"
 #include "BufferQueue.hpp"
 #include "SegmentedStorage.hpp"
 #include "SeqnumAllocator.hpp"
+#include "IoStage.hpp"
+#include "WorkerPool.hpp"
+#include "KeyRing.hpp"
+#include "NonceSequence.hpp"
+#include "MerkleTree.hpp"
+#include "CompressionDictionary.hpp"
+#include "CompressionController.hpp"
+
+// Per-writer settings; LoggingManager fills them from its LoggingConfig. Every field
+// defaults so unit tests can build a stand-alone Writer.
+struct WriterOptions
+{
+    size_t batchSize = 100;    // max entries per dequeue and per blob
+    size_t maxBatchBytes = 0;  // 0 = no byte bound
+    std::chrono::milliseconds maxBatchLinger{0};
+    bool useEncryption = true;
+    BatchEncoding batchEncoding = BatchEncoding::Compact;
+    int compressionLevel = 9;
+    CompressionCodec compressionCodec = CompressionCodec::Zlib;
+    std::shared_ptr<const DictionaryRegistry> dictionaries; // null = no dictionaries
+    // Picks codec and level per blob from queue pressure; null = always the above.
+    std::shared_ptr<CompressionController> compressionController;
+    size_t encryptionChunkSize = 0; // 0 = one GCM tag per blob
+    CipherSuite cipherSuite = CipherSuite::Aes256Gcm;
+
+    // null = a private (unshared) allocator
+    std::shared_ptr<SeqnumAllocator> seqnumAllocator;
+    std::string baseFilename;
+    // When set, finished blobs go to the I/O stage instead of being written inline.
+    std::shared_ptr<IoStage> ioStage;
+    // Helpers for chunked encryption of large blobs; null = chunks sealed inline.
+    std::shared_ptr<WorkerPool> cryptoPool;
+    std::shared_ptr<KeyRing> keyRing;       // null = the placeholder key
+    std::shared_ptr<NonceSequence> nonces;  // null = random IVs
+    // Fed every encrypted blob; null = no Merkle checkpoints.
+    std::shared_ptr<merkle::MerkleAccumulator> merkleLog;
+
+    WriterIdleStrategy idleStrategy = WriterIdleStrategy::Park;
+    size_t queueShard = 0;        // shard this writer drains
+    std::vector<int> cpuAffinity; // empty = unpinned
+};
 
 class Writer
 {
 public:
-    // seqnumAllocator and baseFilename default so unit tests can build a stand-alone
-    // Writer; a null allocator is replaced with a private (unshared) one.
     explicit Writer(BufferQueue &queue,
                     std::shared_ptr<SegmentedStorage> storage,
-                    size_t batchSize = 100,
-                    bool useEncryption = true,
-                    int m_compressionLevel = 9,
-                    std::shared_ptr<SeqnumAllocator> seqnumAllocator = nullptr,
-                    std::string baseFilename = "");
+                    WriterOptions options = {});
 
     ~Writer();
 
@@ -30,22 +67,46 @@ public:
     void stop();
     bool isRunning() const;
 
-    // Entries dropped by the pipeline (serialize/compress/encrypt/write threw).
+    // Entries dropped by the pipeline (serialize/compress/encrypt/write threw). In
+    // pipelined mode write failures are counted by the IoStage instead.
     size_t droppedEntries() const { return m_droppedEntries.load(std::memory_order_acquire); }
 
 private:
     void processLogEntries();
+    // One idle step after an empty dequeue; idleRounds counts consecutive empty polls.
+    // Park never blocks longer than maxWait (the next linger deadline).
+    void idle(size_t &idleRounds, std::chrono::microseconds maxWait);
 
     BufferQueue &m_queue;
     std::shared_ptr<SegmentedStorage> m_storage;
     std::shared_ptr<SeqnumAllocator> m_seqnumAllocator;
+    // When set, finished blobs go to the I/O stage instead of being written inline.
+    std::shared_ptr<IoStage> m_ioStage;
+    // Helpers for chunked encryption of large blobs; null = chunks sealed inline.
+    std::shared_ptr<WorkerPool> m_cryptoPool;
+    // Blobs are sealed with its active key at the time they are built.
+    std::shared_ptr<KeyRing> m_keyRing;
+    std::shared_ptr<NonceSequence> m_nonces; // null = random IVs
+    // Fed every encrypted blob; null = no Merkle checkpoints.
+    std::shared_ptr<merkle::MerkleAccumulator> m_merkleLog;
     std::string m_baseFilename;
     std::unique_ptr<std::thread> m_writerThread;
     std::atomic<bool> m_running{false};
     std::atomic<size_t> m_droppedEntries{0};
-    const size_t m_batchSize;
+    const size_t m_batchSize;     // max entries per dequeue and per blob
+    const size_t m_maxBatchBytes; // 0 = no byte bound
+    const std::chrono::milliseconds m_maxBatchLinger;
     const bool m_useEncryption;
+    const BatchEncoding m_batchEncoding;
     const int m_compressionLevel;
+    const CompressionCodec m_compressionCodec;
+    std::shared_ptr<const DictionaryRegistry> m_dictionaries; // null = no dictionaries
+    // Picks codec and level per blob from queue pressure; null = always the above.
+    std::shared_ptr<CompressionController> m_compressionController;
+    const WriterIdleStrategy m_idleStrategy;
+    const std::vector<int> m_cpuAffinity; // empty = unpinned
+    const size_t m_encryptionChunkSize;   // 0 = one GCM tag per blob
+    const CipherSuite m_cipherSuite;
 
     BufferQueue::ConsumerToken m_consumerToken;
 };
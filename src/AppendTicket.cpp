@@ -0,0 +1,75 @@
+#include "AppendTicket.hpp"
+
+void AppendTicket::State::complete(bool persisted)
+{
+    if (!persisted)
+    {
+        m_failed.store(true, std::memory_order_release);
+    }
+    if (m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        finish(m_failed.load(std::memory_order_acquire) ? Status::Failed : Status::Persisted);
+    }
+}
+
+void AppendTicket::State::abandon()
+{
+    finish(Status::Failed);
+}
+
+void AppendTicket::State::finish(Status status)
+{
+    Status expected = Status::Pending;
+    if (!m_status.compare_exchange_strong(expected, status, std::memory_order_acq_rel))
+    {
+        return; // already resolved (abandoned earlier)
+    }
+
+    // Pairs with the fence in waitFor: either the waiter sees the new status before
+    // sleeping, or we see its m_waiters increment and wake it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_waiters.load(std::memory_order_relaxed) == 0)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_cv.notify_all();
+}
+
+AppendTicket::Status AppendTicket::State::waitFor(std::chrono::milliseconds timeout)
+{
+    Status current = status();
+    if (current != Status::Pending)
+    {
+        return current;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_waiters.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    auto resolved = [this]()
+    { return status() != Status::Pending; };
+    if (timeout == std::chrono::milliseconds::max())
+    {
+        m_cv.wait(lock, resolved);
+    }
+    else
+    {
+        m_cv.wait_for(lock, timeout, resolved);
+    }
+
+    m_waiters.fetch_sub(1, std::memory_order_relaxed);
+    return status();
+}
+
+void AppendTicket::completeAll(std::vector<std::shared_ptr<State>> &states, bool persisted)
+{
+    for (auto &state : states)
+    {
+        state->complete(persisted);
+    }
+    states.clear();
+}
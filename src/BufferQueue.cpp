@@ -1,18 +1,80 @@
 #include "BufferQueue.hpp"
+#include "CpuAffinity.hpp"
 #include <algorithm>
 #include <thread>
 #include <iostream>
 #include <chrono>
 #include <cmath>
+#include <functional>
+#include <stdexcept>
 
-BufferQueue::BufferQueue(size_t capacity, size_t maxExplicitProducers)
+BufferQueue::BufferQueue(size_t capacity, size_t maxExplicitProducers, size_t numShards,
+                         const std::vector<std::vector<int>> &shardCpus)
 {
-    m_queue = moodycamel::ConcurrentQueue<QueueItem>(capacity, maxExplicitProducers, 0);
+    if (numShards == 0)
+    {
+        throw std::invalid_argument("BufferQueue: numShards must be > 0");
+    }
+
+    const size_t shardCapacity = std::max<size_t>(1, (capacity + numShards - 1) / numShards);
+    m_shardCapacity = shardCapacity;
+    m_shards.reserve(numShards);
+    for (size_t i = 0; i < numShards; ++i)
+    {
+        if (shardCpus.empty() || shardCpus[i % shardCpus.size()].empty())
+        {
+            m_shards.push_back(std::make_unique<Shard>(shardCapacity, maxExplicitProducers));
+            continue;
+        }
+
+        std::unique_ptr<Shard> shard;
+        std::exception_ptr error;
+        std::thread builder([&]()
+                            {
+            cpu_affinity::pinCurrentThread(shardCpus[i % shardCpus.size()]);
+            try
+            {
+                shard = std::make_unique<Shard>(shardCapacity, maxExplicitProducers);
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            } });
+        builder.join();
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+        m_shards.push_back(std::move(shard));
+    }
+}
+
+BufferQueue::ConsumerToken BufferQueue::createConsumerToken(size_t shard)
+{
+    if (shard >= m_shards.size())
+    {
+        throw std::out_of_range("BufferQueue: consumer shard out of range");
+    }
+    return ConsumerToken(shard, moodycamel::ConsumerToken(m_shards[shard]->queue));
+}
+
+size_t BufferQueue::shardFor(const std::optional<std::string> &targetFilename) const
+{
+    if (m_shards.size() == 1 || !targetFilename)
+    {
+        return 0;
+    }
+    return std::hash<std::string>{}(*targetFilename) % m_shards.size();
 }
 
-bool BufferQueue::enqueue(QueueItem item, ProducerToken &token)
+moodycamel::ProducerToken &BufferQueue::tokenFor(ProducerToken &token, size_t shard)
 {
-    return m_queue.try_enqueue(token, std::move(item));
+    auto &slot = token.m_tokens[shard];
+    if (!slot)
+    {
+        slot = std::make_unique<moodycamel::ProducerToken>(m_shards[shard]->queue);
+    }
+    return *slot;
 }
 
 bool BufferQueue::enqueueBlocking(QueueItem item, ProducerToken &token, std::chrono::milliseconds timeout)
@@ -21,12 +83,17 @@ bool BufferQueue::enqueueBlocking(QueueItem item, ProducerToken &token, std::chr
     int backoffMs = 1;
     const int maxBackoffMs = 100;
 
+    const size_t shardIndex = shardFor(item.targetFilename);
+    Shard &shard = *m_shards[shardIndex];
+    moodycamel::ProducerToken &shardToken = tokenFor(token, shardIndex);
+
     // moodycamel's try_enqueue leaves the source untouched on capacity failure, so the
     // same `item` can be re-moved on each retry.
     while (true)
     {
-        if (m_queue.try_enqueue(token, std::move(item)))
+        if (shard.queue.try_enqueue(shardToken, std::move(item)))
         {
+            notifyConsumers(shard, false);
             return true;
         }
 
@@ -53,26 +120,25 @@ bool BufferQueue::enqueueBlocking(QueueItem item, ProducerToken &token, std::chr
     }
 }
 
-bool BufferQueue::enqueueBatch(std::vector<QueueItem> items, ProducerToken &token)
+bool BufferQueue::enqueueBulkBlocking(size_t shardIndex, std::vector<QueueItem> &items, ProducerToken &token,
+                                      std::chrono::steady_clock::time_point start,
+                                      std::chrono::milliseconds timeout)
 {
-    return m_queue.try_enqueue_bulk(token, std::make_move_iterator(items.begin()), items.size());
-}
-
-bool BufferQueue::enqueueBatchBlocking(std::vector<QueueItem> items, ProducerToken &token,
-                                       std::chrono::milliseconds timeout)
-{
-    auto start = std::chrono::steady_clock::now();
     int backoffMs = 1;
     const int maxBackoffMs = 100;
 
+    Shard &shard = *m_shards[shardIndex];
+    moodycamel::ProducerToken &shardToken = tokenFor(token, shardIndex);
+
     // try_enqueue_bulk is all-or-nothing on capacity failure: no slot is constructed
     // and the iterator is not advanced, so items stay intact for retry.
     while (true)
     {
-        if (m_queue.try_enqueue_bulk(token,
-                                     std::make_move_iterator(items.begin()),
-                                     items.size()))
+        if (shard.queue.try_enqueue_bulk(shardToken,
+                                         std::make_move_iterator(items.begin()),
+                                         items.size()))
         {
+            notifyConsumers(shard, true);
             return true;
         }
 
@@ -98,9 +164,114 @@ bool BufferQueue::enqueueBatchBlocking(std::vector<QueueItem> items, ProducerTok
     }
 }
 
+bool BufferQueue::enqueueBatchBlocking(std::vector<QueueItem> items, ProducerToken &token,
+                                       std::chrono::milliseconds timeout, size_t *enqueued)
+{
+    auto start = std::chrono::steady_clock::now();
+    if (enqueued)
+    {
+        *enqueued = 0;
+    }
+
+    if (items.empty())
+    {
+        return true;
+    }
+
+    // Common case (single shard, or a batch for one target): one bulk enqueue.
+    const size_t firstShard = shardFor(items.front().targetFilename);
+    bool singleShard = true;
+    for (const auto &item : items)
+    {
+        if (shardFor(item.targetFilename) != firstShard)
+        {
+            singleShard = false;
+            break;
+        }
+    }
+    if (singleShard)
+    {
+        const size_t count = items.size();
+        if (!enqueueBulkBlocking(firstShard, items, token, start, timeout))
+        {
+            return false;
+        }
+        if (enqueued)
+        {
+            *enqueued = count;
+        }
+        return true;
+    }
+
+    std::vector<std::vector<QueueItem>> perShard(m_shards.size());
+    for (auto &item : items)
+    {
+        perShard[shardFor(item.targetFilename)].push_back(std::move(item));
+    }
+    // A share that can never fit would strand the shares queued before it.
+    for (const auto &share : perShard)
+    {
+        if (share.size() > m_shardCapacity)
+        {
+            return false;
+        }
+    }
+
+    // Queued items cannot be taken back, so once the first share is in, the others
+    // get a grace period past `timeout` to find room before the batch is split.
+    // Compared in milliseconds: milliseconds::max() does not fit in nanoseconds.
+    const auto deadline = timeout > std::chrono::milliseconds::max() - COMMITTED_SHARE_GRACE
+                              ? std::chrono::milliseconds::max()
+                              : timeout + COMMITTED_SHARE_GRACE;
+    auto pastDeadline = [&]
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start) >=
+               deadline;
+    };
+    size_t queued = 0;
+    for (size_t shard = 0; shard < perShard.size(); ++shard)
+    {
+        if (perShard[shard].empty())
+        {
+            continue;
+        }
+        const size_t count = perShard[shard].size();
+        if (queued == 0)
+        {
+            if (!enqueueBulkBlocking(shard, perShard[shard], token, start, timeout))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            while (!enqueueBulkBlocking(shard, perShard[shard], token, std::chrono::steady_clock::now(),
+                                        std::chrono::milliseconds(100)))
+            {
+                if (m_closed.load(std::memory_order_acquire) || pastDeadline())
+                {
+                    std::cerr << "BufferQueue: queued " << queued << " of " << items.size()
+                              << " batch items; shard " << shard << " has no room" << std::endl;
+                    if (enqueued)
+                    {
+                        *enqueued = queued;
+                    }
+                    return false;
+                }
+            }
+        }
+        queued += count;
+    }
+    if (enqueued)
+    {
+        *enqueued = queued;
+    }
+    return true;
+}
+
 bool BufferQueue::tryDequeue(QueueItem &item, ConsumerToken &token)
 {
-    if (m_queue.try_dequeue(token, item))
+    if (m_shards[token.m_shard]->queue.try_dequeue(token.m_token, item))
     {
         return true;
     }
@@ -112,7 +283,7 @@ size_t BufferQueue::tryDequeueBatch(std::vector<QueueItem> &items, size_t maxIte
     items.clear();
     items.resize(maxItems);
 
-    size_t dequeued = m_queue.try_dequeue_bulk(token, items.begin(), maxItems);
+    size_t dequeued = m_shards[token.m_shard]->queue.try_dequeue_bulk(token.m_token, items.begin(), maxItems);
     items.resize(dequeued);
 
     return dequeued;
@@ -123,12 +294,70 @@ bool BufferQueue::flush()
     do
     {
         std::this_thread::sleep_for(std::chrono::milliseconds(500));
-    } while (m_queue.size_approx() != 0);
+    } while (size() != 0);
 
     return true;
 }
 
 size_t BufferQueue::size() const
 {
-    return m_queue.size_approx();
-}
\ No newline at end of file
+    size_t total = 0;
+    for (const auto &shard : m_shards)
+    {
+        total += shard->queue.size_approx();
+    }
+    return total;
+}
+
+void BufferQueue::notifyConsumers(Shard &shard, bool all)
+{
+    // Pairs with the fence in waitForItems: either the parked consumer sees our item in
+    // size_approx(), or we see its parkedConsumers increment and wake it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (shard.parkedConsumers.load(std::memory_order_relaxed) == 0)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(shard.parkMutex);
+        ++shard.wakeEpoch;
+    }
+    if (all)
+    {
+        shard.parkCv.notify_all();
+    }
+    else
+    {
+        shard.parkCv.notify_one();
+    }
+}
+
+void BufferQueue::waitForItems(ConsumerToken &token, std::chrono::microseconds timeout)
+{
+    Shard &shard = *m_shards[token.m_shard];
+    std::unique_lock<std::mutex> lock(shard.parkMutex);
+    const uint64_t epoch = shard.wakeEpoch;
+    shard.parkedConsumers.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (shard.queue.size_approx() == 0)
+    {
+        shard.parkCv.wait_for(lock, timeout, [&]()
+                              { return shard.wakeEpoch != epoch; });
+    }
+
+    shard.parkedConsumers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void BufferQueue::wakeConsumers()
+{
+    for (auto &shard : m_shards)
+    {
+        {
+            std::lock_guard<std::mutex> lock(shard->parkMutex);
+            ++shard->wakeEpoch;
+        }
+        shard->parkCv.notify_all();
+    }
+}
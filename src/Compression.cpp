@@ -1,23 +1,86 @@
 #include "Compression.hpp"
+#include "ByteOrder.hpp"
+#include <algorithm>
 #include <stdexcept>
-#include <cstring>
-#include <iostream>
+#include <string>
+
+namespace
+{
+// A zlib header's CMF byte: compression method 8 (deflate) in the low nibble.
+bool isBareZlibHeader(uint8_t firstByte)
+{
+    return (firstByte & 0x0F) == Z_DEFLATED;
+}
+} // namespace
+
+bool Codec::compiledIn(CompressionCodec codec)
+{
+    switch (codec)
+    {
+    case CompressionCodec::Zlib:
+        return true;
+    case CompressionCodec::Zstd:
+#ifdef GDPR_LOGGING_HAVE_ZSTD
+        return true;
+#else
+        return false;
+#endif
+    case CompressionCodec::Lz4:
+#ifdef GDPR_LOGGING_HAVE_LZ4
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+std::unique_ptr<Codec> Codec::create(CompressionCodec codec)
+{
+    switch (codec)
+    {
+    case CompressionCodec::Zlib:
+        return makeZlibCodec();
+    case CompressionCodec::Zstd:
+        return makeZstdCodec();
+    case CompressionCodec::Lz4:
+        return makeLz4Codec();
+    }
+    throw std::runtime_error("Unknown compression codec " + std::to_string(static_cast<int>(codec)));
+}
 
 Compression::Compression() = default;
 
-Compression::~Compression()
+Compression::~Compression() = default;
+
+Codec &Compression::codec(CompressionCodec id)
 {
-    if (m_deflateLevel != 0)
+    std::unique_ptr<Codec> *slot = nullptr;
+    switch (id)
+    {
+    case CompressionCodec::Zlib:
+        slot = &m_zlib;
+        break;
+    case CompressionCodec::Zstd:
+        slot = &m_zstd;
+        break;
+    case CompressionCodec::Lz4:
+        slot = &m_lz4;
+        break;
+    }
+    if (!slot)
     {
-        deflateEnd(&m_deflateStream);
+        throw std::runtime_error("Unknown compression codec " + std::to_string(static_cast<int>(id)));
     }
-    if (m_inflateInitialized)
+    if (!*slot)
     {
-        inflateEnd(&m_inflateStream);
+        *slot = Codec::create(id);
     }
+    return **slot;
 }
 
-void Compression::compress(const uint8_t *data, size_t size, std::vector<uint8_t> &out, int level)
+void Compression::compress(const uint8_t *data, size_t size, std::vector<uint8_t> &out, int level,
+                           CompressionCodec codecId, const CompressionDictionary *dictionary)
 {
     out.clear();
 
@@ -26,145 +89,136 @@ void Compression::compress(const uint8_t *data, size_t size, std::vector<uint8_t
         return;
     }
 
-    // Level changes force a full re-init because zlib's internal buffers are sized by it;
-    // same-level calls take the cheap deflateReset path.
-    if (m_deflateLevel != level)
+    Codec &c = codec(codecId);
+    if (dictionary && !c.supportsDictionaries())
     {
-        if (m_deflateLevel != 0)
-        {
-            deflateEnd(&m_deflateStream);
-            m_deflateLevel = 0;
-        }
-        std::memset(&m_deflateStream, 0, sizeof(m_deflateStream));
-        if (deflateInit(&m_deflateStream, level) != Z_OK)
-        {
-            throw std::runtime_error("Failed to initialize zlib deflate");
-        }
-        m_deflateLevel = level;
+        dictionary = nullptr;
+    }
+    if (dictionary)
+    {
+        out.resize(1 + sizeof(uint32_t));
+        out[0] = static_cast<uint8_t>(codecId) | PAYLOAD_FLAG_DICTIONARY;
+        byteorder::writeLE32(out.data() + 1, dictionary->id);
     }
     else
     {
-        if (deflateReset(&m_deflateStream) != Z_OK)
-        {
-            deflateEnd(&m_deflateStream);
-            m_deflateLevel = 0;
-            throw std::runtime_error("Failed to reset zlib deflate");
-        }
+        out.push_back(static_cast<uint8_t>(codecId));
     }
+    c.compress(data, size, out, level, dictionary);
+}
 
-    m_deflateStream.next_in = const_cast<Bytef *>(data);
-    m_deflateStream.avail_in = size;
-
-    int ret;
-    char outbuffer[32768];
-
-    do
-    {
-        m_deflateStream.next_out = reinterpret_cast<Bytef *>(outbuffer);
-        m_deflateStream.avail_out = sizeof(outbuffer);
+std::vector<uint8_t> Compression::compress(std::vector<uint8_t> &&data, int level, CompressionCodec codecId,
+                                           const CompressionDictionary *dictionary)
+{
+    std::vector<uint8_t> out;
+    compress(data.data(), data.size(), out, level, codecId, dictionary);
+    return out;
+}
 
-        ret = deflate(&m_deflateStream, Z_FINISH);
+void Compression::setDictionaries(std::shared_ptr<const DictionaryRegistry> dictionaries)
+{
+    // The codecs cache digested dictionaries by address.
+    m_zlib.reset();
+    m_zstd.reset();
+    m_lz4.reset();
+    m_dictionaries = std::move(dictionaries);
+}
 
-        if (out.size() < m_deflateStream.total_out)
-        {
-            out.insert(out.end(),
-                       outbuffer,
-                       outbuffer + (m_deflateStream.total_out - out.size()));
-        }
-    } while (ret == Z_OK);
+void Compression::decompress(const uint8_t *data, size_t size, std::vector<uint8_t> &out,
+                             size_t maxDecompressedSize)
+{
+    out.clear();
 
-    if (ret != Z_STREAM_END)
+    if (size == 0)
     {
-        // Abandon the stream; the next call will rebuild it.
-        deflateEnd(&m_deflateStream);
-        m_deflateLevel = 0;
-        throw std::runtime_error("Exception during zlib compression");
+        return;
     }
+
+    beginDecompress();
+    decompressChunk(data, size, [&out](const uint8_t *d, size_t n)
+                    { out.insert(out.end(), d, d + n); },
+                    maxDecompressedSize);
+    endDecompress();
 }
 
-std::vector<uint8_t> Compression::compress(std::vector<uint8_t> &&data, int level)
+std::vector<uint8_t> Compression::decompress(std::vector<uint8_t> &&compressedData,
+                                             size_t maxDecompressedSize)
 {
     std::vector<uint8_t> out;
-    compress(data.data(), data.size(), out, level);
+    decompress(compressedData.data(), compressedData.size(), out, maxDecompressedSize);
     return out;
 }
 
-void Compression::decompress(const uint8_t *data, size_t size, std::vector<uint8_t> &out,
-                              size_t maxDecompressedSize)
+void Compression::beginDecompress()
 {
-    out.clear();
+    m_streamCodec = nullptr;
+    m_headerSize = 0;
+}
 
+void Compression::decompressChunk(const uint8_t *data, size_t size, const OutputSink &sink,
+                                  size_t maxDecompressedSize)
+{
     if (size == 0)
     {
         return;
     }
 
-    if (!m_inflateInitialized)
+    if (!m_streamCodec)
     {
-        std::memset(&m_inflateStream, 0, sizeof(m_inflateStream));
-        if (inflateInit(&m_inflateStream) != Z_OK)
+        if (m_headerSize == 0 && isBareZlibHeader(data[0]))
         {
-            throw std::runtime_error("Failed to initialize zlib inflate");
+            m_streamCodec = &codec(CompressionCodec::Zlib);
+            m_streamCodec->beginDecompress(nullptr);
+            m_streamCodec->decompressChunk(data, size, sink, maxDecompressedSize);
+            return;
         }
-        m_inflateInitialized = true;
-    }
-    else
-    {
-        if (inflateReset(&m_inflateStream) != Z_OK)
-        {
-            inflateEnd(&m_inflateStream);
-            m_inflateInitialized = false;
-            throw std::runtime_error("Failed to reset zlib inflate");
-        }
-    }
-
-    m_inflateStream.next_in = const_cast<Bytef *>(data);
-    m_inflateStream.avail_in = size;
 
-    int ret;
-    char outbuffer[32768];
-
-    do
-    {
-        m_inflateStream.next_out = reinterpret_cast<Bytef *>(outbuffer);
-        m_inflateStream.avail_out = sizeof(outbuffer);
-
-        ret = inflate(&m_inflateStream, Z_NO_FLUSH);
-
-        if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR)
+        // The payload header may arrive split across chunks; collect it first.
+        if (m_headerSize == 0)
         {
-            inflateEnd(&m_inflateStream);
-            m_inflateInitialized = false;
-            throw std::runtime_error("Exception during zlib decompression");
+            const uint8_t id = data[0] & static_cast<uint8_t>(~PAYLOAD_FLAG_DICTIONARY);
+            if (id != static_cast<uint8_t>(CompressionCodec::Zlib) &&
+                id != static_cast<uint8_t>(CompressionCodec::Zstd) &&
+                id != static_cast<uint8_t>(CompressionCodec::Lz4))
+            {
+                throw std::runtime_error("Unknown compression codec " + std::to_string(id));
+            }
+            m_header[m_headerSize++] = data[0];
+            ++data;
+            --size;
         }
-
-        if (m_inflateStream.total_out > maxDecompressedSize)
+        const size_t headerSize = (m_header[0] & PAYLOAD_FLAG_DICTIONARY) ? 1 + sizeof(uint32_t) : 1;
+        const size_t take = std::min(size, headerSize - m_headerSize);
+        std::copy(data, data + take, m_header + m_headerSize);
+        m_headerSize += take;
+        data += take;
+        size -= take;
+        if (m_headerSize < headerSize)
         {
-            inflateEnd(&m_inflateStream);
-            m_inflateInitialized = false;
-            throw std::runtime_error("Decompressed data exceeds maxDecompressedSize");
+            return;
         }
 
-        if (out.size() < m_inflateStream.total_out)
+        const CompressionDictionary *dictionary = nullptr;
+        if (m_header[0] & PAYLOAD_FLAG_DICTIONARY)
         {
-            out.insert(out.end(),
-                       outbuffer,
-                       outbuffer + (m_inflateStream.total_out - out.size()));
+            const uint32_t dictionaryId = byteorder::readLE32(m_header + 1);
+            dictionary = m_dictionaries ? m_dictionaries->find(dictionaryId) : nullptr;
+            if (!dictionary)
+            {
+                throw std::runtime_error("Unknown compression dictionary " + std::to_string(dictionaryId));
+            }
         }
-    } while (ret == Z_OK);
-
-    if (ret != Z_STREAM_END)
-    {
-        inflateEnd(&m_inflateStream);
-        m_inflateInitialized = false;
-        throw std::runtime_error("Exception during zlib decompression");
+        m_streamCodec = &codec(static_cast<CompressionCodec>(m_header[0] & ~PAYLOAD_FLAG_DICTIONARY));
+        m_streamCodec->beginDecompress(dictionary);
     }
+    m_streamCodec->decompressChunk(data, size, sink, maxDecompressedSize);
 }
 
-std::vector<uint8_t> Compression::decompress(std::vector<uint8_t> &&compressedData,
-                                             size_t maxDecompressedSize)
+void Compression::endDecompress()
 {
-    std::vector<uint8_t> out;
-    decompress(compressedData.data(), compressedData.size(), out, maxDecompressedSize);
-    return out;
+    if (!m_streamCodec)
+    {
+        throw std::runtime_error("Exception during decompression: truncated stream");
+    }
+    m_streamCodec->endDecompress();
 }
@@ -0,0 +1,62 @@
+#include "CompressionController.hpp"
+#include <cmath>
+#include <stdexcept>
+
+CompressionController::CompressionController(CompressionCodec codec, int level,
+                                             const AdaptiveCompressionPolicy &policy, size_t queueCapacity)
+    : m_highMark(static_cast<size_t>(std::ceil(policy.highWatermark * static_cast<double>(queueCapacity)))),
+      m_lowMark(static_cast<size_t>(std::floor(policy.lowWatermark * static_cast<double>(queueCapacity)))),
+      m_adjustInterval(policy.adjustInterval)
+{
+    if (policy.minLevel < 1 || policy.minLevel > level)
+    {
+        throw std::invalid_argument("CompressionController: minLevel must be in [1, level]");
+    }
+    if (!(policy.lowWatermark >= 0.0 && policy.lowWatermark < policy.highWatermark && policy.highWatermark <= 1.0))
+    {
+        throw std::invalid_argument("CompressionController: watermarks must satisfy 0 <= low < high <= 1");
+    }
+    if (queueCapacity == 0)
+    {
+        throw std::invalid_argument("CompressionController: queueCapacity must be > 0");
+    }
+
+    // Halving the distance to minLevel reaches it in a few steps even from zstd's
+    // high levels, and spends the first steps where the cost falls fastest.
+    m_ladder.push_back({codec, level});
+    while (level > policy.minLevel)
+    {
+        level = policy.minLevel + (level - policy.minLevel) / 2;
+        m_ladder.push_back({codec, level});
+    }
+    if (policy.pressureCodec &&
+        (*policy.pressureCodec != codec || policy.pressureLevel < policy.minLevel))
+    {
+        m_ladder.push_back({*policy.pressureCodec, policy.pressureLevel});
+    }
+
+    // The first sample may step at once.
+    m_lastChange.store((std::chrono::steady_clock::now() - m_adjustInterval).time_since_epoch().count(),
+                       std::memory_order_relaxed);
+}
+
+void CompressionController::observe(size_t queueSize, std::chrono::steady_clock::time_point now)
+{
+    const size_t step = m_step.load(std::memory_order_relaxed);
+    size_t next;
+    if (queueSize >= m_highMark && step + 1 < m_ladder.size())
+        next = step + 1;
+    else if (queueSize <= m_lowMark && step > 0)
+        next = step - 1;
+    else
+        return;
+
+    int64_t last = m_lastChange.load(std::memory_order_relaxed);
+    const int64_t nowTicks = now.time_since_epoch().count();
+    if (nowTicks - last < m_adjustInterval.count())
+        return;
+    // Whoever claims the interval moves the step; concurrent samplers back off.
+    if (!m_lastChange.compare_exchange_strong(last, nowTicks, std::memory_order_relaxed))
+        return;
+    m_step.store(next, std::memory_order_relaxed);
+}
@@ -0,0 +1,264 @@
+#include "CompressionDictionary.hpp"
+#include "ByteOrder.hpp"
+#include "Crypto.hpp"
+#include "KeyRing.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef GDPR_LOGGING_HAVE_ZSTD
+#include <zdict.h>
+#endif
+
+namespace
+{
+// Registry plaintext: [magic][u32 count] then per dictionary [u32 id][u32 size][bytes].
+constexpr uint8_t REGISTRY_MAGIC[8] = {'G', 'D', 'P', 'R', 'D', 'I', 'C', 'T'};
+
+std::runtime_error registryError(const std::string &what, const std::string &path)
+{
+    return std::runtime_error("DictionaryRegistry: failed to " + what + " " + path + ": " + std::strerror(errno));
+}
+
+void writeAll(int fd, const uint8_t *data, size_t size, const std::string &path)
+{
+    while (size > 0)
+    {
+        const ssize_t n = ::write(fd, data, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            throw registryError("write", path);
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+// The newest samples last, where a deflate window (and zstd's repcodes) reach them cheapest.
+std::vector<uint8_t> rawContentDictionary(const std::vector<std::vector<uint8_t>> &samples, size_t maxSize)
+{
+    std::vector<uint8_t> dict;
+    size_t total = 0;
+    auto first = samples.end();
+    while (first != samples.begin() && total < maxSize)
+    {
+        --first;
+        total += first->size();
+    }
+    for (auto it = first; it != samples.end(); ++it)
+        dict.insert(dict.end(), it->begin(), it->end());
+    if (dict.size() > maxSize)
+        dict.erase(dict.begin(), dict.end() - static_cast<std::ptrdiff_t>(maxSize));
+    return dict;
+}
+} // namespace
+
+std::vector<uint8_t> DictionaryRegistry::train(const std::vector<std::vector<uint8_t>> &samples, size_t maxSize)
+{
+    if (samples.empty() || maxSize == 0)
+    {
+        throw std::runtime_error("DictionaryRegistry: training needs samples and a non-zero size");
+    }
+
+#ifdef GDPR_LOGGING_HAVE_ZSTD
+    std::vector<uint8_t> flat;
+    std::vector<size_t> sizes;
+    sizes.reserve(samples.size());
+    for (const auto &sample : samples)
+    {
+        flat.insert(flat.end(), sample.begin(), sample.end());
+        sizes.push_back(sample.size());
+    }
+    std::vector<uint8_t> trainedDict(maxSize);
+    const size_t trained = ZDICT_trainFromBuffer(trainedDict.data(), trainedDict.size(), flat.data(), sizes.data(),
+                                                 static_cast<unsigned>(sizes.size()));
+    // The trainer refuses sample sets that are too small or too uniform; raw content
+    // still helps there.
+    if (!ZDICT_isError(trained))
+    {
+        trainedDict.resize(trained);
+        return trainedDict;
+    }
+#endif
+    std::vector<uint8_t> dict = rawContentDictionary(samples, maxSize);
+    if (dict.empty())
+    {
+        throw std::runtime_error("DictionaryRegistry: training samples are empty");
+    }
+    return dict;
+}
+
+uint32_t DictionaryRegistry::add(std::vector<uint8_t> bytes)
+{
+    if (bytes.empty())
+    {
+        throw std::invalid_argument("DictionaryRegistry: empty dictionary");
+    }
+    uint32_t maxId = 0;
+    for (const auto &dict : m_dictionaries)
+    {
+        if (dict->bytes == bytes)
+            return dict->id;
+        maxId = std::max(maxId, dict->id);
+    }
+    m_dictionaries.push_back(std::make_unique<CompressionDictionary>(CompressionDictionary{maxId + 1, std::move(bytes)}));
+    return maxId + 1;
+}
+
+const CompressionDictionary *DictionaryRegistry::find(uint32_t id) const
+{
+    for (const auto &dict : m_dictionaries)
+    {
+        if (dict->id == id)
+            return dict.get();
+    }
+    return nullptr;
+}
+
+void DictionaryRegistry::assign(std::string prefix, uint32_t id)
+{
+    if (!find(id))
+    {
+        throw std::invalid_argument("DictionaryRegistry: unknown dictionary " + std::to_string(id));
+    }
+    for (auto &assignment : m_assignments)
+    {
+        if (assignment.first == prefix)
+        {
+            assignment.second = id;
+            return;
+        }
+    }
+    m_assignments.emplace_back(std::move(prefix), id);
+}
+
+const CompressionDictionary *DictionaryRegistry::forTarget(const std::string &targetName) const
+{
+    const std::pair<std::string, uint32_t> *best = nullptr;
+    for (const auto &assignment : m_assignments)
+    {
+        if (targetName.compare(0, assignment.first.size(), assignment.first) == 0 &&
+            (!best || assignment.first.size() > best->first.size()))
+        {
+            best = &assignment;
+        }
+    }
+    return best ? find(best->second) : nullptr;
+}
+
+std::shared_ptr<DictionaryRegistry> DictionaryRegistry::load(const std::string &dir, const KeyRing *keys)
+{
+    auto registry = std::make_shared<DictionaryRegistry>();
+    const std::string path = (std::filesystem::path(dir) / FILENAME).string();
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        return registry;
+    }
+    std::vector<uint8_t> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    std::vector<uint8_t> plain;
+    if (keys)
+    {
+        Crypto crypto;
+        crypto.decrypt(file.data(), file.size(), *keys,
+                       reinterpret_cast<const uint8_t *>(FILENAME), std::strlen(FILENAME), plain);
+    }
+    else
+    {
+        plain = std::move(file);
+    }
+
+    auto corrupt = [&]()
+    { return std::runtime_error("DictionaryRegistry: corrupt registry " + path); };
+    if (plain.size() < sizeof(REGISTRY_MAGIC) + sizeof(uint32_t) ||
+        std::memcmp(plain.data(), REGISTRY_MAGIC, sizeof(REGISTRY_MAGIC)) != 0)
+    {
+        throw corrupt();
+    }
+    size_t pos = sizeof(REGISTRY_MAGIC);
+    const uint32_t count = byteorder::readLE32(plain.data() + pos);
+    pos += sizeof(uint32_t);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (plain.size() - pos < 2 * sizeof(uint32_t))
+            throw corrupt();
+        const uint32_t id = byteorder::readLE32(plain.data() + pos);
+        const uint32_t size = byteorder::readLE32(plain.data() + pos + sizeof(uint32_t));
+        pos += 2 * sizeof(uint32_t);
+        if (id == 0 || size == 0 || plain.size() - pos < size || registry->find(id))
+            throw corrupt();
+        registry->m_dictionaries.push_back(std::make_unique<CompressionDictionary>(CompressionDictionary{
+            id, std::vector<uint8_t>(plain.begin() + pos, plain.begin() + pos + size)}));
+        pos += size;
+    }
+    if (pos != plain.size())
+    {
+        throw corrupt();
+    }
+    return registry;
+}
+
+void DictionaryRegistry::save(const std::string &dir, const KeyRing *keys) const
+{
+    std::vector<uint8_t> plain(REGISTRY_MAGIC, REGISTRY_MAGIC + sizeof(REGISTRY_MAGIC));
+    uint8_t field[sizeof(uint32_t)];
+    byteorder::writeLE32(field, static_cast<uint32_t>(m_dictionaries.size()));
+    plain.insert(plain.end(), field, field + sizeof(field));
+    for (const auto &dict : m_dictionaries)
+    {
+        byteorder::writeLE32(field, dict->id);
+        plain.insert(plain.end(), field, field + sizeof(field));
+        byteorder::writeLE32(field, static_cast<uint32_t>(dict->bytes.size()));
+        plain.insert(plain.end(), field, field + sizeof(field));
+        plain.insert(plain.end(), dict->bytes.begin(), dict->bytes.end());
+    }
+
+    std::vector<uint8_t> sealed;
+    const std::vector<uint8_t> *file = &plain;
+    if (keys)
+    {
+        Crypto crypto;
+        crypto.encrypt(plain.data(), plain.size(), *keys, sealed, /*seqnum=*/0,
+                       reinterpret_cast<const uint8_t *>(FILENAME), std::strlen(FILENAME));
+        file = &sealed;
+    }
+
+    // Write-then-rename, so a crash leaves either the old or the new registry.
+    const std::string path = (std::filesystem::path(dir) / FILENAME).string();
+    const std::string tmp = path + ".tmp";
+    const int fd = ::open(tmp.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        throw registryError("create", tmp);
+    }
+    try
+    {
+        writeAll(fd, file->data(), file->size(), tmp);
+        if (::fsync(fd) != 0)
+            throw registryError("fsync", tmp);
+    }
+    catch (...)
+    {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+    if (::rename(tmp.c_str(), path.c_str()) != 0)
+    {
+        throw registryError("rename", tmp);
+    }
+
+    const int dirFd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd >= 0)
+    {
+        ::fsync(dirFd);
+        ::close(dirFd);
+    }
+}
@@ -0,0 +1,184 @@
+#include "CpuAffinity.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace cpu_affinity
+{
+namespace
+{
+std::vector<int> allowedCpus()
+{
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (sched_getaffinity(0, sizeof(mask), &mask) == 0)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &mask))
+                cpus.push_back(cpu);
+        }
+        return cpus;
+    }
+#endif
+    const unsigned count = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned cpu = 0; cpu < count; ++cpu)
+        cpus.push_back(static_cast<int>(cpu));
+    return cpus;
+}
+} // namespace
+
+std::vector<int> parseCpuList(const std::string &list)
+{
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ','))
+    {
+        range.erase(std::remove_if(range.begin(), range.end(), ::isspace), range.end());
+        if (range.empty())
+            continue;
+        try
+        {
+            size_t dash = range.find('-');
+            size_t used = 0;
+            int first = std::stoi(range.substr(0, dash), &used);
+            if (used != (dash == std::string::npos ? range.size() : dash))
+                throw std::invalid_argument(range);
+            int last = first;
+            if (dash != std::string::npos)
+            {
+                const std::string tail = range.substr(dash + 1);
+                last = std::stoi(tail, &used);
+                if (used != tail.size())
+                    throw std::invalid_argument(range);
+            }
+            if (first < 0 || last < first)
+                throw std::invalid_argument(range);
+            for (int cpu = first; cpu <= last; ++cpu)
+                cpus.push_back(cpu);
+        }
+        catch (const std::exception &)
+        {
+            throw std::invalid_argument("cpu_affinity: malformed cpu list \"" + list + "\"");
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+std::vector<std::vector<int>> nodes()
+{
+    const std::vector<int> allowed = allowedCpus();
+    std::vector<std::vector<int>> result;
+
+    const std::filesystem::path nodeRoot("/sys/devices/system/node");
+    std::error_code ec;
+    std::vector<std::filesystem::path> nodeDirs;
+    for (const auto &entry : std::filesystem::directory_iterator(nodeRoot, ec))
+    {
+        const std::string name = entry.path().filename().string();
+        if (name.rfind("node", 0) == 0 && name.size() > 4 &&
+            std::all_of(name.begin() + 4, name.end(), ::isdigit))
+        {
+            nodeDirs.push_back(entry.path());
+        }
+    }
+    std::sort(nodeDirs.begin(), nodeDirs.end(), [](const auto &a, const auto &b)
+              { return std::stoi(a.filename().string().substr(4)) < std::stoi(b.filename().string().substr(4)); });
+
+    for (const auto &dir : nodeDirs)
+    {
+        std::ifstream in(dir / "cpulist");
+        std::string line;
+        if (!std::getline(in, line))
+            continue;
+        std::vector<int> cpus;
+        try
+        {
+            cpus = parseCpuList(line);
+        }
+        catch (const std::invalid_argument &)
+        {
+            continue;
+        }
+        cpus.erase(std::remove_if(cpus.begin(), cpus.end(), [&](int cpu)
+                                  { return !std::binary_search(allowed.begin(), allowed.end(), cpu); }),
+                   cpus.end());
+        if (!cpus.empty())
+            result.push_back(std::move(cpus));
+    }
+
+    if (result.empty())
+        result.push_back(allowed);
+    return result;
+}
+
+std::vector<std::vector<int>> planWriterCpus(WriterPlacement placement,
+                                             const std::string &cpuList,
+                                             size_t numWriters,
+                                             const std::vector<std::vector<int>> &nodeCpus)
+{
+    std::vector<std::vector<int>> plan(numWriters);
+    switch (placement)
+    {
+    case WriterPlacement::Unpinned:
+        break;
+    case WriterPlacement::CpuList:
+    {
+        const std::vector<int> cpus = parseCpuList(cpuList);
+        if (cpus.empty())
+            throw std::invalid_argument("cpu_affinity: writerCpuList is empty");
+        for (size_t i = 0; i < numWriters; ++i)
+            plan[i] = {cpus[i % cpus.size()]};
+        break;
+    }
+    case WriterPlacement::SpreadNodes:
+        if (nodeCpus.empty())
+            break;
+        for (size_t i = 0; i < numWriters; ++i)
+            plan[i] = nodeCpus[i % nodeCpus.size()];
+        break;
+    case WriterPlacement::CompactNodes:
+    {
+        std::vector<int> ordered;
+        for (const auto &node : nodeCpus)
+            ordered.insert(ordered.end(), node.begin(), node.end());
+        if (ordered.empty())
+            break;
+        for (size_t i = 0; i < numWriters; ++i)
+            plan[i] = {ordered[i % ordered.size()]};
+        break;
+    }
+    }
+    return plan;
+}
+
+bool pinCurrentThread(const std::vector<int> &cpus)
+{
+    if (cpus.empty())
+        return false;
+#ifdef __linux__
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (int cpu : cpus)
+    {
+        if (cpu >= 0 && cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &mask);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) == 0;
+#else
+    return false;
+#endif
+}
+} // namespace cpu_affinity
@@ -1,38 +1,286 @@
 #include "Crypto.hpp"
 #include "ByteOrder.hpp"
+#include "KeyRing.hpp"
+#include "NonceSequence.hpp"
+#include "WorkerPool.hpp"
 #include <openssl/evp.h>
 #include <openssl/rand.h>
 #include <openssl/err.h>
+#include <openssl/objects.h>
+#include <algorithm>
+#include <limits>
 #include <stdexcept>
 #include <cstring>
+#include <string>
 
-Crypto::Crypto()
+namespace
 {
-    OpenSSL_add_all_algorithms();
-    m_encryptCtx = EVP_CIPHER_CTX_new();
-    if (!m_encryptCtx)
+// Chunks run on whichever thread picks them up, so each thread keeps its own context.
+EVP_CIPHER_CTX *threadCipherCtx()
+{
+    struct Holder
     {
-        throw std::runtime_error("Failed to create encryption context");
+        EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+        ~Holder() { EVP_CIPHER_CTX_free(ctx); }
+    };
+    thread_local Holder holder;
+    if (!holder.ctx)
+    {
+        throw std::runtime_error("Failed to create cipher context");
     }
+    return holder.ctx;
+}
 
-    m_decryptCtx = EVP_CIPHER_CTX_new();
-    if (!m_decryptCtx)
+// Chunk i uses the blob IV with its last four bytes XORed with i.
+void chunkIv(const uint8_t *baseIv, uint32_t index, uint8_t *iv)
+{
+    std::memcpy(iv, baseIv, Crypto::GCM_IV_SIZE);
+    const size_t counterOffset = Crypto::GCM_IV_SIZE - sizeof(uint32_t);
+    byteorder::writeLE32(iv + counterOffset, byteorder::readLE32(iv + counterOffset) ^ index);
+}
+
+// Per-chunk AAD suffix of an extended blob: [u32 index], plus a final-chunk byte
+// (STREAM-style) from format version 2 on.
+struct ChunkAad
+{
+    uint8_t bytes[sizeof(uint32_t) + 1];
+    size_t size;
+};
+
+ChunkAad chunkAad(uint8_t version, uint32_t index, bool last)
+{
+    ChunkAad aad{};
+    byteorder::writeLE32(aad.bytes, index);
+    aad.size = sizeof(uint32_t);
+    if (version >= 2)
     {
-        EVP_CIPHER_CTX_free(m_encryptCtx);
-        throw std::runtime_error("Failed to create decryption context");
+        aad.bytes[aad.size++] = last ? 1 : 0;
     }
+    return aad;
 }
 
-Crypto::~Crypto()
+// Blob AAD: [u64 seqnum][u16 nameLen][name], then (extended blobs) the header. Fed
+// to the cipher piece by piece, which yields the same MAC as one contiguous buffer,
+// so building it needs no allocation however long the target name is.
+struct BlobAad
 {
-    if (m_encryptCtx)
+    uint8_t prefix[Crypto::SEQNUM_SIZE + sizeof(uint16_t)];
+    const uint8_t *targetName;
+    size_t targetNameLen;
+    const uint8_t *header = nullptr;
+    size_t headerSize = 0;
+};
+
+BlobAad blobAad(uint64_t seqnum, const uint8_t *targetName, size_t targetNameLen)
+{
+    if (targetNameLen > 0xFFFFu)
     {
-        EVP_CIPHER_CTX_free(m_encryptCtx);
+        throw std::runtime_error("Target name too long for AAD (max 65535 bytes)");
     }
-    if (m_decryptCtx)
+    BlobAad aad;
+    byteorder::writeLE64(aad.prefix, seqnum);
+    byteorder::writeLE16(aad.prefix + Crypto::SEQNUM_SIZE, static_cast<uint16_t>(targetNameLen));
+    aad.targetName = targetName;
+    aad.targetNameLen = targetNameLen;
+    return aad;
+}
+
+// Works for either direction: the context was initialized for one already.
+bool feedAad(EVP_CIPHER_CTX *ctx, const BlobAad &aad, const ChunkAad *suffix)
+{
+    int aadOut = 0;
+    auto update = [&](const uint8_t *data, size_t size)
+    { return size == 0 || EVP_CipherUpdate(ctx, nullptr, &aadOut, data, static_cast<int>(size)) == 1; };
+    return update(aad.prefix, sizeof(aad.prefix)) &&
+           update(aad.targetName, aad.targetNameLen) &&
+           update(aad.header, aad.headerSize) &&
+           (!suffix || update(suffix->bytes, suffix->size));
+}
+
+// Fields of an extended blob header, checked against the body size it claims.
+struct ExtendedHeader
+{
+    uint8_t version;
+    uint8_t flags;
+    size_t size; // header bytes, including the optional key ID
+    size_t chunkSize;
+    size_t chunkCount;
+    uint32_t keyId;
+    CipherSuite suite;
+    size_t plaintextLen;
+};
+
+// Bytes of optional fields after the fixed extended header.
+size_t flaggedFieldsSize(uint8_t flags)
+{
+    return ((flags & Crypto::BLOB_FLAG_KEY_ID) ? sizeof(uint32_t) : 0) +
+           ((flags & Crypto::BLOB_FLAG_CIPHER_SUITE) ? sizeof(uint8_t) : 0);
+}
+
+// Reads at most MAX_EXTENDED_HEADER_SIZE bytes of `header`, and never past bodySize.
+ExtendedHeader parseExtendedHeader(const uint8_t *header, size_t bodySize)
+{
+    if (bodySize < Crypto::EXTENDED_HEADER_SIZE)
+    {
+        throw std::runtime_error("Encrypted data too small - missing complete data");
+    }
+
+    ExtendedHeader h{};
+    h.version = header[0];
+    h.flags = header[1];
+    if (h.version < 1 || h.version > Crypto::BLOB_FORMAT_VERSION ||
+        (h.flags & ~(Crypto::BLOB_FLAG_KEY_ID | Crypto::BLOB_FLAG_CIPHER_SUITE)) != 0)
     {
-        EVP_CIPHER_CTX_free(m_decryptCtx);
+        throw std::runtime_error("Unsupported blob format version");
     }
+
+    h.size = Crypto::EXTENDED_HEADER_SIZE + flaggedFieldsSize(h.flags);
+    if (bodySize < h.size)
+    {
+        throw std::runtime_error("Malformed extended blob header");
+    }
+    const uint8_t *field = header + Crypto::EXTENDED_HEADER_SIZE;
+    h.keyId = KeyRing::DEFAULT_KEY_ID;
+    if (h.flags & Crypto::BLOB_FLAG_KEY_ID)
+    {
+        h.keyId = byteorder::readLE32(field);
+        field += sizeof(uint32_t);
+    }
+    h.suite = CipherSuite::Aes256Gcm;
+    if (h.flags & Crypto::BLOB_FLAG_CIPHER_SUITE)
+    {
+        if (*field > static_cast<uint8_t>(CipherSuite::ChaCha20Poly1305))
+        {
+            throw std::runtime_error("Unsupported cipher suite " + std::to_string(*field));
+        }
+        h.suite = static_cast<CipherSuite>(*field);
+    }
+
+    h.chunkSize = byteorder::readLE32(header + 2);
+    h.chunkCount = byteorder::readLE32(header + 6);
+    // The header is authenticated, but it also sizes the output buffer, so reject
+    // inconsistent values before trusting them. Writers never use chunks larger
+    // than an int (see seal).
+    const size_t tagBytes = h.chunkCount * Crypto::GCM_TAG_SIZE;
+    if (h.chunkSize == 0 || h.chunkCount == 0 ||
+        h.chunkSize > static_cast<size_t>(std::numeric_limits<int>::max()) ||
+        bodySize + Crypto::GCM_TAG_SIZE < h.size + tagBytes)
+    {
+        throw std::runtime_error("Malformed extended blob header");
+    }
+    h.plaintextLen = bodySize + Crypto::GCM_TAG_SIZE - h.size - tagBytes;
+    if (h.plaintextLen <= (h.chunkCount - 1) * h.chunkSize || h.plaintextLen > h.chunkCount * h.chunkSize)
+    {
+        throw std::runtime_error("Malformed extended blob header");
+    }
+    return h;
+}
+
+// `ctx` already holds the key; only the IV is set here. `suffix` (chunked blobs
+// only) is appended to the AAD.
+void sealChunk(EVP_CIPHER_CTX *ctx, const uint8_t *iv,
+               const BlobAad &aad, const ChunkAad *suffix,
+               const uint8_t *in, size_t len, uint8_t *out, uint8_t *tag)
+{
+    if (EVP_EncryptInit_ex(ctx, nullptr, nullptr, nullptr, iv) != 1)
+    {
+        throw std::runtime_error("Failed to initialize encryption");
+    }
+
+    if (!feedAad(ctx, aad, suffix))
+    {
+        throw std::runtime_error("Failed to feed AAD into encryption");
+    }
+
+    int encryptedLen = 0;
+    if (EVP_EncryptUpdate(ctx, out, &encryptedLen, in, static_cast<int>(len)) != 1)
+    {
+        throw std::runtime_error("Failed during encryption update");
+    }
+
+    int finalLen = 0;
+    if (EVP_EncryptFinal_ex(ctx, out + encryptedLen, &finalLen) != 1)
+    {
+        throw std::runtime_error("Failed to finalize encryption");
+    }
+
+    if (static_cast<size_t>(encryptedLen + finalLen) != len)
+    {
+        throw std::runtime_error("Unexpected encryption output size");
+    }
+
+    if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, Crypto::GCM_TAG_SIZE, tag) != 1)
+    {
+        throw std::runtime_error("Failed to get authentication tag");
+    }
+}
+
+void openChunk(EVP_CIPHER_CTX *ctx, const uint8_t *iv,
+               const BlobAad &aad, const ChunkAad *suffix,
+               const uint8_t *in, size_t len, const uint8_t *tag, uint8_t *out)
+{
+    if (EVP_DecryptInit_ex(ctx, nullptr, nullptr, nullptr, iv) != 1)
+    {
+        throw std::runtime_error("Failed to initialize decryption");
+    }
+
+    // EVP_CIPHER_CTX_ctrl takes a non-const pointer, so we copy the tag out.
+    uint8_t tagCopy[Crypto::GCM_TAG_SIZE];
+    std::memcpy(tagCopy, tag, sizeof(tagCopy));
+    if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, Crypto::GCM_TAG_SIZE, tagCopy) != 1)
+    {
+        throw std::runtime_error("Failed to set authentication tag");
+    }
+
+    if (!feedAad(ctx, aad, suffix))
+    {
+        throw std::runtime_error("Failed to feed AAD into decryption");
+    }
+
+    int decryptedLen = 0;
+    if (EVP_DecryptUpdate(ctx, out, &decryptedLen, in, static_cast<int>(len)) != 1)
+    {
+        throw std::runtime_error("Failed during decryption update");
+    }
+
+    int finalLen = 0;
+    if (EVP_DecryptFinal_ex(ctx, out + decryptedLen, &finalLen) != 1)
+    {
+        const std::string cipher = EVP_CIPHER_CTX_nid(ctx) == NID_chacha20_poly1305 ? "ChaCha20-Poly1305" : "AES-GCM";
+        if (suffix)
+        {
+            throw TamperDetectedException(cipher + " authentication tag verification failed for chunk " +
+                                          std::to_string(byteorder::readLE32(suffix->bytes)));
+        }
+        throw TamperDetectedException(cipher + " authentication tag verification failed");
+    }
+}
+
+// Raw keys have no cached context: key the calling thread's context on every use.
+EVP_CIPHER_CTX *keyedContext(const std::vector<uint8_t> &key, CipherSuite suite, bool forEncrypt)
+{
+    EVP_CIPHER_CTX *ctx = threadCipherCtx();
+    EVP_CIPHER_CTX_reset(ctx);
+    const EVP_CIPHER *cipher = Crypto::cipherFor(suite);
+    const int rc = forEncrypt
+                       ? EVP_EncryptInit_ex(ctx, cipher, nullptr, key.data(), nullptr)
+                       : EVP_DecryptInit_ex(ctx, cipher, nullptr, key.data(), nullptr);
+    if (rc != 1)
+    {
+        throw std::runtime_error(forEncrypt ? "Failed to initialize encryption"
+                                            : "Failed to initialize decryption");
+    }
+    return ctx;
+}
+} // namespace
+
+Crypto::Crypto()
+{
+    OpenSSL_add_all_algorithms();
+}
+
+Crypto::~Crypto()
+{
     EVP_cleanup();
 }
 
@@ -40,19 +288,32 @@ std::vector<uint8_t> Crypto::buildAad(uint64_t seqnum,
                                       const uint8_t *targetName,
                                       size_t targetNameLen)
 {
-    if (targetNameLen > 0xFFFFu)
+    const BlobAad parts = blobAad(seqnum, targetName, targetNameLen);
+    std::vector<uint8_t> aad(sizeof(parts.prefix) + targetNameLen);
+    std::memcpy(aad.data(), parts.prefix, sizeof(parts.prefix));
+    if (targetNameLen > 0)
     {
-        throw std::runtime_error("Target name too long for AAD (max 65535 bytes)");
+        std::memcpy(aad.data() + sizeof(parts.prefix), targetName, targetNameLen);
     }
+    return aad;
+}
 
-    std::vector<uint8_t> aad(SEQNUM_SIZE + sizeof(uint16_t) + targetNameLen);
-    byteorder::writeLE64(aad.data(), seqnum);
-    byteorder::writeLE16(aad.data() + SEQNUM_SIZE, static_cast<uint16_t>(targetNameLen));
-    if (targetNameLen > 0)
+const EVP_CIPHER *Crypto::cipherFor(CipherSuite suite)
+{
+    switch (suite)
     {
-        std::memcpy(aad.data() + SEQNUM_SIZE + sizeof(uint16_t), targetName, targetNameLen);
+    case CipherSuite::Aes256Gcm:
+        return EVP_aes_256_gcm();
+    case CipherSuite::ChaCha20Poly1305:
+        return EVP_chacha20_poly1305();
     }
-    return aad;
+    throw std::invalid_argument("Unknown cipher suite");
+}
+
+size_t Crypto::blobSize(uint32_t lengthField)
+{
+    return sizeof(uint32_t) + SEQNUM_SIZE + GCM_IV_SIZE +
+           (lengthField & ~EXTENDED_BLOB_FLAG) + GCM_TAG_SIZE;
 }
 
 bool Crypto::peekSeqnum(const uint8_t *encryptedData, size_t encryptedLen, uint64_t &outSeqnum)
@@ -70,77 +331,156 @@ bool Crypto::peekSeqnum(const std::vector<uint8_t> &encryptedData, uint64_t &out
 
 // Wire format (little-endian):
 //   [u32 dataSize][u64 seqnum][iv GCM_IV_SIZE][ciphertext dataSize][tag GCM_TAG_SIZE]
-// Fresh random IV per call; seqnum + target name are bound into the GCM AAD.
-void Crypto::encrypt(const uint8_t *plaintext, size_t plaintextLen,
-                     const std::vector<uint8_t> &key,
-                     std::vector<uint8_t> &out,
-                     uint64_t seqnum,
-                     const uint8_t *targetName, size_t targetNameLen)
+// Fresh IV per call (random, or from the NonceSequence if one is set); seqnum +
+// target name are bound into the GCM AAD.
+//
+// Extended format, used for chunked blobs, keys other than DEFAULT_KEY_ID and
+// suites other than AES-256-GCM; same outer framing:
+//   [u32 bodySize | EXTENDED_BLOB_FLAG][u64 seqnum][iv GCM_IV_SIZE]
+//   [u8 version][u8 flags][u32 chunkSize][u32 chunkCount]([u32 keyId])([u8 suite])
+//   [ciphertext 0][tag 0] ... [ciphertext n-1][tag n-1]
+// bodySize covers everything between the IV and the last tag, so the final tag
+// sits where a single-tag blob keeps its tag. Chunk i is sealed under the blob AAD,
+// the header, [u32 i] and (version 2) a last-chunk byte, so each chunk can be
+// verified and released on its own while the reader still detects truncation.
+void Crypto::seal(const uint8_t *plaintext, size_t plaintextLen,
+                  const ContextFor &contextFor, uint32_t keyId, CipherSuite suite,
+                  std::vector<uint8_t> &out,
+                  uint64_t seqnum,
+                  const uint8_t *targetName, size_t targetNameLen,
+                  size_t chunkSize, WorkerPool *pool, NonceSequence *nonces)
 {
-    out.clear();
-
-    if (plaintextLen == 0)
-        return;
-    if (key.size() != KEY_SIZE)
-        throw std::runtime_error("Invalid key size");
-
-    const size_t sizeFieldSize = sizeof(uint32_t);
-    const size_t ciphertextSize = plaintextLen;
-    const size_t totalSize = sizeFieldSize + SEQNUM_SIZE + GCM_IV_SIZE + ciphertextSize + GCM_TAG_SIZE;
-
-    out.resize(totalSize);
-
-    byteorder::writeLE32(out.data(), static_cast<uint32_t>(ciphertextSize));
-    byteorder::writeLE64(out.data() + sizeFieldSize, seqnum);
+    const size_t prefixSize = sizeof(uint32_t) + SEQNUM_SIZE + GCM_IV_SIZE;
+    const bool chunked = chunkSize > 0 && plaintextLen > chunkSize;
+    const uint8_t flags = (keyId != KeyRing::DEFAULT_KEY_ID ? BLOB_FLAG_KEY_ID : 0) |
+                          (suite != CipherSuite::Aes256Gcm ? BLOB_FLAG_CIPHER_SUITE : 0);
+    const bool extended = chunked || flags != 0;
+    if (!chunked)
+    {
+        chunkSize = plaintextLen;
+    }
 
-    uint8_t *ivPtr = out.data() + sizeFieldSize + SEQNUM_SIZE;
-    if (RAND_bytes(ivPtr, GCM_IV_SIZE) != 1)
+    const size_t chunkCount = (plaintextLen + chunkSize - 1) / chunkSize;
+    const size_t headerSize = extended ? EXTENDED_HEADER_SIZE + flaggedFieldsSize(flags) : 0;
+    const size_t bodySize = headerSize + plaintextLen + (chunkCount - 1) * GCM_TAG_SIZE;
+    if (chunkSize > static_cast<size_t>(std::numeric_limits<int>::max()) || bodySize >= EXTENDED_BLOB_FLAG)
     {
-        throw std::runtime_error("Failed to generate random IV");
+        throw std::runtime_error("Plaintext too large for one blob");
     }
 
-    EVP_CIPHER_CTX_reset(m_encryptCtx);
+    out.resize(prefixSize + bodySize + GCM_TAG_SIZE);
+    byteorder::writeLE32(out.data(), static_cast<uint32_t>(bodySize) | (extended ? EXTENDED_BLOB_FLAG : 0));
+    byteorder::writeLE64(out.data() + sizeof(uint32_t), seqnum);
 
-    if (EVP_EncryptInit_ex(m_encryptCtx, EVP_aes_256_gcm(), nullptr, key.data(), ivPtr) != 1)
+    uint8_t *ivPtr = out.data() + sizeof(uint32_t) + SEQNUM_SIZE;
+    if (nonces)
     {
-        throw std::runtime_error("Failed to initialize encryption");
+        nonces->next(ivPtr);
     }
-
-    const auto aad = buildAad(seqnum, targetName, targetNameLen);
-    int aadOut = 0;
-    if (EVP_EncryptUpdate(m_encryptCtx, nullptr, &aadOut, aad.data(),
-                          static_cast<int>(aad.size())) != 1)
+    else if (RAND_bytes(ivPtr, GCM_IV_SIZE) != 1)
     {
-        throw std::runtime_error("Failed to feed AAD into encryption");
+        throw std::runtime_error("Failed to generate random IV");
     }
 
-    const size_t ciphertextOffset = sizeFieldSize + SEQNUM_SIZE + GCM_IV_SIZE;
+    BlobAad aad = blobAad(seqnum, targetName, targetNameLen);
 
-    int encryptedLen = 0;
-    if (EVP_EncryptUpdate(m_encryptCtx, out.data() + ciphertextOffset, &encryptedLen,
-                          plaintext, plaintextLen) != 1)
+    if (!extended)
     {
-        throw std::runtime_error("Failed during encryption update");
+        uint8_t *ciphertext = out.data() + prefixSize;
+        sealChunk(contextFor(keyId, suite, true), ivPtr, aad, nullptr,
+                  plaintext, plaintextLen, ciphertext, ciphertext + plaintextLen);
+        return;
     }
 
-    int finalLen = 0;
-    if (EVP_EncryptFinal_ex(m_encryptCtx, out.data() + ciphertextOffset + encryptedLen, &finalLen) != 1)
+    uint8_t *header = out.data() + prefixSize;
+    header[0] = BLOB_FORMAT_VERSION;
+    header[1] = flags;
+    byteorder::writeLE32(header + 2, static_cast<uint32_t>(chunkSize));
+    byteorder::writeLE32(header + 6, static_cast<uint32_t>(chunkCount));
+    uint8_t *field = header + EXTENDED_HEADER_SIZE;
+    if (flags & BLOB_FLAG_KEY_ID)
     {
-        throw std::runtime_error("Failed to finalize encryption");
+        byteorder::writeLE32(field, keyId);
+        field += sizeof(uint32_t);
     }
-
-    if (encryptedLen + finalLen != static_cast<int>(plaintextLen))
+    if (flags & BLOB_FLAG_CIPHER_SUITE)
     {
-        throw std::runtime_error("Unexpected encryption output size");
+        *field = static_cast<uint8_t>(suite);
     }
+    aad.header = header;
+    aad.headerSize = headerSize;
 
-    if (EVP_CIPHER_CTX_ctrl(m_encryptCtx, EVP_CTRL_GCM_GET_TAG, GCM_TAG_SIZE,
-                            out.data() + ciphertextOffset + ciphertextSize) != 1)
+    uint8_t *chunksStart = header + headerSize;
+    auto sealOne = [&](size_t i)
     {
-        throw std::runtime_error("Failed to get authentication tag");
+        const size_t offset = i * chunkSize;
+        const size_t len = std::min(chunkSize, plaintextLen - offset);
+        uint8_t *dst = chunksStart + i * (chunkSize + GCM_TAG_SIZE);
+        uint8_t iv[GCM_IV_SIZE];
+        chunkIv(ivPtr, static_cast<uint32_t>(i), iv);
+        const ChunkAad suffix = chunkAad(BLOB_FORMAT_VERSION, static_cast<uint32_t>(i), i + 1 == chunkCount);
+        sealChunk(contextFor(keyId, suite, true), iv, aad, &suffix, plaintext + offset, len, dst, dst + len);
+    };
+
+    if (pool && chunkCount > 1)
+    {
+        pool->parallelFor(chunkCount, sealOne);
+    }
+    else
+    {
+        for (size_t i = 0; i < chunkCount; ++i)
+            sealOne(i);
     }
 }
 
+void Crypto::encrypt(const uint8_t *plaintext, size_t plaintextLen,
+                     const std::vector<uint8_t> &key,
+                     std::vector<uint8_t> &out,
+                     uint64_t seqnum,
+                     const uint8_t *targetName, size_t targetNameLen,
+                     size_t chunkSize, WorkerPool *pool)
+{
+    out.clear();
+
+    if (plaintextLen == 0)
+        return;
+    if (key.size() != KEY_SIZE)
+        throw std::runtime_error("Invalid key size");
+
+    seal(plaintext, plaintextLen,
+         [&key](uint32_t, CipherSuite suite, bool forEncrypt)
+         { return keyedContext(key, suite, forEncrypt); },
+         KeyRing::DEFAULT_KEY_ID, CipherSuite::Aes256Gcm, out, seqnum, targetName, targetNameLen, chunkSize, pool, m_nonces.get());
+}
+
+void Crypto::encrypt(const uint8_t *plaintext, size_t plaintextLen,
+                     const KeyRing &keys,
+                     std::vector<uint8_t> &out,
+                     uint64_t seqnum,
+                     const uint8_t *targetName, size_t targetNameLen,
+                     size_t chunkSize, WorkerPool *pool, CipherSuite suite)
+{
+    out.clear();
+
+    if (plaintextLen == 0)
+        return;
+
+    seal(plaintext, plaintextLen,
+         [&keys](uint32_t keyId, CipherSuite s, bool forEncrypt)
+         { return forEncrypt ? keys.encryptContext(keyId, s) : keys.decryptContext(keyId, s); },
+         keys.activeKeyId(), suite, out, seqnum, targetName, targetNameLen, chunkSize, pool, m_nonces.get());
+}
+
+void Crypto::encrypt(const uint8_t *plaintext, size_t plaintextLen,
+                     const std::vector<uint8_t> &key,
+                     std::vector<uint8_t> &out,
+                     uint64_t seqnum,
+                     const uint8_t *targetName, size_t targetNameLen)
+{
+    encrypt(plaintext, plaintextLen, key, out, seqnum, targetName, targetNameLen,
+            /*chunkSize=*/0, nullptr);
+}
+
 void Crypto::encrypt(const uint8_t *plaintext, size_t plaintextLen,
                      const std::vector<uint8_t> &key,
                      std::vector<uint8_t> &out)
@@ -156,91 +496,148 @@ std::vector<uint8_t> Crypto::encrypt(std::vector<uint8_t> &&plaintext,
     return out;
 }
 
-std::vector<uint8_t> Crypto::decrypt(const std::vector<uint8_t> &encryptedData,
-                                     const std::vector<uint8_t> &key,
-                                     const uint8_t *targetName, size_t targetNameLen)
+void Crypto::open(const uint8_t *encryptedData, size_t encryptedLen,
+                  const ContextFor &contextFor,
+                  const uint8_t *targetName, size_t targetNameLen,
+                  std::vector<uint8_t> &out, WorkerPool *pool)
 {
-    if (encryptedData.empty())
-    {
-        return std::vector<uint8_t>();
-    }
-
-    if (key.size() != KEY_SIZE)
-    {
-        throw std::runtime_error("Invalid key size. Expected 32 bytes for AES-256");
-    }
-
     const size_t headerSize = sizeof(uint32_t) + SEQNUM_SIZE + GCM_IV_SIZE;
-    if (encryptedData.size() < headerSize)
+    if (encryptedLen < headerSize)
     {
         throw std::runtime_error("Encrypted data too small - missing header");
     }
 
-    uint32_t dataSize = byteorder::readLE32(encryptedData.data());
+    uint32_t dataSize = byteorder::readLE32(encryptedData);
+    if (dataSize & EXTENDED_BLOB_FLAG)
+    {
+        openExtended(encryptedData, encryptedLen, contextFor, targetName, targetNameLen, out, pool);
+        return;
+    }
     size_t position = sizeof(uint32_t);
 
-    uint64_t seqnum = byteorder::readLE64(encryptedData.data() + position);
+    uint64_t seqnum = byteorder::readLE64(encryptedData + position);
     position += SEQNUM_SIZE;
 
-    const uint8_t *ivPtr = encryptedData.data() + position;
+    const uint8_t *ivPtr = encryptedData + position;
     position += GCM_IV_SIZE;
 
-    if (position + dataSize > encryptedData.size())
+    if (position + dataSize > encryptedLen)
     {
         throw std::runtime_error("Encrypted data too small - missing complete data");
     }
 
-    const uint8_t *ciphertextPtr = encryptedData.data() + position;
+    const uint8_t *ciphertextPtr = encryptedData + position;
     position += dataSize;
 
-    if (position + GCM_TAG_SIZE > encryptedData.size())
+    if (position + GCM_TAG_SIZE > encryptedLen)
     {
         throw std::runtime_error("Encrypted data too small - missing authentication tag");
     }
 
-    // EVP_CIPHER_CTX_ctrl takes a non-const pointer, so we copy the tag out.
-    std::vector<uint8_t> tag(GCM_TAG_SIZE);
-    std::memcpy(tag.data(), encryptedData.data() + position, GCM_TAG_SIZE);
-
-    EVP_CIPHER_CTX_reset(m_decryptCtx);
+    const BlobAad aad = blobAad(seqnum, targetName, targetNameLen);
+    out.resize(dataSize);
+    openChunk(contextFor(KeyRing::DEFAULT_KEY_ID, CipherSuite::Aes256Gcm, false), ivPtr, aad, nullptr,
+              ciphertextPtr, dataSize, encryptedData + position, out.data());
+}
 
-    if (EVP_DecryptInit_ex(m_decryptCtx, EVP_aes_256_gcm(), nullptr, key.data(), ivPtr) != 1)
+void Crypto::openExtended(const uint8_t *encryptedData, size_t encryptedLen,
+                          const ContextFor &contextFor,
+                          const uint8_t *targetName, size_t targetNameLen,
+                          std::vector<uint8_t> &out, WorkerPool *pool)
+{
+    const size_t prefixSize = sizeof(uint32_t) + SEQNUM_SIZE + GCM_IV_SIZE;
+    const size_t bodySize = byteorder::readLE32(encryptedData) & ~EXTENDED_BLOB_FLAG;
+    if (encryptedLen < prefixSize + bodySize + GCM_TAG_SIZE)
     {
-        throw std::runtime_error("Failed to initialize decryption");
+        throw std::runtime_error("Encrypted data too small - missing complete data");
     }
 
-    if (EVP_CIPHER_CTX_ctrl(m_decryptCtx, EVP_CTRL_GCM_SET_TAG, GCM_TAG_SIZE, tag.data()) != 1)
+    const uint64_t seqnum = byteorder::readLE64(encryptedData + sizeof(uint32_t));
+    const uint8_t *ivPtr = encryptedData + sizeof(uint32_t) + SEQNUM_SIZE;
+    const uint8_t *header = encryptedData + prefixSize;
+    const ExtendedHeader h = parseExtendedHeader(header, bodySize);
+
+    BlobAad aad = blobAad(seqnum, targetName, targetNameLen);
+    aad.header = header;
+    aad.headerSize = h.size;
+
+    out.resize(h.plaintextLen);
+    const uint8_t *chunksStart = header + h.size;
+    auto openOne = [&](size_t i)
     {
-        throw std::runtime_error("Failed to set authentication tag");
+        const size_t offset = i * h.chunkSize;
+        const size_t len = std::min(h.chunkSize, h.plaintextLen - offset);
+        const uint8_t *src = chunksStart + i * (h.chunkSize + GCM_TAG_SIZE);
+        uint8_t iv[GCM_IV_SIZE];
+        chunkIv(ivPtr, static_cast<uint32_t>(i), iv);
+        const ChunkAad suffix = chunkAad(h.version, static_cast<uint32_t>(i), i + 1 == h.chunkCount);
+        openChunk(contextFor(h.keyId, h.suite, false), iv, aad, &suffix, src, len, src + len,
+                  out.data() + offset);
+    };
+
+    if (pool && h.chunkCount > 1)
+    {
+        pool->parallelFor(h.chunkCount, openOne);
     }
-
-    const auto aad = buildAad(seqnum, targetName, targetNameLen);
-    int aadOut = 0;
-    if (EVP_DecryptUpdate(m_decryptCtx, nullptr, &aadOut, aad.data(),
-                          static_cast<int>(aad.size())) != 1)
+    else
     {
-        throw std::runtime_error("Failed to feed AAD into decryption");
+        for (size_t i = 0; i < h.chunkCount; ++i)
+            openOne(i);
     }
+}
 
-    std::vector<uint8_t> decryptedData(dataSize);
-    int decryptedLen = 0;
+void Crypto::decrypt(const uint8_t *encryptedData, size_t encryptedLen,
+                     const std::vector<uint8_t> &key,
+                     const uint8_t *targetName, size_t targetNameLen,
+                     std::vector<uint8_t> &out, WorkerPool *pool)
+{
+    out.clear();
 
-    if (EVP_DecryptUpdate(m_decryptCtx, decryptedData.data(), &decryptedLen,
-                          ciphertextPtr, dataSize) != 1)
-    {
-        throw std::runtime_error("Failed during decryption update");
-    }
+    if (encryptedLen == 0)
+        return;
+    if (key.size() != KEY_SIZE)
+        throw std::runtime_error("Invalid key size. Expected 32 bytes for AES-256");
 
-    int finalLen = 0;
-    int ret = EVP_DecryptFinal_ex(m_decryptCtx, decryptedData.data() + decryptedLen, &finalLen);
+    open(encryptedData, encryptedLen,
+         [&key](uint32_t, CipherSuite suite, bool forEncrypt)
+         { return keyedContext(key, suite, forEncrypt); },
+         targetName, targetNameLen, out, pool);
+}
 
-    if (ret != 1)
-    {
-        throw TamperDetectedException("AES-GCM authentication tag verification failed");
-    }
+void Crypto::decrypt(const uint8_t *encryptedData, size_t encryptedLen,
+                     const KeyRing &keys,
+                     const uint8_t *targetName, size_t targetNameLen,
+                     std::vector<uint8_t> &out, WorkerPool *pool)
+{
+    out.clear();
+
+    if (encryptedLen == 0)
+        return;
+
+    open(encryptedData, encryptedLen,
+         [&keys](uint32_t keyId, CipherSuite suite, bool forEncrypt)
+         { return forEncrypt ? keys.encryptContext(keyId, suite) : keys.decryptContext(keyId, suite); },
+         targetName, targetNameLen, out, pool);
+}
 
-    decryptedData.resize(decryptedLen + finalLen);
-    return decryptedData;
+std::vector<uint8_t> Crypto::decrypt(const std::vector<uint8_t> &encryptedData,
+                                     const std::vector<uint8_t> &key,
+                                     const uint8_t *targetName, size_t targetNameLen,
+                                     WorkerPool *pool)
+{
+    std::vector<uint8_t> plaintext;
+    decrypt(encryptedData.data(), encryptedData.size(), key, targetName, targetNameLen, plaintext, pool);
+    return plaintext;
+}
+
+std::vector<uint8_t> Crypto::decrypt(const std::vector<uint8_t> &encryptedData,
+                                     const KeyRing &keys,
+                                     const uint8_t *targetName, size_t targetNameLen,
+                                     WorkerPool *pool)
+{
+    std::vector<uint8_t> plaintext;
+    decrypt(encryptedData.data(), encryptedData.size(), keys, targetName, targetNameLen, plaintext, pool);
+    return plaintext;
 }
 
 std::vector<uint8_t> Crypto::decrypt(const std::vector<uint8_t> &encryptedData,
@@ -248,3 +645,95 @@ std::vector<uint8_t> Crypto::decrypt(const std::vector<uint8_t> &encryptedData,
 {
     return decrypt(encryptedData, key, nullptr, 0);
 }
+
+void Crypto::decryptStream(std::istream &in, const KeyRing &keys,
+                           const uint8_t *targetName, size_t targetNameLen,
+                           const PlaintextSink &sink, WorkerPool *pool)
+{
+    auto readExact = [&in](uint8_t *dst, size_t size)
+    {
+        if (!in.read(reinterpret_cast<char *>(dst), static_cast<std::streamsize>(size)))
+        {
+            throw std::runtime_error("Encrypted data too small - unexpected end of stream");
+        }
+    };
+    const ContextFor contextFor = [&keys](uint32_t keyId, CipherSuite suite, bool forEncrypt)
+    { return forEncrypt ? keys.encryptContext(keyId, suite) : keys.decryptContext(keyId, suite); };
+
+    const size_t prefixSize = sizeof(uint32_t) + SEQNUM_SIZE + GCM_IV_SIZE;
+    uint8_t prefix[prefixSize];
+    readExact(prefix, prefixSize);
+
+    const uint32_t lengthField = byteorder::readLE32(prefix);
+    const size_t bodySize = lengthField & ~EXTENDED_BLOB_FLAG;
+    if (!(lengthField & EXTENDED_BLOB_FLAG))
+    {
+        m_streamIn.resize(prefixSize + bodySize + GCM_TAG_SIZE);
+        std::memcpy(m_streamIn.data(), prefix, prefixSize);
+        readExact(m_streamIn.data() + prefixSize, bodySize + GCM_TAG_SIZE);
+        open(m_streamIn.data(), m_streamIn.size(), contextFor, targetName, targetNameLen, m_streamOut, nullptr);
+        sink(m_streamOut.data(), m_streamOut.size());
+        return;
+    }
+
+    const uint64_t seqnum = byteorder::readLE64(prefix + sizeof(uint32_t));
+    const uint8_t *ivPtr = prefix + sizeof(uint32_t) + SEQNUM_SIZE;
+
+    uint8_t header[MAX_EXTENDED_HEADER_SIZE];
+    readExact(header, std::min(bodySize, EXTENDED_HEADER_SIZE));
+    if (bodySize >= EXTENDED_HEADER_SIZE)
+    {
+        readExact(header + EXTENDED_HEADER_SIZE,
+                  std::min(bodySize - EXTENDED_HEADER_SIZE, flaggedFieldsSize(header[1])));
+    }
+    const ExtendedHeader h = parseExtendedHeader(header, bodySize);
+
+    BlobAad aad = blobAad(seqnum, targetName, targetNameLen);
+    aad.header = header;
+    aad.headerSize = h.size;
+
+    // Until the first tag checks out, chunkSize is only bounded by parseExtendedHeader;
+    // no chunk is longer than the plaintext, whose bytes really are in the file.
+    const size_t window = std::min(h.chunkCount, pool ? pool->size() + 1 : 1);
+    const size_t outStride = std::min(h.chunkSize, h.plaintextLen);
+    const size_t inStride = outStride + GCM_TAG_SIZE;
+    m_streamIn.resize(window * inStride);
+    m_streamOut.resize(window * outStride);
+
+    auto chunkLen = [&](size_t i)
+    { return std::min(h.chunkSize, h.plaintextLen - i * h.chunkSize); };
+
+    for (size_t first = 0; first < h.chunkCount; first += window)
+    {
+        const size_t count = std::min(window, h.chunkCount - first);
+        for (size_t k = 0; k < count; ++k)
+        {
+            readExact(m_streamIn.data() + k * inStride, chunkLen(first + k) + GCM_TAG_SIZE);
+        }
+
+        auto openOne = [&](size_t k)
+        {
+            const size_t i = first + k;
+            const size_t len = chunkLen(i);
+            const uint8_t *src = m_streamIn.data() + k * inStride;
+            uint8_t iv[GCM_IV_SIZE];
+            chunkIv(ivPtr, static_cast<uint32_t>(i), iv);
+            const ChunkAad suffix = chunkAad(h.version, static_cast<uint32_t>(i), i + 1 == h.chunkCount);
+            openChunk(contextFor(h.keyId, h.suite, false), iv, aad, &suffix, src, len, src + len,
+                      m_streamOut.data() + k * outStride);
+        };
+        if (pool && count > 1)
+        {
+            pool->parallelFor(count, openOne);
+        }
+        else
+        {
+            openOne(0);
+        }
+
+        for (size_t k = 0; k < count; ++k)
+        {
+            sink(m_streamOut.data() + k * outStride, chunkLen(first + k));
+        }
+    }
+}
@@ -0,0 +1,133 @@
+#include "EntryStoragePool.hpp"
+#include <mutex>
+#include <utility>
+
+namespace
+{
+template <typename Buffer>
+using Magazine = std::vector<Buffer>;
+
+template <typename Buffer>
+class Depot
+{
+public:
+    // Stores a full magazine and hands back an empty one, or drops the buffers
+    // when the depot is at its cap.
+    void exchangeFull(Magazine<Buffer> &magazine)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_full.size() >= EntryStoragePool::MAX_DEPOT_MAGAZINES)
+        {
+            magazine.clear();
+            return;
+        }
+        m_full.push_back(std::move(magazine));
+        magazine = Magazine<Buffer>();
+        if (!m_empty.empty())
+        {
+            magazine = std::move(m_empty.back());
+            m_empty.pop_back();
+        }
+    }
+
+    // Swaps an empty magazine for a full one, if the depot has any.
+    void exchangeEmpty(Magazine<Buffer> &magazine)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_full.empty())
+            return;
+        if (magazine.capacity() > 0)
+            m_empty.push_back(std::move(magazine));
+        magazine = std::move(m_full.back());
+        m_full.pop_back();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::vector<Magazine<Buffer>> m_full;
+    std::vector<Magazine<Buffer>> m_empty;
+};
+
+// Never destroyed: threads return their magazines on exit, which may be after
+// static destruction has begun.
+template <typename Buffer>
+Depot<Buffer> &depot()
+{
+    static Depot<Buffer> *instance = new Depot<Buffer>();
+    return *instance;
+}
+
+template <typename Buffer>
+class LocalCache
+{
+public:
+    ~LocalCache()
+    {
+        if (!m_loaded.empty())
+            depot<Buffer>().exchangeFull(m_loaded);
+        if (!m_previous.empty())
+            depot<Buffer>().exchangeFull(m_previous);
+    }
+
+    Buffer take()
+    {
+        if (m_loaded.empty())
+        {
+            if (!m_previous.empty())
+                std::swap(m_loaded, m_previous);
+            else
+                depot<Buffer>().exchangeEmpty(m_loaded);
+            if (m_loaded.empty())
+                return Buffer();
+        }
+        Buffer buffer = std::move(m_loaded.back());
+        m_loaded.pop_back();
+        return buffer;
+    }
+
+    void give(Buffer &&buffer)
+    {
+        // Nothing to gain from a buffer that holds no heap block (an SSO string).
+        if (buffer.capacity() <= Buffer().capacity() ||
+            buffer.capacity() > EntryStoragePool::MAX_RETAINED_CAPACITY)
+            return;
+        buffer.clear();
+        if (m_loaded.size() >= EntryStoragePool::MAGAZINE_SIZE)
+        {
+            if (m_previous.size() >= EntryStoragePool::MAGAZINE_SIZE)
+                depot<Buffer>().exchangeFull(m_previous);
+            std::swap(m_loaded, m_previous);
+        }
+        if (m_loaded.capacity() < EntryStoragePool::MAGAZINE_SIZE)
+            m_loaded.reserve(EntryStoragePool::MAGAZINE_SIZE);
+        m_loaded.push_back(std::move(buffer));
+    }
+
+private:
+    Magazine<Buffer> m_loaded;
+    Magazine<Buffer> m_previous;
+};
+
+thread_local LocalCache<std::string> t_strings;
+thread_local LocalCache<std::vector<uint8_t>> t_bytes;
+} // namespace
+
+std::string EntryStoragePool::takeString()
+{
+    return t_strings.take();
+}
+
+std::vector<uint8_t> EntryStoragePool::takeBytes()
+{
+    return t_bytes.take();
+}
+
+void EntryStoragePool::give(std::string &&buffer)
+{
+    t_strings.give(std::move(buffer));
+}
+
+void EntryStoragePool::give(std::vector<uint8_t> &&buffer)
+{
+    t_bytes.give(std::move(buffer));
+}
@@ -0,0 +1,87 @@
+#include "InternedString.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace
+{
+constexpr size_t SHARD_COUNT = 16;
+constexpr size_t CACHE_SLOTS = 64; // per thread, direct-mapped
+
+const std::string &emptyString()
+{
+    static const std::string *empty = new std::string();
+    return *empty;
+}
+
+struct Shard
+{
+    std::shared_mutex mutex;
+    // Keys view the owned strings, whose buffers never move.
+    std::unordered_map<std::string_view, std::unique_ptr<const std::string>> values;
+};
+
+// Never destroyed: handles may outlive static destruction (e.g. in thread_local
+// or static objects elsewhere).
+Shard *shards()
+{
+    static Shard *table = new Shard[SHARD_COUNT];
+    return table;
+}
+
+std::atomic<size_t> g_internedCount{1}; // the empty string
+
+struct CacheSlot
+{
+    size_t hash = 0;
+    const std::string *value = nullptr;
+};
+
+thread_local CacheSlot t_cache[CACHE_SLOTS];
+
+const std::string *intern(std::string_view value)
+{
+    if (value.empty())
+        return &emptyString();
+
+    const size_t hash = std::hash<std::string_view>{}(value);
+    CacheSlot &slot = t_cache[hash % CACHE_SLOTS];
+    if (slot.value && slot.hash == hash && *slot.value == value)
+        return slot.value;
+
+    Shard &shard = shards()[(hash / CACHE_SLOTS) % SHARD_COUNT];
+    const std::string *found = nullptr;
+    {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.values.find(value);
+        if (it != shard.values.end())
+            found = it->second.get();
+    }
+    if (!found)
+    {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.values.find(value);
+        if (it == shard.values.end())
+        {
+            auto owned = std::make_unique<const std::string>(value);
+            const std::string_view key = *owned;
+            it = shard.values.emplace(key, std::move(owned)).first;
+            g_internedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        found = it->second.get();
+    }
+    slot = {hash, found};
+    return found;
+}
+} // namespace
+
+InternedString::InternedString() : m_value(&emptyString()) {}
+
+InternedString::InternedString(std::string_view value) : m_value(intern(value)) {}
+
+size_t InternedString::internedCount()
+{
+    return g_internedCount.load(std::memory_order_relaxed);
+}
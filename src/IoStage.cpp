@@ -0,0 +1,197 @@
+#include "IoStage.hpp"
+#include <chrono>
+#include <iostream>
+#include <sys/uio.h>
+
+namespace
+{
+// Full-ring retries spent yielding before the submitter starts sleeping.
+constexpr size_t SUBMIT_YIELD_ROUNDS = 256;
+constexpr std::chrono::microseconds SUBMIT_BACKOFF{100};
+// Bound on a single park so an I/O thread re-checks m_running regularly.
+constexpr std::chrono::milliseconds MAX_PARK_DURATION{50};
+} // namespace
+
+IoStage::IoStage(std::shared_ptr<SegmentedStorage> storage,
+                 size_t numThreads,
+                 size_t ringCapacity)
+    : m_storage(std::move(storage)),
+      m_numThreads(numThreads),
+      m_ring(ringCapacity),
+      m_spentBuffers(ringCapacity)
+{
+    if (numThreads == 0)
+        throw std::invalid_argument("IoStage: numThreads must be > 0");
+}
+
+IoStage::~IoStage()
+{
+    stop();
+}
+
+void IoStage::start()
+{
+    if (m_running.exchange(true))
+    {
+        return;
+    }
+
+    m_threads.reserve(m_numThreads);
+    for (size_t i = 0; i < m_numThreads; ++i)
+    {
+        m_threads.emplace_back(&IoStage::run, this);
+    }
+}
+
+void IoStage::stop()
+{
+    if (!m_running.exchange(false))
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_parkMutex);
+        ++m_wakeEpoch;
+    }
+    m_parkCv.notify_all();
+
+    for (auto &thread : m_threads)
+    {
+        if (thread.joinable())
+        {
+            thread.join();
+        }
+    }
+    m_threads.clear();
+}
+
+size_t IoRequest::settle(size_t blobsWritten)
+{
+    if (shares.size() != blobs.size())
+    {
+        const bool persisted = blobsWritten >= blobs.size();
+        AppendTicket::completeAll(completions, persisted);
+        return persisted ? 0 : entryCount;
+    }
+
+    size_t persistedCompletions = 0;
+    size_t lostEntries = 0;
+    for (size_t i = 0; i < shares.size(); ++i)
+    {
+        if (i < blobsWritten)
+            persistedCompletions += shares[i].completions;
+        else
+            lostEntries += shares[i].entries;
+    }
+    for (size_t i = 0; i < completions.size(); ++i)
+    {
+        completions[i]->complete(i < persistedCompletions);
+    }
+    completions.clear();
+    return lostEntries;
+}
+
+void IoStage::submit(IoRequest &&request)
+{
+    size_t rounds = 0;
+    while (!m_ring.tryPush(std::move(request)))
+    {
+        if (rounds++ < SUBMIT_YIELD_ROUNDS)
+        {
+            std::this_thread::yield();
+        }
+        else
+        {
+            std::this_thread::sleep_for(SUBMIT_BACKOFF);
+        }
+    }
+
+    // Pairs with the fence in waitForWork (see BufferQueue::notifyConsumers).
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_parkedThreads.load(std::memory_order_relaxed) > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_parkMutex);
+            ++m_wakeEpoch;
+        }
+        m_parkCv.notify_one();
+    }
+}
+
+bool IoStage::takeSpentBuffer(std::vector<uint8_t> &out)
+{
+    return m_spentBuffers.tryPop(out);
+}
+
+void IoStage::waitForWork()
+{
+    std::unique_lock<std::mutex> lock(m_parkMutex);
+    const uint64_t epoch = m_wakeEpoch;
+    m_parkedThreads.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (m_ring.sizeApprox() == 0 && m_running.load(std::memory_order_acquire))
+    {
+        m_parkCv.wait_for(lock, MAX_PARK_DURATION, [&]()
+                          { return m_wakeEpoch != epoch; });
+    }
+
+    m_parkedThreads.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void IoStage::run()
+{
+    IoRequest request;
+    std::vector<struct iovec> iov;
+
+    while (true)
+    {
+        if (!m_ring.tryPop(request))
+        {
+            // Writers are joined before stop(), so an empty ring after stop is final.
+            if (!m_running.load(std::memory_order_acquire))
+            {
+                break;
+            }
+            waitForWork();
+            continue;
+        }
+
+        size_t blobsWritten = 0;
+        try
+        {
+            iov.clear();
+            for (auto &blob : request.blobs)
+            {
+                iov.push_back({blob.data(), blob.size()});
+            }
+            if (request.targetFilename)
+            {
+                m_storage->writevToFile(*request.targetFilename, iov.data(), iov.size(), &blobsWritten);
+            }
+            else
+            {
+                m_storage->writev(iov.data(), iov.size(), &blobsWritten);
+            }
+            request.settle(blobsWritten);
+        }
+        catch (const std::exception &e)
+        {
+            const size_t lost = request.settle(blobsWritten);
+            m_droppedEntries.fetch_add(lost, std::memory_order_acq_rel);
+            std::cerr << "IoStage: dropped " << lost << " entries from "
+                      << (request.targetFilename ? *request.targetFilename : std::string("<default>"))
+                      << ": " << e.what() << std::endl;
+        }
+
+        for (auto &blob : request.blobs)
+        {
+            blob.clear();
+            m_spentBuffers.tryPush(std::move(blob)); // dropped if the ring is full
+        }
+        request.blobs.clear();
+        request.shares.clear();
+        request.targetFilename.reset();
+    }
+}
@@ -0,0 +1,551 @@
+#include "IoUring.hpp"
+#include <stdexcept>
+
+#ifdef GDPR_LOGGING_HAVE_IO_URING
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace
+{
+int sysSetup(unsigned entries, io_uring_params *params)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sysEnter(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int sysRegister(int ringFd, unsigned opcode, const void *arg, unsigned nrArgs)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_register, ringFd, opcode, arg, nrArgs));
+}
+
+std::runtime_error uringError(const std::string &what, int err)
+{
+    return std::runtime_error("io_uring " + what + " failed: " + std::strerror(err));
+}
+
+// Throws unless the kernel supports every opcode IoUring issues. Kernels before
+// 5.6 have neither IORING_REGISTER_PROBE nor IORING_OP_OPENAT, so a failed
+// probe means the ring is unusable too.
+void requireOpcodes(int ringFd)
+{
+    constexpr unsigned opCount = 256;
+    std::vector<uint8_t> storage(sizeof(io_uring_probe) + opCount * sizeof(io_uring_probe_op), 0);
+    auto *probe = reinterpret_cast<io_uring_probe *>(storage.data());
+    if (sysRegister(ringFd, IORING_REGISTER_PROBE, probe, opCount) < 0)
+    {
+        throw uringError("probe", errno);
+    }
+    for (const unsigned opcode : {IORING_OP_OPENAT, IORING_OP_WRITE, IORING_OP_WRITEV, IORING_OP_FSYNC})
+    {
+        if (opcode > probe->last_op || !(probe->ops[opcode].flags & IO_URING_OP_SUPPORTED))
+        {
+            throw std::runtime_error("io_uring opcode " + std::to_string(opcode) + " is not supported by this kernel");
+        }
+    }
+}
+} // namespace
+
+struct IoUring::Impl
+{
+    // One submitted SQE. Waiters keep theirs on the stack; fire-and-forget fsyncs
+    // are heap-allocated and freed by whoever reaps them.
+    struct Op
+    {
+        int result = 0;
+        bool done = false;   // guarded by cqMutex
+        bool detached = false;
+        int closeAfter = -1; // detached fsync: fd to close once it completes
+    };
+
+    int ringFd = -1;
+    void *sqRing = MAP_FAILED;
+    size_t sqRingSize = 0;
+    void *cqRing = MAP_FAILED;
+    size_t cqRingSize = 0;
+    io_uring_sqe *sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+    size_t sqesSize = 0;
+
+    unsigned *sqHead = nullptr;
+    unsigned *sqTail = nullptr;
+    unsigned sqMask = 0;
+    unsigned *sqArray = nullptr;
+    unsigned *cqHead = nullptr;
+    unsigned *cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe *cqes = nullptr;
+    // Cap on submitted-but-unreaped SQEs so the CQ ring can never overflow.
+    unsigned maxInflight = 0;
+
+    std::mutex sqMutex;
+    std::atomic<unsigned> inflight{0};
+
+    std::mutex cqMutex;
+    std::condition_variable cqCv;
+    bool reaping = false;  // guarded by cqMutex
+    size_t detached = 0;   // guarded by cqMutex
+
+    std::mutex slotMutex;
+    std::vector<int> freeSlots; // empty when file registration is unsupported
+
+    Impl(unsigned entries, size_t fileSlots);
+    ~Impl() { release(); }
+
+    void release();
+    // Queues one SQE for `op` and hands it to the kernel. Returns false, with
+    // op.result set to -errno, if io_uring_enter failed and the SQE was withdrawn;
+    // once this returns true the kernel owns the SQE and will post its CQE.
+    bool submit(Op &op, const std::function<void(io_uring_sqe &)> &prepare);
+    void wait(Op &op);
+    // Reaps at least one completion, or waits for the thread currently reaping.
+    void pump(std::unique_lock<std::mutex> &cqLock);
+    void reapLocked();
+    int run(const std::function<void(io_uring_sqe &)> &prepare);
+};
+
+IoUring::Impl::Impl(unsigned entries, size_t fileSlots)
+{
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    ringFd = sysSetup(entries, &params);
+    if (ringFd < 0)
+    {
+        throw uringError("setup", errno);
+    }
+    try
+    {
+        requireOpcodes(ringFd);
+    }
+    catch (...)
+    {
+        release();
+        throw;
+    }
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap)
+    {
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+    }
+
+    sqRing = ::mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED)
+    {
+        const int err = errno;
+        release();
+        throw uringError("mmap", err);
+    }
+    cqRing = singleMmap ? sqRing
+                        : ::mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                 ringFd, IORING_OFF_CQ_RING);
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    sqes = static_cast<io_uring_sqe *>(::mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+                                              MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES));
+    if (cqRing == MAP_FAILED || sqes == MAP_FAILED)
+    {
+        const int err = errno;
+        release();
+        throw uringError("mmap", err);
+    }
+
+    auto *sq = static_cast<uint8_t *>(sqRing);
+    sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    auto *cq = static_cast<uint8_t *>(cqRing);
+    cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    maxInflight = std::min(params.sq_entries, params.cq_entries);
+
+    // Sparse table (-1 entries) that SegmentedStorage fills as it opens segments.
+    // Older kernels without sparse registration just get unregistered fds.
+    if (fileSlots > 0)
+    {
+        std::vector<int> table(fileSlots, -1);
+        if (sysRegister(ringFd, IORING_REGISTER_FILES, table.data(), static_cast<unsigned>(table.size())) == 0)
+        {
+            freeSlots.reserve(fileSlots);
+            for (size_t i = fileSlots; i > 0; --i)
+            {
+                freeSlots.push_back(static_cast<int>(i - 1));
+            }
+        }
+    }
+}
+
+void IoUring::Impl::release()
+{
+    if (sqes != MAP_FAILED)
+        ::munmap(sqes, sqesSize);
+    if (cqRing != MAP_FAILED && cqRing != sqRing)
+        ::munmap(cqRing, cqRingSize);
+    if (sqRing != MAP_FAILED)
+        ::munmap(sqRing, sqRingSize);
+    sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+    cqRing = sqRing = MAP_FAILED;
+    if (ringFd >= 0)
+    {
+        ::close(ringFd);
+        ringFd = -1;
+    }
+}
+
+bool IoUring::Impl::submit(Op &op, const std::function<void(io_uring_sqe &)> &prepare)
+{
+    std::unique_lock<std::mutex> sqLock(sqMutex);
+    while (inflight.load(std::memory_order_acquire) >= maxInflight)
+    {
+        // Completion queue is at capacity; help drain it before queueing more.
+        sqLock.unlock();
+        {
+            std::unique_lock<std::mutex> cqLock(cqMutex);
+            pump(cqLock);
+        }
+        sqLock.lock();
+    }
+
+    // Only submitter (under sqMutex), and every submit leaves the SQ empty on
+    // return (consumed by the kernel or withdrawn), so the slot at tail is free.
+    const unsigned tail = *sqTail;
+    const unsigned index = tail & sqMask;
+    io_uring_sqe &sqe = sqes[index];
+    std::memset(&sqe, 0, sizeof(sqe));
+    prepare(sqe);
+    sqe.user_data = reinterpret_cast<uint64_t>(&op);
+    sqArray[index] = index;
+    __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+    inflight.fetch_add(1, std::memory_order_acq_rel);
+
+    while (true)
+    {
+        const unsigned pending = *sqTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        if (pending == 0)
+        {
+            return true;
+        }
+        const int ret = sysEnter(ringFd, pending, 0, 0);
+        if (ret >= 0 || errno == EINTR)
+        {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EBUSY)
+        {
+            // Kernel wants completions reaped first; the SQE stays queued meanwhile.
+            sqLock.unlock();
+            {
+                std::unique_lock<std::mutex> cqLock(cqMutex);
+                pump(cqLock);
+            }
+            sqLock.lock();
+            continue;
+        }
+        // io_uring_enter only fails when it consumed nothing, and the SQ was empty
+        // before this call, so ours is the one pending SQE. Without SQPOLL the
+        // kernel reads the tail only inside enter, so it is safe to take it back.
+        op.result = -errno;
+        __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+        inflight.fetch_sub(1, std::memory_order_acq_rel);
+        return false;
+    }
+}
+
+void IoUring::Impl::pump(std::unique_lock<std::mutex> &cqLock)
+{
+    if (reaping)
+    {
+        cqCv.wait(cqLock);
+        return;
+    }
+    if (inflight.load(std::memory_order_acquire) == 0)
+    {
+        return;
+    }
+
+    reaping = true;
+    cqLock.unlock();
+    int ret;
+    do
+    {
+        ret = sysEnter(ringFd, 0, 1, IORING_ENTER_GETEVENTS);
+    } while (ret < 0 && errno == EINTR);
+    cqLock.lock();
+    reapLocked();
+    reaping = false;
+    cqCv.notify_all();
+}
+
+void IoUring::Impl::reapLocked()
+{
+    unsigned head = *cqHead;
+    const unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    unsigned reaped = 0;
+    for (; head != tail; ++head, ++reaped)
+    {
+        const io_uring_cqe &cqe = cqes[head & cqMask];
+        Op *op = reinterpret_cast<Op *>(cqe.user_data);
+        op->result = cqe.res;
+        if (!op->detached)
+        {
+            op->done = true;
+            continue;
+        }
+
+        if (op->result < 0)
+        {
+            std::cerr << "IoUring: background fsync failed: " << std::strerror(-op->result) << std::endl;
+        }
+        if (op->closeAfter >= 0)
+        {
+            ::close(op->closeAfter);
+        }
+        delete op;
+        --detached;
+    }
+    __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    inflight.fetch_sub(reaped, std::memory_order_acq_rel);
+}
+
+void IoUring::Impl::wait(Op &op)
+{
+    std::unique_lock<std::mutex> cqLock(cqMutex);
+    while (!op.done)
+    {
+        pump(cqLock);
+    }
+}
+
+int IoUring::Impl::run(const std::function<void(io_uring_sqe &)> &prepare)
+{
+    Op op;
+    if (submit(op, prepare))
+    {
+        wait(op);
+    }
+    return op.result;
+}
+
+IoUring::IoUring(unsigned entries, size_t fileSlots)
+    : m_impl(std::make_unique<Impl>(entries, fileSlots))
+{
+}
+
+IoUring::~IoUring()
+{
+    drain();
+}
+
+bool IoUring::compiledIn()
+{
+    return true;
+}
+
+int IoUring::registerFile(int fd)
+{
+    std::lock_guard<std::mutex> lock(m_impl->slotMutex);
+    if (m_impl->freeSlots.empty())
+    {
+        return -1;
+    }
+    const int slot = m_impl->freeSlots.back();
+    io_uring_files_update update;
+    std::memset(&update, 0, sizeof(update));
+    update.offset = static_cast<unsigned>(slot);
+    update.fds = reinterpret_cast<uint64_t>(&fd);
+    if (sysRegister(m_impl->ringFd, IORING_REGISTER_FILES_UPDATE, &update, 1) != 1)
+    {
+        return -1;
+    }
+    m_impl->freeSlots.pop_back();
+    return slot;
+}
+
+void IoUring::unregisterFile(int slot)
+{
+    if (slot < 0)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_impl->slotMutex);
+    int empty = -1;
+    io_uring_files_update update;
+    std::memset(&update, 0, sizeof(update));
+    update.offset = static_cast<unsigned>(slot);
+    update.fds = reinterpret_cast<uint64_t>(&empty);
+    sysRegister(m_impl->ringFd, IORING_REGISTER_FILES_UPDATE, &update, 1);
+    m_impl->freeSlots.push_back(slot);
+}
+
+void IoUring::writeFull(int fd, int slot, const uint8_t *buf, size_t count, off_t offset)
+{
+    size_t total = 0;
+    while (total < count)
+    {
+        const int res = m_impl->run([&](io_uring_sqe &sqe)
+                                    {
+            sqe.opcode = IORING_OP_WRITE;
+            sqe.fd = slot >= 0 ? slot : fd;
+            if (slot >= 0)
+                sqe.flags |= IOSQE_FIXED_FILE;
+            sqe.addr = reinterpret_cast<uint64_t>(buf + total);
+            sqe.len = static_cast<uint32_t>(std::min<size_t>(count - total, 1u << 30));
+            sqe.off = static_cast<uint64_t>(offset + total); });
+        if (res == -EINTR || res == -EAGAIN)
+            continue;
+        if (res <= 0)
+            throw uringError("write", res == 0 ? EIO : -res);
+        total += static_cast<size_t>(res);
+    }
+}
+
+void IoUring::writevFull(int fd, int slot, const struct iovec *iov, size_t iovcnt, off_t offset)
+{
+    std::vector<struct iovec> pending(iov, iov + iovcnt);
+    size_t index = 0;
+    size_t total = 0;
+    while (index < pending.size())
+    {
+        const size_t batch = std::min<size_t>(pending.size() - index, IOV_MAX);
+        const int res = m_impl->run([&](io_uring_sqe &sqe)
+                                    {
+            sqe.opcode = IORING_OP_WRITEV;
+            sqe.fd = slot >= 0 ? slot : fd;
+            if (slot >= 0)
+                sqe.flags |= IOSQE_FIXED_FILE;
+            sqe.addr = reinterpret_cast<uint64_t>(&pending[index]);
+            sqe.len = static_cast<uint32_t>(batch);
+            sqe.off = static_cast<uint64_t>(offset + total); });
+        if (res == -EINTR || res == -EAGAIN)
+            continue;
+        if (res <= 0)
+            throw uringError("writev", res == 0 ? EIO : -res);
+
+        size_t written = static_cast<size_t>(res);
+        total += written;
+        while (written > 0 && index < pending.size())
+        {
+            const size_t step = std::min(written, pending[index].iov_len);
+            pending[index].iov_base = static_cast<uint8_t *>(pending[index].iov_base) + step;
+            pending[index].iov_len -= step;
+            written -= step;
+            if (pending[index].iov_len == 0)
+                ++index;
+        }
+        while (index < pending.size() && pending[index].iov_len == 0)
+            ++index;
+    }
+}
+
+void IoUring::fdatasync(int fd, int slot)
+{
+    const int res = m_impl->run([&](io_uring_sqe &sqe)
+                                {
+        sqe.opcode = IORING_OP_FSYNC;
+        sqe.fd = slot >= 0 ? slot : fd;
+        if (slot >= 0)
+            sqe.flags |= IOSQE_FIXED_FILE;
+        sqe.fsync_flags = IORING_FSYNC_DATASYNC; });
+    if (res < 0)
+        throw uringError("fdatasync", -res);
+}
+
+int IoUring::openat(const char *path, int flags, mode_t mode)
+{
+    const int res = m_impl->run([&](io_uring_sqe &sqe)
+                                {
+        sqe.opcode = IORING_OP_OPENAT;
+        sqe.fd = AT_FDCWD;
+        sqe.addr = reinterpret_cast<uint64_t>(path);
+        sqe.len = mode;
+        sqe.open_flags = static_cast<uint32_t>(flags | O_CLOEXEC); });
+    if (res < 0)
+        throw uringError("openat", -res);
+    return res;
+}
+
+void IoUring::fsyncAndCloseAsync(int fd)
+{
+    auto *op = new Impl::Op;
+    op->detached = true;
+    op->closeAfter = fd;
+    {
+        std::lock_guard<std::mutex> cqLock(m_impl->cqMutex);
+        ++m_impl->detached;
+    }
+    const bool published = m_impl->submit(*op, [&](io_uring_sqe &sqe)
+                                          {
+        sqe.opcode = IORING_OP_FSYNC;
+        sqe.fd = fd; });
+    if (!published)
+    {
+        // The kernel never saw the SQE, so nothing will reap `op`; do it inline.
+        {
+            std::lock_guard<std::mutex> cqLock(m_impl->cqMutex);
+            --m_impl->detached;
+        }
+        delete op;
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+void IoUring::drain()
+{
+    std::unique_lock<std::mutex> cqLock(m_impl->cqMutex);
+    while (m_impl->detached > 0)
+    {
+        m_impl->pump(cqLock);
+    }
+}
+
+#else // !GDPR_LOGGING_HAVE_IO_URING
+
+struct IoUring::Impl
+{
+};
+
+IoUring::IoUring(unsigned, size_t)
+{
+    throw std::runtime_error("io_uring support was not compiled in");
+}
+
+IoUring::~IoUring() = default;
+
+bool IoUring::compiledIn()
+{
+    return false;
+}
+
+int IoUring::registerFile(int) { return -1; }
+void IoUring::unregisterFile(int) {}
+void IoUring::writeFull(int, int, const uint8_t *, size_t, off_t) {}
+void IoUring::writevFull(int, int, const struct iovec *, size_t, off_t) {}
+void IoUring::fdatasync(int, int) {}
+int IoUring::openat(const char *, int, mode_t) { return -1; }
+void IoUring::fsyncAndCloseAsync(int) {}
+void IoUring::drain() {}
+
+#endif
@@ -0,0 +1,138 @@
+#include "KeyRing.hpp"
+#include "Crypto.hpp"
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+std::atomic<uint64_t> nextRingId{1};
+
+struct CachedContext
+{
+    uint64_t ringId;
+    uint32_t keyId;
+    CipherSuite suite;
+    bool forEncrypt;
+    EVP_CIPHER_CTX *ctx;
+};
+
+// Per-thread cache. Entries of destroyed rings are never hit again; they age out
+// once the cache is full.
+struct ContextCache
+{
+    static constexpr size_t MAX_ENTRIES = 64;
+    std::vector<CachedContext> entries;
+
+    ~ContextCache()
+    {
+        for (auto &entry : entries)
+            EVP_CIPHER_CTX_free(entry.ctx);
+    }
+};
+
+thread_local ContextCache contextCache;
+} // namespace
+
+KeyRing::KeyRing() : m_id(nextRingId.fetch_add(1, std::memory_order_relaxed))
+{
+}
+
+KeyRing::KeyRing(uint32_t keyId, std::vector<uint8_t> key) : KeyRing()
+{
+    addKey(keyId, std::move(key));
+    setActiveKey(keyId);
+}
+
+void KeyRing::addKey(uint32_t keyId, std::vector<uint8_t> key)
+{
+    if (key.size() != Crypto::KEY_SIZE)
+    {
+        throw std::invalid_argument("KeyRing: key " + std::to_string(keyId) + " must be " +
+                                    std::to_string(Crypto::KEY_SIZE) + " bytes");
+    }
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    auto it = m_keys.find(keyId);
+    if (it != m_keys.end())
+    {
+        // Cached contexts would silently keep the old bytes, so IDs are immutable.
+        if (it->second != key)
+        {
+            throw std::invalid_argument("KeyRing: key ID " + std::to_string(keyId) + " already in use");
+        }
+        return;
+    }
+    m_keys.emplace(keyId, std::move(key));
+}
+
+void KeyRing::setActiveKey(uint32_t keyId)
+{
+    if (!hasKey(keyId))
+    {
+        throw std::invalid_argument("KeyRing: unknown key ID " + std::to_string(keyId));
+    }
+    m_activeKeyId.store(keyId, std::memory_order_release);
+}
+
+bool KeyRing::hasKey(uint32_t keyId) const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_keys.count(keyId) != 0;
+}
+
+EVP_CIPHER_CTX *KeyRing::encryptContext(uint32_t keyId, CipherSuite suite) const
+{
+    return context(keyId, suite, true);
+}
+
+EVP_CIPHER_CTX *KeyRing::decryptContext(uint32_t keyId, CipherSuite suite) const
+{
+    return context(keyId, suite, false);
+}
+
+EVP_CIPHER_CTX *KeyRing::context(uint32_t keyId, CipherSuite suite, bool forEncrypt) const
+{
+    auto &entries = contextCache.entries;
+    for (const auto &entry : entries)
+    {
+        if (entry.ringId == m_id && entry.keyId == keyId && entry.suite == suite &&
+            entry.forEncrypt == forEncrypt)
+            return entry.ctx;
+    }
+    const EVP_CIPHER *cipher = Crypto::cipherFor(suite);
+
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    if (!ctx)
+    {
+        throw std::runtime_error("KeyRing: failed to create cipher context");
+    }
+
+    int rc;
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        auto it = m_keys.find(keyId);
+        if (it == m_keys.end())
+        {
+            EVP_CIPHER_CTX_free(ctx);
+            throw std::runtime_error("KeyRing: unknown key ID " + std::to_string(keyId));
+        }
+        rc = forEncrypt
+                 ? EVP_EncryptInit_ex(ctx, cipher, nullptr, it->second.data(), nullptr)
+                 : EVP_DecryptInit_ex(ctx, cipher, nullptr, it->second.data(), nullptr);
+    }
+    if (rc != 1)
+    {
+        EVP_CIPHER_CTX_free(ctx);
+        throw std::runtime_error("KeyRing: failed to initialize cipher context");
+    }
+
+    if (entries.size() >= ContextCache::MAX_ENTRIES)
+    {
+        EVP_CIPHER_CTX_free(entries.front().ctx);
+        entries.erase(entries.begin());
+    }
+    entries.push_back({m_id, keyId, suite, forEncrypt, ctx});
+    return ctx;
+}
@@ -1,11 +1,65 @@
 #include "LogEntry.hpp"
 #include "ByteOrder.hpp"
+#include "Compression.hpp"
+#include "EntryStoragePool.hpp"
+#include "LogEntryView.hpp"
+#include <algorithm>
 #include <cstring>
 #include <stdexcept>
 #include <iostream>
+#include <string_view>
+#include <unordered_map>
 
 namespace
 {
+// Sizes the Compact entry (see serializeCompact) at `data` without decoding it.
+// Returns true once all `size` bytes of it are within `available`; otherwise
+// `size` is a lower bound on its length, to be retried with at least that many
+// bytes. Throws on lengths no valid entry could have.
+bool measureCompactEntry(const uint8_t *data, size_t available, size_t &size)
+{
+    size_t offset = 1; // action
+    // Reads the varint at `offset`; false if it runs past `available`.
+    auto varint = [&](uint64_t &value)
+    {
+        if (offset >= available)
+        {
+            size = offset + 1;
+            return false;
+        }
+        const uint8_t *pos = data + offset;
+        if (!byteorder::readVarint(pos, data + available, value))
+        {
+            if (pos != data + available || available - offset >= 10)
+                throw std::runtime_error("Failed to deserialize log entry");
+            size = available + 1;
+            return false;
+        }
+        offset = static_cast<size_t>(pos - data);
+        return true;
+    };
+    // Skips a length-prefixed field; false if its bytes are not all there yet.
+    auto field = [&](uint64_t limit)
+    {
+        uint64_t length;
+        if (!varint(length))
+            return false;
+        if (length > limit)
+            throw std::runtime_error("Failed to deserialize log entry");
+        offset += static_cast<size_t>(length);
+        size = offset;
+        return offset <= available;
+    };
+
+    uint64_t delta;
+    for (int i = 0; i < 4; ++i)
+    {
+        if (!field(LogEntry::MAX_STRING_SIZE))
+            return false;
+    }
+    return varint(delta) && field(LogEntry::MAX_PAYLOAD_SIZE);
+}
+
 inline void appendLE32(std::vector<uint8_t> &v, uint32_t x)
 {
     uint8_t buf[4];
@@ -19,6 +73,116 @@ inline void appendLE64(std::vector<uint8_t> &v, uint64_t x)
     byteorder::writeLE64(buf, x);
     v.insert(v.end(), buf, buf + 8);
 }
+
+inline void appendVarint(std::vector<uint8_t> &v, uint64_t x)
+{
+    uint8_t buf[byteorder::MAX_VARINT_SIZE];
+    v.insert(v.end(), buf, buf + byteorder::writeVarint(buf, x));
+}
+
+inline int64_t timestampMillis(std::chrono::system_clock::time_point t)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(t.time_since_epoch()).count();
+}
+
+// Distinct values in first-seen order, then one index per entry, each index as
+// wide as the dictionary needs (1, 2 or 4 bytes).
+template <typename Field>
+void appendDictionaryColumn(std::vector<uint8_t> &out, const std::vector<LogEntry> &entries, Field field)
+{
+    std::unordered_map<std::string_view, uint32_t> ids;
+    std::vector<uint32_t> indices;
+    std::vector<std::string_view> values;
+    indices.reserve(entries.size());
+    for (const auto &entry : entries)
+    {
+        const std::string &value = field(entry);
+        auto [it, inserted] = ids.emplace(value, static_cast<uint32_t>(values.size()));
+        if (inserted)
+            values.push_back(value);
+        indices.push_back(it->second);
+    }
+
+    appendVarint(out, values.size());
+    for (const auto &value : values)
+    {
+        appendVarint(out, value.size());
+        out.insert(out.end(), value.begin(), value.end());
+    }
+    const uint8_t width = values.size() <= 0x100 ? 1 : values.size() <= 0x10000 ? 2 : 4;
+    out.push_back(width);
+    for (uint32_t index : indices)
+    {
+        for (uint8_t b = 0; b < width; ++b)
+            out.push_back(static_cast<uint8_t>(index >> (8 * b)));
+    }
+}
+
+// Bounds-checked cursor over a columnar batch.
+class ColumnReader
+{
+public:
+    ColumnReader(const uint8_t *data, size_t size) : m_pos(data), m_end(data + size) {}
+
+    const uint8_t *take(size_t n)
+    {
+        if (n > remaining())
+            throw std::runtime_error("Unexpected end of columnar batch");
+        const uint8_t *p = m_pos;
+        m_pos += n;
+        return p;
+    }
+    uint8_t u8() { return *take(1); }
+    uint32_t u32() { return byteorder::readLE32(take(sizeof(uint32_t))); }
+    uint64_t u64() { return byteorder::readLE64(take(sizeof(uint64_t))); }
+    uint64_t varint()
+    {
+        uint64_t v;
+        if (!byteorder::readVarint(m_pos, m_end, v))
+            throw std::runtime_error("Malformed varint in columnar batch");
+        return v;
+    }
+    // A varint that must not exceed `limit`.
+    size_t size(size_t limit, const char *what)
+    {
+        const uint64_t v = varint();
+        if (v > limit)
+            throw std::runtime_error(std::string("Columnar batch: ") + what + " exceeds its limit");
+        return static_cast<size_t>(v);
+    }
+    size_t remaining() const { return static_cast<size_t>(m_end - m_pos); }
+
+private:
+    const uint8_t *m_pos;
+    const uint8_t *m_end;
+};
+
+void readDictionaryColumn(ColumnReader &in, size_t count, std::vector<std::string> &values,
+                          std::vector<uint32_t> &indices)
+{
+    const size_t distinct = in.size(count, "dictionary size");
+    values.clear();
+    values.reserve(distinct);
+    for (size_t i = 0; i < distinct; ++i)
+    {
+        const size_t length = in.size(LogEntry::MAX_STRING_SIZE, "string length");
+        values.emplace_back(reinterpret_cast<const char *>(in.take(length)), length);
+    }
+    const uint8_t width = in.u8();
+    if (width != 1 && width != 2 && width != 4)
+        throw std::runtime_error("Columnar batch: bad index width");
+    const uint8_t *raw = in.take(count * width);
+    indices.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint32_t index = 0;
+        for (uint8_t b = 0; b < width; ++b)
+            index |= static_cast<uint32_t>(raw[i * width + b]) << (8 * b);
+        if (index >= values.size())
+            throw std::runtime_error("Columnar batch: dictionary index out of range");
+        indices[i] = index;
+    }
+}
 } // namespace
 
 LogEntry::LogEntry()
@@ -46,6 +210,64 @@ LogEntry::LogEntry(ActionType actionType,
 {
 }
 
+LogEntry::LogEntry(ActionType actionType,
+                   std::string dataLocation,
+                   InternedString dataControllerId,
+                   InternedString dataProcessorId,
+                   std::string dataSubjectId,
+                   std::vector<uint8_t> payload)
+    : m_actionType(actionType),
+      m_dataLocation(std::move(dataLocation)),
+      m_dataControllerId(dataControllerId),
+      m_dataProcessorId(dataProcessorId),
+      m_dataSubjectId(std::move(dataSubjectId)),
+      m_timestamp(std::chrono::system_clock::now()),
+      m_payload(std::move(payload))
+{
+}
+
+LogEntry LogEntry::make(ActionType actionType,
+                        std::string_view dataLocation,
+                        InternedString dataControllerId,
+                        InternedString dataProcessorId,
+                        std::string_view dataSubjectId,
+                        const uint8_t *payload,
+                        size_t payloadSize)
+{
+    // Short strings fit inline; only longer ones are worth a pooled buffer.
+    auto pooledString = [](std::string_view value)
+    {
+        std::string str = value.size() > std::string().capacity() ? EntryStoragePool::takeString() : std::string();
+        str.assign(value.data(), value.size());
+        return str;
+    };
+
+    LogEntry entry;
+    entry.m_actionType = actionType;
+    entry.m_dataLocation = pooledString(dataLocation);
+    entry.m_dataControllerId = Id(dataControllerId);
+    entry.m_dataProcessorId = Id(dataProcessorId);
+    entry.m_dataSubjectId = pooledString(dataSubjectId);
+    entry.m_timestamp = std::chrono::system_clock::now();
+    if (payloadSize > 0)
+    {
+        entry.m_payload = EntryStoragePool::takeBytes();
+        entry.m_payload.assign(payload, payload + payloadSize);
+    }
+    return entry;
+}
+
+void LogEntry::recycle(std::vector<LogEntry> &entries)
+{
+    for (auto &entry : entries)
+    {
+        EntryStoragePool::give(std::move(entry.m_dataLocation));
+        EntryStoragePool::give(std::move(entry.m_dataSubjectId));
+        EntryStoragePool::give(std::move(entry.m_payload));
+    }
+    entries.clear();
+}
+
 // Wire format (all integers little-endian):
 //   u32 actionType | 4× (u32 length + bytes) | u64 timestamp_ms | u32 payloadSize | payload
 
@@ -65,8 +287,8 @@ void LogEntry::serialize(std::vector<uint8_t> &out) &&
     appendLE32(out, static_cast<uint32_t>(m_actionType));
 
     appendStringToVector(out, std::move(m_dataLocation));
-    appendStringToVector(out, std::move(m_dataControllerId));
-    appendStringToVector(out, std::move(m_dataProcessorId));
+    appendStringToVector(out, m_dataControllerId.str());
+    appendStringToVector(out, m_dataProcessorId.str());
     appendStringToVector(out, std::move(m_dataSubjectId));
 
     int64_t timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -88,8 +310,8 @@ void LogEntry::serialize(std::vector<uint8_t> &out) const &
     appendLE32(out, static_cast<uint32_t>(m_actionType));
 
     appendStringToVector(out, m_dataLocation);
-    appendStringToVector(out, m_dataControllerId);
-    appendStringToVector(out, m_dataProcessorId);
+    appendStringToVector(out, m_dataControllerId.str());
+    appendStringToVector(out, m_dataProcessorId.str());
     appendStringToVector(out, m_dataSubjectId);
 
     int64_t timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -122,73 +344,33 @@ std::vector<uint8_t> LogEntry::serialize() const &
 
 bool LogEntry::deserialize(std::vector<uint8_t> &&data)
 {
-    try
-    {
-        size_t offset = 0;
-
-        if (data.size() < sizeof(uint32_t))
-            return false;
-
-        uint32_t actionType = byteorder::readLE32(data.data() + offset);
-        offset += sizeof(uint32_t);
-        m_actionType = static_cast<ActionType>(actionType);
-
-        if (!extractStringFromVector(data, offset, m_dataLocation))
-            return false;
-        if (!extractStringFromVector(data, offset, m_dataControllerId))
-            return false;
-        if (!extractStringFromVector(data, offset, m_dataProcessorId))
-            return false;
-        if (!extractStringFromVector(data, offset, m_dataSubjectId))
-            return false;
-
-        if (offset + sizeof(uint64_t) > data.size())
-            return false;
-
-        int64_t timestamp = static_cast<int64_t>(byteorder::readLE64(data.data() + offset));
-        offset += sizeof(uint64_t);
-        m_timestamp = std::chrono::system_clock::time_point(std::chrono::milliseconds(timestamp));
-
-        if (offset + sizeof(uint32_t) > data.size())
-            return false;
-
-        uint32_t payloadSize = byteorder::readLE32(data.data() + offset);
-        offset += sizeof(uint32_t);
-
-        if (payloadSize > MAX_PAYLOAD_SIZE)
-            return false;
-
-        if (offset + payloadSize > data.size())
-            return false;
-
-        if (payloadSize > 0)
-        {
-            m_payload.clear();
-            m_payload.reserve(payloadSize);
-
-            auto start_it = data.begin() + offset;
-            auto end_it = start_it + payloadSize;
-            m_payload.assign(std::make_move_iterator(start_it),
-                             std::make_move_iterator(end_it));
-            offset += payloadSize;
-        }
-        else
-        {
-            m_payload.clear();
-        }
-
-        return true;
-    }
-    catch (const std::exception &)
-    {
+    LogEntryView view;
+    if (!view.parse(data.data(), data.size()))
         return false;
-    }
+    *this = view.toLogEntry();
+    return true;
 }
 
-void LogEntry::serializeBatch(std::vector<LogEntry> &&entries, std::vector<uint8_t> &out)
+void LogEntry::serializeBatch(std::vector<LogEntry> &&entries, std::vector<uint8_t> &out,
+                              BatchEncoding encoding)
 {
     out.clear();
 
+    if (encoding == BatchEncoding::Columnar)
+    {
+        serializeColumnar(std::move(entries), out);
+        return;
+    }
+    if (encoding == BatchEncoding::Compact)
+    {
+        serializeCompact(entries, out);
+        return;
+    }
+    if (entries.size() >= BATCH_ENCODING_MARKER)
+    {
+        throw std::length_error("LogEntry: too many entries for one batch");
+    }
+
     if (entries.empty())
     {
         out.resize(sizeof(uint32_t));
@@ -218,13 +400,245 @@ void LogEntry::serializeBatch(std::vector<LogEntry> &&entries, std::vector<uint8
     }
 }
 
-std::vector<uint8_t> LogEntry::serializeBatch(std::vector<LogEntry> &&entries)
+std::vector<uint8_t> LogEntry::serializeBatch(std::vector<LogEntry> &&entries, BatchEncoding encoding)
 {
     std::vector<uint8_t> batchData;
-    serializeBatch(std::move(entries), batchData);
+    serializeBatch(std::move(entries), batchData, encoding);
     return batchData;
 }
 
+// Columnar layout (after BATCH_ENCODING_MARKER and the BatchEncoding byte; varints
+// are LEB128, fixed integers little-endian):
+//   u32 count
+//   action types, 2 bits per entry, four entries per byte, low bits first
+//   u64 first timestamp_ms, then count-1 zigzag varint deltas to the previous one
+//   controller, processor and subject IDs, each as a dictionary column:
+//     varint distinct | distinct x (varint length + bytes) | u8 width | count x index
+//   locations, front-coded: count x (varint shared prefix, varint suffix length),
+//     then the suffixes back to back
+//   payloads: count x varint size, then the payloads back to back
+void LogEntry::serializeColumnar(std::vector<LogEntry> &&entries, std::vector<uint8_t> &out)
+{
+    const size_t count = entries.size();
+    if (count > UINT32_MAX)
+    {
+        throw std::length_error("LogEntry: too many entries for one batch");
+    }
+    appendLE32(out, BATCH_ENCODING_MARKER);
+    out.push_back(static_cast<uint8_t>(BatchEncoding::Columnar));
+    appendLE32(out, static_cast<uint32_t>(count));
+
+    const size_t actionsPos = out.size();
+    out.resize(actionsPos + (count + 3) / 4, 0);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto action = static_cast<uint32_t>(entries[i].m_actionType) & 3;
+        out[actionsPos + i / 4] |= static_cast<uint8_t>(action << (2 * (i % 4)));
+    }
+
+    int64_t previous = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const int64_t timestamp = timestampMillis(entries[i].m_timestamp);
+        if (i == 0)
+            appendLE64(out, static_cast<uint64_t>(timestamp));
+        else
+            appendVarint(out, byteorder::zigzagEncode(timestamp - previous));
+        previous = timestamp;
+    }
+
+    appendDictionaryColumn(out, entries, [](const LogEntry &e) -> const std::string &
+                           { return e.m_dataControllerId.str(); });
+    appendDictionaryColumn(out, entries, [](const LogEntry &e) -> const std::string &
+                           { return e.m_dataProcessorId.str(); });
+    appendDictionaryColumn(out, entries, [](const LogEntry &e) -> const std::string &
+                           { return e.m_dataSubjectId; });
+
+    auto sharedPrefix = [&](size_t i)
+    {
+        if (i == 0)
+            return size_t{0};
+        const std::string &prev = entries[i - 1].m_dataLocation;
+        const std::string &cur = entries[i].m_dataLocation;
+        return static_cast<size_t>(
+            std::mismatch(cur.begin(), cur.begin() + std::min(cur.size(), prev.size()), prev.begin()).first -
+            cur.begin());
+    };
+    for (size_t i = 0; i < count; ++i)
+    {
+        const size_t shared = sharedPrefix(i);
+        appendVarint(out, shared);
+        appendVarint(out, entries[i].m_dataLocation.size() - shared);
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        const std::string &location = entries[i].m_dataLocation;
+        out.insert(out.end(), location.begin() + sharedPrefix(i), location.end());
+    }
+
+    for (const auto &entry : entries)
+        appendVarint(out, entry.m_payload.size());
+    for (auto &entry : entries)
+        out.insert(out.end(), entry.m_payload.begin(), entry.m_payload.end());
+}
+
+// Compact layout, row format v2 (after BATCH_ENCODING_MARKER and the BatchEncoding
+// byte; varints are LEB128):
+//   varint count | zigzag varint base timestamp_ms (the first entry's)
+//   count x entry:
+//     u8 actionType | 4x (varint length + bytes) | zigzag varint timestamp_ms - base
+//     | varint payloadSize | payload
+void LogEntry::serializeCompact(const std::vector<LogEntry> &entries, std::vector<uint8_t> &out)
+{
+    size_t estimate = 2 * sizeof(uint32_t) + 1 + 2 * byteorder::MAX_VARINT_SIZE;
+    for (const auto &entry : entries)
+        estimate += entry.serializedSize();
+    out.reserve(estimate);
+
+    appendLE32(out, BATCH_ENCODING_MARKER);
+    out.push_back(static_cast<uint8_t>(BatchEncoding::Compact));
+    appendVarint(out, entries.size());
+    const int64_t base = entries.empty() ? 0 : timestampMillis(entries.front().m_timestamp);
+    appendVarint(out, byteorder::zigzagEncode(base));
+
+    auto appendString = [&](std::string_view value)
+    {
+        appendVarint(out, value.size());
+        out.insert(out.end(), value.begin(), value.end());
+    };
+    for (const auto &entry : entries)
+    {
+        out.push_back(static_cast<uint8_t>(entry.m_actionType));
+        appendString(entry.m_dataLocation);
+        appendString(entry.m_dataControllerId.view());
+        appendString(entry.m_dataProcessorId.view());
+        appendString(entry.m_dataSubjectId);
+        appendVarint(out, byteorder::zigzagEncode(timestampMillis(entry.m_timestamp) - base));
+        appendVarint(out, entry.m_payload.size());
+        out.insert(out.end(), entry.m_payload.begin(), entry.m_payload.end());
+    }
+}
+
+void LogEntry::decodeMarkedBatch(const uint8_t *data, size_t size,
+                                 const std::function<void(LogEntry &&)> &onEntry)
+{
+    if (size < 1)
+    {
+        throw std::runtime_error("Batch data too small to contain its encoding");
+    }
+    switch (static_cast<BatchEncoding>(data[0]))
+    {
+    case BatchEncoding::Columnar:
+        decodeColumnar(data + 1, size - 1, onEntry);
+        return;
+    case BatchEncoding::Compact:
+        decodeCompact(data + 1, size - 1, onEntry);
+        return;
+    default:
+        throw std::runtime_error("Unknown batch encoding " + std::to_string(data[0]));
+    }
+}
+
+void LogEntry::decodeColumnar(const uint8_t *data, size_t size,
+                              const std::function<void(LogEntry &&)> &onEntry)
+{
+    ColumnReader in(data, size);
+    const uint32_t count = in.u32();
+    // Every entry takes at least seven bytes (three indices, four varints), so a
+    // forged count cannot make us allocate far beyond the input.
+    if (count > in.remaining() / 7 + 1)
+    {
+        throw std::runtime_error("Columnar batch: entry count exceeds the data");
+    }
+    std::vector<LogEntry> entries(count);
+
+    const uint8_t *actions = in.take((count + 3) / 4);
+    for (size_t i = 0; i < count; ++i)
+        entries[i].m_actionType = static_cast<ActionType>((actions[i / 4] >> (2 * (i % 4))) & 3);
+
+    int64_t timestamp = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        timestamp = i == 0 ? static_cast<int64_t>(in.u64())
+                           : static_cast<int64_t>(static_cast<uint64_t>(timestamp) +
+                                                  static_cast<uint64_t>(byteorder::zigzagDecode(in.varint())));
+        entries[i].m_timestamp = std::chrono::system_clock::time_point(std::chrono::milliseconds(timestamp));
+    }
+
+    std::vector<std::string> values;
+    std::vector<uint32_t> indices;
+    readDictionaryColumn(in, count, values, indices);
+    for (size_t i = 0; i < count; ++i)
+        entries[i].m_dataControllerId = Id(values[indices[i]]);
+    readDictionaryColumn(in, count, values, indices);
+    for (size_t i = 0; i < count; ++i)
+        entries[i].m_dataProcessorId = Id(values[indices[i]]);
+    readDictionaryColumn(in, count, values, indices);
+    for (size_t i = 0; i < count; ++i)
+        entries[i].m_dataSubjectId = values[indices[i]];
+
+    std::vector<std::pair<size_t, size_t>> locationParts(count); // shared prefix, suffix length
+    size_t previousLength = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const size_t shared = in.size(previousLength, "location prefix");
+        const size_t suffix = in.size(MAX_STRING_SIZE - shared, "location length");
+        locationParts[i] = {shared, suffix};
+        previousLength = shared + suffix;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::string &location = entries[i].m_dataLocation;
+        const auto [shared, suffix] = locationParts[i];
+        location.reserve(shared + suffix);
+        if (shared > 0)
+            location.assign(entries[i - 1].m_dataLocation, 0, shared);
+        location.append(reinterpret_cast<const char *>(in.take(suffix)), suffix);
+    }
+
+    std::vector<size_t> payloadSizes(count);
+    for (size_t i = 0; i < count; ++i)
+        payloadSizes[i] = in.size(MAX_PAYLOAD_SIZE, "payload size");
+    for (size_t i = 0; i < count; ++i)
+    {
+        const uint8_t *payload = in.take(payloadSizes[i]);
+        entries[i].m_payload.assign(payload, payload + payloadSizes[i]);
+    }
+
+    if (in.remaining() != 0)
+    {
+        throw std::runtime_error("Trailing bytes after columnar batch");
+    }
+    for (auto &entry : entries)
+        onEntry(std::move(entry));
+}
+
+void LogEntry::decodeCompact(const uint8_t *data, size_t size,
+                             const std::function<void(LogEntry &&)> &onEntry)
+{
+    const uint8_t *pos = data;
+    const uint8_t *end = data + size;
+    uint64_t count;
+    int64_t base;
+    if (!LogEntryView::parseCompactHeader(pos, end, count, base))
+    {
+        throw std::runtime_error("Malformed compact batch header");
+    }
+    LogEntryView view;
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        if (!view.parseCompact(pos, end, base))
+        {
+            throw std::runtime_error("Failed to deserialize log entry");
+        }
+        onEntry(view.toLogEntry());
+    }
+    if (pos != end)
+    {
+        throw std::runtime_error("Trailing bytes after compact batch");
+    }
+}
+
 std::vector<LogEntry> LogEntry::deserializeBatch(std::vector<uint8_t> &&batchData)
 {
     std::vector<LogEntry> entries;
@@ -237,56 +651,258 @@ std::vector<LogEntry> LogEntry::deserializeBatch(std::vector<uint8_t> &&batchDat
         }
 
         uint32_t numEntries = byteorder::readLE32(batchData.data());
-        entries.reserve(numEntries);
+        if (numEntries == BATCH_ENCODING_MARKER)
+        {
+            // All or nothing, like any batch that fails before its first entry.
+            std::vector<LogEntry> decoded;
+            decodeMarkedBatch(batchData.data() + sizeof(uint32_t), batchData.size() - sizeof(uint32_t),
+                              [&](LogEntry &&entry)
+                              { decoded.emplace_back(std::move(entry)); });
+            return decoded;
+        }
+        // Each entry is copied once, straight from the batch into its fields.
+        entries.reserve(std::min<size_t>(numEntries, batchData.size() / sizeof(uint32_t)));
+        for (const LogEntryView &view : LogEntryBatchView(batchData.data(), batchData.size()))
+        {
+            entries.push_back(view.toLogEntry());
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error deserializing log batch: " << e.what() << std::endl;
+    }
+
+    return entries;
+}
+
+LogEntry::BatchDecoder::BatchDecoder(std::function<void(LogEntry &&)> onEntry)
+    : m_onEntry(std::move(onEntry))
+{
+}
+
+LogEntry::BatchDecoder LogEntry::BatchDecoder::forViews(std::function<void(const LogEntryView &)> onView)
+{
+    BatchDecoder decoder;
+    decoder.m_onView = std::move(onView);
+    return decoder;
+}
+
+void LogEntry::BatchDecoder::emit(const LogEntryView &view)
+{
+    if (m_onView)
+        m_onView(view);
+    else
+        m_onEntry(view.toLogEntry());
+    --m_remaining;
+}
+
+void LogEntry::BatchDecoder::emitEntry(const uint8_t *data, size_t size)
+{
+    LogEntryView view;
+    if (!view.parse(data, size))
+    {
+        throw std::runtime_error("Failed to deserialize log entry");
+    }
+    emit(view);
+    m_inEntry = false;
+    m_needed = sizeof(uint32_t);
+}
 
-        size_t position = sizeof(uint32_t);
+void LogEntry::BatchDecoder::emitCompactEntry(const uint8_t *data, size_t size)
+{
+    LogEntryView view;
+    const uint8_t *pos = data;
+    if (!view.parseCompact(pos, data + size, m_baseMillis) || pos != data + size)
+    {
+        throw std::runtime_error("Failed to deserialize log entry");
+    }
+    emit(view);
+}
 
-        for (uint32_t i = 0; i < numEntries; ++i)
+void LogEntry::BatchDecoder::appendMarked(const uint8_t *data, size_t size)
+{
+    // The decompressor upstream is uncapped because Rows and Compact entries are
+    // consumed as they arrive; a batch buffered whole gets the usual zip-bomb cap
+    // here instead.
+    if (size > Compression::DEFAULT_MAX_DECOMPRESSED_SIZE - m_pending.size())
+    {
+        throw std::runtime_error("Encoded batch exceeds maximum decompressed size");
+    }
+    m_pending.insert(m_pending.end(), data, data + size);
+}
+
+void LogEntry::BatchDecoder::feedMarked(const uint8_t *data, size_t size)
+{
+    // Marker, encoding byte and the two header varints.
+    constexpr size_t maxCompactHeader = sizeof(uint32_t) + 1 + 2 * 10;
+
+    while (m_marked == Marked::Header && size > 0)
+    {
+        // Byte by byte: the header is a couple of dozen bytes at most.
+        m_pending.push_back(*data++);
+        --size;
+        if (static_cast<BatchEncoding>(m_pending[sizeof(uint32_t)]) != BatchEncoding::Compact)
         {
-            if (position + sizeof(uint32_t) > batchData.size())
-            {
-                throw std::runtime_error("Unexpected end of batch data");
-            }
+            m_marked = Marked::Whole;
+            break;
+        }
+        const uint8_t *pos = m_pending.data() + sizeof(uint32_t) + 1;
+        const uint8_t *end = m_pending.data() + m_pending.size();
+        uint64_t count, base;
+        if (byteorder::readVarint(pos, end, count) && byteorder::readVarint(pos, end, base))
+        {
+            m_remaining = count;
+            m_baseMillis = byteorder::zigzagDecode(base);
+            m_marked = Marked::Compact;
+            m_pending.clear();
+            m_needed = 0;
+        }
+        else if (m_pending.size() >= maxCompactHeader)
+        {
+            throw std::runtime_error("Malformed compact batch header");
+        }
+    }
 
-            uint32_t entrySize = byteorder::readLE32(batchData.data() + position);
-            position += sizeof(uint32_t);
+    if (m_marked == Marked::Whole)
+    {
+        appendMarked(data, size);
+        return;
+    }
+    while (size > 0)
+    {
+        if (m_remaining == 0)
+        {
+            throw std::runtime_error("Trailing bytes after compact batch");
+        }
 
-            if (entrySize > MAX_ENTRY_SIZE)
+        size_t entrySize;
+        if (m_pending.empty())
+        {
+            // Whole entries in this piece are decoded where they lie; a partial
+            // one at the end is kept until the rest arrives.
+            if (measureCompactEntry(data, size, entrySize))
             {
-                throw std::runtime_error("Entry size exceeds MAX_ENTRY_SIZE");
+                emitCompactEntry(data, entrySize);
+                data += entrySize;
+                size -= entrySize;
+                continue;
             }
+            m_pending.assign(data, data + size);
+            m_needed = entrySize;
+            return;
+        }
 
-            if (position + entrySize > batchData.size())
-            {
-                throw std::runtime_error("Unexpected end of batch data");
-            }
+        const size_t take = std::min(size, m_needed - m_pending.size());
+        m_pending.insert(m_pending.end(), data, data + take);
+        data += take;
+        size -= take;
+        if (m_pending.size() < m_needed)
+        {
+            return;
+        }
+        if (measureCompactEntry(m_pending.data(), m_pending.size(), entrySize))
+        {
+            emitCompactEntry(m_pending.data(), m_pending.size());
+            m_pending.clear();
+        }
+        else
+        {
+            m_needed = entrySize;
+        }
+    }
+}
 
-            std::vector<uint8_t> entryData;
-            entryData.reserve(entrySize);
+void LogEntry::BatchDecoder::feed(const uint8_t *data, size_t size)
+{
+    if (m_marked != Marked::No)
+    {
+        feedMarked(data, size);
+        return;
+    }
+    while (size > 0)
+    {
+        if (m_haveCount && !m_inEntry && m_remaining == 0)
+        {
+            throw std::runtime_error("Trailing bytes after last batch entry");
+        }
 
-            auto start_it = batchData.begin() + position;
-            auto end_it = start_it + entrySize;
-            entryData.assign(std::make_move_iterator(start_it),
-                             std::make_move_iterator(end_it));
-            position += entrySize;
+        // A whole entry in this piece is decoded where it lies.
+        if (m_inEntry && m_pending.empty() && size >= m_needed)
+        {
+            const size_t entrySize = m_needed;
+            emitEntry(data, entrySize);
+            data += entrySize;
+            size -= entrySize;
+            continue;
+        }
+
+        const size_t take = std::min(size, m_needed - m_pending.size());
+        m_pending.insert(m_pending.end(), data, data + take);
+        data += take;
+        size -= take;
+        if (m_pending.size() < m_needed)
+        {
+            return;
+        }
 
-            LogEntry entry;
-            if (entry.deserialize(std::move(entryData)))
+        if (!m_haveCount)
+        {
+            m_remaining = byteorder::readLE32(m_pending.data());
+            m_haveCount = true;
+            m_needed = sizeof(uint32_t);
+            if (m_remaining == BATCH_ENCODING_MARKER)
             {
-                entries.emplace_back(std::move(entry));
+                // Keep the marker: a batch buffered whole reaches finish() as written.
+                m_marked = Marked::Header;
+                feedMarked(data, size);
+                return;
             }
-            else
+        }
+        else if (!m_inEntry)
+        {
+            const uint32_t entrySize = byteorder::readLE32(m_pending.data());
+            if (entrySize > MAX_ENTRY_SIZE)
             {
-                throw std::runtime_error("Failed to deserialize log entry");
+                throw std::runtime_error("Entry size exceeds MAX_ENTRY_SIZE");
             }
+            m_inEntry = true;
+            m_needed = entrySize;
         }
+        else
+        {
+            emitEntry(m_pending.data(), m_pending.size());
+        }
+        m_pending.clear();
     }
-    catch (const std::exception &e)
+}
+
+void LogEntry::BatchDecoder::finish()
+{
+    if (m_marked == Marked::Whole)
     {
-        std::cerr << "Error deserializing log batch: " << e.what() << std::endl;
+        if (m_onView)
+        {
+            for (const LogEntryView &view : LogEntryBatchView(m_pending.data(), m_pending.size()))
+                m_onView(view);
+        }
+        else
+        {
+            decodeMarkedBatch(m_pending.data() + sizeof(uint32_t), m_pending.size() - sizeof(uint32_t),
+                              m_onEntry);
+        }
+        m_pending.clear();
+        m_marked = Marked::No;
+        m_remaining = 0;
+        return;
+    }
+    if (m_marked == Marked::Header)
+    {
+        throw std::runtime_error("Unexpected end of batch data");
+    }
+    if (!m_haveCount || m_inEntry || m_remaining != 0 || !m_pending.empty())
+    {
+        throw std::runtime_error("Unexpected end of batch data");
     }
-
-    return entries;
 }
 
 void LogEntry::appendToVector(std::vector<uint8_t> &vec, const void *data, size_t size) const
@@ -312,23 +928,3 @@ void LogEntry::appendStringToVector(std::vector<uint8_t> &vec, std::string &&str
         vec.insert(vec.end(), str.begin(), str.end());
     }
 }
-
-bool LogEntry::extractStringFromVector(std::vector<uint8_t> &vec, size_t &offset, std::string &str)
-{
-    if (offset + sizeof(uint32_t) > vec.size())
-        return false;
-
-    uint32_t length = byteorder::readLE32(vec.data() + offset);
-    offset += sizeof(uint32_t);
-
-    if (length > MAX_STRING_SIZE)
-        return false;
-
-    if (offset + length > vec.size())
-        return false;
-
-    str.assign(reinterpret_cast<const char *>(vec.data() + offset), length);
-    offset += length;
-
-    return true;
-}
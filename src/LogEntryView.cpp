@@ -0,0 +1,244 @@
+#include "LogEntryView.hpp"
+#include "ByteOrder.hpp"
+#include <stdexcept>
+
+namespace
+{
+// Bounds-checked reads for parse(); each returns false instead of overrunning.
+bool readU32(const uint8_t *&pos, const uint8_t *end, uint32_t &value)
+{
+    if (static_cast<size_t>(end - pos) < sizeof(uint32_t))
+        return false;
+    value = byteorder::readLE32(pos);
+    pos += sizeof(uint32_t);
+    return true;
+}
+
+bool readVarintString(const uint8_t *&pos, const uint8_t *end, std::string_view &value)
+{
+    uint64_t length;
+    if (!byteorder::readVarint(pos, end, length) || length > LogEntry::MAX_STRING_SIZE ||
+        static_cast<size_t>(end - pos) < length)
+        return false;
+    value = std::string_view(reinterpret_cast<const char *>(pos), static_cast<size_t>(length));
+    pos += length;
+    return true;
+}
+
+bool readString(const uint8_t *&pos, const uint8_t *end, std::string_view &value)
+{
+    uint32_t length;
+    if (!readU32(pos, end, length) || length > LogEntry::MAX_STRING_SIZE ||
+        static_cast<size_t>(end - pos) < length)
+        return false;
+    value = std::string_view(reinterpret_cast<const char *>(pos), length);
+    pos += length;
+    return true;
+}
+} // namespace
+
+LogEntryView::LogEntryView(const LogEntry &entry)
+    : m_actionType(entry.m_actionType),
+      m_dataLocation(entry.m_dataLocation),
+      m_dataControllerId(entry.m_dataControllerId.view()),
+      m_dataProcessorId(entry.m_dataProcessorId.view()),
+      m_dataSubjectId(entry.m_dataSubjectId),
+      m_timestamp(entry.m_timestamp),
+      m_payload(entry.m_payload.data()),
+      m_payloadSize(entry.m_payload.size())
+{
+}
+
+bool LogEntryView::parse(const uint8_t *data, size_t size)
+{
+    const uint8_t *pos = data;
+    const uint8_t *end = data + size;
+
+    uint32_t actionType;
+    if (!readU32(pos, end, actionType))
+        return false;
+    m_actionType = static_cast<LogEntry::ActionType>(actionType);
+
+    if (!readString(pos, end, m_dataLocation) ||
+        !readString(pos, end, m_dataControllerId) ||
+        !readString(pos, end, m_dataProcessorId) ||
+        !readString(pos, end, m_dataSubjectId))
+        return false;
+
+    if (static_cast<size_t>(end - pos) < sizeof(uint64_t))
+        return false;
+    const int64_t timestamp = static_cast<int64_t>(byteorder::readLE64(pos));
+    pos += sizeof(uint64_t);
+    m_timestamp = std::chrono::system_clock::time_point(std::chrono::milliseconds(timestamp));
+
+    uint32_t payloadSize;
+    if (!readU32(pos, end, payloadSize) || payloadSize > LogEntry::MAX_PAYLOAD_SIZE ||
+        static_cast<size_t>(end - pos) < payloadSize)
+        return false;
+    m_payload = pos;
+    m_payloadSize = payloadSize;
+    return true;
+}
+
+bool LogEntryView::parseCompact(const uint8_t *&pos, const uint8_t *end, int64_t baseMillis)
+{
+    const uint8_t *p = pos;
+    if (p == end)
+        return false;
+    m_actionType = static_cast<LogEntry::ActionType>(*p++);
+
+    if (!readVarintString(p, end, m_dataLocation) ||
+        !readVarintString(p, end, m_dataControllerId) ||
+        !readVarintString(p, end, m_dataProcessorId) ||
+        !readVarintString(p, end, m_dataSubjectId))
+        return false;
+
+    uint64_t delta;
+    if (!byteorder::readVarint(p, end, delta))
+        return false;
+    const int64_t timestamp = static_cast<int64_t>(static_cast<uint64_t>(baseMillis) +
+                                                   static_cast<uint64_t>(byteorder::zigzagDecode(delta)));
+    m_timestamp = std::chrono::system_clock::time_point(std::chrono::milliseconds(timestamp));
+
+    uint64_t payloadSize;
+    if (!byteorder::readVarint(p, end, payloadSize) || payloadSize > LogEntry::MAX_PAYLOAD_SIZE ||
+        static_cast<size_t>(end - p) < payloadSize)
+        return false;
+    m_payload = p;
+    m_payloadSize = static_cast<size_t>(payloadSize);
+    pos = p + payloadSize;
+    return true;
+}
+
+bool LogEntryView::parseCompactHeader(const uint8_t *&pos, const uint8_t *end, uint64_t &count,
+                                      int64_t &baseMillis)
+{
+    uint64_t base;
+    if (!byteorder::readVarint(pos, end, count) || !byteorder::readVarint(pos, end, base))
+        return false;
+    baseMillis = byteorder::zigzagDecode(base);
+    // Every entry takes at least seven bytes (action, four lengths, timestamp,
+    // payload size), so a forged count is caught before anyone trusts it.
+    return count <= static_cast<uint64_t>(end - pos) / 7;
+}
+
+LogEntry LogEntryView::toLogEntry() const
+{
+    LogEntry entry;
+    entry.m_actionType = m_actionType;
+    entry.m_dataLocation.assign(m_dataLocation.data(), m_dataLocation.size());
+    entry.m_dataControllerId = LogEntry::Id(std::string(m_dataControllerId));
+    entry.m_dataProcessorId = LogEntry::Id(std::string(m_dataProcessorId));
+    entry.m_dataSubjectId.assign(m_dataSubjectId.data(), m_dataSubjectId.size());
+    entry.m_timestamp = m_timestamp;
+    entry.m_payload.assign(m_payload, m_payload + m_payloadSize);
+    return entry;
+}
+
+LogEntryBatchView::LogEntryBatchView(const uint8_t *data, size_t size)
+    : m_end(data + size)
+{
+    if (size < sizeof(uint32_t))
+    {
+        throw std::runtime_error("Batch data too small to contain entry count");
+    }
+    const uint32_t count = byteorder::readLE32(data);
+    if (count != LogEntry::BATCH_ENCODING_MARKER)
+    {
+        m_first = data + sizeof(uint32_t);
+        m_count = count;
+        return;
+    }
+
+    const uint8_t *pos = data + sizeof(uint32_t);
+    if (pos != m_end && static_cast<BatchEncoding>(*pos) == BatchEncoding::Compact)
+    {
+        ++pos;
+        uint64_t compactCount;
+        if (!LogEntryView::parseCompactHeader(pos, m_end, compactCount, m_baseMillis))
+        {
+            throw std::runtime_error("Malformed compact batch header");
+        }
+        m_encoding = BatchEncoding::Compact;
+        m_first = pos;
+        m_count = static_cast<size_t>(compactCount);
+        return;
+    }
+    m_encoding = BatchEncoding::Columnar;
+    LogEntry::decodeMarkedBatch(pos, size - sizeof(uint32_t),
+                                [&](LogEntry &&entry)
+                                { m_decoded.push_back(std::move(entry)); });
+    m_count = m_decoded.size();
+}
+
+LogEntryBatchView::Iterator LogEntryBatchView::begin() const
+{
+    return Iterator(this, 0, m_first);
+}
+
+LogEntryBatchView::Iterator LogEntryBatchView::end() const
+{
+    return Iterator(this, m_count, nullptr);
+}
+
+LogEntryBatchView::Iterator::Iterator(const LogEntryBatchView *batch, size_t index, const uint8_t *position)
+    : m_batch(batch), m_index(index), m_position(position)
+{
+    settle();
+}
+
+LogEntryBatchView::Iterator &LogEntryBatchView::Iterator::operator++()
+{
+    ++m_index;
+    settle();
+    return *this;
+}
+
+void LogEntryBatchView::Iterator::settle()
+{
+    const uint8_t *end = m_batch->m_end;
+    switch (m_batch->m_encoding)
+    {
+    case BatchEncoding::Columnar:
+        if (m_index < m_batch->m_count)
+            m_current = LogEntryView(m_batch->m_decoded[m_index]);
+        return;
+    case BatchEncoding::Compact:
+        if (m_index < m_batch->m_count)
+        {
+            if (!m_current.parseCompact(m_position, end, m_batch->m_baseMillis))
+            {
+                throw std::runtime_error("Failed to deserialize log entry");
+            }
+        }
+        else if (m_position && m_position != end)
+        {
+            throw std::runtime_error("Trailing bytes after compact batch");
+        }
+        return;
+    default:
+        break;
+    }
+
+    if (m_index >= m_batch->m_count)
+        return;
+    if (static_cast<size_t>(end - m_position) < sizeof(uint32_t))
+    {
+        throw std::runtime_error("Unexpected end of batch data");
+    }
+    const uint32_t entrySize = byteorder::readLE32(m_position);
+    m_position += sizeof(uint32_t);
+    if (entrySize > LogEntry::MAX_ENTRY_SIZE)
+    {
+        throw std::runtime_error("Entry size exceeds MAX_ENTRY_SIZE");
+    }
+    if (static_cast<size_t>(end - m_position) < entrySize)
+    {
+        throw std::runtime_error("Unexpected end of batch data");
+    }
+    if (!m_current.parse(m_position, entrySize))
+    {
+        throw std::runtime_error("Failed to deserialize log entry");
+    }
+    m_position += entrySize;
+}
@@ -1,30 +1,31 @@
 #include "LogExporter.hpp"
+#include "LogEntryView.hpp"
 #include "ByteOrder.hpp"
 #include "Compression.hpp"
+#include "CompressionDictionary.hpp"
 #include "Crypto.hpp"
+#include "MerkleTree.hpp"
 #include "PlaceholderCryptoMaterial.hpp"
 #include "SealMarker.hpp"
 #include <openssl/evp.h>
 #include <algorithm>
+#include <atomic>
 #include <cstdio>
 #include <cstring>
 #include <ctime>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <sstream>
+#include <streambuf>
+#include <string_view>
 #include <utility>
 
 namespace
 {
-bool isSealPlaintext(const std::vector<uint8_t> &plaintext)
-{
-    if (plaintext.size() != seal_marker::MAGIC_LEN)
-        return false;
-    return std::memcmp(plaintext.data(), seal_marker::MAGIC, seal_marker::MAGIC_LEN) == 0;
-}
-
 const char *actionTypeName(LogEntry::ActionType t)
 {
     switch (t)
@@ -41,7 +42,7 @@ const char *actionTypeName(LogEntry::ActionType t)
     return "UNKNOWN";
 }
 
-void appendJsonEscaped(std::string &out, const std::string &s)
+void appendJsonEscaped(std::string &out, std::string_view s)
 {
     out.push_back('"');
     for (unsigned char c : s)
@@ -85,22 +86,19 @@ void appendJsonEscaped(std::string &out, const std::string &s)
     out.push_back('"');
 }
 
-std::string base64Encode(const std::vector<uint8_t> &data)
+void appendBase64(std::string &out, const uint8_t *data, size_t size)
 {
-    if (data.empty())
-        return {};
-    const size_t outLen = 4 * ((data.size() + 2) / 3);
-    std::string out(outLen, '\0');
-    int written = EVP_EncodeBlock(reinterpret_cast<unsigned char *>(&out[0]),
-                                  data.data(),
-                                  static_cast<int>(data.size()));
-    if (written < 0)
-        return {};
-    out.resize(static_cast<size_t>(written));
-    return out;
+    if (size == 0)
+        return;
+    const size_t start = out.size();
+    // EVP_EncodeBlock NUL-terminates.
+    out.resize(start + 4 * ((size + 2) / 3) + 1);
+    int written = EVP_EncodeBlock(reinterpret_cast<unsigned char *>(&out[start]), data,
+                                  static_cast<int>(size));
+    out.resize(start + static_cast<size_t>(std::max(written, 0)));
 }
 
-std::string formatRfc3339Utc(std::chrono::system_clock::time_point tp)
+void appendRfc3339Utc(std::string &out, std::chrono::system_clock::time_point tp)
 {
     using namespace std::chrono;
     const auto ms = duration_cast<milliseconds>(tp.time_since_epoch()).count();
@@ -115,50 +113,144 @@ std::string formatRfc3339Utc(std::chrono::system_clock::time_point tp)
     std::tm tm{};
     gmtime_r(&secs, &tm);
     char buf[32];
-    std::snprintf(buf, sizeof(buf),
-                  "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ",
-                  tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
-                  tm.tm_hour, tm.tm_min, tm.tm_sec, millis);
-    return std::string(buf);
+    const int n = std::snprintf(buf, sizeof(buf),
+                                "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ",
+                                tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                                tm.tm_hour, tm.tm_min, tm.tm_sec, millis);
+    out.append(buf, static_cast<size_t>(std::clamp(n, 0, static_cast<int>(sizeof(buf)) - 1)));
 }
 
-std::vector<uint8_t> readFile(const std::string &path)
+// Location of one blob, found by reading only its length field and seqnum.
+struct BlobRef
+{
+    uint64_t seqnum;
+    size_t segment; // index into the segment list
+    uint64_t offset;
+};
+
+constexpr size_t BLOB_PREFIX_SIZE = sizeof(uint32_t) + Crypto::SEQNUM_SIZE;
+
+// Appends a BlobRef per complete blob; a partial tail (crash mid-write) is ignored.
+bool scanSegment(const std::string &path, size_t segment, std::vector<BlobRef> &refs)
 {
     std::ifstream f(path, std::ios::binary | std::ios::ate);
     if (!f)
-        return {};
-    auto size = f.tellg();
-    if (size <= 0)
-        return {};
-    std::vector<uint8_t> buf(static_cast<size_t>(size));
-    f.seekg(0);
-    f.read(reinterpret_cast<char *>(buf.data()), size);
-    return buf;
+        return false;
+    const auto end = f.tellg();
+    if (end <= 0)
+        return true;
+    const uint64_t fileSize = static_cast<uint64_t>(end);
+
+    uint64_t pos = 0;
+    uint8_t prefix[BLOB_PREFIX_SIZE];
+    while (pos + BLOB_PREFIX_SIZE <= fileSize)
+    {
+        f.seekg(static_cast<std::streamoff>(pos));
+        if (!f.read(reinterpret_cast<char *>(prefix), BLOB_PREFIX_SIZE))
+            return false;
+        const size_t blobSize = Crypto::blobSize(byteorder::readLE32(prefix));
+        if (pos + blobSize > fileSize)
+            break;
+        refs.push_back(BlobRef{byteorder::readLE64(prefix + sizeof(uint32_t)), segment, pos});
+        pos += blobSize;
+    }
+    return true;
 }
 
-struct Blob
+// Serialized-batch sink. Holds back the first CHECKPOINT_SIZE bytes so the seal
+// and checkpoint batches can be told apart from a data batch without buffering it.
+class BatchStream
 {
-    size_t offset;
-    std::vector<uint8_t> bytes;
+public:
+    enum class Kind
+    {
+        Data,
+        Seal,
+        Checkpoint
+    };
+
+    explicit BatchStream(std::function<void(const LogEntryView &)> onEntry)
+        : m_decoder(LogEntry::BatchDecoder::forViews(std::move(onEntry)))
+    {
+    }
+
+    void feed(const uint8_t *data, size_t size)
+    {
+        if (!m_passthrough)
+        {
+            const size_t take = std::min(size, sizeof(m_head) - m_headLen);
+            std::memcpy(m_head + m_headLen, data, take);
+            m_headLen += take;
+            data += take;
+            size -= take;
+            if (size == 0)
+                return;
+            m_passthrough = true;
+            m_decoder.feed(m_head, m_headLen);
+        }
+        m_decoder.feed(data, size);
+    }
+
+    // A checkpoint's contents are returned through leafCount and root.
+    Kind finish(uint64_t &leafCount, merkle::Hash &root)
+    {
+        if (!m_passthrough)
+        {
+            if (m_headLen == seal_marker::MAGIC_LEN &&
+                std::memcmp(m_head, seal_marker::MAGIC, seal_marker::MAGIC_LEN) == 0)
+                return Kind::Seal;
+            if (merkle::decodeCheckpoint(m_head, m_headLen, leafCount, root))
+                return Kind::Checkpoint;
+            m_decoder.feed(m_head, m_headLen);
+        }
+        m_decoder.finish();
+        return Kind::Data;
+    }
+
+private:
+    LogEntry::BatchDecoder m_decoder;
+    uint8_t m_head[std::max(seal_marker::MAGIC_LEN, merkle::CHECKPOINT_SIZE)];
+    size_t m_headLen = 0;
+    bool m_passthrough = false;
 };
 
-std::vector<Blob> splitSegmentIntoBlobs(const std::vector<uint8_t> &segment)
+// Read-through view of another streambuf that hashes every byte taken from it, so
+// a blob's Merkle leaf comes out of the same read that decrypts it. Keeps no get
+// area of its own, so the source can be repositioned freely between blobs.
+class LeafHashingBuf : public std::streambuf
 {
-    std::vector<Blob> blobs;
-    size_t pos = 0;
-    while (pos + sizeof(uint32_t) <= segment.size())
+public:
+    LeafHashingBuf(std::streambuf *source, merkle::LeafHasher &hasher)
+        : m_source(source), m_hasher(hasher)
     {
-        uint32_t ciphertextSize = byteorder::readLE32(segment.data() + pos);
-        size_t blobSize = sizeof(uint32_t) + Crypto::SEQNUM_SIZE + Crypto::GCM_IV_SIZE +
-                          ciphertextSize + Crypto::GCM_TAG_SIZE;
-        if (pos + blobSize > segment.size())
-            break;
-        blobs.push_back({pos, std::vector<uint8_t>(segment.begin() + pos,
-                                                   segment.begin() + pos + blobSize)});
-        pos += blobSize;
     }
-    return blobs;
-}
+
+protected:
+    int_type underflow() override { return m_source->sgetc(); }
+
+    int_type uflow() override
+    {
+        const int_type c = m_source->sbumpc();
+        if (!traits_type::eq_int_type(c, traits_type::eof()))
+        {
+            const uint8_t byte = static_cast<uint8_t>(traits_type::to_char_type(c));
+            m_hasher.update(&byte, 1);
+        }
+        return c;
+    }
+
+    std::streamsize xsgetn(char *s, std::streamsize n) override
+    {
+        const std::streamsize got = m_source->sgetn(s, n);
+        if (got > 0)
+            m_hasher.update(reinterpret_cast<const uint8_t *>(s), static_cast<size_t>(got));
+        return got;
+    }
+
+private:
+    std::streambuf *m_source;
+    merkle::LeafHasher &m_hasher;
+};
 
 // Filename layout "<target>_YYYYMMDD_HHMMSS_NNNNNN.log" — strip the three trailing
 // underscore-separated fields to recover the target name used for AAD binding.
@@ -192,7 +284,7 @@ std::vector<std::string> listSegments(const std::string &dir)
     return files;
 }
 
-bool passesFilter(const LogEntry &e, const ExportFilter &filter)
+bool passesFilter(const LogEntryView &e, const ExportFilter &filter)
 {
     const auto unset = std::chrono::system_clock::time_point{};
     if (filter.from != unset && e.getTimestamp() < filter.from)
@@ -204,10 +296,10 @@ bool passesFilter(const LogEntry &e, const ExportFilter &filter)
     return true;
 }
 
-void writeNdjsonLine(std::ostream &out, const LogEntry &e)
+// Appends one NDJSON line for `e` to `line`.
+void appendNdjsonLine(std::string &line, const LogEntryView &e)
 {
-    std::string line;
-    line.reserve(256 + e.getPayload().size() * 2);
+    line.reserve(line.size() + 256 + e.getPayloadSize() * 2);
     line.append("{\"actionType\":\"");
     line.append(actionTypeName(e.getActionType()));
     line.append("\",\"dataLocation\":");
@@ -219,33 +311,59 @@ void writeNdjsonLine(std::ostream &out, const LogEntry &e)
     line.append(",\"dataSubjectId\":");
     appendJsonEscaped(line, e.getDataSubjectId());
     line.append(",\"timestamp\":\"");
-    line.append(formatRfc3339Utc(e.getTimestamp()));
+    appendRfc3339Utc(line, e.getTimestamp());
     line.append("\",\"payload\":\"");
-    line.append(base64Encode(e.getPayload()));
+    appendBase64(line, e.getPayloadData(), e.getPayloadSize());
     line.append("\"}\n");
-    out.write(line.data(), static_cast<std::streamsize>(line.size()));
 }
 
-struct DecodedBatch
+// Blobs each decode lane takes per window; bounds buffered output to
+// lanes * BLOBS_PER_LANE blobs' worth of NDJSON.
+constexpr size_t BLOBS_PER_LANE = 4;
+
+// Everything one thread needs to decode blobs: its own cipher and codec state and
+// its own read position in the segment files.
+struct DecodeLane
 {
-    uint64_t seqnum;
-    std::vector<LogEntry> entries;
-    std::string segmentPath;
-    size_t blobOffset;
+    explicit DecodeLane(std::shared_ptr<const DictionaryRegistry> dictionaries)
+        : hashingBuf(segmentIn.rdbuf(), hasher), blobIn(&hashingBuf)
+    {
+        compression.setDictionaries(std::move(dictionaries));
+    }
+
+    Crypto crypto;
+    Compression compression;
+    std::ifstream segmentIn;
+    size_t openSegment = std::numeric_limits<size_t>::max();
+    merkle::LeafHasher hasher;
+    LeafHashingBuf hashingBuf;
+    std::istream blobIn;
+    std::string line;
 };
 
-struct TargetState
+// One blob's decode result, committed in seqnum order.
+struct DecodedBlob
 {
-    std::vector<DecodedBatch> batches;
-    bool sealSeen = false;
-    uint64_t sealSeqnum = 0;
+    std::string ndjson; // parallel mode only; serial mode writes straight to the output
+    BatchStream::Kind kind = BatchStream::Kind::Data;
+    uint64_t checkpointLeaves = 0;
+    merkle::Hash checkpointRoot{};
+    merkle::Hash leaf{};
+    std::string error; // empty = decoded
+    bool tampered = false;
 };
 } // namespace
 
-LogExporter::LogExporter(std::string basePath, bool useEncryption, int compressionLevel)
+LogExporter::LogExporter(std::string basePath, bool useEncryption, int compressionLevel,
+                         std::shared_ptr<WorkerPool> cryptoPool,
+                         std::shared_ptr<KeyRing> keyRing,
+                         std::shared_ptr<WorkerPool> decodePool)
     : m_basePath(std::move(basePath)),
       m_useEncryption(useEncryption),
-      m_compressionLevel(compressionLevel)
+      m_compressionLevel(compressionLevel),
+      m_cryptoPool(std::move(cryptoPool)),
+      m_keyRing(keyRing ? std::move(keyRing) : placeholder_crypto::makeKeyRing()),
+      m_decodePool(std::move(decodePool))
 {
 }
 
@@ -274,172 +392,278 @@ bool LogExporter::exportToNDJSON(const std::string &outputPath, const ExportFilt
         std::cerr << "LogExporter: " << reason << std::endl;
     };
 
-    Crypto crypto;
-    Compression compression;
-    const std::vector<uint8_t> key(Crypto::KEY_SIZE, placeholder_crypto::KEY_BYTE);
-
-    std::map<std::string, TargetState> perTarget;
-
-    for (const auto &segmentPath : listSegments(m_basePath))
+    // Pass 1 reads only blob prefixes, so per-target ordering and gap checks
+    // happen before any plaintext exists and memory stays independent of log size.
+    const std::vector<std::string> segments = listSegments(m_basePath);
+    std::vector<std::vector<BlobRef>> scanned(segments.size());
+    std::vector<char> scanOk(segments.size(), 0);
+    auto scan = [&](size_t i)
+    { scanOk[i] = scanSegment(segments[i], i, scanned[i]); };
+    if (m_decodePool)
+        m_decodePool->parallelFor(segments.size(), scan);
+    else
+        for (size_t i = 0; i < segments.size(); ++i)
+            scan(i);
+
+    std::map<std::string, std::vector<BlobRef>> perTarget;
+    for (size_t i = 0; i < segments.size(); ++i)
     {
-        auto segment = readFile(segmentPath);
-        if (segment.empty())
-            continue;
+        if (!scanOk[i])
+        {
+            abortAndCleanup("failed to read segment " + segments[i]);
+            return false;
+        }
+        auto &refs = perTarget[parseTargetFromSegmentPath(segments[i])];
+        refs.insert(refs.end(), scanned[i].begin(), scanned[i].end());
+    }
+    scanned.clear();
 
-        const std::string target = parseTargetFromSegmentPath(segmentPath);
-        TargetState &state = perTarget[target];
+    // Blobs in output order: target by target, each in seqnum order.
+    struct BlobTask
+    {
+        const std::string *target;
+        BlobRef ref;
+    };
+    std::vector<BlobTask> tasks;
+    for (auto &[target, blobs] : perTarget)
+    {
+        std::sort(blobs.begin(), blobs.end(),
+                  [](const BlobRef &a, const BlobRef &b)
+                  { return a.seqnum < b.seqnum; });
 
-        for (const auto &blob : splitSegmentIntoBlobs(segment))
+        for (size_t i = 0; i < blobs.size(); ++i)
         {
-            uint64_t seqnum = 0;
-            if (!Crypto::peekSeqnum(blob.bytes, seqnum))
-            {
-                std::ostringstream msg;
-                msg << "malformed blob (too small for header) in " << segmentPath
-                    << " at offset " << blob.offset;
-                abortAndCleanup(msg.str());
-                return false;
-            }
-
-            std::vector<uint8_t> plaintext;
-            try
-            {
-                plaintext = crypto.decrypt(blob.bytes, key,
-                                           reinterpret_cast<const uint8_t *>(target.data()),
-                                           target.size());
-            }
-            catch (const TamperDetectedException &e)
-            {
-                std::ostringstream msg;
-                msg << "tamper detected in " << segmentPath
-                    << " at offset " << blob.offset
-                    << " (seqnum " << seqnum << ", target '" << target << "'): "
-                    << e.what();
-                abortAndCleanup(msg.str());
-                return false;
-            }
-            catch (const std::exception &e)
+            const uint64_t expected = static_cast<uint64_t>(i);
+            if (blobs[i].seqnum != expected)
             {
                 std::ostringstream msg;
-                msg << "decryption failed in " << segmentPath
-                    << " at offset " << blob.offset << ": " << e.what();
-                abortAndCleanup(msg.str());
-                return false;
-            }
-
-            std::vector<uint8_t> serialized;
-            if (m_compressionLevel > 0)
-            {
-                try
+                if (i > 0 && blobs[i - 1].seqnum == blobs[i].seqnum)
                 {
-                    serialized = compression.decompress(std::move(plaintext));
+                    msg << "duplicate seqnum " << blobs[i].seqnum
+                        << " for target '" << target << "'";
                 }
-                catch (const std::exception &e)
+                else
                 {
-                    std::ostringstream msg;
-                    msg << "decompression failed in " << segmentPath
-                        << " at offset " << blob.offset << ": " << e.what();
-                    abortAndCleanup(msg.str());
-                    return false;
+                    msg << "seqnum gap for target '" << target
+                        << "': expected " << expected
+                        << ", got " << blobs[i].seqnum;
                 }
+                abortAndCleanup(msg.str());
+                return false;
             }
-            else
-            {
-                serialized = std::move(plaintext);
-            }
+            tasks.push_back(BlobTask{&target, blobs[i]});
+        }
+    }
 
-            if (isSealPlaintext(serialized))
+    // Pass 2 streams each blob through decrypt -> [inflate] -> deserialize -> NDJSON.
+    // Every blob is also hashed into its target's Merkle tree as it is read, and
+    // each checkpoint batch's root is checked against the blobs before it.
+    //
+    // With a decode pool, windows of blobs are decoded on one lane per thread into
+    // per-blob buffers, then committed (checked and written) in order, so the output
+    // and every check match a serial run. Without one, a single lane writes each
+    // entry straight to the output.
+    std::shared_ptr<const DictionaryRegistry> dictionaries;
+    try
+    {
+        dictionaries = DictionaryRegistry::load(m_basePath, m_keyRing.get());
+    }
+    catch (const std::exception &e)
+    {
+        abortAndCleanup(std::string("failed to load compression dictionaries: ") + e.what());
+        return false;
+    }
+    std::vector<std::unique_ptr<DecodeLane>> lanes;
+    const size_t laneCount = m_decodePool ? m_decodePool->size() + 1 : 1;
+    for (size_t i = 0; i < laneCount; ++i)
+        lanes.push_back(std::make_unique<DecodeLane>(dictionaries));
+
+    auto decode = [&](DecodeLane &lane, const BlobTask &task, DecodedBlob &result, bool buffered)
+    {
+        const std::string &target = *task.target;
+        const BlobRef &blob = task.ref;
+        try
+        {
+            if (lane.openSegment != blob.segment)
             {
-                if (state.sealSeen && state.sealSeqnum != seqnum)
+                lane.segmentIn.close();
+                lane.segmentIn.clear();
+                lane.segmentIn.open(segments[blob.segment], std::ios::binary);
+                lane.openSegment = blob.segment;
+            }
+            lane.segmentIn.seekg(static_cast<std::streamoff>(blob.offset));
+            lane.blobIn.clear();
+
+            BatchStream batch([&](const LogEntryView &e)
+                              {
+                if (!passesFilter(e, filter))
+                    return;
+                if (buffered)
                 {
-                    std::ostringstream msg;
-                    msg << "multiple seal batches with different seqnums for target '"
-                        << target << "' (" << state.sealSeqnum << " and " << seqnum
-                        << ") — log may have been spliced";
-                    abortAndCleanup(msg.str());
-                    return false;
+                    appendNdjsonLine(result.ndjson, e);
+                    return;
                 }
-                state.sealSeen = true;
-                state.sealSeqnum = seqnum;
-                continue;
-            }
-
-            std::vector<LogEntry> entries;
-            try
+                lane.line.clear();
+                appendNdjsonLine(lane.line, e);
+                out.write(lane.line.data(), static_cast<std::streamsize>(lane.line.size())); });
+            const auto *targetBytes = reinterpret_cast<const uint8_t *>(target.data());
+            if (m_compressionLevel > 0)
             {
-                entries = LogEntry::deserializeBatch(std::move(serialized));
+                // Streamed straight to `out`, Rows and Compact entries are consumed
+                // as they are produced, so no cap; BatchDecoder caps the encodings
+                // it has to buffer whole. Buffered, the blob's NDJSON is held until
+                // its turn, so the zip-bomb cap applies to every encoding.
+                const size_t maxDecompressed =
+                    buffered ? Compression::DEFAULT_MAX_DECOMPRESSED_SIZE : std::numeric_limits<size_t>::max();
+                const Compression::OutputSink toBatch = [&](const uint8_t *d, size_t n)
+                { batch.feed(d, n); };
+                lane.compression.beginDecompress();
+                lane.crypto.decryptStream(lane.blobIn, *m_keyRing, targetBytes, target.size(),
+                                          [&](const uint8_t *d, size_t n)
+                                          { lane.compression.decompressChunk(d, n, toBatch, maxDecompressed); },
+                                          m_cryptoPool.get());
+                lane.compression.endDecompress();
             }
-            catch (const std::exception &e)
+            else
             {
-                std::ostringstream msg;
-                msg << "deserialization failed in " << segmentPath
-                    << " at offset " << blob.offset << ": " << e.what();
-                abortAndCleanup(msg.str());
-                return false;
+                lane.crypto.decryptStream(lane.blobIn, *m_keyRing, targetBytes, target.size(),
+                                          [&](const uint8_t *d, size_t n)
+                                          { batch.feed(d, n); },
+                                          m_cryptoPool.get());
             }
+            result.kind = batch.finish(result.checkpointLeaves, result.checkpointRoot);
+        }
+        catch (const TamperDetectedException &e)
+        {
+            result.tampered = true;
+            result.error = e.what();
+        }
+        catch (const std::exception &e)
+        {
+            result.error = e.what();
+        }
+        result.leaf = lane.hasher.finish();
+    };
+
+    // Per-target verification state, reset at each target's first blob.
+    bool sealSeen = false;
+    merkle::Frontier verified;           // leaves [0, verified.size())
+    std::vector<merkle::Hash> unchecked; // leaves from verified.size() on
 
-            state.batches.push_back(DecodedBatch{seqnum, std::move(entries),
-                                                 segmentPath, blob.offset});
+    auto warnIfUnsealed = [&](const std::string &target)
+    {
+        if (!sealSeen)
+        {
+            // Missing seal = crash before shutdown (or an attacker dropped it).
+            // Tail-truncation is undetectable in this case; partial export continues.
+            std::cerr << "LogExporter: warning — no seal batch for target '"
+                      << target << "' (tail truncation cannot be detected)"
+                      << std::endl;
         }
-    }
+    };
 
-    for (auto &[target, state] : perTarget)
+    // Checks blob `index` once it has been decoded; false aborts the export.
+    auto commit = [&](size_t index, DecodedBlob &result)
     {
-        auto &batches = state.batches;
-        std::sort(batches.begin(), batches.end(),
-                  [](const DecodedBatch &a, const DecodedBatch &b)
-                  { return a.seqnum < b.seqnum; });
+        const std::string &target = *tasks[index].target;
+        const BlobRef &blob = tasks[index].ref;
+        if (blob.seqnum == 0)
+        {
+            sealSeen = false;
+            verified = merkle::Frontier();
+            unchecked.clear();
+        }
 
-        for (size_t i = 0; i < batches.size(); ++i)
+        if (!result.error.empty())
         {
-            const uint64_t expected = static_cast<uint64_t>(i);
-            if (batches[i].seqnum != expected)
+            std::ostringstream msg;
+            msg << (result.tampered ? "tamper detected in " : "decoding failed in ") << segments[blob.segment]
+                << " at offset " << blob.offset
+                << " (seqnum " << blob.seqnum << ", target '" << target << "'): "
+                << result.error;
+            abortAndCleanup(msg.str());
+            return false;
+        }
+        out.write(result.ndjson.data(), static_cast<std::streamsize>(result.ndjson.size()));
+        sealSeen = result.kind == BatchStream::Kind::Seal;
+
+        if (result.kind == BatchStream::Kind::Checkpoint)
+        {
+            const uint64_t from = verified.size();
+            const uint64_t checkpointLeaves = result.checkpointLeaves;
+            if (checkpointLeaves == 0 || checkpointLeaves < from || checkpointLeaves > blob.seqnum)
             {
                 std::ostringstream msg;
-                if (i + 1 < batches.size() && batches[i + 1].seqnum == batches[i].seqnum)
-                {
-                    msg << "duplicate seqnum " << batches[i].seqnum
-                        << " for target '" << target << "'";
-                }
-                else
-                {
-                    msg << "seqnum gap for target '" << target
-                        << "': expected " << expected
-                        << ", got " << batches[i].seqnum;
-                }
+                msg << "Merkle checkpoint at seqnum " << blob.seqnum << " for target '" << target
+                    << "' covers " << checkpointLeaves << " batches, expected " << from
+                    << " to " << blob.seqnum;
                 abortAndCleanup(msg.str());
                 return false;
             }
-        }
-
-        if (state.sealSeen)
-        {
-            const uint64_t expectedDataCount = state.sealSeqnum;
-            if (batches.size() != expectedDataCount)
+            merkle::Frontier tree = verified;
+            for (uint64_t leaf = from; leaf < checkpointLeaves; ++leaf)
+                tree.append(unchecked[leaf - from]);
+            if (tree.root() != result.checkpointRoot)
             {
                 std::ostringstream msg;
-                msg << "target '" << target << "' truncated: seal reports "
-                    << expectedDataCount << " batches but "
-                    << batches.size() << " present";
+                msg << "Merkle checkpoint at seqnum " << blob.seqnum << " for target '" << target
+                    << "' does not match batches 0-" << (checkpointLeaves - 1)
+                    << " — log may have been rewritten";
                 abortAndCleanup(msg.str());
                 return false;
             }
+            verified = std::move(tree);
+            unchecked.erase(unchecked.begin(), unchecked.begin() + (checkpointLeaves - from));
         }
-        else if (!batches.empty())
+        unchecked.push_back(result.leaf);
+
+        const bool lastOfTarget = index + 1 == tasks.size() || tasks[index + 1].target != tasks[index].target;
+        // The seal's seqnum is the count of earlier batches, so with no gaps it sorts last.
+        if (sealSeen && !lastOfTarget)
         {
-            // Missing seal = crash before shutdown (or an attacker dropped it).
-            // Tail-truncation is undetectable in this case; partial export continues.
-            std::cerr << "LogExporter: warning — no seal batch for target '"
-                      << target << "' (tail truncation cannot be detected)"
-                      << std::endl;
+            const size_t remaining = perTarget[target].size() - blob.seqnum - 1;
+            std::ostringstream msg;
+            msg << "seal batch for target '" << target << "' at seqnum " << blob.seqnum
+                << " is followed by " << remaining
+                << " more batches — log may have been spliced";
+            abortAndCleanup(msg.str());
+            return false;
         }
+        if (lastOfTarget)
+            warnIfUnsealed(target);
+        return true;
+    };
 
-        for (const auto &batch : batches)
+    if (!m_decodePool)
+    {
+        DecodedBlob result;
+        for (size_t i = 0; i < tasks.size(); ++i)
+        {
+            result = DecodedBlob();
+            decode(*lanes[0], tasks[i], result, /*buffered=*/false);
+            if (!commit(i, result))
+                return false;
+        }
+    }
+    else
+    {
+        const size_t window = laneCount * BLOBS_PER_LANE;
+        std::vector<DecodedBlob> results(window);
+        for (size_t begin = 0; begin < tasks.size(); begin += window)
         {
-            for (const auto &e : batch.entries)
+            const size_t end = std::min(tasks.size(), begin + window);
+            for (auto &result : results)
+                result = DecodedBlob();
+            std::atomic<size_t> next{begin};
+            // Each lane is run by one thread at a time; lanes pull blobs until the window is done.
+            m_decodePool->parallelFor(laneCount, [&](size_t lane)
+                                      {
+                for (size_t i = next.fetch_add(1); i < end; i = next.fetch_add(1))
+                    decode(*lanes[lane], tasks[i], results[i - begin], /*buffered=*/true); });
+            for (size_t i = begin; i < end; ++i)
             {
-                if (passesFilter(e, filter))
-                    writeNdjsonLine(out, e);
+                if (!commit(i, results[i - begin]))
+                    return false;
             }
         }
     }
@@ -70,7 +70,8 @@ BufferQueue::ProducerToken Logger::createProducerToken()
 
 bool Logger::append(LogEntry entry,
                     BufferQueue::ProducerToken &token,
-                    const std::optional<std::string> &filename)
+                    const std::optional<std::string> &filename,
+                    std::shared_ptr<AppendTicket::State> completion)
 {
     std::shared_ptr<BufferQueue> queue;
     std::chrono::milliseconds timeout;
@@ -85,13 +86,14 @@ bool Logger::append(LogEntry entry,
         timeout = m_appendTimeout;
     }
 
-    QueueItem item{std::move(entry), filename};
+    QueueItem item{std::move(entry), filename, std::move(completion)};
     return queue->enqueueBlocking(std::move(item), token, timeout);
 }
 
 bool Logger::appendBatch(std::vector<LogEntry> entries,
                          BufferQueue::ProducerToken &token,
-                         const std::optional<std::string> &filename)
+                         const std::optional<std::string> &filename,
+                         std::shared_ptr<AppendTicket::State> completion)
 {
     std::shared_ptr<BufferQueue> queue;
     std::chrono::milliseconds timeout;
@@ -115,7 +117,7 @@ bool Logger::appendBatch(std::vector<LogEntry> entries,
     batch.reserve(entries.size());
     for (auto &entry : entries)
     {
-        batch.emplace_back(std::move(entry), filename);
+        batch.emplace_back(std::move(entry), filename, completion);
     }
     return queue->enqueueBatchBlocking(std::move(batch), token, timeout);
 }
@@ -4,15 +4,27 @@
 #include "LogExporter.hpp"
 #include "PlaceholderCryptoMaterial.hpp"
 #include "SealMarker.hpp"
+#include "CpuAffinity.hpp"
 #include <iostream>
 #include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
 #include <vector>
 
 LoggingManager::LoggingManager(const LoggingConfig &config)
     : m_numWriterThreads(config.numWriterThreads),
       m_batchSize(config.batchSize),
+      m_maxBatchBytes(config.maxBatchBytes),
+      m_maxBatchLinger(config.maxBatchLinger),
       m_useEncryption(config.useEncryption),
+      m_batchEncoding(config.batchEncoding),
       m_compressionLevel(config.compressionLevel),
+      m_compressionCodec(config.compressionCodec),
+      m_encryptionChunkSize(config.encryptionChunkSize),
+      m_exportThreads(config.exportThreads),
+      m_cipherSuite(config.cipherSuite),
+      m_writerIdleStrategy(config.writerIdleStrategy),
       m_basePath(config.basePath),
       m_baseFilename(config.baseFilename)
 {
@@ -23,12 +35,49 @@ LoggingManager::LoggingManager(const LoggingConfig &config)
         throw std::invalid_argument("LoggingConfig: numWriterThreads must be > 0");
     if (config.batchSize == 0)
         throw std::invalid_argument("LoggingConfig: batchSize must be > 0");
+    if (config.maxBatchLinger.count() < 0)
+        throw std::invalid_argument("LoggingConfig: maxBatchLinger must be >= 0");
     if (config.maxSegmentSize == 0)
         throw std::invalid_argument("LoggingConfig: maxSegmentSize must be > 0");
     if (config.maxOpenFiles == 0)
         throw std::invalid_argument("LoggingConfig: maxOpenFiles must be > 0");
     if (config.maxAttempts == 0)
         throw std::invalid_argument("LoggingConfig: maxAttempts must be > 0");
+    if (config.usePipelinedWriter && config.numIoThreads == 0)
+        throw std::invalid_argument("LoggingConfig: numIoThreads must be > 0 in pipelined mode");
+    if (config.usePipelinedWriter && config.ioRingCapacity == 0)
+        throw std::invalid_argument("LoggingConfig: ioRingCapacity must be > 0 in pipelined mode");
+    if (config.durability.mode == DurabilityMode::Periodic && config.durability.syncInterval.count() <= 0)
+        throw std::invalid_argument("LoggingConfig: durability.syncInterval must be > 0 in periodic mode");
+    if (config.storageBackend == StorageBackend::IoUring && config.ioUringQueueDepth == 0)
+        throw std::invalid_argument("LoggingConfig: ioUringQueueDepth must be > 0 for the io_uring backend");
+    if (config.encryptionChunkSize > static_cast<size_t>(std::numeric_limits<int>::max()))
+        throw std::invalid_argument("LoggingConfig: encryptionChunkSize must fit in an int");
+    if (config.cipherSuite != CipherSuite::Aes256Gcm && config.cipherSuite != CipherSuite::ChaCha20Poly1305)
+        throw std::invalid_argument("LoggingConfig: unknown cipherSuite");
+    if (config.nonceStrategy != NonceStrategy::Random && config.nonceStrategy != NonceStrategy::Counter)
+        throw std::invalid_argument("LoggingConfig: unknown nonceStrategy");
+    if (config.batchEncoding != BatchEncoding::Rows && config.batchEncoding != BatchEncoding::Columnar &&
+        config.batchEncoding != BatchEncoding::Compact)
+        throw std::invalid_argument("LoggingConfig: unknown batchEncoding");
+    if (config.compressionCodec != CompressionCodec::Zlib && config.compressionCodec != CompressionCodec::Zstd &&
+        config.compressionCodec != CompressionCodec::Lz4)
+        throw std::invalid_argument("LoggingConfig: unknown compressionCodec");
+    // Also validates writerCpuList (throws std::invalid_argument).
+    m_writerCpus = cpu_affinity::planWriterCpus(config.writerPlacement, config.writerCpuList,
+                                                config.numWriterThreads, cpu_affinity::nodes());
+
+    if (!Codec::compiledIn(m_compressionCodec))
+    {
+        std::cerr << "LoggingSystem: compression codec " << static_cast<int>(m_compressionCodec)
+                  << " was not compiled in; falling back to zlib" << std::endl;
+        // LZ4 was asked for to keep CPU low, so take zlib's cheapest level instead.
+        if (m_compressionCodec == CompressionCodec::Lz4 && m_compressionLevel > 0)
+            m_compressionLevel = 1;
+        m_compressionCodec = CompressionCodec::Zlib;
+        if (m_compressionLevel > 9)
+            m_compressionLevel = 9;
+    }
 
     if (!std::filesystem::create_directories(config.basePath) &&
         !std::filesystem::exists(config.basePath))
@@ -36,14 +85,73 @@ LoggingManager::LoggingManager(const LoggingConfig &config)
         throw std::runtime_error("Failed to create log directory: " + config.basePath);
     }
 
-    m_queue = std::make_shared<BufferQueue>(config.queueCapacity, config.maxExplicitProducers);
+    const size_t queueShards = config.targetAffineDispatch ? config.numWriterThreads : 1;
+    // Shard i is drained by writer i, so it lives on that writer's node.
+    const bool bindShards = config.bindQueueShardsToNodes && config.targetAffineDispatch;
+    m_queue = std::make_shared<BufferQueue>(config.queueCapacity, config.maxExplicitProducers, queueShards,
+                                            bindShards ? m_writerCpus : std::vector<std::vector<int>>{});
     m_storage = std::make_shared<SegmentedStorage>(
         config.basePath, config.baseFilename,
         config.maxSegmentSize,
         config.maxAttempts,
         config.baseRetryDelay,
-        config.maxOpenFiles);
+        config.maxOpenFiles,
+        config.durability,
+        config.storageBackend,
+        config.ioUringQueueDepth);
     m_seqnumAllocator = std::make_shared<SeqnumAllocator>();
+    m_keyRing = config.keyRing ? config.keyRing : placeholder_crypto::makeKeyRing();
+    if (config.usePipelinedWriter)
+    {
+        m_ioStage = std::make_shared<IoStage>(m_storage, config.numIoThreads, config.ioRingCapacity);
+    }
+    if (config.useEncryption && config.nonceStrategy == NonceStrategy::Counter)
+    {
+        // SegmentedStorage has created basePath by now.
+        m_nonces = std::make_shared<NonceSequence>(
+            config.nonceStateFile.empty() ? (std::filesystem::path(config.basePath) / "nonce.state").string()
+                                          : config.nonceStateFile);
+    }
+    if (config.useEncryption && config.merkleCheckpointInterval > 0)
+    {
+        m_merkleLog = std::make_shared<merkle::MerkleAccumulator>(config.merkleCheckpointInterval);
+    }
+    if (m_compressionLevel > 0 && !config.compressionDictionaries.empty())
+    {
+        // Extend the directory's registry rather than replace it: blobs from earlier
+        // runs keep naming their dictionaries by ID.
+        const KeyRing *registryKeys = config.useEncryption ? m_keyRing.get() : nullptr;
+        auto dictionaries = DictionaryRegistry::load(config.basePath, registryKeys);
+        for (const auto &[prefix, path] : config.compressionDictionaries)
+        {
+            std::ifstream in(path, std::ios::binary);
+            if (!in)
+            {
+                throw std::invalid_argument("LoggingConfig: cannot read compression dictionary " + path);
+            }
+            std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            dictionaries->assign(prefix, dictionaries->add(std::move(bytes)));
+        }
+        dictionaries->save(config.basePath, registryKeys);
+        m_dictionaries = std::move(dictionaries);
+    }
+    if (m_compressionLevel > 0 && config.adaptiveCompression.enabled)
+    {
+        AdaptiveCompressionPolicy policy = config.adaptiveCompression;
+        if (policy.pressureCodec && !Codec::compiledIn(*policy.pressureCodec))
+        {
+            std::cerr << "LoggingSystem: pressure codec " << static_cast<int>(*policy.pressureCodec)
+                      << " was not compiled in; adaptive compression only lowers the level" << std::endl;
+            policy.pressureCodec.reset();
+        }
+        // Throws std::invalid_argument for a bad policy.
+        m_compressionController = std::make_shared<CompressionController>(
+            m_compressionCodec, m_compressionLevel, policy, config.queueCapacity);
+    }
+    if (config.useEncryption && config.encryptionChunkSize > 0 && config.cryptoThreads > 0)
+    {
+        m_cryptoPool = std::make_shared<WorkerPool>(config.cryptoThreads);
+    }
 
     Logger::getInstance().initialize(m_queue, config.appendTimeout);
 
@@ -52,7 +160,12 @@ LoggingManager::LoggingManager(const LoggingConfig &config)
 
 LoggingManager::~LoggingManager()
 {
-    stop();
+    // A manager that was never started still initialized the Logger in its ctor;
+    // release it so the next manager's initialize() doesn't bind to our queue.
+    if (!stop())
+    {
+        Logger::getInstance().reset();
+    }
 }
 
 bool LoggingManager::start()
@@ -68,19 +181,63 @@ bool LoggingManager::start()
     m_running.store(true, std::memory_order_release);
     m_acceptingEntries.store(true, std::memory_order_release);
 
+    if (m_ioStage)
+    {
+        m_ioStage->start();
+    }
+
+    WriterOptions options;
+    options.batchSize = m_batchSize;
+    options.maxBatchBytes = m_maxBatchBytes;
+    options.maxBatchLinger = m_maxBatchLinger;
+    options.useEncryption = m_useEncryption;
+    options.batchEncoding = m_batchEncoding;
+    options.compressionLevel = m_compressionLevel;
+    options.compressionCodec = m_compressionCodec;
+    options.dictionaries = m_dictionaries;
+    options.compressionController = m_compressionController;
+    options.encryptionChunkSize = m_encryptionChunkSize;
+    options.cipherSuite = m_cipherSuite;
+    options.seqnumAllocator = m_seqnumAllocator;
+    options.baseFilename = m_baseFilename;
+    options.ioStage = m_ioStage;
+    options.cryptoPool = m_cryptoPool;
+    options.keyRing = m_keyRing;
+    options.nonces = m_nonces;
+    options.merkleLog = m_merkleLog;
+    options.idleStrategy = m_writerIdleStrategy;
+
+    m_queue->reopen();
     for (size_t i = 0; i < m_numWriterThreads; ++i)
     {
-        auto writer = std::make_unique<Writer>(*m_queue, m_storage,
-                                               m_batchSize,
-                                               m_useEncryption, m_compressionLevel,
-                                               m_seqnumAllocator, m_baseFilename);
+        options.queueShard = i % m_queue->shardCount();
+        options.cpuAffinity = m_writerCpus[i];
+        auto writer = std::make_unique<Writer>(*m_queue, m_storage, options);
         writer->start();
         m_writers.push_back(std::move(writer));
     }
 
     std::cout << "LoggingSystem: Started " << m_numWriterThreads << " writer threads";
+    if (m_ioStage)
+    {
+        std::cout << " in pipelined mode";
+    }
+    if (m_queue->shardCount() > 1)
+    {
+        std::cout << " with target-affine dispatch";
+    }
+    if (!m_writerCpus.empty() && !m_writerCpus.front().empty())
+    {
+        std::cout << " (pinned)";
+    }
     std::cout << " (Encryption: " << (m_useEncryption ? "Enabled" : "Disabled");
-    std::cout << ", Compression: " << (m_compressionLevel != 0 ? "Enabled" : "Disabled") << ")" << std::endl;
+    std::cout << ", Compression: "
+              << (m_compressionLevel == 0                                ? "Disabled"
+                  : m_compressionCodec == CompressionCodec::Zstd ? "zstd"
+                  : m_compressionCodec == CompressionCodec::Lz4  ? "lz4"
+                                                                 : "zlib")
+              << (m_compressionController ? ", adaptive" : "")
+              << ")" << std::endl;
     return true;
 }
 
@@ -113,24 +270,31 @@ bool LoggingManager::stop()
         writer->stop();
     }
     m_writers.clear();
+    if (m_queue)
+    {
+        m_queue->close();
+    }
+
+    // Writers are joined, so nothing else can be submitted; drain the ring before sealing.
+    if (m_ioStage)
+    {
+        m_ioStage->stop();
+    }
 
     // Seal each target with a batch at seqnum == count, giving the exporter a
-    // high-water-mark for tail-truncation detection.
+    // high-water-mark for tail-truncation detection. With Merkle checkpoints on, a
+    // final checkpoint over every earlier batch comes right before it.
     if (m_useEncryption && m_seqnumAllocator && m_storage)
     {
         try
         {
             Crypto crypto;
+            crypto.setNonceSource(m_nonces);
             Compression compression;
-            const std::vector<uint8_t> key(Crypto::KEY_SIZE, placeholder_crypto::KEY_BYTE);
 
-            for (const auto &[target, count] : m_seqnumAllocator->snapshot())
+            auto writeControlBatch = [&](const std::string &target, std::vector<uint8_t> plaintext,
+                                         uint64_t seqnum)
             {
-                if (count == 0)
-                    continue;
-
-                std::vector<uint8_t> plaintext(seal_marker::MAGIC,
-                                               seal_marker::MAGIC + seal_marker::MAGIC_LEN);
                 std::vector<uint8_t> scratch;
                 std::vector<uint8_t> *current = &plaintext;
                 std::vector<uint8_t> *other = &scratch;
@@ -138,16 +302,39 @@ bool LoggingManager::stop()
                 if (m_compressionLevel > 0)
                 {
                     compression.compress(current->data(), current->size(),
-                                         *other, m_compressionLevel);
+                                         *other, m_compressionLevel, m_compressionCodec);
                     std::swap(current, other);
                 }
 
                 std::vector<uint8_t> encrypted;
-                crypto.encrypt(current->data(), current->size(), key, encrypted,
-                               /*seqnum=*/count,
+                crypto.encrypt(current->data(), current->size(), *m_keyRing, encrypted,
+                               seqnum,
                                reinterpret_cast<const uint8_t *>(target.data()),
-                               target.size());
+                               target.size(),
+                               /*chunkSize=*/0, nullptr, m_cipherSuite);
                 m_storage->writeToFile(target, encrypted.data(), encrypted.size());
+            };
+
+            for (const auto &[target, count] : m_seqnumAllocator->snapshot())
+            {
+                if (count == 0)
+                    continue;
+
+                uint64_t sealSeqnum = count;
+                if (m_merkleLog)
+                {
+                    if (auto checkpoint = m_merkleLog->finalCheckpoint(target, *m_seqnumAllocator))
+                    {
+                        writeControlBatch(target,
+                                          merkle::encodeCheckpoint(checkpoint->leafCount, checkpoint->root),
+                                          checkpoint->seqnum);
+                        sealSeqnum = checkpoint->seqnum + 1;
+                    }
+                }
+                writeControlBatch(target,
+                                  std::vector<uint8_t>(seal_marker::MAGIC,
+                                                       seal_marker::MAGIC + seal_marker::MAGIC_LEN),
+                                  sealSeqnum);
             }
         }
         catch (const std::exception &e)
@@ -222,6 +409,63 @@ bool LoggingManager::appendBatch(std::vector<LogEntry> entries,
     return Logger::getInstance().appendBatch(std::move(entries), token, filename);
 }
 
+AppendTicket LoggingManager::appendAsync(LogEntry entry,
+                                         BufferQueue::ProducerToken &token,
+                                         const std::optional<std::string> &filename)
+{
+    auto state = std::make_shared<AppendTicket::State>();
+    AppendTicket ticket(state);
+
+    InflightGuard guard(m_inflightAppends);
+    if (!m_acceptingEntries.load(std::memory_order_acquire))
+    {
+        std::cerr << "LoggingSystem: Not accepting entries" << std::endl;
+        state->abandon();
+        return ticket;
+    }
+
+    if (!Logger::getInstance().append(std::move(entry), token, filename, state))
+    {
+        state->abandon();
+    }
+    return ticket;
+}
+
+AppendTicket LoggingManager::appendBatchAsync(std::vector<LogEntry> entries,
+                                              BufferQueue::ProducerToken &token,
+                                              const std::optional<std::string> &filename)
+{
+    auto state = std::make_shared<AppendTicket::State>(entries.size());
+    AppendTicket ticket(state);
+    if (entries.empty())
+    {
+        state->complete(true); // nothing to wait for
+        return ticket;
+    }
+
+    InflightGuard guard(m_inflightAppends);
+    if (!m_acceptingEntries.load(std::memory_order_acquire))
+    {
+        std::cerr << "LoggingSystem: Not accepting entries" << std::endl;
+        state->abandon();
+        return ticket;
+    }
+
+    // One target means one shard, so enqueueing is all-or-nothing and a rejected
+    // batch has nothing left to write.
+    if (!Logger::getInstance().appendBatch(std::move(entries), token, filename, state))
+    {
+        state->abandon();
+    }
+    return ticket;
+}
+
+void LoggingManager::rotateKey(uint32_t keyId, std::vector<uint8_t> key)
+{
+    m_keyRing->addKey(keyId, std::move(key));
+    m_keyRing->setActiveKey(keyId);
+}
+
 bool LoggingManager::exportLogs(
     const std::string &outputPath,
     std::chrono::system_clock::time_point fromTimestamp,
@@ -240,6 +484,8 @@ bool LoggingManager::exportLogs(
     filter.to = toTimestamp;
     filter.subjectId = dataSubjectId;
 
-    LogExporter exporter(m_basePath, m_useEncryption, m_compressionLevel);
+    // Export is rare, so its helpers exist only while it runs.
+    LogExporter exporter(m_basePath, m_useEncryption, m_compressionLevel, m_cryptoPool, m_keyRing,
+                         m_exportThreads > 0 ? std::make_shared<WorkerPool>(m_exportThreads) : nullptr);
     return exporter.exportToNDJSON(outputPath, filter);
 }
\ No newline at end of file
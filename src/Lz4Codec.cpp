@@ -0,0 +1,169 @@
+#include "Codec.hpp"
+#include <stdexcept>
+#include <string>
+
+#ifdef GDPR_LOGGING_HAVE_LZ4
+
+#include <lz4frame.h>
+
+namespace
+{
+std::runtime_error lz4Error(const char *what, size_t code)
+{
+    return std::runtime_error(std::string(what) + ": " + LZ4F_getErrorName(code));
+}
+
+// LZ4 frame format, so the exporter can inflate a blob as it streams in. Levels
+// below 3 use the fast compressor, 3-12 LZ4-HC.
+class Lz4Codec : public Codec
+{
+public:
+    Lz4Codec()
+    {
+        if (LZ4F_isError(LZ4F_createCompressionContext(&m_cctx, LZ4F_VERSION)))
+        {
+            throw std::runtime_error("Failed to create LZ4 compression context");
+        }
+        if (LZ4F_isError(LZ4F_createDecompressionContext(&m_dctx, LZ4F_VERSION)))
+        {
+            LZ4F_freeCompressionContext(m_cctx);
+            throw std::runtime_error("Failed to create LZ4 decompression context");
+        }
+    }
+
+    ~Lz4Codec() override
+    {
+        LZ4F_freeCompressionContext(m_cctx);
+        LZ4F_freeDecompressionContext(m_dctx);
+    }
+
+    void compress(const uint8_t *data, size_t size, std::vector<uint8_t> &out, int level,
+                  const CompressionDictionary *) override
+    {
+        LZ4F_preferences_t prefs = LZ4F_INIT_PREFERENCES;
+        prefs.compressionLevel = level;
+        // Whole batch in one update: nothing to gain from LZ4F's internal staging buffer.
+        prefs.autoFlush = 1;
+        prefs.frameInfo.contentSize = size;
+        // Blocks are independent of one another (the default), and the AEAD tag
+        // already covers the payload, so no content checksum.
+
+        const size_t base = out.size();
+        out.resize(base + LZ4F_compressFrameBound(size, &prefs));
+        uint8_t *dst = out.data() + base;
+        size_t capacity = out.size() - base;
+        size_t written = 0;
+
+        size_t rc = LZ4F_compressBegin(m_cctx, dst, capacity, &prefs);
+        if (!LZ4F_isError(rc))
+        {
+            written += rc;
+            rc = LZ4F_compressUpdate(m_cctx, dst + written, capacity - written, data, size, nullptr);
+        }
+        if (!LZ4F_isError(rc))
+        {
+            written += rc;
+            rc = LZ4F_compressEnd(m_cctx, dst + written, capacity - written, nullptr);
+        }
+        if (LZ4F_isError(rc))
+        {
+            out.resize(base);
+            throw lz4Error("Exception during LZ4 compression", rc);
+        }
+        out.resize(base + written + rc);
+    }
+
+    // The dictionary API of LZ4F is still experimental in the releases we build against.
+    bool supportsDictionaries() const override { return false; }
+
+    void beginDecompress(const CompressionDictionary *) override
+    {
+        LZ4F_resetDecompressionContext(m_dctx);
+        m_produced = 0;
+        m_ended = false;
+    }
+
+    void decompressChunk(const uint8_t *data, size_t size, const OutputSink &sink,
+                         size_t maxDecompressedSize) override
+    {
+        if (size == 0)
+        {
+            return;
+        }
+        if (m_ended)
+        {
+            throw std::runtime_error("Exception during LZ4 decompression: data after end of stream");
+        }
+
+        uint8_t outbuffer[32768];
+        while (true)
+        {
+            size_t consumed = size;
+            size_t produced = sizeof(outbuffer);
+            const size_t rc = LZ4F_decompress(m_dctx, outbuffer, &produced, data, &consumed, nullptr);
+            if (LZ4F_isError(rc))
+            {
+                LZ4F_resetDecompressionContext(m_dctx);
+                throw lz4Error("Exception during LZ4 decompression", rc);
+            }
+            data += consumed;
+            size -= consumed;
+            m_produced += produced;
+            if (m_produced > maxDecompressedSize)
+            {
+                LZ4F_resetDecompressionContext(m_dctx);
+                throw std::runtime_error("Decompressed data exceeds maxDecompressedSize");
+            }
+            if (produced > 0)
+            {
+                sink(outbuffer, produced);
+            }
+
+            if (rc == 0)
+            {
+                // The frame is complete and fully flushed.
+                m_ended = true;
+                if (size != 0)
+                {
+                    throw std::runtime_error("Exception during LZ4 decompression: data after end of stream");
+                }
+                return;
+            }
+            // A full output buffer may hide more buffered output; otherwise stop once
+            // the input is used up.
+            if (size == 0 && produced < sizeof(outbuffer))
+            {
+                return;
+            }
+        }
+    }
+
+    void endDecompress() override
+    {
+        if (!m_ended)
+        {
+            throw std::runtime_error("Exception during LZ4 decompression: truncated stream");
+        }
+    }
+
+private:
+    LZ4F_cctx *m_cctx = nullptr;
+    LZ4F_dctx *m_dctx = nullptr;
+    size_t m_produced = 0;
+    bool m_ended = false;
+};
+} // namespace
+
+std::unique_ptr<Codec> makeLz4Codec()
+{
+    return std::make_unique<Lz4Codec>();
+}
+
+#else // !GDPR_LOGGING_HAVE_LZ4
+
+std::unique_ptr<Codec> makeLz4Codec()
+{
+    throw std::runtime_error("LZ4 support was not compiled in");
+}
+
+#endif
@@ -0,0 +1,283 @@
+#include "MerkleTree.hpp"
+#include <iostream>
+#include "ByteOrder.hpp"
+#include "SeqnumAllocator.hpp"
+#include <openssl/evp.h>
+#include <cstring>
+#include <stdexcept>
+
+namespace merkle
+{
+namespace
+{
+constexpr uint8_t LEAF_PREFIX = 0x00;
+constexpr uint8_t NODE_PREFIX = 0x01;
+
+// Largest power of two strictly below n (n > 1).
+size_t splitPoint(size_t n)
+{
+    size_t k = 1;
+    while (k << 1 < n)
+        k <<= 1;
+    return k;
+}
+
+Hash rootOfRange(const std::vector<Hash> &leaves, size_t begin, size_t end)
+{
+    if (end - begin == 1)
+        return leaves[begin];
+    const size_t k = splitPoint(end - begin);
+    return nodeHash(rootOfRange(leaves, begin, begin + k), rootOfRange(leaves, begin + k, end));
+}
+
+void pathOfRange(const std::vector<Hash> &leaves, size_t begin, size_t end, size_t index,
+                 std::vector<Hash> &proof)
+{
+    if (end - begin == 1)
+        return;
+    const size_t k = splitPoint(end - begin);
+    if (index < k)
+    {
+        pathOfRange(leaves, begin, begin + k, index, proof);
+        proof.push_back(rootOfRange(leaves, begin + k, end));
+    }
+    else
+    {
+        pathOfRange(leaves, begin + k, end, index - k, proof);
+        proof.push_back(rootOfRange(leaves, begin, begin + k));
+    }
+}
+} // namespace
+
+struct LeafHasher::Impl
+{
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+    ~Impl() { EVP_MD_CTX_free(ctx); }
+
+    void reset()
+    {
+        if (!ctx || EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr) != 1 ||
+            EVP_DigestUpdate(ctx, &LEAF_PREFIX, 1) != 1)
+        {
+            throw std::runtime_error("Failed to initialize SHA-256");
+        }
+    }
+};
+
+LeafHasher::LeafHasher() : m_impl(std::make_unique<Impl>())
+{
+    m_impl->reset();
+}
+
+LeafHasher::~LeafHasher() = default;
+
+void LeafHasher::update(const uint8_t *data, size_t size)
+{
+    if (size > 0 && EVP_DigestUpdate(m_impl->ctx, data, size) != 1)
+    {
+        throw std::runtime_error("SHA-256 update failed");
+    }
+}
+
+Hash LeafHasher::finish()
+{
+    Hash out;
+    if (EVP_DigestFinal_ex(m_impl->ctx, out.data(), nullptr) != 1)
+    {
+        throw std::runtime_error("SHA-256 finalization failed");
+    }
+    m_impl->reset();
+    return out;
+}
+
+Hash leafHash(const uint8_t *data, size_t size)
+{
+    thread_local LeafHasher hasher;
+    hasher.update(data, size);
+    return hasher.finish();
+}
+
+Hash nodeHash(const Hash &left, const Hash &right)
+{
+    uint8_t buf[1 + 2 * sizeof(Hash)];
+    buf[0] = NODE_PREFIX;
+    std::memcpy(buf + 1, left.data(), left.size());
+    std::memcpy(buf + 1 + left.size(), right.data(), right.size());
+    Hash out;
+    if (EVP_Digest(buf, sizeof(buf), out.data(), nullptr, EVP_sha256(), nullptr) != 1)
+    {
+        throw std::runtime_error("SHA-256 failed");
+    }
+    return out;
+}
+
+Hash rootOf(const std::vector<Hash> &leaves, size_t count)
+{
+    if (count == 0 || count > leaves.size())
+    {
+        throw std::invalid_argument("merkle::rootOf: count out of range");
+    }
+    return rootOfRange(leaves, 0, count);
+}
+
+std::vector<Hash> inclusionProof(const std::vector<Hash> &leaves, size_t treeSize, size_t index)
+{
+    if (treeSize > leaves.size() || index >= treeSize)
+    {
+        throw std::invalid_argument("merkle::inclusionProof: index out of range");
+    }
+    std::vector<Hash> proof;
+    pathOfRange(leaves, 0, treeSize, index, proof);
+    return proof;
+}
+
+// RFC 9162, section 2.1.3.2.
+bool verifyInclusion(const Hash &leaf, uint64_t index, uint64_t treeSize,
+                     const std::vector<Hash> &proof, const Hash &root)
+{
+    if (index >= treeSize)
+        return false;
+    uint64_t fn = index;
+    uint64_t sn = treeSize - 1;
+    Hash r = leaf;
+    for (const Hash &p : proof)
+    {
+        if (sn == 0)
+            return false;
+        if ((fn & 1) || fn == sn)
+        {
+            r = nodeHash(p, r);
+            while (!(fn & 1) && fn != 0)
+            {
+                fn >>= 1;
+                sn >>= 1;
+            }
+        }
+        else
+        {
+            r = nodeHash(r, p);
+        }
+        fn >>= 1;
+        sn >>= 1;
+    }
+    return sn == 0 && r == root;
+}
+
+void Frontier::append(const Hash &leaf)
+{
+    m_subtrees.emplace_back(1, leaf);
+    while (m_subtrees.size() >= 2 &&
+           m_subtrees[m_subtrees.size() - 2].first == m_subtrees.back().first)
+    {
+        auto right = m_subtrees.back();
+        m_subtrees.pop_back();
+        auto &left = m_subtrees.back();
+        left.second = nodeHash(left.second, right.second);
+        left.first *= 2;
+    }
+    ++m_size;
+}
+
+Hash Frontier::root() const
+{
+    if (m_subtrees.empty())
+    {
+        throw std::logic_error("merkle::Frontier: root of an empty tree");
+    }
+    // Subtree sizes are the binary digits of m_size, largest first; folding them
+    // from the right reproduces the split-at-largest-power-of-two tree shape.
+    Hash r = m_subtrees.back().second;
+    for (size_t i = m_subtrees.size() - 1; i > 0; --i)
+    {
+        r = nodeHash(m_subtrees[i - 1].second, r);
+    }
+    return r;
+}
+
+std::vector<uint8_t> encodeCheckpoint(uint64_t leafCount, const Hash &root)
+{
+    std::vector<uint8_t> out(CHECKPOINT_SIZE);
+    std::memcpy(out.data(), CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_LEN);
+    byteorder::writeLE64(out.data() + CHECKPOINT_MAGIC_LEN, leafCount);
+    std::memcpy(out.data() + CHECKPOINT_MAGIC_LEN + sizeof(uint64_t), root.data(), root.size());
+    return out;
+}
+
+bool decodeCheckpoint(const uint8_t *data, size_t size, uint64_t &leafCount, Hash &root)
+{
+    if (size != CHECKPOINT_SIZE || std::memcmp(data, CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_LEN) != 0)
+        return false;
+    leafCount = byteorder::readLE64(data + CHECKPOINT_MAGIC_LEN);
+    std::memcpy(root.data(), data + CHECKPOINT_MAGIC_LEN + sizeof(uint64_t), root.size());
+    return true;
+}
+
+MerkleAccumulator::MerkleAccumulator(size_t interval) : m_interval(interval)
+{
+    if (interval == 0)
+    {
+        throw std::invalid_argument("MerkleAccumulator: interval must be > 0");
+    }
+}
+
+void MerkleAccumulator::append(TargetTree &tree, uint64_t seqnum, const Hash &leaf)
+{
+    if (tree.abandoned)
+        return;
+    tree.waiting.emplace(seqnum, leaf);
+    for (auto it = tree.waiting.begin();
+         it != tree.waiting.end() && it->first == tree.frontier.size();
+         it = tree.waiting.erase(it))
+    {
+        tree.frontier.append(it->second);
+    }
+}
+
+std::optional<Checkpoint> MerkleAccumulator::add(const std::string &target, uint64_t seqnum,
+                                                 const Hash &leaf, SeqnumAllocator &seqnums)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    TargetTree &tree = m_trees[target];
+    append(tree, seqnum, leaf);
+    if (tree.abandoned || ++tree.sinceCheckpoint < m_interval || tree.frontier.size() == 0)
+        return std::nullopt;
+    tree.sinceCheckpoint = 0;
+    return Checkpoint{seqnums.next(target), tree.frontier.size(), tree.frontier.root()};
+}
+
+void MerkleAccumulator::addCheckpoint(const std::string &target, uint64_t seqnum, const Hash &leaf)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    append(m_trees[target], seqnum, leaf);
+}
+
+std::optional<Checkpoint> MerkleAccumulator::finalCheckpoint(const std::string &target,
+                                                             SeqnumAllocator &seqnums)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_trees.find(target);
+    if (it == m_trees.end() || it->second.abandoned || it->second.frontier.size() == 0)
+        return std::nullopt;
+    it->second.sinceCheckpoint = 0;
+    return Checkpoint{seqnums.next(target), it->second.frontier.size(), it->second.frontier.root()};
+}
+
+void MerkleAccumulator::abandon(const std::string &target, uint64_t seqnum)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    TargetTree &tree = m_trees[target];
+    if (tree.abandoned)
+        return;
+    tree.abandoned = true;
+    tree.waiting.clear();
+    std::cerr << "MerkleAccumulator: seqnum " << seqnum << " of " << target
+              << " will never be written; no further checkpoints for this target" << std::endl;
+}
+
+size_t MerkleAccumulator::waitingLeaves(const std::string &target)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_trees.find(target);
+    return it == m_trees.end() ? 0 : it->second.waiting.size();
+}
+} // namespace merkle
@@ -0,0 +1,139 @@
+#include "NonceSequence.hpp"
+#include "ByteOrder.hpp"
+#include "Crypto.hpp"
+#include <openssl/rand.h>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+std::runtime_error stateError(const std::string &what, const std::string &path)
+{
+    return std::runtime_error("NonceSequence: failed to " + what + " " + path + ": " + std::strerror(errno));
+}
+
+void writeAll(int fd, const uint8_t *data, size_t size, const std::string &path)
+{
+    while (size > 0)
+    {
+        const ssize_t n = ::write(fd, data, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            throw stateError("write", path);
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+} // namespace
+
+NonceSequence::NonceSequence(std::string stateFile) : m_stateFile(std::move(stateFile))
+{
+    if (m_stateFile.empty())
+    {
+        uint8_t prefix[sizeof(uint32_t)];
+        if (RAND_bytes(prefix, sizeof(prefix)) != 1)
+        {
+            throw std::runtime_error("NonceSequence: failed to generate random prefix");
+        }
+        const uint64_t start = static_cast<uint64_t>(byteorder::readLE32(prefix)) << 32;
+        m_next.store(start, std::memory_order_relaxed);
+        m_limit = start + 0xFFFFFFFFu;
+        return;
+    }
+
+    uint64_t resume = 0;
+    const int fd = ::open(m_stateFile.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0)
+    {
+        uint8_t buf[sizeof(uint64_t)];
+        const ssize_t n = ::read(fd, buf, sizeof(buf));
+        ::close(fd);
+        if (n != static_cast<ssize_t>(sizeof(buf)))
+        {
+            throw std::runtime_error("NonceSequence: corrupt state file " + m_stateFile);
+        }
+        resume = byteorder::readLE64(buf);
+    }
+    else if (errno != ENOENT)
+    {
+        throw stateError("open", m_stateFile);
+    }
+
+    m_next.store(resume, std::memory_order_relaxed);
+    m_reserved.store(resume, std::memory_order_relaxed);
+    reserveThrough(resume);
+}
+
+void NonceSequence::next(uint8_t *iv)
+{
+    const uint64_t value = m_next.fetch_add(1, std::memory_order_relaxed);
+    if (m_stateFile.empty())
+    {
+        if (value >= m_limit)
+        {
+            throw std::runtime_error("NonceSequence: counter space of this prefix exhausted");
+        }
+    }
+    else if (value >= m_reserved.load(std::memory_order_acquire))
+    {
+        reserveThrough(value);
+    }
+
+    byteorder::writeLE64(iv, value);
+    std::memset(iv + sizeof(uint64_t), 0, Crypto::GCM_IV_SIZE - sizeof(uint64_t));
+}
+
+void NonceSequence::reserveThrough(uint64_t value)
+{
+    std::lock_guard<std::mutex> lock(m_reserveMutex);
+    uint64_t reserved = m_reserved.load(std::memory_order_relaxed);
+    if (value < reserved)
+    {
+        return;
+    }
+    while (reserved <= value)
+    {
+        reserved += RESERVE_BLOCK;
+    }
+
+    // Write-then-rename, so a crash leaves either the old or the new bound.
+    const std::string tmp = m_stateFile + ".tmp";
+    const int fd = ::open(tmp.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        throw stateError("create", tmp);
+    }
+    uint8_t buf[sizeof(uint64_t)];
+    byteorder::writeLE64(buf, reserved);
+    try
+    {
+        writeAll(fd, buf, sizeof(buf), tmp);
+        if (::fsync(fd) != 0)
+            throw stateError("fsync", tmp);
+    }
+    catch (...)
+    {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+    if (::rename(tmp.c_str(), m_stateFile.c_str()) != 0)
+    {
+        throw stateError("rename", tmp);
+    }
+
+    const std::string dir = std::filesystem::path(m_stateFile).parent_path().string();
+    const int dirFd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd >= 0)
+    {
+        ::fsync(dirFd);
+        ::close(dirFd);
+    }
+
+    m_reserved.store(reserved, std::memory_order_release);
+}
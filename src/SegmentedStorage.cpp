@@ -10,22 +10,63 @@ SegmentedStorage::SegmentedStorage(const std::string &basePath,
                                    size_t maxSegmentSize,
                                    size_t maxAttempts,
                                    std::chrono::milliseconds baseRetryDelay,
-                                   size_t maxOpenFiles)
+                                   size_t maxOpenFiles,
+                                   DurabilityPolicy durability,
+                                   StorageBackend backend,
+                                   unsigned ioUringQueueDepth)
     : m_basePath(basePath),
       m_baseFilename(baseFilename),
       m_maxSegmentSize(maxSegmentSize),
       m_maxAttempts(maxAttempts),
       m_baseRetryDelay(baseRetryDelay),
       m_maxOpenFiles(maxOpenFiles),
+      m_durability(durability),
       m_cache(maxOpenFiles, this)
 {
+    if (m_durability.mode == DurabilityMode::Periodic && m_durability.syncInterval.count() <= 0)
+    {
+        throw std::invalid_argument("SegmentedStorage: periodic syncInterval must be > 0");
+    }
+
+    if (backend == StorageBackend::IoUring)
+    {
+        try
+        {
+            // A few spare slots for get() races that briefly open a second fd.
+            m_uring = std::make_unique<IoUring>(ioUringQueueDepth, maxOpenFiles + 16);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "SegmentedStorage: io_uring backend unavailable (" << e.what()
+                      << "), falling back to pwrite" << std::endl;
+        }
+    }
+
     std::filesystem::create_directories(m_basePath);
     m_cache.get(m_baseFilename); // pre-warm
+
+    if (m_durability.mode == DurabilityMode::Periodic)
+    {
+        m_syncThread = std::thread(&SegmentedStorage::periodicSyncLoop, this);
+    }
 }
 
 SegmentedStorage::~SegmentedStorage()
 {
+    if (m_syncThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_syncThreadMutex);
+            m_stopSyncThread = true;
+        }
+        m_syncThreadCv.notify_all();
+        m_syncThread.join();
+    }
     m_cache.closeAll();
+    if (m_uring)
+    {
+        m_uring->drain();
+    }
 }
 
 std::shared_ptr<SegmentedStorage::CacheEntry> SegmentedStorage::LRUCache::get(const std::string &filename)
@@ -52,18 +93,7 @@ std::shared_ptr<SegmentedStorage::CacheEntry> SegmentedStorage::LRUCache::get(co
     auto it = m_cache.find(filename);
     if (it != m_cache.end())
     {
-        if (newEntry->fd >= 0)
-        {
-            try
-            {
-                m_parent->fsyncRetry(newEntry->fd);
-            }
-            catch (...)
-            {
-            }
-            ::close(newEntry->fd);
-            newEntry->fd = -1;
-        }
+        m_parent->closeSegmentFile(*newEntry, true);
         m_lruList.erase(it->second.lruIt);
         m_lruList.push_front(filename);
         it->second.lruIt = m_lruList.begin();
@@ -94,19 +124,7 @@ void SegmentedStorage::LRUCache::evictLRU()
         auto entry = it->second.entry;
         {
             std::unique_lock<std::shared_mutex> fileLock(entry->fileMutex);
-            int fd = entry->fd;
-            entry->fd = -1;
-            if (fd >= 0)
-            {
-                try
-                {
-                    m_parent->fsyncRetry(fd);
-                }
-                catch (...)
-                {
-                }
-                ::close(fd);
-            }
+            m_parent->closeSegmentFile(*entry, true);
         }
         m_cache.erase(it);
     }
@@ -122,7 +140,7 @@ std::shared_ptr<SegmentedStorage::CacheEntry> SegmentedStorage::LRUCache::recons
 
     std::string segmentPath = m_parent->generateSegmentPath(filename, latestIndex);
     entry->currentSegmentPath = segmentPath;
-    entry->fd = m_parent->openWithRetry(segmentPath.c_str(), O_CREAT | O_RDWR | O_APPEND, 0644);
+    m_parent->openSegmentFile(*entry, segmentPath);
 
     size_t fileSize = m_parent->getFileSize(segmentPath);
     entry->currentOffset.store(fileSize, std::memory_order_release);
@@ -163,6 +181,18 @@ void SegmentedStorage::LRUCache::invalidate(const std::string &filename)
     m_cache.erase(it);
 }
 
+std::vector<std::shared_ptr<SegmentedStorage::CacheEntry>> SegmentedStorage::LRUCache::snapshot() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<std::shared_ptr<CacheEntry>> entries;
+    entries.reserve(m_cache.size());
+    for (const auto &pair : m_cache)
+    {
+        entries.push_back(pair.second.entry);
+    }
+    return entries;
+}
+
 void SegmentedStorage::LRUCache::closeAll()
 {
     std::lock_guard<std::mutex> lock(m_mutex);
@@ -172,6 +202,11 @@ void SegmentedStorage::LRUCache::closeAll()
         std::unique_lock<std::shared_mutex> fileLock(entry->fileMutex);
         int fd = entry->fd;
         entry->fd = -1;
+        if (m_parent->m_uring)
+        {
+            m_parent->m_uring->unregisterFile(entry->fileSlot);
+        }
+        entry->fileSlot = -1;
         if (fd >= 0)
         {
             try
@@ -258,11 +293,48 @@ size_t SegmentedStorage::writeToFile(const std::string &filename, std::vector<ui
 
 size_t SegmentedStorage::writeToFile(const std::string &filename, const uint8_t *data, size_t size)
 {
+    struct iovec iov;
+    iov.iov_base = const_cast<uint8_t *>(data);
+    iov.iov_len = size;
+    return writevToFile(filename, &iov, 1);
+}
+
+size_t SegmentedStorage::writev(const struct iovec *iov, size_t iovcnt, size_t *buffersWritten)
+{
+    return writevToFile(m_baseFilename, iov, iovcnt, buffersWritten);
+}
+
+size_t SegmentedStorage::writevToFile(const std::string &filename, const struct iovec *iov, size_t iovcnt,
+                                      size_t *buffersWritten)
+{
+    if (buffersWritten)
+        *buffersWritten = 0;
+    size_t size = 0;
+    for (size_t i = 0; i < iovcnt; ++i)
+        size += iov[i].iov_len;
     if (size == 0)
+    {
+        if (buffersWritten)
+            *buffersWritten = iovcnt;
         return 0;
+    }
+
+    if (iovcnt > 1 && size > m_maxSegmentSize)
+    {
+        // Blobs must not straddle segments; too big to land together, so write
+        // them one by one and let each rotate as needed.
+        for (size_t i = 0; i < iovcnt; ++i)
+        {
+            writevToFile(filename, &iov[i], 1);
+            if (buffersWritten)
+                *buffersWritten = i + 1;
+        }
+        return size;
+    }
 
     std::shared_ptr<CacheEntry> entry = m_cache.get(filename);
     size_t writeOffset;
+    uint64_t ticket;
 
     // Reserve and pwrite under a shared_lock so a concurrent rotation (exclusive lock)
     // can't slip between fetch_add and pwrite and strand the reservation on a closed fd.
@@ -315,33 +387,212 @@ size_t SegmentedStorage::writeToFile(const std::string &filename, const uint8_t
             continue;
         }
 
-        pwriteFull(entry->fd, data, size, static_cast<off_t>(writeOffset));
+        writeSegmentFile(*entry, iov, iovcnt, static_cast<off_t>(writeOffset));
+        // Taken while still holding the shared lock, so the bytes behind this ticket
+        // are either on the current fd or were synced by the rotation/eviction that
+        // replaced it.
+        ticket = entry->writtenSeq.fetch_add(1, std::memory_order_acq_rel) + 1;
         break;
     }
 
+    if (m_durability.mode == DurabilityMode::GroupCommit)
+    {
+        awaitDurable(*entry, ticket);
+    }
+
+    if (buffersWritten)
+        *buffersWritten = iovcnt;
     return size;
 }
 
+void SegmentedStorage::awaitDurable(CacheEntry &entry, uint64_t ticket)
+{
+    std::unique_lock<std::mutex> lock(entry.syncMutex);
+    while (entry.durableSeq < ticket)
+    {
+        if (entry.syncInProgress)
+        {
+            // Someone else is leading a round; it may or may not cover our ticket.
+            entry.syncCv.wait(lock);
+            continue;
+        }
+
+        entry.syncInProgress = true;
+        const uint64_t target = entry.writtenSeq.load(std::memory_order_acquire);
+        lock.unlock();
+
+        std::exception_ptr error;
+        try
+        {
+            // Shared lock keeps the fd open; if it was rotated or evicted since our
+            // pwrite, the old fd was fsync'ed before it was closed, unless eviction
+            // recorded that the fsync failed.
+            std::shared_lock<std::shared_mutex> fileLock(entry.fileMutex);
+            if (entry.fd >= 0)
+            {
+                syncSegmentData(entry);
+            }
+            else if (entry.closeSyncFailed)
+            {
+                throw std::runtime_error("SegmentedStorage: segment " + entry.currentSegmentPath +
+                                         " was closed without a successful fsync");
+            }
+            m_syncRounds.fetch_add(1, std::memory_order_relaxed);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        entry.syncInProgress = false;
+        if (!error)
+        {
+            entry.durableSeq = std::max(entry.durableSeq, target);
+        }
+        entry.syncCv.notify_all();
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+void SegmentedStorage::periodicSyncLoop()
+{
+    std::unique_lock<std::mutex> lock(m_syncThreadMutex);
+    while (!m_syncThreadCv.wait_for(lock, m_durability.syncInterval, [this]()
+                                    { return m_stopSyncThread; }))
+    {
+        lock.unlock();
+        for (const auto &entry : m_cache.snapshot())
+        {
+            uint64_t written = entry->writtenSeq.load(std::memory_order_acquire);
+            bool dirty;
+            {
+                std::lock_guard<std::mutex> syncLock(entry->syncMutex);
+                dirty = entry->durableSeq < written;
+            }
+            if (!dirty)
+            {
+                continue;
+            }
+            try
+            {
+                awaitDurable(*entry, written);
+            }
+            catch (const std::exception &e)
+            {
+                // Leave the entry dirty; the next tick retries.
+                std::cerr << "SegmentedStorage: periodic sync failed: " << e.what() << std::endl;
+            }
+        }
+        lock.lock();
+    }
+}
+
 void SegmentedStorage::flush()
 {
     m_cache.flushAll();
+    if (m_uring)
+    {
+        // Rotated-out segments may still have their background fsync in flight.
+        m_uring->drain();
+    }
 }
 
-std::string SegmentedStorage::rotateSegment(const std::string &filename, std::shared_ptr<CacheEntry> entry)
+void SegmentedStorage::openSegmentFile(CacheEntry &entry, const std::string &path)
 {
-    // Caller holds unique_lock(entry->fileMutex).
-    if (entry->fd >= 0)
+    const int flags = O_CREAT | O_RDWR | O_APPEND;
+    if (!m_uring)
     {
-        fsyncRetry(entry->fd);
-        ::close(entry->fd);
-        entry->fd = -1;
+        entry.fd = openWithRetry(path.c_str(), flags, 0644);
+        return;
     }
+    entry.fd = retryWithBackoff([&]()
+                                { return m_uring->openat(path.c_str(), flags, 0644); });
+    entry.fileSlot = m_uring->registerFile(entry.fd);
+}
+
+void SegmentedStorage::writeSegmentFile(const CacheEntry &entry, const struct iovec *iov, size_t iovcnt, off_t offset)
+{
+    if (iovcnt == 1)
+    {
+        const auto *data = static_cast<const uint8_t *>(iov[0].iov_base);
+        if (m_uring)
+            m_uring->writeFull(entry.fd, entry.fileSlot, data, iov[0].iov_len, offset);
+        else
+            pwriteFull(entry.fd, data, iov[0].iov_len, offset);
+        return;
+    }
+
+    if (m_uring)
+        m_uring->writevFull(entry.fd, entry.fileSlot, iov, iovcnt, offset);
+    else
+        pwritevFull(entry.fd, iov, iovcnt, offset);
+}
+
+void SegmentedStorage::syncSegmentData(const CacheEntry &entry)
+{
+    if (m_uring)
+    {
+        retryWithBackoff([&]()
+                         { m_uring->fdatasync(entry.fd, entry.fileSlot); return 0; });
+    }
+    else
+    {
+        fdatasyncRetry(entry.fd);
+    }
+}
+
+void SegmentedStorage::closeSegmentFile(CacheEntry &entry, bool bestEffort)
+{
+    const int fd = entry.fd;
+    if (fd < 0)
+    {
+        return;
+    }
+
+    if (m_uring && m_durability.mode != DurabilityMode::GroupCommit)
+    {
+        m_uring->unregisterFile(entry.fileSlot);
+        entry.fileSlot = -1;
+        entry.fd = -1;
+        m_uring->fsyncAndCloseAsync(fd);
+        return;
+    }
+
+    try
+    {
+        fsyncRetry(fd);
+    }
+    catch (const std::exception &e)
+    {
+        if (!bestEffort)
+            throw;
+        std::cerr << "SegmentedStorage: fsync before closing " << entry.currentSegmentPath
+                  << " failed: " << e.what() << std::endl;
+        entry.closeSyncFailed = true;
+    }
+    if (m_uring)
+    {
+        m_uring->unregisterFile(entry.fileSlot);
+    }
+    entry.fileSlot = -1;
+    entry.fd = -1;
+    ::close(fd);
+}
+
+std::string SegmentedStorage::rotateSegment(const std::string &filename, std::shared_ptr<CacheEntry> entry)
+{
+    // Caller holds unique_lock(entry->fileMutex).
+    closeSegmentFile(*entry, false);
 
     size_t newIndex = entry->segmentIndex.fetch_add(1, std::memory_order_acq_rel) + 1;
     entry->currentOffset.store(0, std::memory_order_release);
     std::string newPath = generateSegmentPath(filename, newIndex);
     entry->currentSegmentPath = newPath;
-    entry->fd = openWithRetry(newPath.c_str(), O_CREAT | O_RDWR | O_APPEND, 0644);
+    openSegmentFile(*entry, newPath);
 
     // Bump generation last so an acquire-reader that sees the new value also sees the
     // reset offset and new fd from the preceding release stores.
@@ -0,0 +1,126 @@
+#include "WorkerPool.hpp"
+
+WorkerPool::WorkerPool(size_t numThreads)
+{
+    m_threads.reserve(numThreads);
+    for (size_t i = 0; i < numThreads; ++i)
+    {
+        m_threads.emplace_back(&WorkerPool::run, this);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (auto &thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+void WorkerPool::parallelFor(size_t count, const std::function<void(size_t)> &fn)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->fn = &fn;
+    job->count = count;
+
+    if (count > 1 && !m_threads.empty())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.push_back(job);
+        }
+        m_cv.notify_all();
+    }
+
+    work(*job);
+
+    {
+        std::unique_lock<std::mutex> lock(job->mutex);
+        job->doneCv.wait(lock, [&]()
+                         { return job->finished.load(std::memory_order_acquire) == job->count; });
+    }
+
+    if (job->error)
+    {
+        std::rethrow_exception(job->error);
+    }
+}
+
+void WorkerPool::work(Job &job)
+{
+    while (true)
+    {
+        const size_t index = job.next.fetch_add(1, std::memory_order_relaxed);
+        if (index >= job.count)
+        {
+            return;
+        }
+
+        if (!job.failed.load(std::memory_order_acquire))
+        {
+            try
+            {
+                (*job.fn)(index);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(job.mutex);
+                if (!job.error)
+                {
+                    job.error = std::current_exception();
+                }
+                job.failed.store(true, std::memory_order_release);
+            }
+        }
+
+        if (job.finished.fetch_add(1, std::memory_order_acq_rel) + 1 == job.count)
+        {
+            {
+                std::lock_guard<std::mutex> lock(job.mutex);
+            }
+            job.doneCv.notify_all();
+        }
+    }
+}
+
+void WorkerPool::run()
+{
+    while (true)
+    {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]()
+                      { return m_stop || !m_jobs.empty(); });
+            if (m_jobs.empty())
+            {
+                return;
+            }
+            job = m_jobs.front();
+            // Every index is claimed: nothing left for other helpers to pick up.
+            if (job->next.load(std::memory_order_relaxed) >= job->count)
+            {
+                m_jobs.pop_front();
+                continue;
+            }
+        }
+        work(*job);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_jobs.empty() && m_jobs.front() == job)
+            {
+                m_jobs.pop_front();
+            }
+        }
+    }
+}
@@ -2,28 +2,97 @@
 #include "Crypto.hpp"
 #include "Compression.hpp"
 #include "PlaceholderCryptoMaterial.hpp"
+#include "CpuAffinity.hpp"
 #include <iostream>
 #include <chrono>
 #include <optional>
 #include <string>
 #include <unordered_map>
+#include <iterator>
+#include <vector>
+#include <algorithm>
+#include <sys/uio.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+// Empty polls SpinYield spends spinning before it starts yielding.
+constexpr size_t SPIN_ROUNDS_BEFORE_YIELD = 64;
+// Upper bound on a single park so a lost wakeup can never stall a writer for long.
+constexpr std::chrono::milliseconds MAX_PARK_DURATION{50};
+// Written blob buffers kept for reuse by the CPU stages.
+constexpr size_t MAX_SPARE_BLOBS = 16;
+// Per-target map nodes kept after their target goes quiet, so the vectors in
+// them keep their allocations for the next target that shows up.
+constexpr size_t MAX_SPARE_NODES = 64;
+
+// Finds `key` in `map`, inserting a spare node (or a fresh one) if it is absent.
+template <typename Map>
+typename Map::iterator acquireNode(Map &map, std::vector<typename Map::node_type> &spares,
+                                   const typename Map::key_type &key)
+{
+    auto it = map.find(key);
+    if (it != map.end())
+        return it;
+    if (spares.empty())
+        return map.try_emplace(key).first;
+    auto node = std::move(spares.back());
+    spares.pop_back();
+    node.key() = key;
+    return map.insert(std::move(node)).position;
+}
+
+// Removes the node at `it`, keeping it as a spare, and returns the next iterator.
+template <typename Map>
+typename Map::iterator releaseNode(Map &map, std::vector<typename Map::node_type> &spares,
+                                   typename Map::iterator it)
+{
+    auto next = std::next(it);
+    auto node = map.extract(it);
+    if (spares.size() < MAX_SPARE_NODES)
+        spares.push_back(std::move(node));
+    return next;
+}
+
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+} // namespace
 
 Writer::Writer(BufferQueue &queue,
                std::shared_ptr<SegmentedStorage> storage,
-               size_t batchSize,
-               bool useEncryption,
-               int compressionLevel,
-               std::shared_ptr<SeqnumAllocator> seqnumAllocator,
-               std::string baseFilename)
+               WriterOptions options)
     : m_queue(queue),
       m_storage(std::move(storage)),
-      m_seqnumAllocator(seqnumAllocator ? std::move(seqnumAllocator)
-                                        : std::make_shared<SeqnumAllocator>()),
-      m_baseFilename(std::move(baseFilename)),
-      m_batchSize(batchSize),
-      m_useEncryption(useEncryption),
-      m_compressionLevel(compressionLevel),
-      m_consumerToken(queue.createConsumerToken())
+      m_seqnumAllocator(options.seqnumAllocator ? std::move(options.seqnumAllocator)
+                                                : std::make_shared<SeqnumAllocator>()),
+      m_ioStage(std::move(options.ioStage)),
+      m_cryptoPool(std::move(options.cryptoPool)),
+      m_keyRing(options.keyRing ? std::move(options.keyRing) : placeholder_crypto::makeKeyRing()),
+      m_nonces(std::move(options.nonces)),
+      m_merkleLog(std::move(options.merkleLog)),
+      m_baseFilename(std::move(options.baseFilename)),
+      m_batchSize(options.batchSize),
+      m_maxBatchBytes(options.maxBatchBytes),
+      m_maxBatchLinger(options.maxBatchLinger),
+      m_useEncryption(options.useEncryption),
+      m_batchEncoding(options.batchEncoding),
+      m_compressionLevel(options.compressionLevel),
+      m_compressionCodec(options.compressionCodec),
+      m_dictionaries(std::move(options.dictionaries)),
+      m_compressionController(std::move(options.compressionController)),
+      m_idleStrategy(options.idleStrategy),
+      m_cpuAffinity(std::move(options.cpuAffinity)),
+      m_encryptionChunkSize(options.encryptionChunkSize),
+      m_cipherSuite(options.cipherSuite),
+      m_consumerToken(queue.createConsumerToken(options.queueShard))
 {
 }
 
@@ -46,6 +115,7 @@ void Writer::stop()
 {
     if (m_running.exchange(false))
     {
+        m_queue.wakeConsumers();
         if (m_writerThread && m_writerThread->joinable())
         {
             m_writerThread->join();
@@ -58,82 +128,332 @@ bool Writer::isRunning() const
     return m_running.load();
 }
 
+void Writer::idle(size_t &idleRounds, std::chrono::microseconds maxWait)
+{
+    switch (m_idleStrategy)
+    {
+    case WriterIdleStrategy::BusySpin:
+        cpuRelax();
+        break;
+    case WriterIdleStrategy::SpinYield:
+        if (idleRounds < SPIN_ROUNDS_BEFORE_YIELD)
+        {
+            cpuRelax();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+        break;
+    case WriterIdleStrategy::Park:
+        m_queue.waitForItems(m_consumerToken, maxWait);
+        break;
+    }
+    ++idleRounds;
+}
+
 void Writer::processLogEntries()
 {
+    using Clock = std::chrono::steady_clock;
+
+    // Pin before anything below allocates, so the pipeline state is node-local.
+    if (!m_cpuAffinity.empty() && !cpu_affinity::pinCurrentThread(m_cpuAffinity))
+    {
+        std::cerr << "Writer: could not pin to the requested CPUs; running unpinned" << std::endl;
+    }
+
     std::vector<QueueItem> batch;
 
     Crypto crypto;
+    crypto.setNonceSource(m_nonces);
     Compression compression;
-    std::vector<uint8_t> encryptionKey(crypto.KEY_SIZE, placeholder_crypto::KEY_BYTE);
 
-    // Reused across loop iterations so clear() keeps the underlying allocations.
-    std::unordered_map<std::optional<std::string>, std::vector<LogEntry>> groupedEntries;
+    // Per-target accumulation. A group is flushed into one blob once it holds
+    // m_batchSize entries or m_maxBatchBytes serialized bytes, or once its oldest
+    // entry has lingered m_maxBatchLinger. Only targets with entries pending have
+    // a group, so the linger scan never walks targets that went quiet; flushed
+    // groups are recycled so their vectors keep their allocations.
+    struct PendingGroup
+    {
+        std::vector<LogEntry> entries;
+        std::vector<std::shared_ptr<AppendTicket::State>> completions;
+        size_t bytes = 0;
+        Clock::time_point firstArrival;
+    };
+    using PendingMap = std::unordered_map<std::optional<std::string>, PendingGroup>;
+    PendingMap pending;
+    std::vector<PendingMap::node_type> spareGroups;
+    size_t pendingEntries = 0;
+    // Codec and level for the blobs built in this iteration.
+    CompressionController::Setting compressionSetting{m_compressionCodec, m_compressionLevel};
     std::vector<uint8_t> scratchA;
     std::vector<uint8_t> scratchB;
+    size_t idleRounds = 0;
 
-    while (m_running)
+    // Finished blobs per target. They are written at the end of each iteration, so
+    // several blobs for one target cost one offset reservation and one pwritev
+    // (or one IoStage request) instead of one each. The map key is the target;
+    // targetFilename is only filled in when the request goes to the IoStage.
+    using PendingOutput = IoRequest;
+    using OutputMap = std::unordered_map<std::optional<std::string>, PendingOutput>;
+    OutputMap outputs;
+    std::vector<OutputMap::node_type> spareOutputs;
+    std::vector<std::vector<uint8_t>> spareBlobs;
+    std::vector<struct iovec> iov;
+
+    auto recycleBlob = [&](std::vector<uint8_t> &blob)
     {
-        size_t entriesDequeued = m_queue.tryDequeueBatch(batch, m_batchSize, m_consumerToken);
-        if (entriesDequeued == 0)
+        if (spareBlobs.size() < MAX_SPARE_BLOBS)
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(5));
-            continue;
+            blob.clear();
+            spareBlobs.push_back(std::move(blob));
         }
+    };
 
-        groupedEntries.clear();
-        for (auto &item : batch)
+    // Stands in for a scratch buffer that was moved into an output.
+    auto replacementBuffer = [&](std::vector<uint8_t> &slot)
+    {
+        slot = std::vector<uint8_t>();
+        if (m_ioStage && m_ioStage->takeSpentBuffer(slot))
+            return;
+        if (!spareBlobs.empty())
         {
-            groupedEntries[item.targetFilename].emplace_back(std::move(item.entry));
+            slot = std::move(spareBlobs.back());
+            spareBlobs.pop_back();
         }
+    };
 
-        for (auto &[targetFilename, entries] : groupedEntries)
+    // Seals the checkpoint batch for `checkpoint` into `output`, encoded like the
+    // seal batch: compressed if blobs are, never chunked.
+    auto writeCheckpoint = [&](const std::string &resolvedTarget, PendingOutput &output,
+                               const merkle::Checkpoint &checkpoint)
+    {
+        std::vector<uint8_t> plaintext = merkle::encodeCheckpoint(checkpoint.leafCount, checkpoint.root);
+        std::vector<uint8_t> compressed;
+        const std::vector<uint8_t> *current = &plaintext;
+        if (m_compressionLevel > 0)
         {
-            const size_t groupSize = entries.size();
-            try
+            compression.compress(plaintext.data(), plaintext.size(), compressed, compressionSetting.level,
+                                 compressionSetting.codec);
+            current = &compressed;
+        }
+        std::vector<uint8_t> blob;
+        crypto.encrypt(current->data(), current->size(), *m_keyRing, blob,
+                       checkpoint.seqnum,
+                       reinterpret_cast<const uint8_t *>(resolvedTarget.data()),
+                       resolvedTarget.size(),
+                       /*chunkSize=*/0, nullptr, m_cipherSuite);
+        m_merkleLog->addCheckpoint(resolvedTarget, checkpoint.seqnum,
+                                   merkle::leafHash(blob.data(), blob.size()));
+        output.blobs.push_back(std::move(blob));
+        output.shares.push_back({});
+    };
+
+    auto flushGroup = [&](const std::optional<std::string> &targetFilename, PendingGroup &group)
+    {
+        const size_t groupSize = group.entries.size();
+        if (groupSize == 0)
+            return;
+        pendingEntries -= groupSize;
+        // Must match what the exporter parses from the segment filename,
+        // otherwise AAD reconstruction fails the tag check.
+        const std::string &resolvedTarget = targetFilename ? *targetFilename : m_baseFilename;
+        // Allocated but not yet in `outputs`; never written if the group fails.
+        std::optional<uint64_t> unwritten;
+        try
+        {
+            LogEntry::serializeBatch(std::move(group.entries), scratchA, m_batchEncoding);
+            // Producers building entries with LogEntry::make() reuse these buffers.
+            LogEntry::recycle(group.entries);
+            group.bytes = 0;
+            std::vector<uint8_t> *current = &scratchA;
+            std::vector<uint8_t> *other = &scratchB;
+            std::optional<merkle::Checkpoint> checkpoint;
+
+            if (m_compressionLevel > 0)
+            {
+                compression.compress(current->data(), current->size(), *other, compressionSetting.level,
+                                     compressionSetting.codec,
+                                     m_dictionaries ? m_dictionaries->forTarget(resolvedTarget) : nullptr);
+                std::swap(current, other);
+            }
+            if (m_useEncryption)
             {
-                // Must match what the exporter parses from the segment filename,
-                // otherwise AAD reconstruction fails the tag check.
-                const std::string &resolvedTarget =
-                    targetFilename ? *targetFilename : m_baseFilename;
+                const uint64_t seqnum = m_seqnumAllocator->next(resolvedTarget);
+                unwritten = seqnum;
+                crypto.encrypt(current->data(), current->size(), *m_keyRing, *other,
+                               seqnum,
+                               reinterpret_cast<const uint8_t *>(resolvedTarget.data()),
+                               resolvedTarget.size(),
+                               m_encryptionChunkSize, m_cryptoPool.get(), m_cipherSuite);
+                std::swap(current, other);
+                if (m_merkleLog)
+                {
+                    checkpoint = m_merkleLog->add(resolvedTarget, seqnum,
+                                                  merkle::leafHash(current->data(), current->size()),
+                                                  *m_seqnumAllocator);
+                }
+            }
 
-                LogEntry::serializeBatch(std::move(entries), scratchA);
-                std::vector<uint8_t> *current = &scratchA;
-                std::vector<uint8_t> *other = &scratchB;
+            PendingOutput &output = acquireNode(outputs, spareOutputs, targetFilename)->second;
+            output.blobs.push_back(std::move(*current));
+            unwritten.reset();
+            replacementBuffer(*current);
+            output.entryCount += groupSize;
+            output.shares.push_back({groupSize, group.completions.size()});
+            for (auto &completion : group.completions)
+                output.completions.push_back(std::move(completion));
+            group.completions.clear();
 
-                if (m_compressionLevel > 0)
+            if (checkpoint)
+            {
+                try
                 {
-                    compression.compress(current->data(), current->size(), *other, m_compressionLevel);
-                    std::swap(current, other);
+                    writeCheckpoint(resolvedTarget, output, *checkpoint);
                 }
-                if (m_useEncryption)
+                catch (const std::exception &e)
                 {
-                    const uint64_t seqnum = m_seqnumAllocator->next(resolvedTarget);
-                    crypto.encrypt(current->data(), current->size(), encryptionKey, *other,
-                                   seqnum,
-                                   reinterpret_cast<const uint8_t *>(resolvedTarget.data()),
-                                   resolvedTarget.size());
-                    std::swap(current, other);
+                    // Its seqnum stays unused, so the exporter reports a gap.
+                    if (m_merkleLog)
+                        m_merkleLog->abandon(resolvedTarget, checkpoint->seqnum);
+                    std::cerr << "Writer: failed to build Merkle checkpoint for " << resolvedTarget
+                              << ": " << e.what() << std::endl;
                 }
+            }
+        }
+        catch (const std::exception &e)
+        {
+            // Drop the failing group; keep the thread alive for subsequent batches.
+            if (unwritten && m_merkleLog)
+                m_merkleLog->abandon(resolvedTarget, *unwritten);
+            group.entries.clear();
+            group.bytes = 0;
+            AppendTicket::completeAll(group.completions, false);
+            m_droppedEntries.fetch_add(groupSize, std::memory_order_acq_rel);
+            std::cerr << "Writer: dropped " << groupSize << " entries from "
+                      << (targetFilename ? *targetFilename : std::string("<default>"))
+                      << ": " << e.what() << std::endl;
+        }
+    };
+
+    auto writeOutputs = [&]()
+    {
+        for (auto it = outputs.begin(); it != outputs.end(); it = releaseNode(outputs, spareOutputs, it))
+        {
+            const std::optional<std::string> &targetFilename = it->first;
+            PendingOutput &output = it->second;
 
+            if (m_ioStage)
+            {
+                output.targetFilename = targetFilename;
+                m_ioStage->submit(std::move(output));
+                output = PendingOutput();
+                continue;
+            }
+
+            iov.clear();
+            for (auto &blob : output.blobs)
+                iov.push_back({blob.data(), blob.size()});
+            size_t blobsWritten = 0;
+            try
+            {
                 if (targetFilename)
-                {
-                    m_storage->writeToFile(*targetFilename, current->data(), current->size());
-                }
+                    m_storage->writevToFile(*targetFilename, iov.data(), iov.size(), &blobsWritten);
                 else
-                {
-                    m_storage->write(current->data(), current->size());
-                }
+                    m_storage->writev(iov.data(), iov.size(), &blobsWritten);
+                output.settle(blobsWritten);
             }
             catch (const std::exception &e)
             {
-                // Drop the failing group; keep the thread alive for subsequent batches.
-                m_droppedEntries.fetch_add(groupSize, std::memory_order_acq_rel);
-                std::cerr << "Writer: dropped " << groupSize << " entries from "
+                // Blobs the per-blob fallback already wrote keep their tickets.
+                const size_t lost = output.settle(blobsWritten);
+                m_droppedEntries.fetch_add(lost, std::memory_order_acq_rel);
+                std::cerr << "Writer: dropped " << lost << " entries from "
                           << (targetFilename ? *targetFilename : std::string("<default>"))
                           << ": " << e.what() << std::endl;
             }
+
+            for (auto &blob : output.blobs)
+                recycleBlob(blob);
+            output.blobs.clear();
+            output.shares.clear();
+            output.entryCount = 0;
         }
+    };
 
+    // Flushes expired groups and returns how long until the next one expires.
+    auto flushExpired = [&](Clock::time_point now)
+    {
+        auto nextDeadline = Clock::time_point::max();
+        for (auto it = pending.begin(); it != pending.end();)
+        {
+            const auto deadline = it->second.firstArrival + m_maxBatchLinger;
+            if (deadline <= now)
+            {
+                flushGroup(it->first, it->second);
+                it = releaseNode(pending, spareGroups, it);
+                continue;
+            }
+            nextDeadline = std::min(nextDeadline, deadline);
+            ++it;
+        }
+        return nextDeadline;
+    };
+
+    while (m_running)
+    {
+        size_t entriesDequeued = m_queue.tryDequeueBatch(batch, m_batchSize, m_consumerToken);
+        const auto now = Clock::now();
+        if (m_compressionController)
+        {
+            m_compressionController->observe(m_queue.size(), now);
+            compressionSetting = m_compressionController->current();
+        }
+
+        for (auto &item : batch)
+        {
+            auto groupIt = acquireNode(pending, spareGroups, item.targetFilename);
+            PendingGroup &group = groupIt->second;
+            if (group.entries.empty())
+                group.firstArrival = now;
+            if (m_maxBatchBytes > 0)
+                group.bytes += item.entry.serializedSize();
+            group.entries.emplace_back(std::move(item.entry));
+            if (item.completion)
+                group.completions.push_back(std::move(item.completion));
+            ++pendingEntries;
+
+            if (group.entries.size() >= m_batchSize ||
+                (m_maxBatchBytes > 0 && group.bytes >= m_maxBatchBytes))
+            {
+                flushGroup(groupIt->first, group);
+                releaseNode(pending, spareGroups, groupIt);
+            }
+        }
         batch.clear();
+
+        const auto nextDeadline = pendingEntries > 0 ? flushExpired(now) : Clock::time_point::max();
+        writeOutputs();
+
+        if (entriesDequeued == 0)
+        {
+            auto maxWait = std::chrono::duration_cast<std::chrono::microseconds>(MAX_PARK_DURATION);
+            if (nextDeadline != Clock::time_point::max())
+            {
+                maxWait = std::min(maxWait, std::chrono::duration_cast<std::chrono::microseconds>(
+                                                nextDeadline - Clock::now()));
+            }
+            if (maxWait.count() > 0)
+                idle(idleRounds, maxWait);
+            continue;
+        }
+        idleRounds = 0;
+    }
+
+    // Don't strand lingering entries on shutdown.
+    for (auto it = pending.begin(); it != pending.end(); it = releaseNode(pending, spareGroups, it))
+    {
+        flushGroup(it->first, it->second);
     }
+    writeOutputs();
 }
@@ -0,0 +1,203 @@
+#include "Codec.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <zlib.h>
+
+namespace
+{
+class ZlibCodec : public Codec
+{
+public:
+    ~ZlibCodec() override
+    {
+        if (m_deflateInitialized)
+        {
+            deflateEnd(&m_deflateStream);
+        }
+        if (m_inflateInitialized)
+        {
+            inflateEnd(&m_inflateStream);
+        }
+    }
+
+    void compress(const uint8_t *data, size_t size, std::vector<uint8_t> &out, int level,
+                  const CompressionDictionary *dictionary) override
+    {
+        // Level changes force a full re-init because zlib's internal buffers are sized by it;
+        // same-level calls take the cheap deflateReset path.
+        if (!m_deflateInitialized || m_deflateLevel != level)
+        {
+            if (m_deflateInitialized)
+            {
+                deflateEnd(&m_deflateStream);
+                m_deflateInitialized = false;
+            }
+            std::memset(&m_deflateStream, 0, sizeof(m_deflateStream));
+            if (deflateInit(&m_deflateStream, level) != Z_OK)
+            {
+                throw std::runtime_error("Failed to initialize zlib deflate");
+            }
+            m_deflateInitialized = true;
+            m_deflateLevel = level;
+        }
+        else
+        {
+            if (deflateReset(&m_deflateStream) != Z_OK)
+            {
+                deflateEnd(&m_deflateStream);
+                m_deflateInitialized = false;
+                throw std::runtime_error("Failed to reset zlib deflate");
+            }
+        }
+        // Deflate keeps only the last 32 KiB of a longer dictionary.
+        if (dictionary &&
+            deflateSetDictionary(&m_deflateStream, dictionary->bytes.data(),
+                                 static_cast<uInt>(dictionary->bytes.size())) != Z_OK)
+        {
+            deflateEnd(&m_deflateStream);
+            m_deflateInitialized = false;
+            throw std::runtime_error("Failed to set zlib dictionary");
+        }
+
+        m_deflateStream.next_in = const_cast<Bytef *>(data);
+        m_deflateStream.avail_in = size;
+
+        const size_t base = out.size();
+        int ret;
+        char outbuffer[32768];
+
+        do
+        {
+            m_deflateStream.next_out = reinterpret_cast<Bytef *>(outbuffer);
+            m_deflateStream.avail_out = sizeof(outbuffer);
+
+            ret = deflate(&m_deflateStream, Z_FINISH);
+
+            if (out.size() - base < m_deflateStream.total_out)
+            {
+                out.insert(out.end(),
+                           outbuffer,
+                           outbuffer + (m_deflateStream.total_out - (out.size() - base)));
+            }
+        } while (ret == Z_OK);
+
+        if (ret != Z_STREAM_END)
+        {
+            // Abandon the stream; the next call will rebuild it.
+            deflateEnd(&m_deflateStream);
+            m_deflateInitialized = false;
+            throw std::runtime_error("Exception during zlib compression");
+        }
+    }
+
+    void beginDecompress(const CompressionDictionary *dictionary) override
+    {
+        m_inflateDictionary = dictionary;
+        if (!m_inflateInitialized)
+        {
+            std::memset(&m_inflateStream, 0, sizeof(m_inflateStream));
+            if (inflateInit(&m_inflateStream) != Z_OK)
+            {
+                throw std::runtime_error("Failed to initialize zlib inflate");
+            }
+            m_inflateInitialized = true;
+        }
+        else
+        {
+            if (inflateReset(&m_inflateStream) != Z_OK)
+            {
+                inflateEnd(&m_inflateStream);
+                m_inflateInitialized = false;
+                throw std::runtime_error("Failed to reset zlib inflate");
+            }
+        }
+        m_inflateEnded = false;
+    }
+
+    void decompressChunk(const uint8_t *data, size_t size, const OutputSink &sink,
+                         size_t maxDecompressedSize) override
+    {
+        if (size == 0)
+        {
+            return;
+        }
+        if (!m_inflateInitialized || m_inflateEnded)
+        {
+            throw std::runtime_error("Exception during zlib decompression: data after end of stream");
+        }
+
+        m_inflateStream.next_in = const_cast<Bytef *>(data);
+        m_inflateStream.avail_in = size;
+
+        uint8_t outbuffer[32768];
+        do
+        {
+            m_inflateStream.next_out = outbuffer;
+            m_inflateStream.avail_out = sizeof(outbuffer);
+
+            const int ret = inflate(&m_inflateStream, Z_NO_FLUSH);
+            // The stream header names its dictionary by Adler-32, so a wrong one fails here.
+            if (ret == Z_NEED_DICT && m_inflateDictionary &&
+                inflateSetDictionary(&m_inflateStream, m_inflateDictionary->bytes.data(),
+                                     static_cast<uInt>(m_inflateDictionary->bytes.size())) == Z_OK)
+            {
+                continue;
+            }
+            if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR || ret == Z_STREAM_ERROR)
+            {
+                inflateEnd(&m_inflateStream);
+                m_inflateInitialized = false;
+                throw std::runtime_error("Exception during zlib decompression");
+            }
+            if (m_inflateStream.total_out > maxDecompressedSize)
+            {
+                inflateEnd(&m_inflateStream);
+                m_inflateInitialized = false;
+                throw std::runtime_error("Decompressed data exceeds maxDecompressedSize");
+            }
+
+            const size_t produced = sizeof(outbuffer) - m_inflateStream.avail_out;
+            if (produced > 0)
+            {
+                sink(outbuffer, produced);
+            }
+
+            if (ret == Z_STREAM_END)
+            {
+                m_inflateEnded = true;
+                if (m_inflateStream.avail_in != 0)
+                {
+                    throw std::runtime_error("Exception during zlib decompression: data after end of stream");
+                }
+                return;
+            }
+            if (ret == Z_BUF_ERROR)
+            {
+                return; // needs the next piece of input
+            }
+        } while (m_inflateStream.avail_in > 0 || m_inflateStream.avail_out == 0);
+    }
+
+    void endDecompress() override
+    {
+        if (!m_inflateEnded)
+        {
+            throw std::runtime_error("Exception during zlib decompression: truncated stream");
+        }
+    }
+
+private:
+    z_stream m_deflateStream{};
+    z_stream m_inflateStream{};
+    bool m_deflateInitialized = false;
+    int m_deflateLevel = 0; // bound to m_deflateStream while initialized
+    bool m_inflateInitialized = false;
+    bool m_inflateEnded = false; // Z_STREAM_END seen
+    const CompressionDictionary *m_inflateDictionary = nullptr;
+};
+} // namespace
+
+std::unique_ptr<Codec> makeZlibCodec()
+{
+    return std::make_unique<ZlibCodec>();
+}
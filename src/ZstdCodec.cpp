@@ -0,0 +1,206 @@
+#include "Codec.hpp"
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#ifdef GDPR_LOGGING_HAVE_ZSTD
+
+#include <zstd.h>
+
+namespace
+{
+std::runtime_error zstdError(const char *what, size_t code)
+{
+    return std::runtime_error(std::string(what) + ": " + ZSTD_getErrorName(code));
+}
+
+class ZstdCodec : public Codec
+{
+public:
+    ZstdCodec() : m_cctx(ZSTD_createCCtx()), m_dctx(ZSTD_createDCtx())
+    {
+        if (!m_cctx || !m_dctx)
+        {
+            ZSTD_freeCCtx(m_cctx);
+            ZSTD_freeDCtx(m_dctx);
+            throw std::runtime_error("Failed to create zstd context");
+        }
+    }
+
+    ~ZstdCodec() override
+    {
+        ZSTD_freeCDict(m_cdict);
+        for (auto &entry : m_ddicts)
+        {
+            ZSTD_freeDDict(entry.second);
+        }
+        ZSTD_freeCCtx(m_cctx);
+        ZSTD_freeDCtx(m_dctx);
+    }
+
+    void compress(const uint8_t *data, size_t size, std::vector<uint8_t> &out, int level,
+                  const CompressionDictionary *dictionary) override
+    {
+        // A digested dictionary is bound to a level; writers keep one level, so
+        // caching the last one avoids re-digesting per batch.
+        ZSTD_CDict *cdict = nullptr;
+        if (dictionary)
+        {
+            if (m_cdictFor != dictionary || m_cdictLevel != level)
+            {
+                ZSTD_freeCDict(m_cdict);
+                m_cdictFor = nullptr;
+                m_cdict = ZSTD_createCDict(dictionary->bytes.data(), dictionary->bytes.size(), level);
+                if (!m_cdict)
+                {
+                    throw std::runtime_error("Failed to create zstd dictionary");
+                }
+                m_cdictFor = dictionary;
+                m_cdictLevel = level;
+            }
+            cdict = m_cdict;
+        }
+        const size_t refRc = ZSTD_CCtx_refCDict(m_cctx, cdict);
+        if (ZSTD_isError(refRc))
+        {
+            throw zstdError("Failed to set zstd dictionary", refRc);
+        }
+
+        // Parameters stick to the context between frames, so only a level change costs a call.
+        if (level != m_level)
+        {
+            const size_t rc = ZSTD_CCtx_setParameter(m_cctx, ZSTD_c_compressionLevel, level);
+            if (ZSTD_isError(rc))
+            {
+                throw zstdError("Failed to set zstd level", rc);
+            }
+            m_level = level;
+        }
+
+        const size_t base = out.size();
+        out.resize(base + ZSTD_compressBound(size));
+        const size_t written = ZSTD_compress2(m_cctx, out.data() + base, out.size() - base, data, size);
+        if (ZSTD_isError(written))
+        {
+            out.resize(base);
+            ZSTD_CCtx_reset(m_cctx, ZSTD_reset_session_only);
+            throw zstdError("Exception during zstd compression", written);
+        }
+        out.resize(base + written);
+    }
+
+    void beginDecompress(const CompressionDictionary *dictionary) override
+    {
+        ZSTD_DCtx_reset(m_dctx, ZSTD_reset_session_only);
+        ZSTD_DDict *ddict = nullptr;
+        if (dictionary)
+        {
+            ZSTD_DDict *&slot = m_ddicts[dictionary];
+            if (!slot)
+            {
+                slot = ZSTD_createDDict(dictionary->bytes.data(), dictionary->bytes.size());
+                if (!slot)
+                {
+                    m_ddicts.erase(dictionary);
+                    throw std::runtime_error("Failed to create zstd dictionary");
+                }
+            }
+            ddict = slot;
+        }
+        const size_t rc = ZSTD_DCtx_refDDict(m_dctx, ddict);
+        if (ZSTD_isError(rc))
+        {
+            throw zstdError("Failed to set zstd dictionary", rc);
+        }
+        m_produced = 0;
+        m_ended = false;
+    }
+
+    void decompressChunk(const uint8_t *data, size_t size, const OutputSink &sink,
+                         size_t maxDecompressedSize) override
+    {
+        if (size == 0)
+        {
+            return;
+        }
+        if (m_ended)
+        {
+            throw std::runtime_error("Exception during zstd decompression: data after end of stream");
+        }
+
+        ZSTD_inBuffer in{data, size, 0};
+        uint8_t outbuffer[32768];
+        while (true)
+        {
+            ZSTD_outBuffer outBuf{outbuffer, sizeof(outbuffer), 0};
+            const size_t rc = ZSTD_decompressStream(m_dctx, &outBuf, &in);
+            if (ZSTD_isError(rc))
+            {
+                ZSTD_DCtx_reset(m_dctx, ZSTD_reset_session_only);
+                throw zstdError("Exception during zstd decompression", rc);
+            }
+            m_produced += outBuf.pos;
+            if (m_produced > maxDecompressedSize)
+            {
+                ZSTD_DCtx_reset(m_dctx, ZSTD_reset_session_only);
+                throw std::runtime_error("Decompressed data exceeds maxDecompressedSize");
+            }
+            if (outBuf.pos > 0)
+            {
+                sink(outbuffer, outBuf.pos);
+            }
+
+            if (rc == 0)
+            {
+                // Frame complete (and flushed, since outBuf had room to spare).
+                m_ended = true;
+                if (in.pos != in.size)
+                {
+                    throw std::runtime_error("Exception during zstd decompression: data after end of stream");
+                }
+                return;
+            }
+            // A full output buffer may hide more buffered output; otherwise stop once
+            // the input is used up.
+            if (in.pos == in.size && outBuf.pos < outBuf.size)
+            {
+                return;
+            }
+        }
+    }
+
+    void endDecompress() override
+    {
+        if (!m_ended)
+        {
+            throw std::runtime_error("Exception during zstd decompression: truncated stream");
+        }
+    }
+
+private:
+    ZSTD_CCtx *m_cctx;
+    ZSTD_DCtx *m_dctx;
+    int m_level = ZSTD_CLEVEL_DEFAULT;
+    const CompressionDictionary *m_cdictFor = nullptr;
+    int m_cdictLevel = 0;
+    ZSTD_CDict *m_cdict = nullptr;
+    // Keyed by address: a Compression's dictionaries outlive its codecs.
+    std::map<const CompressionDictionary *, ZSTD_DDict *> m_ddicts;
+    size_t m_produced = 0;
+    bool m_ended = false;
+};
+} // namespace
+
+std::unique_ptr<Codec> makeZstdCodec()
+{
+    return std::make_unique<ZstdCodec>();
+}
+
+#else // !GDPR_LOGGING_HAVE_ZSTD
+
+std::unique_ptr<Codec> makeZstdCodec()
+{
+    throw std::runtime_error("zstd support was not compiled in");
+}
+
+#endif
@@ -1,12 +1,26 @@
 #include <gtest/gtest.h>
+#include "ByteOrder.hpp"
+#include "Codec.hpp"
+#include "Compression.hpp"
+#include "CompressionDictionary.hpp"
 #include "Config.hpp"
+#include "Crypto.hpp"
+#include "KeyRing.hpp"
 #include "LogEntry.hpp"
+#include "LogExporter.hpp"
 #include "LoggingManager.hpp"
+#include "MerkleTree.hpp"
+#include "PlaceholderCryptoMaterial.hpp"
+#include "SealMarker.hpp"
 #include <openssl/evp.h>
 #include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <set>
 #include <sstream>
 #include <string>
@@ -119,6 +133,93 @@ EntryKey keyFromLine(const std::string &line)
                     extractStringField(line, "dataSubjectId"),
                     base64Decode(extractStringField(line, "payload")));
 }
+
+// Target name of a "<target>_YYYYMMDD_HHMMSS_NNNNNN.log" segment.
+std::string segmentTarget(const std::string &path)
+{
+    std::string name = std::filesystem::path(path).stem().string();
+    for (int i = 0; i < 3; ++i)
+        name.erase(name.rfind('_'));
+    return name;
+}
+
+// Every sealed blob of `target`, in write order.
+std::vector<std::vector<uint8_t>> sealedBlobs(const std::string &dir, const std::string &target)
+{
+    std::vector<std::vector<uint8_t>> blobs;
+    for (const auto &path : listLogFiles(dir))
+    {
+        if (segmentTarget(path) != target)
+            continue;
+        std::ifstream in(path, std::ios::binary);
+        const std::vector<uint8_t> segment((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        size_t pos = 0;
+        while (segment.size() - pos >= sizeof(uint32_t))
+        {
+            const size_t size = Crypto::blobSize(byteorder::readLE32(segment.data() + pos));
+            if (size > segment.size() - pos)
+                break;
+            blobs.emplace_back(segment.begin() + pos, segment.begin() + pos + size);
+            pos += size;
+        }
+    }
+    return blobs;
+}
+
+// What a sealed blob's header records, with the defaults for single-tag blobs.
+struct BlobHeader
+{
+    uint32_t chunkCount = 1;
+    uint32_t keyId = KeyRing::DEFAULT_KEY_ID;
+    CipherSuite suite = CipherSuite::Aes256Gcm;
+};
+
+BlobHeader readHeader(const std::vector<uint8_t> &blob)
+{
+    BlobHeader header;
+    if ((byteorder::readLE32(blob.data()) & Crypto::EXTENDED_BLOB_FLAG) == 0)
+        return header;
+    // [u8 version][u8 flags][u32 chunkSize][u32 chunkCount]([u32 keyId])([u8 suite])
+    const uint8_t *extended = blob.data() + sizeof(uint32_t) + Crypto::SEQNUM_SIZE + Crypto::GCM_IV_SIZE;
+    const uint8_t flags = extended[1];
+    header.chunkCount = byteorder::readLE32(extended + 2 + sizeof(uint32_t));
+    const uint8_t *field = extended + Crypto::EXTENDED_HEADER_SIZE;
+    if (flags & Crypto::BLOB_FLAG_KEY_ID)
+    {
+        header.keyId = byteorder::readLE32(field);
+        field += sizeof(uint32_t);
+    }
+    if (flags & Crypto::BLOB_FLAG_CIPHER_SUITE)
+        header.suite = static_cast<CipherSuite>(*field);
+    return header;
+}
+
+// The blobs' plaintexts as the writer sealed them (still compressed, if it compressed).
+std::vector<std::vector<uint8_t>> openBlobs(const std::string &dir, const std::string &target,
+                                            const KeyRing &keys)
+{
+    Crypto crypto;
+    std::vector<std::vector<uint8_t>> payloads;
+    for (const auto &blob : sealedBlobs(dir, target))
+    {
+        payloads.push_back(crypto.decrypt(blob, keys, reinterpret_cast<const uint8_t *>(target.data()),
+                                          target.size()));
+    }
+    return payloads;
+}
+
+bool isCheckpointBatch(const std::vector<uint8_t> &plaintext)
+{
+    uint64_t leafCount;
+    merkle::Hash root;
+    return merkle::decodeCheckpoint(plaintext.data(), plaintext.size(), leafCount, root);
+}
+
+bool isSealBatch(const std::vector<uint8_t> &plaintext)
+{
+    return plaintext.size() >= seal_marker::MAGIC_LEN &&
+           std::memcmp(plaintext.data(), seal_marker::MAGIC, seal_marker::MAGIC_LEN) == 0;
+}
 } // namespace
 
 class ExportTest : public ::testing::Test
@@ -155,6 +256,53 @@ protected:
         cfg.maxSegmentSize = 16 * 1024;
         return cfg;
     }
+
+    // Entry i of a test's log, and the target it is appended to.
+    using MakeEntry = std::function<LogEntry(int)>;
+    using TargetOf = std::function<std::optional<std::string>(int)>;
+
+    // Entries [begin, end) of `makeEntry`, recorded in `expected`.
+    std::vector<LogEntry> expectEntries(int begin, int end, const MakeEntry &makeEntry)
+    {
+        std::vector<LogEntry> entries;
+        for (int i = begin; i < end; ++i)
+        {
+            entries.push_back(makeEntry(i));
+            expected.insert(keyOf(entries.back()));
+        }
+        return entries;
+    }
+
+    void appendEntries(LoggingManager &mgr, int begin, int end, const MakeEntry &makeEntry,
+                       const TargetOf &targetOf)
+    {
+        auto token = mgr.createProducerToken();
+        std::vector<LogEntry> entries = expectEntries(begin, end, makeEntry);
+        for (int i = begin; i < end; ++i)
+            ASSERT_TRUE(mgr.append(std::move(entries[i - begin]), token, targetOf(i)));
+    }
+
+    // Writes entries [0, count) with a manager built from `cfg`, exports with it and
+    // checks the export holds exactly those entries.
+    void roundTrip(const LoggingConfig &cfg, int count, const MakeEntry &makeEntry, const TargetOf &targetOf)
+    {
+        LoggingManager mgr(cfg);
+        ASSERT_TRUE(mgr.start());
+        ASSERT_NO_FATAL_FAILURE(appendEntries(mgr, 0, count, makeEntry, targetOf));
+        ASSERT_TRUE(mgr.stop());
+        ASSERT_TRUE(mgr.exportLogs(outputPath));
+        expectExported();
+    }
+
+    void expectExported()
+    {
+        std::multiset<EntryKey> actual;
+        for (const auto &line : readLines(outputPath))
+            actual.insert(keyFromLine(line));
+        EXPECT_EQ(actual, expected);
+    }
+
+    std::multiset<EntryKey> expected;
 };
 
 TEST_F(ExportTest, RoundTripViaExport)
@@ -406,3 +554,477 @@ TEST_F(ExportTest, RejectsWithEncryptionDisabled)
     EXPECT_FALSE(mgr.exportLogs(outputPath));
     EXPECT_FALSE(std::filesystem::exists(outputPath));
 }
+
+// The pipelined writer must produce the same exportable, seal-verified log as the
+// inline writer, across several targets and rotations.
+TEST_F(ExportTest, PipelinedWriterRoundTrip)
+{
+    LoggingConfig cfg = makeConfig();
+    cfg.usePipelinedWriter = true;
+    cfg.numIoThreads = 2;
+    cfg.ioRingCapacity = 4;
+
+    roundTrip(
+        cfg, 300,
+        [](int i)
+        { return LogEntry(LogEntry::ActionType::UPDATE, "loc_" + std::to_string(i), "c", "p",
+                          "subj_" + std::to_string(i % 5)); },
+        [](int i) -> std::optional<std::string>
+        {
+            if (i % 3 == 0)
+                return std::nullopt;
+            return "pipe_target_" + std::to_string(i % 3);
+        });
+}
+
+// Sharded queue: each target's entries are batched by exactly one writer.
+TEST_F(ExportTest, TargetAffineDispatchRoundTrip)
+{
+    LoggingConfig cfg = makeConfig();
+    cfg.numWriterThreads = 3;
+    cfg.targetAffineDispatch = true;
+
+    roundTrip(
+        cfg, 240,
+        [](int i)
+        { return LogEntry(LogEntry::ActionType::READ, "loc_" + std::to_string(i), "c", "p", "s"); },
+        [](int i) -> std::optional<std::string>
+        {
+            if (i % 4 == 0)
+                return std::nullopt;
+            return "affine_target_" + std::to_string(i % 4);
+        });
+}
+
+TEST_F(ExportTest, ChunkedEncryptionRoundTrip)
+{
+    LoggingConfig cfg = makeConfig();
+    cfg.batchSize = 200;
+    cfg.compressionLevel = 0;
+    cfg.maxSegmentSize = 1024 * 1024;
+    cfg.encryptionChunkSize = 1024;
+    cfg.cryptoThreads = 2;
+
+    {
+        LoggingManager mgr(cfg);
+        ASSERT_TRUE(mgr.start());
+        auto token = mgr.createProducerToken();
+        auto batch = expectEntries(0, 400, [](int i)
+                                   { return LogEntry(LogEntry::ActionType::UPDATE, "loc_" + std::to_string(i),
+                                                     "c", "p", "subj_" + std::to_string(i % 5),
+                                                     std::vector<uint8_t>(64, static_cast<uint8_t>(i))); });
+        ASSERT_TRUE(mgr.appendBatch(std::move(batch), token, "chunked_target"));
+        ASSERT_TRUE(mgr.stop());
+        ASSERT_TRUE(mgr.exportLogs(outputPath));
+    }
+    expectExported();
+
+    bool sawChunkedBlob = false;
+    for (const auto &blob : sealedBlobs(testDir, "chunked_target"))
+        sawChunkedBlob |= readHeader(blob).chunkCount > 1;
+    EXPECT_TRUE(sawChunkedBlob);
+}
+
+TEST_F(ExportTest, KeyRotationRoundTrip)
+{
+    const int numEntries = 200;
+    auto makeEntry = [](int i)
+    {
+        return LogEntry(LogEntry::ActionType::READ, "loc_" + std::to_string(i), "c", "p",
+                        "subj_" + std::to_string(i % 3));
+    };
+    auto target = [](int) -> std::optional<std::string> { return "rotating_target"; };
+    {
+        LoggingManager mgr(makeConfig());
+        ASSERT_TRUE(mgr.start());
+        ASSERT_NO_FATAL_FAILURE(appendEntries(mgr, 0, numEntries / 2, makeEntry, target));
+        // Let the first half reach disk under the default key.
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        mgr.rotateKey(3, std::vector<uint8_t>(Crypto::KEY_SIZE, 0x33));
+        ASSERT_NO_FATAL_FAILURE(appendEntries(mgr, numEntries / 2, numEntries, makeEntry, target));
+        EXPECT_THROW(mgr.rotateKey(3, std::vector<uint8_t>(Crypto::KEY_SIZE, 0x44)),
+                     std::invalid_argument);
+        ASSERT_TRUE(mgr.stop());
+        ASSERT_TRUE(mgr.exportLogs(outputPath));
+    }
+    expectExported();
+
+    std::set<uint32_t> keyIds;
+    for (const auto &blob : sealedBlobs(testDir, "rotating_target"))
+        keyIds.insert(readHeader(blob).keyId);
+    EXPECT_EQ(keyIds, (std::set<uint32_t>{KeyRing::DEFAULT_KEY_ID, 3}));
+}
+
+// io_uring backend with small segments, so rotation's background fsync+close and
+// registered-file recycling are on the export path. Falls back to pwrite if the
+// kernel has no io_uring, which this test then covers instead.
+TEST_F(ExportTest, IoUringBackendRoundTrip)
+{
+    LoggingConfig cfg = makeConfig();
+    cfg.storageBackend = StorageBackend::IoUring;
+    cfg.maxSegmentSize = 1024;
+
+    roundTrip(
+        cfg, 400,
+        [](int i)
+        { return LogEntry(LogEntry::ActionType::CREATE, "loc_" + std::to_string(i), "c", "p",
+                          "subj_" + std::to_string(i % 7)); },
+        [](int i) -> std::optional<std::string>
+        {
+            if (i % 2 == 0)
+                return std::nullopt;
+            return "uring_target";
+        });
+    const auto segments = listLogFiles(testDir);
+    EXPECT_GT(std::count_if(segments.begin(), segments.end(),
+                            [](const std::string &path) { return segmentTarget(path) == "uring_target"; }),
+              1);
+}
+
+TEST_F(ExportTest, ChaCha20Poly1305RoundTrip)
+{
+    LoggingConfig cfg = makeConfig();
+    cfg.cipherSuite = CipherSuite::ChaCha20Poly1305;
+    cfg.encryptionChunkSize = 512;
+
+    // The exporter takes the suite from each blob header; no config needed.
+    roundTrip(
+        cfg, 300,
+        [](int i)
+        { return LogEntry(LogEntry::ActionType::DELETE, "loc_" + std::to_string(i), "c", "p",
+                          "subj_" + std::to_string(i % 4), std::vector<uint8_t>(32, static_cast<uint8_t>(i))); },
+        [](int) -> std::optional<std::string> { return "chacha_target"; });
+
+    const auto blobs = sealedBlobs(testDir, "chacha_target");
+    ASSERT_FALSE(blobs.empty());
+    for (const auto &blob : blobs)
+        EXPECT_EQ(readHeader(blob).suite, CipherSuite::ChaCha20Poly1305);
+
+    cfg.cipherSuite = static_cast<CipherSuite>(9);
+    EXPECT_THROW(LoggingManager{cfg}, std::invalid_argument);
+}
+
+TEST_F(ExportTest, CounterNoncesRoundTrip)
+{
+    LoggingConfig cfg = makeConfig();
+    cfg.nonceStrategy = NonceStrategy::Counter;
+
+    for (int run = 0; run < 2; ++run)
+    {
+        // The second manager resumes the counter from <basePath>/nonce.state.
+        LoggingManager mgr(cfg);
+        ASSERT_TRUE(mgr.start());
+        ASSERT_NO_FATAL_FAILURE(appendEntries(
+            mgr, 0, 100,
+            [run](int i)
+            { return LogEntry(LogEntry::ActionType::CREATE, "loc_" + std::to_string(run) + "_" + std::to_string(i),
+                              "c", "p", "subj_" + std::to_string(i % 3)); },
+            [run](int) -> std::optional<std::string> { return "counter_target_" + std::to_string(run); }));
+        ASSERT_TRUE(mgr.stop());
+    }
+    EXPECT_TRUE(std::filesystem::exists(testDir + "/nonce.state"));
+
+    {
+        LoggingManager mgr(cfg);
+        ASSERT_TRUE(mgr.exportLogs(outputPath));
+    }
+    expectExported();
+}
+
+TEST_F(ExportTest, MerkleCheckpointsRoundTrip)
+{
+    LoggingConfig cfg = makeConfig();
+    cfg.batchSize = 4;
+    cfg.merkleCheckpointInterval = 3;
+
+    // Checkpoint batches carry no entries, so the export holds exactly the data.
+    roundTrip(
+        cfg, 200,
+        [](int i)
+        { return LogEntry(LogEntry::ActionType::UPDATE, "loc_" + std::to_string(i), "c", "p",
+                          "subj_" + std::to_string(i % 5)); },
+        [](int i) -> std::optional<std::string> { return "merkle_" + std::to_string(i % 2); });
+
+    auto keys = placeholder_crypto::makeKeyRing();
+    Compression compression;
+    for (const std::string target : {"merkle_0", "merkle_1"})
+    {
+        size_t checkpoints = 0;
+        for (auto &payload : openBlobs(testDir, target, *keys))
+            checkpoints += isCheckpointBatch(compression.decompress(std::move(payload)));
+        EXPECT_GE(checkpoints, 2u) << target;
+    }
+
+    // Re-encrypting a data blob at its own seqnum passes every check but the
+    // checkpoint roots.
+    std::string segmentPath;
+    for (const auto &path : listLogFiles(testDir))
+    {
+        if (segmentTarget(path) == "merkle_0")
+        {
+            segmentPath = path;
+            break;
+        }
+    }
+    ASSERT_FALSE(segmentPath.empty());
+    std::vector<uint8_t> segment;
+    {
+        std::ifstream in(segmentPath, std::ios::binary);
+        segment.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    const std::string target = "merkle_0";
+    const auto *targetBytes = reinterpret_cast<const uint8_t *>(target.data());
+    const std::vector<uint8_t> original(segment.begin(),
+                                        segment.begin() + Crypto::blobSize(byteorder::readLE32(segment.data())));
+    uint64_t seqnum = 0;
+    ASSERT_TRUE(Crypto::peekSeqnum(original, seqnum));
+    Crypto crypto;
+    const auto plaintext = crypto.decrypt(original, *keys, targetBytes, target.size());
+    std::vector<uint8_t> resealed;
+    crypto.encrypt(plaintext.data(), plaintext.size(), *keys, resealed, seqnum, targetBytes, target.size());
+    ASSERT_EQ(resealed.size(), original.size());
+    std::copy(resealed.begin(), resealed.end(), segment.begin());
+    {
+        std::ofstream out(segmentPath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(segment.data()), static_cast<std::streamsize>(segment.size()));
+    }
+    EXPECT_FALSE(LogExporter(testDir, true, cfg.compressionLevel).exportToNDJSON(outputPath, ExportFilter{}));
+}
+
+// The exporter dispatches on each blob's codec ID, so a directory written with
+// every compiled-in codec exports as one.
+TEST_F(ExportTest, MixedCodecDirectoryExports)
+{
+    auto makeEntry = [](int i)
+    {
+        return LogEntry(LogEntry::ActionType::CREATE, "loc_" + std::to_string(i), "c", "p",
+                        "subj_" + std::to_string(i % 4));
+    };
+    std::vector<CompressionCodec> codecs;
+    std::unique_ptr<LoggingManager> last;
+    for (CompressionCodec codec : {CompressionCodec::Zlib, CompressionCodec::Zstd, CompressionCodec::Lz4})
+    {
+        if (!Codec::compiledIn(codec))
+            continue;
+        codecs.push_back(codec);
+        LoggingConfig cfg = makeConfig();
+        cfg.compressionCodec = codec;
+        cfg.compressionLevel = codec == CompressionCodec::Zstd ? 12 : codec == CompressionCodec::Lz4 ? 1 : 6;
+        last.reset(); // the Logger singleton is torn down with the previous manager
+        last = std::make_unique<LoggingManager>(cfg);
+        ASSERT_TRUE(last->start());
+        const std::string target = "codec_" + std::to_string(static_cast<int>(codec));
+        ASSERT_NO_FATAL_FAILURE(appendEntries(*last, 0, 100, makeEntry,
+                                              [&](int) -> std::optional<std::string> { return target; }));
+        ASSERT_TRUE(last->stop());
+    }
+    ASSERT_TRUE(last->exportLogs(outputPath));
+    expectExported();
+
+    auto keys = placeholder_crypto::makeKeyRing();
+    for (CompressionCodec codec : codecs)
+    {
+        const auto payloads = openBlobs(testDir, "codec_" + std::to_string(static_cast<int>(codec)), *keys);
+        ASSERT_FALSE(payloads.empty());
+        for (const auto &payload : payloads)
+            EXPECT_EQ(payload.at(0), static_cast<uint8_t>(codec));
+    }
+}
+
+// Dictionaries are configured per target class on the writer side only; the
+// exporter finds them through the registry stored in the log directory.
+TEST_F(ExportTest, DictionaryCompressionRoundTrip)
+{
+    auto makeEntry = [](int i)
+    {
+        return LogEntry(LogEntry::ActionType::READ, "/records/" + std::to_string(i), "ctrl", "proc",
+                        "subj_" + std::to_string(i % 7));
+    };
+    std::vector<std::vector<uint8_t>> samples;
+    for (int i = 0; i < 200; ++i)
+        samples.push_back(LogEntry::serializeBatch({makeEntry(i)}));
+    std::filesystem::create_directories(testDir);
+    const std::string dictPath = testDir + "/trained.dict";
+    {
+        const std::vector<uint8_t> dict = DictionaryRegistry::train(samples, 4096);
+        std::ofstream out(dictPath, std::ios::binary);
+        out.write(reinterpret_cast<const char *>(dict.data()), static_cast<std::streamsize>(dict.size()));
+    }
+
+    {
+        LoggingConfig cfg = makeConfig();
+        cfg.batchSize = 4;
+        cfg.compressionDictionaries = {{"dict_", dictPath}};
+        LoggingManager mgr(cfg);
+        ASSERT_TRUE(mgr.start());
+        // One target class uses the dictionary, the other compresses without.
+        ASSERT_NO_FATAL_FAILURE(appendEntries(mgr, 0, 120, makeEntry, [](int i) -> std::optional<std::string>
+                                              { return i % 2 ? "dict_target" : "plain_target"; }));
+        ASSERT_TRUE(mgr.stop());
+    }
+    ASSERT_TRUE(std::filesystem::exists(std::filesystem::path(testDir) / DictionaryRegistry::FILENAME));
+
+    LogExporter exporter(testDir, /*useEncryption=*/true, /*compressionLevel=*/6);
+    ASSERT_TRUE(exporter.exportToNDJSON(outputPath, ExportFilter{}));
+    expectExported();
+
+    auto keys = placeholder_crypto::makeKeyRing();
+    auto usesDictionary = [&](const std::string &target)
+    {
+        bool used = false;
+        for (const auto &payload : openBlobs(testDir, target, *keys))
+            used |= (payload.at(0) & Compression::PAYLOAD_FLAG_DICTIONARY) != 0;
+        return used;
+    };
+    EXPECT_TRUE(usesDictionary("dict_target"));
+    EXPECT_FALSE(usesDictionary("plain_target"));
+}
+
+// Under pressure the controller changes codec and level between blobs; the exporter
+// takes both from each payload.
+TEST_F(ExportTest, AdaptiveCompressionExports)
+{
+    LoggingConfig cfg = makeConfig();
+    cfg.queueCapacity = 256;
+    cfg.batchSize = 8;
+    cfg.compressionLevel = 9;
+    cfg.adaptiveCompression.enabled = true;
+    cfg.adaptiveCompression.highWatermark = 0.05;
+    cfg.adaptiveCompression.lowWatermark = 0.0;
+    cfg.adaptiveCompression.adjustInterval = std::chrono::milliseconds(0);
+    if (Codec::compiledIn(CompressionCodec::Lz4))
+        cfg.adaptiveCompression.pressureCodec = CompressionCodec::Lz4;
+    {
+        LoggingManager mgr(cfg);
+        ASSERT_TRUE(mgr.start());
+        ASSERT_NO_FATAL_FAILURE(appendEntries(
+            mgr, 0, 2000,
+            [](int i)
+            { return LogEntry(LogEntry::ActionType::UPDATE, "loc_" + std::to_string(i), "c", "p",
+                              "subj_" + std::to_string(i % 9)); },
+            [](int i) -> std::optional<std::string> { return "adaptive_" + std::to_string(i % 3); }));
+        ASSERT_TRUE(mgr.stop());
+    }
+
+    LogExporter exporter(testDir, /*useEncryption=*/true, /*compressionLevel=*/9);
+    ASSERT_TRUE(exporter.exportToNDJSON(outputPath, ExportFilter{}));
+    expectExported();
+
+    if (Codec::compiledIn(CompressionCodec::Lz4))
+    {
+        auto keys = placeholder_crypto::makeKeyRing();
+        bool sawPressureCodec = false;
+        for (int t = 0; t < 3; ++t)
+        {
+            for (const auto &payload : openBlobs(testDir, "adaptive_" + std::to_string(t), *keys))
+                sawPressureCodec |= payload.at(0) == static_cast<uint8_t>(CompressionCodec::Lz4);
+        }
+        EXPECT_TRUE(sawPressureCodec);
+    }
+}
+
+// Writers may switch batch encoding between runs; the exporter reads every one.
+TEST_F(ExportTest, MixedBatchEncodingsExport)
+{
+    const std::vector<BatchEncoding> encodings = {BatchEncoding::Rows, BatchEncoding::Columnar,
+                                                  BatchEncoding::Compact};
+    auto targetName = [](BatchEncoding encoding)
+    { return "encoding_" + std::to_string(static_cast<int>(encoding)); };
+    std::unique_ptr<LoggingManager> last;
+    for (BatchEncoding encoding : encodings)
+    {
+        LoggingConfig cfg = makeConfig();
+        cfg.batchEncoding = encoding;
+        cfg.encryptionChunkSize = 256; // marked batches also stream through chunked blobs
+        last.reset();
+        last = std::make_unique<LoggingManager>(cfg);
+        ASSERT_TRUE(last->start());
+        ASSERT_NO_FATAL_FAILURE(appendEntries(
+            *last, 0, 150,
+            [](int i)
+            { return LogEntry(static_cast<LogEntry::ActionType>(i % 4), "/records/" + std::to_string(i),
+                              "ctrl_" + std::to_string(i % 2), "proc", "subj_" + std::to_string(i % 6)); },
+            [&](int) -> std::optional<std::string> { return targetName(encoding); }));
+        ASSERT_TRUE(last->stop());
+    }
+    ASSERT_TRUE(last->exportLogs(outputPath));
+    expectExported();
+
+    auto keys = placeholder_crypto::makeKeyRing();
+    Compression compression;
+    for (BatchEncoding encoding : encodings)
+    {
+        size_t batches = 0;
+        for (auto &payload : openBlobs(testDir, targetName(encoding), *keys))
+        {
+            const std::vector<uint8_t> batch = compression.decompress(std::move(payload));
+            if (isSealBatch(batch))
+                continue;
+            ++batches;
+            ASSERT_GE(batch.size(), sizeof(uint32_t) + 1);
+            const bool marked = byteorder::readLE32(batch.data()) == LogEntry::BATCH_ENCODING_MARKER;
+            EXPECT_EQ(marked, encoding != BatchEncoding::Rows);
+            if (marked)
+            {
+                EXPECT_EQ(static_cast<BatchEncoding>(batch[sizeof(uint32_t)]), encoding);
+            }
+        }
+        EXPECT_GT(batches, 0u);
+    }
+}
+
+// Parallel decoding must produce the serial export byte for byte, checkpoints and
+// seals included, and still abort on the first tampered blob.
+TEST_F(ExportTest, ParallelExportMatchesSerial)
+{
+    LoggingConfig cfg = makeConfig();
+    cfg.batchSize = 4;
+    cfg.merkleCheckpointInterval = 5;
+    {
+        LoggingManager mgr(cfg);
+        ASSERT_TRUE(mgr.start());
+        auto token = mgr.createProducerToken();
+        for (int i = 0; i < 600; ++i)
+        {
+            LogEntry entry(LogEntry::ActionType::READ, "loc_" + std::to_string(i), "c", "p",
+                           "subj_" + std::to_string(i % 5));
+            ASSERT_TRUE(mgr.append(std::move(entry), token, "parallel_" + std::to_string(i % 4)));
+        }
+        ASSERT_TRUE(mgr.stop());
+    }
+
+    auto readAll = [](const std::string &path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    };
+    const std::string serialPath = testDir + "/serial.ndjson";
+    ASSERT_TRUE(LogExporter(testDir, true, 6).exportToNDJSON(serialPath, ExportFilter{}));
+    auto pool = std::make_shared<WorkerPool>(3);
+    ASSERT_TRUE(LogExporter(testDir, true, 6, nullptr, nullptr, pool).exportToNDJSON(outputPath, ExportFilter{}));
+    EXPECT_EQ(readLines(serialPath).size(), 600u);
+    EXPECT_EQ(readAll(outputPath), readAll(serialPath));
+
+    ExportFilter subject;
+    subject.subjectId = "subj_3";
+    ASSERT_TRUE(LogExporter(testDir, true, 6).exportToNDJSON(serialPath, subject));
+    ASSERT_TRUE(LogExporter(testDir, true, 6, nullptr, nullptr, pool).exportToNDJSON(outputPath, subject));
+    EXPECT_EQ(readLines(outputPath).size(), 120u);
+    EXPECT_EQ(readAll(outputPath), readAll(serialPath));
+
+    std::string segment;
+    for (const auto &path : listLogFiles(testDir))
+    {
+        if (std::filesystem::file_size(path) > 32)
+            segment = path;
+    }
+    ASSERT_FALSE(segment.empty());
+    std::string content = readAll(segment);
+    content[20] ^= 0x01; // inside the first blob's sealed header
+    {
+        std::ofstream out(segment, std::ios::binary | std::ios::trunc);
+        out.write(content.data(), static_cast<std::streamsize>(content.size()));
+    }
+    EXPECT_FALSE(LogExporter(testDir, true, 6, nullptr, nullptr, pool).exportToNDJSON(outputPath, ExportFilter{}));
+    EXPECT_FALSE(std::filesystem::exists(outputPath));
+}
@@ -14,6 +14,7 @@
 #include <fstream>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 // Reads segments back manually to assert the raw on-disk wire format, independent
@@ -36,9 +37,10 @@ std::vector<uint8_t> readFile(const std::string &path)
 }
 
 // Blob wire format: [u32 ciphertextSize][u64 seqnum][IV, GCM_IV_SIZE bytes][ciphertext][GCM_TAG_SIZE bytes tag].
-std::vector<std::vector<uint8_t>> splitSegmentIntoBlobs(const std::vector<uint8_t> &segment)
+// Returns (offset, size) of each complete blob.
+std::vector<std::pair<size_t, size_t>> splitSegmentIntoBlobs(const std::vector<uint8_t> &segment)
 {
-    std::vector<std::vector<uint8_t>> blobs;
+    std::vector<std::pair<size_t, size_t>> blobs;
     size_t pos = 0;
     while (pos + sizeof(uint32_t) <= segment.size())
     {
@@ -47,7 +49,7 @@ std::vector<std::vector<uint8_t>> splitSegmentIntoBlobs(const std::vector<uint8_
                           ciphertextSize + Crypto::GCM_TAG_SIZE;
         if (pos + blobSize > segment.size())
             break;
-        blobs.emplace_back(segment.begin() + pos, segment.begin() + pos + blobSize);
+        blobs.emplace_back(pos, blobSize);
         pos += blobSize;
     }
     return blobs;
@@ -62,12 +64,15 @@ std::vector<LogEntry> decryptSegmentToEntries(const std::vector<uint8_t> &segmen
     std::vector<uint8_t> key(Crypto::KEY_SIZE, placeholder_crypto::KEY_BYTE);
 
     std::vector<LogEntry> out;
-    for (auto &blob : splitSegmentIntoBlobs(segment))
+    Compression compression;
+    std::vector<uint8_t> plaintext; // reused across blobs
+    for (const auto &[offset, size] : splitSegmentIntoBlobs(segment))
     {
-        auto plaintext = crypto.decrypt(blob, key,
-                                        reinterpret_cast<const uint8_t *>(target.data()),
-                                        target.size());
-        auto decompressed = Compression{}.decompress(std::move(plaintext));
+        crypto.decrypt(segment.data() + offset, size, key,
+                       reinterpret_cast<const uint8_t *>(target.data()),
+                       target.size(), plaintext);
+        std::vector<uint8_t> decompressed;
+        compression.decompress(plaintext.data(), plaintext.size(), decompressed);
         if (decompressed.size() == seal_marker::MAGIC_LEN &&
             std::memcmp(decompressed.data(), seal_marker::MAGIC, seal_marker::MAGIC_LEN) == 0)
         {
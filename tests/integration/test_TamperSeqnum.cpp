@@ -451,3 +451,43 @@ int main(int argc, char **argv)
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
 }
+
+TEST_F(TamperSeqnumTest, ResealedBatchDetectedByMerkleCheckpoint)
+{
+    // Someone holding the key can re-encrypt a batch at its own seqnum, which GCM
+    // and the seqnum checks accept; the checkpoint root no longer matches.
+    LoggingConfig cfg = makeConfig();
+    cfg.numWriterThreads = 1;
+    cfg.merkleCheckpointInterval = 2;
+    LoggingManager mgr(cfg);
+    ASSERT_TRUE(mgr.start());
+    writeEntries(mgr, 6);
+    ASSERT_TRUE(mgr.stop());
+    ASSERT_TRUE(mgr.exportLogs(outputPath));
+
+    auto segments = listLogFiles(testDir);
+    ASSERT_EQ(segments.size(), 1u);
+    auto segment = readSegment(segments[0]);
+    auto spans = scanBlobs(segment);
+    ASSERT_GE(spans.size(), 4u);
+
+    const std::string target = "ts";
+    const auto *targetBytes = reinterpret_cast<const uint8_t *>(target.data());
+    auto keys = placeholder_crypto::makeKeyRing();
+    Crypto crypto;
+    std::vector<uint8_t> original(segment.begin() + spans[0].offset,
+                                  segment.begin() + spans[0].offset + spans[0].size);
+    uint64_t seqnum = 0;
+    ASSERT_TRUE(Crypto::peekSeqnum(original, seqnum));
+    const auto plaintext = crypto.decrypt(original, *keys, targetBytes, target.size());
+    std::vector<uint8_t> resealed;
+    crypto.encrypt(plaintext.data(), plaintext.size(), *keys, resealed, seqnum,
+                   targetBytes, target.size());
+    ASSERT_EQ(resealed.size(), original.size());
+    ASSERT_NE(resealed, original); // fresh IV
+    std::copy(resealed.begin(), resealed.end(), segment.begin() + spans[0].offset);
+    writeSegment(segments[0], segment);
+
+    EXPECT_FALSE(mgr.exportLogs(outputPath));
+    EXPECT_FALSE(std::filesystem::exists(outputPath));
+}
@@ -6,6 +6,10 @@
 #include <chrono>
 #include <future>
 #include <random>
+#include <map>
+#include <optional>
+#include <cstdint>
+#include <algorithm>
 
 // Basic functionality tests
 class BufferQueueBasicTest : public ::testing::Test
@@ -913,6 +917,248 @@ TEST_F(BufferQueueTimingTest, FlushWithTimeout)
     consumer.join();
 }
 
+// A parked consumer must be woken by an enqueue well before its park timeout.
+TEST_F(BufferQueueTimingTest, WaitForItemsWakesOnEnqueue)
+{
+    BufferQueue::ProducerToken producerToken = queue->createProducerToken();
+    BufferQueue::ConsumerToken consumerToken = queue->createConsumerToken();
+
+    auto waiter = std::async(std::launch::async, [&]
+                             {
+        auto start = std::chrono::steady_clock::now();
+        queue->waitForItems(consumerToken, std::chrono::seconds(5));
+        return std::chrono::steady_clock::now() - start; });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_TRUE(queue->enqueueBlocking(createTestItem(1), producerToken, std::chrono::milliseconds(100)));
+
+    ASSERT_EQ(waiter.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+    EXPECT_LT(waiter.get(), std::chrono::seconds(2));
+}
+
+TEST_F(BufferQueueTimingTest, WaitForItemsReturnsImmediatelyWhenNonEmpty)
+{
+    BufferQueue::ProducerToken producerToken = queue->createProducerToken();
+    BufferQueue::ConsumerToken consumerToken = queue->createConsumerToken();
+    EXPECT_TRUE(queue->enqueueBlocking(createTestItem(1), producerToken, std::chrono::milliseconds(100)));
+
+    auto start = std::chrono::steady_clock::now();
+    queue->waitForItems(consumerToken, std::chrono::seconds(5));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+}
+
+TEST_F(BufferQueueTimingTest, WakeConsumersReleasesParkedWaiter)
+{
+    BufferQueue::ConsumerToken consumerToken = queue->createConsumerToken();
+    auto waiter = std::async(std::launch::async, [&]
+                             { queue->waitForItems(consumerToken, std::chrono::seconds(5)); });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    queue->wakeConsumers();
+
+    EXPECT_EQ(waiter.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+}
+
+// Target-affine sharding: every item for a target lands in the same shard, and a
+// consumer bound to that shard sees one producer's items in enqueue order.
+class BufferQueueShardTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        queue = std::make_unique<BufferQueue>(4096, 4, NUM_SHARDS);
+    }
+
+    QueueItem createItem(int id, const std::optional<std::string> &target)
+    {
+        return QueueItem(LogEntry(LogEntry::ActionType::READ,
+                                  "loc/" + std::to_string(id), "c", "p", "s"),
+                         target);
+    }
+
+    static constexpr size_t NUM_SHARDS = 4;
+    std::unique_ptr<BufferQueue> queue;
+};
+
+TEST_F(BufferQueueShardTest, RejectsZeroShardsAndBadConsumerShard)
+{
+    EXPECT_THROW(BufferQueue(64, 1, 0), std::invalid_argument);
+    EXPECT_THROW(queue->createConsumerToken(NUM_SHARDS), std::out_of_range);
+    EXPECT_EQ(queue->shardCount(), NUM_SHARDS);
+}
+
+TEST_F(BufferQueueShardTest, TargetsRouteToOneShardInProducerOrder)
+{
+    auto producer = queue->createProducerToken();
+    std::vector<std::string> targets;
+    for (int t = 0; t < 16; ++t)
+        targets.push_back("target_" + std::to_string(t));
+
+    const int perTarget = 20;
+    for (int i = 0; i < perTarget; ++i)
+        for (const auto &target : targets)
+            ASSERT_TRUE(queue->enqueueBlocking(createItem(i, target), producer, std::chrono::milliseconds(100)));
+    EXPECT_EQ(queue->size(), targets.size() * perTarget);
+
+    size_t total = 0;
+    for (size_t shard = 0; shard < NUM_SHARDS; ++shard)
+    {
+        auto consumer = queue->createConsumerToken(shard);
+        std::vector<QueueItem> items;
+        std::map<std::string, int> nextExpected;
+        while (queue->tryDequeueBatch(items, 64, consumer) > 0)
+        {
+            for (auto &item : items)
+            {
+                ASSERT_TRUE(item.targetFilename.has_value());
+                EXPECT_EQ(queue->shardFor(item.targetFilename), shard);
+                int &expected = nextExpected[*item.targetFilename];
+                EXPECT_EQ(item.entry.getDataLocation(), "loc/" + std::to_string(expected));
+                ++expected;
+                ++total;
+            }
+        }
+    }
+    EXPECT_EQ(total, targets.size() * perTarget);
+    EXPECT_EQ(queue->size(), 0u);
+}
+
+TEST_F(BufferQueueShardTest, MixedTargetBatchIsSplitAcrossShards)
+{
+    auto producer = queue->createProducerToken();
+    std::vector<QueueItem> batch;
+    for (int i = 0; i < 64; ++i)
+    {
+        std::optional<std::string> target;
+        if (i % 8 != 0)
+            target = "mixed_" + std::to_string(i % 8);
+        batch.push_back(createItem(i, target));
+    }
+    ASSERT_TRUE(queue->enqueueBatchBlocking(std::move(batch), producer, std::chrono::milliseconds(100)));
+    EXPECT_EQ(queue->size(), 64u);
+
+    // Untargeted entries always go to shard 0.
+    EXPECT_EQ(queue->shardFor(std::nullopt), 0u);
+
+    size_t total = 0;
+    for (size_t shard = 0; shard < NUM_SHARDS; ++shard)
+    {
+        auto consumer = queue->createConsumerToken(shard);
+        std::vector<QueueItem> items;
+        while (queue->tryDequeueBatch(items, 64, consumer) > 0)
+        {
+            for (const auto &item : items)
+                EXPECT_EQ(queue->shardFor(item.targetFilename), shard);
+            total += items.size();
+        }
+    }
+    EXPECT_EQ(total, 64u);
+}
+
+// A batch spanning shards is never left half-enqueued by a timeout.
+TEST_F(BufferQueueShardTest, MixedTargetBatchIsAllOrNothing)
+{
+    auto producer = queue->createProducerToken();
+    std::vector<std::optional<std::string>> targetFor(NUM_SHARDS);
+    for (int i = 0; !targetFor[1] || !targetFor[2]; ++i)
+    {
+        const std::string target = "target_" + std::to_string(i);
+        auto &slot = targetFor[queue->shardFor(target)];
+        if (!slot)
+            slot = target;
+    }
+    auto fill = [&](size_t shard)
+    {
+        size_t count = 0;
+        while (queue->enqueueBlocking(createItem(0, targetFor[shard]), producer, std::chrono::milliseconds(0)))
+            ++count;
+        return count;
+    };
+    auto drain = [&](size_t shard, size_t maxItems)
+    {
+        auto consumer = queue->createConsumerToken(shard);
+        std::vector<QueueItem> items;
+        size_t count = 0;
+        while (count < maxItems && queue->tryDequeueBatch(items, std::min<size_t>(64, maxItems - count), consumer) > 0)
+            count += items.size();
+        return count;
+    };
+    auto mixedBatch = [&]
+    {
+        std::vector<QueueItem> batch;
+        for (int i = 0; i < 8; ++i)
+        {
+            batch.push_back(createItem(i, targetFor[1]));
+            batch.push_back(createItem(i, targetFor[2]));
+        }
+        return batch;
+    };
+
+    // The first share does not fit: nothing is enqueued.
+    const size_t fullFirst = fill(1);
+    EXPECT_FALSE(queue->enqueueBatchBlocking(mixedBatch(), producer, std::chrono::milliseconds(10)));
+    EXPECT_EQ(queue->size(), fullFirst);
+    EXPECT_EQ(drain(1, SIZE_MAX), fullFirst);
+
+    // A later share that does not fit is waited for past the timeout.
+    const size_t fullSecond = fill(2);
+    std::thread consumer([&]
+                         {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        drain(2, 8); });
+    EXPECT_TRUE(queue->enqueueBatchBlocking(mixedBatch(), producer, std::chrono::milliseconds(10)));
+    consumer.join();
+    EXPECT_EQ(drain(1, SIZE_MAX), 8u);
+    EXPECT_EQ(drain(2, SIZE_MAX), fullSecond);
+}
+
+TEST_F(BufferQueueShardTest, MixedTargetBatchNeverHangs)
+{
+    auto producer = queue->createProducerToken();
+    std::vector<std::optional<std::string>> targetFor(NUM_SHARDS);
+    for (int i = 0; !targetFor[1] || !targetFor[2]; ++i)
+    {
+        const std::string target = "target_" + std::to_string(i);
+        auto &slot = targetFor[queue->shardFor(target)];
+        if (!slot)
+            slot = target;
+    }
+    auto mixedBatch = [&](size_t secondShare)
+    {
+        std::vector<QueueItem> batch;
+        for (int i = 0; i < 8; ++i)
+            batch.push_back(createItem(i, targetFor[1]));
+        for (size_t i = 0; i < secondShare; ++i)
+            batch.push_back(createItem(static_cast<int>(i), targetFor[2]));
+        return batch;
+    };
+
+    // A share larger than its shard can never fit: rejected before anything is queued.
+    size_t enqueued = 1;
+    EXPECT_FALSE(queue->enqueueBatchBlocking(mixedBatch(4096 / NUM_SHARDS + 1), producer,
+                                             std::chrono::milliseconds::max(), &enqueued));
+    EXPECT_EQ(enqueued, 0u);
+    EXPECT_EQ(queue->size(), 0u);
+
+    // No consumer drains shard 2 and the queue is closed: the first share stays
+    // queued and the call reports it instead of waiting forever.
+    while (queue->enqueueBlocking(createItem(0, targetFor[2]), producer, std::chrono::milliseconds(0)))
+    {
+    }
+    const size_t fullSecond = queue->size();
+    queue->close();
+    EXPECT_FALSE(queue->enqueueBatchBlocking(mixedBatch(8), producer, std::chrono::milliseconds::max(), &enqueued));
+    EXPECT_EQ(enqueued, 8u);
+    EXPECT_EQ(queue->size(), fullSecond + 8);
+
+    // Reopened, the grace period past the timeout bounds the wait instead.
+    queue->reopen();
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(queue->enqueueBatchBlocking(mixedBatch(8), producer, std::chrono::milliseconds(10), &enqueued));
+    EXPECT_EQ(enqueued, 8u);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, BufferQueue::COMMITTED_SHARE_GRACE);
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -145,6 +145,163 @@ TEST_F(CompressionTest, DecompressCapEnforced)
     EXPECT_EQ(round_tripped, zerosCopy);
 }
 
+// Streaming inflate must produce the same bytes whatever the input split, and
+// must reject truncated streams and bytes after the end of the stream.
+TEST_F(CompressionTest, StreamingDecompress)
+{
+    std::vector<uint8_t> original(200000);
+    for (size_t i = 0; i < original.size(); ++i)
+        original[i] = static_cast<uint8_t>((i / 7) ^ (i % 31));
+    std::vector<uint8_t> compressed = Compression{}.compress(std::vector<uint8_t>(original));
+
+    Compression compression;
+    for (size_t step : {size_t(1), size_t(333), compressed.size()})
+    {
+        std::vector<uint8_t> out;
+        compression.beginDecompress();
+        for (size_t pos = 0; pos < compressed.size(); pos += step)
+        {
+            compression.decompressChunk(compressed.data() + pos, std::min(step, compressed.size() - pos),
+                                        [&](const uint8_t *d, size_t n)
+                                        { out.insert(out.end(), d, d + n); });
+        }
+        compression.endDecompress();
+        EXPECT_EQ(out, original);
+    }
+
+    auto discard = [](const uint8_t *, size_t) {};
+    compression.beginDecompress();
+    compression.decompressChunk(compressed.data(), compressed.size() / 2, discard);
+    EXPECT_THROW(compression.endDecompress(), std::runtime_error);
+
+    std::vector<uint8_t> trailing = compressed;
+    trailing.push_back(0);
+    compression.beginDecompress();
+    EXPECT_THROW(compression.decompressChunk(trailing.data(), trailing.size(), discard), std::runtime_error);
+
+    compression.beginDecompress();
+    EXPECT_THROW(compression.decompressChunk(compressed.data(), compressed.size(), discard, 1000),
+                 std::runtime_error);
+}
+
+// Every payload names its codec in the first byte; zstd must round-trip through
+// both the one-shot and the streaming paths with the same checks as zlib.
+TEST_F(CompressionTest, ZstdRoundTripAndStreaming)
+{
+    if (!Codec::compiledIn(CompressionCodec::Zstd))
+        GTEST_SKIP() << "zstd support was not compiled in";
+
+    std::vector<uint8_t> original(200000);
+    for (size_t i = 0; i < original.size(); ++i)
+        original[i] = static_cast<uint8_t>((i / 7) ^ (i % 31));
+
+    Compression compression;
+    std::vector<uint8_t> compressed;
+    compression.compress(original.data(), original.size(), compressed, 3, CompressionCodec::Zstd);
+    ASSERT_FALSE(compressed.empty());
+    EXPECT_EQ(compressed[0], static_cast<uint8_t>(CompressionCodec::Zstd));
+    EXPECT_LT(compressed.size(), original.size());
+
+    EXPECT_EQ(compression.decompress(std::vector<uint8_t>(compressed)), original);
+
+    for (size_t step : {size_t(1), size_t(333), compressed.size()})
+    {
+        std::vector<uint8_t> out;
+        compression.beginDecompress();
+        for (size_t pos = 0; pos < compressed.size(); pos += step)
+        {
+            compression.decompressChunk(compressed.data() + pos, std::min(step, compressed.size() - pos),
+                                        [&](const uint8_t *d, size_t n)
+                                        { out.insert(out.end(), d, d + n); });
+        }
+        compression.endDecompress();
+        EXPECT_EQ(out, original);
+    }
+
+    auto discard = [](const uint8_t *, size_t) {};
+    compression.beginDecompress();
+    compression.decompressChunk(compressed.data(), compressed.size() / 2, discard);
+    EXPECT_THROW(compression.endDecompress(), std::runtime_error);
+
+    compression.beginDecompress();
+    EXPECT_THROW(compression.decompressChunk(compressed.data(), compressed.size(), discard, 1000),
+                 std::runtime_error);
+}
+
+// LZ4 frames over the fast and the HC compressor, through both decompress paths,
+// with the same zip-bomb cap as the other codecs.
+TEST_F(CompressionTest, Lz4RoundTripAndCap)
+{
+    if (!Codec::compiledIn(CompressionCodec::Lz4))
+        GTEST_SKIP() << "LZ4 support was not compiled in";
+
+    std::vector<uint8_t> original(200000);
+    for (size_t i = 0; i < original.size(); ++i)
+        original[i] = static_cast<uint8_t>((i / 7) ^ (i % 31));
+
+    Compression compression;
+    for (int level : {1, 9})
+    {
+        std::vector<uint8_t> compressed;
+        compression.compress(original.data(), original.size(), compressed, level, CompressionCodec::Lz4);
+        ASSERT_FALSE(compressed.empty());
+        EXPECT_EQ(compressed[0], static_cast<uint8_t>(CompressionCodec::Lz4));
+        EXPECT_LT(compressed.size(), original.size());
+        EXPECT_EQ(compression.decompress(std::vector<uint8_t>(compressed)), original);
+
+        for (size_t step : {size_t(1), size_t(333)})
+        {
+            std::vector<uint8_t> out;
+            compression.beginDecompress();
+            for (size_t pos = 0; pos < compressed.size(); pos += step)
+            {
+                compression.decompressChunk(compressed.data() + pos, std::min(step, compressed.size() - pos),
+                                            [&](const uint8_t *d, size_t n)
+                                            { out.insert(out.end(), d, d + n); });
+            }
+            compression.endDecompress();
+            EXPECT_EQ(out, original);
+        }
+
+        auto discard = [](const uint8_t *, size_t) {};
+        compression.beginDecompress();
+        compression.decompressChunk(compressed.data(), compressed.size() / 2, discard);
+        EXPECT_THROW(compression.endDecompress(), std::runtime_error);
+
+        std::vector<uint8_t> trailing = compressed;
+        trailing.push_back(0);
+        compression.beginDecompress();
+        EXPECT_THROW(compression.decompressChunk(trailing.data(), trailing.size(), discard), std::runtime_error);
+    }
+
+    std::vector<uint8_t> zeros(5 * 1024 * 1024, 0);
+    std::vector<uint8_t> compressed;
+    compression.compress(zeros.data(), zeros.size(), compressed, 1, CompressionCodec::Lz4);
+    ASSERT_LT(compressed.size(), zeros.size() / 10);
+    EXPECT_THROW(compression.decompress(std::vector<uint8_t>(compressed), 1 * 1024 * 1024),
+                 std::runtime_error);
+    EXPECT_EQ(compression.decompress(std::move(compressed), 10 * 1024 * 1024), zeros);
+}
+
+// Blobs written before codec IDs existed hold a bare zlib stream; they must still read.
+TEST_F(CompressionTest, LegacyZlibPayloadStillDecompresses)
+{
+    std::vector<uint8_t> batch = LogEntry::serializeBatch({entry1, entry2, entry3, entry4});
+    uLongf bound = compressBound(batch.size());
+    std::vector<uint8_t> legacy(bound);
+    ASSERT_EQ(compress2(legacy.data(), &bound, batch.data(), batch.size(), Z_DEFAULT_COMPRESSION), Z_OK);
+    legacy.resize(bound);
+
+    EXPECT_EQ(Compression{}.decompress(std::move(legacy)), batch);
+}
+
+TEST_F(CompressionTest, UnknownCodecRejected)
+{
+    std::vector<uint8_t> compressed = Compression{}.compress(LogEntry::serializeBatch({entry1}));
+    compressed[0] = 0x7F;
+    EXPECT_THROW(Compression{}.decompress(std::move(compressed)), std::runtime_error);
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include "CompressionController.hpp"
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+AdaptiveCompressionPolicy makePolicy()
+{
+    AdaptiveCompressionPolicy policy;
+    policy.enabled = true;
+    policy.minLevel = 1;
+    policy.highWatermark = 0.75;
+    policy.lowWatermark = 0.25;
+    policy.adjustInterval = std::chrono::milliseconds(10);
+    return policy;
+}
+
+std::vector<int> levels(const CompressionController &controller)
+{
+    std::vector<int> out;
+    for (const auto &setting : controller.ladder())
+        out.push_back(setting.level);
+    return out;
+}
+} // namespace
+
+TEST(CompressionControllerTest, LadderHalvesTowardMinLevel)
+{
+    CompressionController zlib(CompressionCodec::Zlib, 9, makePolicy(), 100);
+    EXPECT_EQ(levels(zlib), (std::vector<int>{9, 5, 3, 2, 1}));
+
+    AdaptiveCompressionPolicy policy = makePolicy();
+    policy.minLevel = 3;
+    policy.pressureCodec = CompressionCodec::Lz4;
+    CompressionController zstd(CompressionCodec::Zstd, 19, policy, 100);
+    EXPECT_EQ(levels(zstd), (std::vector<int>{19, 11, 7, 5, 4, 3, 1}));
+    EXPECT_EQ(zstd.ladder().back().codec, CompressionCodec::Lz4);
+    EXPECT_EQ(zstd.ladder().front().codec, CompressionCodec::Zstd);
+
+    // Already at minLevel: nothing to step down to.
+    CompressionController fixed(CompressionCodec::Zlib, 1, makePolicy(), 100);
+    EXPECT_EQ(fixed.ladder().size(), 1u);
+}
+
+TEST(CompressionControllerTest, StepsWithPressureAndHysteresis)
+{
+    CompressionController controller(CompressionCodec::Zlib, 9, makePolicy(), 100);
+    auto t = Clock::now();
+    const auto interval = std::chrono::milliseconds(10);
+
+    controller.observe(80, t);
+    EXPECT_EQ(controller.step(), 1u);
+    EXPECT_EQ(controller.current().level, 5);
+
+    // Within the interval further samples don't move it.
+    controller.observe(100, t + interval / 2);
+    EXPECT_EQ(controller.step(), 1u);
+
+    // Between the watermarks the step holds.
+    t += interval;
+    controller.observe(50, t);
+    EXPECT_EQ(controller.step(), 1u);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        t += interval;
+        controller.observe(100, t);
+    }
+    EXPECT_EQ(controller.step(), controller.ladder().size() - 1);
+    EXPECT_EQ(controller.current().level, 1);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        t += interval;
+        controller.observe(25, t);
+    }
+    EXPECT_EQ(controller.step(), 0u);
+    EXPECT_EQ(controller.current().level, 9);
+}
+
+TEST(CompressionControllerTest, RejectsBadPolicy)
+{
+    AdaptiveCompressionPolicy policy = makePolicy();
+    policy.minLevel = 0;
+    EXPECT_THROW(CompressionController(CompressionCodec::Zlib, 9, policy, 100), std::invalid_argument);
+    policy = makePolicy();
+    policy.minLevel = 10;
+    EXPECT_THROW(CompressionController(CompressionCodec::Zlib, 9, policy, 100), std::invalid_argument);
+    policy = makePolicy();
+    policy.lowWatermark = 0.8;
+    EXPECT_THROW(CompressionController(CompressionCodec::Zlib, 9, policy, 100), std::invalid_argument);
+    policy = makePolicy();
+    policy.highWatermark = 1.5;
+    EXPECT_THROW(CompressionController(CompressionCodec::Zlib, 9, policy, 100), std::invalid_argument);
+    EXPECT_THROW(CompressionController(CompressionCodec::Zlib, 9, makePolicy(), 0), std::invalid_argument);
+}
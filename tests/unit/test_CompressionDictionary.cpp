@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+#include "CompressionDictionary.hpp"
+#include "Compression.hpp"
+#include "Crypto.hpp"
+#include "KeyRing.hpp"
+#include "LogEntry.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+// Small batches shaped like production traffic: few controllers, shared prefixes.
+std::vector<uint8_t> sampleBatch(int seed, size_t entries)
+{
+    std::vector<LogEntry> batch;
+    for (size_t i = 0; i < entries; ++i)
+    {
+        const int n = seed * 31 + static_cast<int>(i);
+        batch.emplace_back(LogEntry::ActionType::READ,
+                           "/data/customers/records/" + std::to_string(n),
+                           "controller-" + std::to_string(n % 3),
+                           "processor-" + std::to_string(n % 2),
+                           "subject-" + std::to_string(n % 50),
+                           std::vector<uint8_t>{'{', '"', 'f', 'i', 'e', 'l', 'd', '"', ':', static_cast<uint8_t>('0' + n % 10), '}'});
+    }
+    return LogEntry::serializeBatch(std::move(batch));
+}
+
+std::vector<std::vector<uint8_t>> sampleBatches(size_t count)
+{
+    std::vector<std::vector<uint8_t>> samples;
+    for (size_t i = 0; i < count; ++i)
+        samples.push_back(sampleBatch(static_cast<int>(i), 4));
+    return samples;
+}
+
+class DictionaryRegistryTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        dir = "./test_compression_dictionary";
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(dir);
+    }
+
+    std::string dir;
+};
+} // namespace
+
+TEST_F(DictionaryRegistryTest, AddDeduplicatesAndAssignsLongestPrefix)
+{
+    DictionaryRegistry registry;
+    const uint32_t a = registry.add({1, 2, 3});
+    const uint32_t b = registry.add({4, 5, 6});
+    EXPECT_NE(a, b);
+    EXPECT_EQ(registry.add({1, 2, 3}), a);
+    EXPECT_THROW(registry.add({}), std::invalid_argument);
+    EXPECT_EQ(registry.find(999), nullptr);
+
+    EXPECT_EQ(registry.forTarget("audit_eu"), nullptr);
+    registry.assign("", a);
+    registry.assign("audit_", b);
+    EXPECT_EQ(registry.forTarget("audit_eu")->id, b);
+    EXPECT_EQ(registry.forTarget("billing")->id, a);
+    EXPECT_THROW(registry.assign("x", 999), std::invalid_argument);
+}
+
+TEST_F(DictionaryRegistryTest, SaveLoadRoundTrip)
+{
+    KeyRing keys(KeyRing::DEFAULT_KEY_ID, std::vector<uint8_t>(Crypto::KEY_SIZE, 0x42));
+    for (const KeyRing *ring : {static_cast<const KeyRing *>(nullptr), static_cast<const KeyRing *>(&keys)})
+    {
+        DictionaryRegistry registry;
+        const uint32_t a = registry.add({1, 2, 3});
+        const uint32_t b = registry.add(std::vector<uint8_t>(5000, 7));
+        registry.save(dir, ring);
+
+        auto loaded = DictionaryRegistry::load(dir, ring);
+        ASSERT_NE(loaded->find(a), nullptr);
+        ASSERT_NE(loaded->find(b), nullptr);
+        EXPECT_EQ(loaded->find(a)->bytes, registry.find(a)->bytes);
+        EXPECT_EQ(loaded->find(b)->bytes, registry.find(b)->bytes);
+        // New dictionaries never reuse an ID already on disk.
+        EXPECT_GT(loaded->add({9}), b);
+    }
+
+    EXPECT_TRUE(DictionaryRegistry::load(dir + "/missing", nullptr)->empty());
+}
+
+// Sealed registries are authenticated like blobs; plaintext ones are at least parsed strictly.
+TEST_F(DictionaryRegistryTest, DamagedRegistryRejected)
+{
+    KeyRing keys(KeyRing::DEFAULT_KEY_ID, std::vector<uint8_t>(Crypto::KEY_SIZE, 0x42));
+    DictionaryRegistry registry;
+    registry.add(std::vector<uint8_t>(100, 1));
+    registry.save(dir, &keys);
+
+    const std::string path = dir + "/" + DictionaryRegistry::FILENAME;
+    std::vector<char> file;
+    {
+        std::ifstream in(path, std::ios::binary);
+        file.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    file[file.size() / 2] ^= 0x01;
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(file.data(), static_cast<std::streamsize>(file.size()));
+    }
+    EXPECT_THROW(DictionaryRegistry::load(dir, &keys), TamperDetectedException);
+
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << "GDPRDICT\x05";
+    }
+    EXPECT_THROW(DictionaryRegistry::load(dir, nullptr), std::runtime_error);
+}
+
+TEST_F(DictionaryRegistryTest, TrainedDictionaryShrinksSmallBatches)
+{
+    const std::vector<uint8_t> dictBytes = DictionaryRegistry::train(sampleBatches(400), 8 * 1024);
+    ASSERT_FALSE(dictBytes.empty());
+    EXPECT_LE(dictBytes.size(), 8 * 1024u);
+    EXPECT_THROW(DictionaryRegistry::train({}), std::runtime_error);
+
+    auto registry = std::make_shared<DictionaryRegistry>();
+    const CompressionDictionary *dict = registry->find(registry->add(dictBytes));
+
+    const std::vector<uint8_t> batch = sampleBatch(1000, 4);
+    for (CompressionCodec codec : {CompressionCodec::Zlib, CompressionCodec::Zstd})
+    {
+        if (!Codec::compiledIn(codec))
+            continue;
+        Compression compression;
+        compression.setDictionaries(registry);
+        std::vector<uint8_t> plain, primed;
+        compression.compress(batch.data(), batch.size(), plain, 6, codec);
+        compression.compress(batch.data(), batch.size(), primed, 6, codec, dict);
+        EXPECT_LT(primed.size(), plain.size()) << "codec " << static_cast<int>(codec);
+        EXPECT_EQ(primed[0], static_cast<uint8_t>(codec) | Compression::PAYLOAD_FLAG_DICTIONARY);
+
+        EXPECT_EQ(compression.decompress(std::vector<uint8_t>(primed)), batch);
+
+        // Byte-at-a-time streaming splits the dictionary ID across calls.
+        std::vector<uint8_t> out;
+        compression.beginDecompress();
+        for (uint8_t byte : primed)
+        {
+            compression.decompressChunk(&byte, 1, [&](const uint8_t *d, size_t n)
+                                        { out.insert(out.end(), d, d + n); });
+        }
+        compression.endDecompress();
+        EXPECT_EQ(out, batch);
+
+        // Without the registry, or with a different dictionary under the ID, it fails.
+        Compression unaware;
+        EXPECT_THROW(unaware.decompress(std::vector<uint8_t>(primed)), std::runtime_error);
+        auto wrong = std::make_shared<DictionaryRegistry>();
+        wrong->add(std::vector<uint8_t>(dictBytes.rbegin(), dictBytes.rend()));
+        unaware.setDictionaries(wrong);
+        EXPECT_THROW(unaware.decompress(std::vector<uint8_t>(primed)), std::runtime_error);
+    }
+}
+
+TEST_F(DictionaryRegistryTest, CodecsWithoutDictionariesRecordNone)
+{
+    if (!Codec::compiledIn(CompressionCodec::Lz4))
+        GTEST_SKIP() << "LZ4 support was not compiled in";
+
+    DictionaryRegistry registry;
+    const CompressionDictionary *dict = registry.find(registry.add(sampleBatch(1, 4)));
+    const std::vector<uint8_t> batch = sampleBatch(2, 4);
+    Compression compression;
+    std::vector<uint8_t> out;
+    compression.compress(batch.data(), batch.size(), out, 1, CompressionCodec::Lz4, dict);
+    EXPECT_EQ(out[0], static_cast<uint8_t>(CompressionCodec::Lz4));
+    EXPECT_EQ(Compression{}.decompress(std::move(out)), batch);
+}
@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+#include "CpuAffinity.hpp"
+#include <algorithm>
+#include <thread>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+TEST(CpuAffinityTest, ParseCpuList)
+{
+    EXPECT_EQ(cpu_affinity::parseCpuList("0-3,8,10-11"), (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(cpu_affinity::parseCpuList(" 5 , 1-2,2 "), (std::vector<int>{1, 2, 5}));
+    EXPECT_TRUE(cpu_affinity::parseCpuList("").empty());
+    EXPECT_THROW(cpu_affinity::parseCpuList("3-1"), std::invalid_argument);
+    EXPECT_THROW(cpu_affinity::parseCpuList("a"), std::invalid_argument);
+    EXPECT_THROW(cpu_affinity::parseCpuList("1-2x"), std::invalid_argument);
+}
+
+TEST(CpuAffinityTest, PlanWriterCpus)
+{
+    const std::vector<std::vector<int>> twoNodes = {{0, 1, 2}, {3, 4, 5}};
+
+    auto unpinned = cpu_affinity::planWriterCpus(WriterPlacement::Unpinned, "", 3, twoNodes);
+    ASSERT_EQ(unpinned.size(), 3u);
+    EXPECT_TRUE(std::all_of(unpinned.begin(), unpinned.end(), [](const auto &s)
+                            { return s.empty(); }));
+
+    auto spread = cpu_affinity::planWriterCpus(WriterPlacement::SpreadNodes, "", 3, twoNodes);
+    EXPECT_EQ(spread, (std::vector<std::vector<int>>{{0, 1, 2}, {3, 4, 5}, {0, 1, 2}}));
+
+    auto compact = cpu_affinity::planWriterCpus(WriterPlacement::CompactNodes, "", 4, twoNodes);
+    EXPECT_EQ(compact, (std::vector<std::vector<int>>{{0}, {1}, {2}, {3}}));
+
+    auto list = cpu_affinity::planWriterCpus(WriterPlacement::CpuList, "7,9", 3, twoNodes);
+    EXPECT_EQ(list, (std::vector<std::vector<int>>{{7}, {9}, {7}}));
+    EXPECT_THROW(cpu_affinity::planWriterCpus(WriterPlacement::CpuList, "", 1, twoNodes),
+                 std::invalid_argument);
+}
+
+TEST(CpuAffinityTest, NodesCoverOnlyAllowedCpus)
+{
+    auto nodes = cpu_affinity::nodes();
+    ASSERT_FALSE(nodes.empty());
+    for (const auto &node : nodes)
+        EXPECT_FALSE(node.empty());
+}
+
+#ifdef __linux__
+TEST(CpuAffinityTest, PinnedThreadRunsOnRequestedCpu)
+{
+    const int target = cpu_affinity::nodes().front().front();
+    int observed = -1;
+    bool pinned = false;
+    std::thread t([&]()
+                  {
+        pinned = cpu_affinity::pinCurrentThread({target});
+        observed = sched_getcpu(); });
+    t.join();
+    ASSERT_TRUE(pinned);
+    EXPECT_EQ(observed, target);
+    EXPECT_FALSE(cpu_affinity::pinCurrentThread({}));
+}
+#endif
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
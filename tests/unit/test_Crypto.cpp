@@ -1,7 +1,12 @@
 #include <gtest/gtest.h>
 #include "Crypto.hpp"
+#include "ByteOrder.hpp"
+#include "KeyRing.hpp"
+#include "WorkerPool.hpp"
 #include <cstring>
+#include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 #include <algorithm>
 
@@ -292,6 +297,352 @@ TEST_F(CryptoTest, FreshIVPerEncryption)
     EXPECT_EQ(data, crypto.decrypt(encrypted2, key));
 }
 
+TEST_F(CryptoTest, ChunkedRoundTrip)
+{
+    std::vector<uint8_t> data(100000);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<uint8_t>(i * 7);
+    std::vector<uint8_t> key = createRandomKey();
+    const std::string target = "chunked";
+    const auto *name = reinterpret_cast<const uint8_t *>(target.data());
+
+    WorkerPool pool(3);
+    for (WorkerPool *p : {static_cast<WorkerPool *>(nullptr), &pool})
+    {
+        std::vector<uint8_t> encrypted;
+        crypto.encrypt(data.data(), data.size(), key, encrypted, 9, name, target.size(), 4096, p);
+        ASSERT_TRUE(byteorder::readLE32(encrypted.data()) & Crypto::EXTENDED_BLOB_FLAG);
+        EXPECT_EQ(Crypto::blobSize(byteorder::readLE32(encrypted.data())), encrypted.size());
+
+        uint64_t seqnum = 0;
+        ASSERT_TRUE(Crypto::peekSeqnum(encrypted, seqnum));
+        EXPECT_EQ(seqnum, 9u);
+
+        // Either side may use the pool.
+        EXPECT_EQ(data, crypto.decrypt(encrypted, key, name, target.size(), &pool));
+        EXPECT_EQ(data, crypto.decrypt(encrypted, key, name, target.size()));
+    }
+}
+
+TEST_F(CryptoTest, ChunkedSmallPlaintextKeepsSingleTagFormat)
+{
+    std::vector<uint8_t> data = stringToBytes("short");
+    std::vector<uint8_t> key = createRandomKey();
+
+    std::vector<uint8_t> encrypted;
+    crypto.encrypt(data.data(), data.size(), key, encrypted, 0, nullptr, 0, 4096, nullptr);
+    EXPECT_EQ(byteorder::readLE32(encrypted.data()), data.size());
+    EXPECT_EQ(data, crypto.decrypt(encrypted, key));
+}
+
+TEST_F(CryptoTest, ChunkedTamperDetected)
+{
+    const size_t chunkSize = 1024;
+    std::vector<uint8_t> data(4 * chunkSize);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<uint8_t>(i);
+    std::vector<uint8_t> key = createRandomKey();
+    const std::string target = "t";
+    const auto *name = reinterpret_cast<const uint8_t *>(target.data());
+
+    std::vector<uint8_t> encrypted;
+    crypto.encrypt(data.data(), data.size(), key, encrypted, 1, name, target.size(), chunkSize, nullptr);
+    const size_t chunksStart = sizeof(uint32_t) + Crypto::SEQNUM_SIZE + Crypto::GCM_IV_SIZE +
+                               Crypto::EXTENDED_HEADER_SIZE;
+    const size_t stride = chunkSize + Crypto::GCM_TAG_SIZE;
+
+    // Flipped ciphertext bit in a middle chunk.
+    auto flipped = encrypted;
+    flipped[chunksStart + stride + 5] ^= 0x01;
+    EXPECT_THROW(crypto.decrypt(flipped, key, name, target.size()), TamperDetectedException);
+
+    // Two chunks swapped (each keeps a valid tag, but for the wrong index).
+    auto swapped = encrypted;
+    std::swap_ranges(swapped.begin() + chunksStart, swapped.begin() + chunksStart + stride,
+                     swapped.begin() + chunksStart + stride);
+    EXPECT_THROW(crypto.decrypt(swapped, key, name, target.size()), TamperDetectedException);
+
+    // Last chunk dropped, with length field and chunk count patched to match.
+    auto truncated = encrypted;
+    truncated.resize(truncated.size() - stride);
+    byteorder::writeLE32(truncated.data(),
+                         byteorder::readLE32(truncated.data()) - static_cast<uint32_t>(stride));
+    byteorder::writeLE32(truncated.data() + chunksStart - sizeof(uint32_t), 3);
+    EXPECT_THROW(crypto.decrypt(truncated, key, name, target.size()), TamperDetectedException);
+
+    // Wrong target.
+    EXPECT_THROW(crypto.decrypt(encrypted, key, nullptr, 0), TamperDetectedException);
+}
+
+TEST_F(CryptoTest, KeyRingDefaultKeyKeepsSingleTagFormat)
+{
+    std::vector<uint8_t> data = stringToBytes("default key");
+    std::vector<uint8_t> key = createRandomKey();
+    KeyRing ring(KeyRing::DEFAULT_KEY_ID, key);
+
+    std::vector<uint8_t> encrypted;
+    crypto.encrypt(data.data(), data.size(), ring, encrypted, 3, nullptr, 0);
+    EXPECT_EQ(byteorder::readLE32(encrypted.data()), data.size());
+
+    // Interchangeable with the raw-key API.
+    EXPECT_EQ(data, crypto.decrypt(encrypted, key, nullptr, 0));
+    EXPECT_EQ(data, crypto.decrypt(encrypted, ring, nullptr, 0));
+}
+
+TEST_F(CryptoTest, KeyRingRotationRecordsKeyId)
+{
+    std::vector<uint8_t> data = stringToBytes("sealed after rotation");
+    const std::string target = "rotated";
+    const auto *name = reinterpret_cast<const uint8_t *>(target.data());
+    KeyRing ring(KeyRing::DEFAULT_KEY_ID, createRandomKey());
+
+    std::vector<uint8_t> before;
+    crypto.encrypt(data.data(), data.size(), ring, before, 0, name, target.size());
+
+    ring.addKey(7, createRandomKey());
+    ring.setActiveKey(7);
+    std::vector<uint8_t> after;
+    crypto.encrypt(data.data(), data.size(), ring, after, 1, name, target.size());
+
+    ASSERT_TRUE(byteorder::readLE32(after.data()) & Crypto::EXTENDED_BLOB_FLAG);
+    const size_t header = sizeof(uint32_t) + Crypto::SEQNUM_SIZE + Crypto::GCM_IV_SIZE;
+    EXPECT_EQ(after[header + 1] & Crypto::BLOB_FLAG_KEY_ID, Crypto::BLOB_FLAG_KEY_ID);
+    EXPECT_EQ(byteorder::readLE32(after.data() + header + Crypto::EXTENDED_HEADER_SIZE), 7u);
+    EXPECT_EQ(Crypto::blobSize(byteorder::readLE32(after.data())), after.size());
+
+    // Both blobs open with the same ring, each under its own key.
+    EXPECT_EQ(data, crypto.decrypt(before, ring, name, target.size()));
+    EXPECT_EQ(data, crypto.decrypt(after, ring, name, target.size()));
+
+    // The key ID is authenticated: pointing it at another key fails the tag.
+    auto relabeled = after;
+    byteorder::writeLE32(relabeled.data() + header + Crypto::EXTENDED_HEADER_SIZE, 0);
+    EXPECT_THROW(crypto.decrypt(relabeled, ring, name, target.size()), TamperDetectedException);
+
+    // A ring without key 7 cannot open the blob.
+    KeyRing oldRing(KeyRing::DEFAULT_KEY_ID, createRandomKey());
+    EXPECT_THROW(crypto.decrypt(after, oldRing, name, target.size()), std::runtime_error);
+}
+
+TEST_F(CryptoTest, DecryptStreamMatchesDecrypt)
+{
+    std::vector<uint8_t> data(10000);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<uint8_t>(i * 13);
+    const std::string target = "streamed";
+    const auto *name = reinterpret_cast<const uint8_t *>(target.data());
+    KeyRing ring(KeyRing::DEFAULT_KEY_ID, createRandomKey());
+    ring.addKey(4, createRandomKey());
+    WorkerPool pool(2);
+
+    // Two blobs back to back: single-tag, then chunked under a non-default key.
+    std::vector<uint8_t> file, blob;
+    crypto.encrypt(data.data(), data.size(), ring, blob, 0, name, target.size());
+    file.insert(file.end(), blob.begin(), blob.end());
+    ring.setActiveKey(4);
+    crypto.encrypt(data.data(), data.size(), ring, blob, 1, name, target.size(), 1000);
+    file.insert(file.end(), blob.begin(), blob.end());
+
+    for (WorkerPool *p : {static_cast<WorkerPool *>(nullptr), &pool})
+    {
+        std::istringstream in(std::string(file.begin(), file.end()));
+        for (int i = 0; i < 2; ++i)
+        {
+            std::vector<uint8_t> out;
+            size_t calls = 0;
+            crypto.decryptStream(in, ring, name, target.size(), [&](const uint8_t *d, size_t n)
+                                 { out.insert(out.end(), d, d + n); ++calls; }, p);
+            EXPECT_EQ(data, out);
+            EXPECT_EQ(calls, i == 0 ? 1u : 10u);
+        }
+        EXPECT_EQ(in.peek(), std::char_traits<char>::eof());
+    }
+}
+
+TEST_F(CryptoTest, DecryptStreamRejectsTamperAndTruncation)
+{
+    const size_t chunkSize = 512;
+    std::vector<uint8_t> data(4 * chunkSize);
+    std::vector<uint8_t> key = createRandomKey();
+    KeyRing ring(KeyRing::DEFAULT_KEY_ID, key);
+    std::vector<uint8_t> encrypted;
+    crypto.encrypt(data.data(), data.size(), ring, encrypted, 2, nullptr, 0, chunkSize);
+    const size_t chunksStart = sizeof(uint32_t) + Crypto::SEQNUM_SIZE + Crypto::GCM_IV_SIZE +
+                               Crypto::EXTENDED_HEADER_SIZE;
+    const size_t stride = chunkSize + Crypto::GCM_TAG_SIZE;
+    auto discard = [](const uint8_t *, size_t) {};
+    auto streamOf = [](const std::vector<uint8_t> &bytes)
+    { return std::istringstream(std::string(bytes.begin(), bytes.end())); };
+
+    auto flipped = encrypted;
+    flipped[chunksStart + 2 * stride + 1] ^= 0x80;
+    auto in = streamOf(flipped);
+    EXPECT_THROW(crypto.decryptStream(in, ring, nullptr, 0, discard), TamperDetectedException);
+
+    // Dropping the final chunk and patching only the chunk count leaves every
+    // remaining tag valid except the new last one, which lacks the last-chunk flag.
+    auto dropped = encrypted;
+    dropped.resize(dropped.size() - stride);
+    byteorder::writeLE32(dropped.data(), byteorder::readLE32(dropped.data()) - static_cast<uint32_t>(stride));
+    byteorder::writeLE32(dropped.data() + chunksStart - sizeof(uint32_t), 3);
+    in = streamOf(dropped);
+    EXPECT_THROW(crypto.decryptStream(in, ring, nullptr, 0, discard), TamperDetectedException);
+
+    // A short file is an I/O error, not a tag failure.
+    auto cut = encrypted;
+    cut.resize(cut.size() - 1);
+    in = streamOf(cut);
+    EXPECT_THROW(crypto.decryptStream(in, ring, nullptr, 0, discard), std::runtime_error);
+}
+
+// chunkSize sizes the stream buffers before any tag is checked, so a forged one
+// must not turn into a huge allocation.
+TEST_F(CryptoTest, DecryptStreamBoundsForgedChunkSize)
+{
+    std::vector<uint8_t> data(300, 0x5A);
+    KeyRing ring(7, createRandomKey()); // a non-default key ID forces the extended format
+    std::vector<uint8_t> encrypted;
+    crypto.encrypt(data.data(), data.size(), ring, encrypted, 0, nullptr, 0);
+    ASSERT_NE(byteorder::readLE32(encrypted.data()) & Crypto::EXTENDED_BLOB_FLAG, 0u);
+    const size_t chunkSizeField = sizeof(uint32_t) + Crypto::SEQNUM_SIZE + Crypto::GCM_IV_SIZE + 2;
+    auto discard = [](const uint8_t *, size_t) {};
+    auto streamWithChunkSize = [&](uint32_t chunkSize)
+    {
+        auto forged = encrypted;
+        byteorder::writeLE32(forged.data() + chunkSizeField, chunkSize);
+        return std::istringstream(std::string(forged.begin(), forged.end()));
+    };
+
+    // Larger than any writer uses: rejected by the header checks.
+    auto in = streamWithChunkSize(0xFFFFFFFFu);
+    EXPECT_THROW(crypto.decryptStream(in, ring, nullptr, 0, discard), std::runtime_error);
+    // Plausible but forged: the tag check fails, with buffers sized by the plaintext.
+    in = streamWithChunkSize(0x40000000u);
+    EXPECT_THROW(crypto.decryptStream(in, ring, nullptr, 0, discard), TamperDetectedException);
+}
+
+TEST_F(CryptoTest, ChaCha20Poly1305RoundTrip)
+{
+    std::vector<uint8_t> data(5000);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<uint8_t>(i * 3);
+    const std::string target = "chacha";
+    const auto *name = reinterpret_cast<const uint8_t *>(target.data());
+    KeyRing ring(KeyRing::DEFAULT_KEY_ID, createRandomKey());
+    const size_t suiteOffset = sizeof(uint32_t) + Crypto::SEQNUM_SIZE + Crypto::GCM_IV_SIZE +
+                               Crypto::EXTENDED_HEADER_SIZE;
+
+    for (size_t chunkSize : {size_t(0), size_t(1024)})
+    {
+        std::vector<uint8_t> encrypted;
+        crypto.encrypt(data.data(), data.size(), ring, encrypted, 5, name, target.size(),
+                       chunkSize, nullptr, CipherSuite::ChaCha20Poly1305);
+        // Even the default key needs an extended header to name the suite.
+        ASSERT_TRUE(byteorder::readLE32(encrypted.data()) & Crypto::EXTENDED_BLOB_FLAG);
+        ASSERT_EQ(encrypted[suiteOffset - Crypto::EXTENDED_HEADER_SIZE + 1], Crypto::BLOB_FLAG_CIPHER_SUITE);
+        EXPECT_EQ(encrypted[suiteOffset], static_cast<uint8_t>(CipherSuite::ChaCha20Poly1305));
+        EXPECT_EQ(Crypto::blobSize(byteorder::readLE32(encrypted.data())), encrypted.size());
+
+        EXPECT_EQ(data, crypto.decrypt(encrypted, ring, name, target.size()));
+        std::istringstream in(std::string(encrypted.begin(), encrypted.end()));
+        std::vector<uint8_t> streamed;
+        crypto.decryptStream(in, ring, name, target.size(), [&](const uint8_t *d, size_t n)
+                             { streamed.insert(streamed.end(), d, d + n); });
+        EXPECT_EQ(data, streamed);
+
+        // The suite byte is authenticated: relabeling the blob as AES-GCM fails.
+        auto relabeled = encrypted;
+        relabeled[suiteOffset] = static_cast<uint8_t>(CipherSuite::Aes256Gcm);
+        EXPECT_THROW(crypto.decrypt(relabeled, ring, name, target.size()), TamperDetectedException);
+
+        auto flipped = encrypted;
+        flipped[suiteOffset + 1 + 10] ^= 0x04;
+        EXPECT_THROW(crypto.decrypt(flipped, ring, name, target.size()), TamperDetectedException);
+
+        auto unknown = encrypted;
+        unknown[suiteOffset] = 0x7F;
+        EXPECT_THROW(crypto.decrypt(unknown, ring, name, target.size()), std::runtime_error);
+    }
+}
+
+TEST_F(CryptoTest, SpanDecryptIntoReusedBuffer)
+{
+    std::vector<uint8_t> key = createRandomKey();
+    KeyRing ring(KeyRing::DEFAULT_KEY_ID, key);
+    const std::string target(300, 't'); // longer than any fixed AAD buffer would hold
+    const auto *name = reinterpret_cast<const uint8_t *>(target.data());
+
+    // Several blobs back to back, read in place as the exporter's segments are.
+    std::vector<std::vector<uint8_t>> plaintexts;
+    std::vector<uint8_t> segment;
+    std::vector<std::pair<size_t, size_t>> spans;
+    for (size_t i = 0; i < 6; ++i)
+    {
+        plaintexts.push_back(stringToBytes("batch " + std::to_string(i) + std::string(100 * (6 - i), 'x')));
+        std::vector<uint8_t> blob;
+        crypto.encrypt(plaintexts.back().data(), plaintexts.back().size(), ring, blob, i, name,
+                       target.size(), /*chunkSize=*/i % 2 ? 128 : 0, nullptr);
+        spans.emplace_back(segment.size(), blob.size());
+        segment.insert(segment.end(), blob.begin(), blob.end());
+    }
+
+    std::vector<uint8_t> out;
+    const uint8_t *firstBuffer = nullptr;
+    for (size_t i = 0; i < spans.size(); ++i)
+    {
+        crypto.decrypt(segment.data() + spans[i].first, spans[i].second, ring, name, target.size(), out);
+        EXPECT_EQ(out, plaintexts[i]);
+        // Plaintexts shrink, so the first allocation serves every later blob.
+        if (i == 0)
+            firstBuffer = out.data();
+        EXPECT_EQ(out.data(), firstBuffer);
+
+        std::vector<uint8_t> viaKey;
+        crypto.decrypt(segment.data() + spans[i].first, spans[i].second, key, name, target.size(), viaKey);
+        EXPECT_EQ(viaKey, plaintexts[i]);
+    }
+
+    crypto.decrypt(segment.data(), 0, ring, name, target.size(), out);
+    EXPECT_TRUE(out.empty());
+
+    segment[spans[2].first + spans[2].second - 1] ^= 0x01;
+    EXPECT_THROW(crypto.decrypt(segment.data() + spans[2].first, spans[2].second, ring, name,
+                                target.size(), out),
+                 TamperDetectedException);
+}
+
+TEST_F(CryptoTest, PiecewiseAadMatchesContiguousAad)
+{
+    // A blob sealed directly with OpenSSL over the contiguous buildAad bytes must
+    // open: the cipher paths feed the same AAD in pieces.
+    std::vector<uint8_t> key = createRandomKey();
+    const std::vector<uint8_t> data = stringToBytes("sealed elsewhere");
+    const std::string target = "interop";
+    const auto *name = reinterpret_cast<const uint8_t *>(target.data());
+    const uint64_t seqnum = 77;
+    const auto aad = Crypto::buildAad(seqnum, name, target.size());
+
+    const size_t prefixSize = sizeof(uint32_t) + Crypto::SEQNUM_SIZE + Crypto::GCM_IV_SIZE;
+    std::vector<uint8_t> blob(prefixSize + data.size() + Crypto::GCM_TAG_SIZE);
+    byteorder::writeLE32(blob.data(), static_cast<uint32_t>(data.size()));
+    byteorder::writeLE64(blob.data() + sizeof(uint32_t), seqnum);
+    uint8_t *iv = blob.data() + sizeof(uint32_t) + Crypto::SEQNUM_SIZE;
+    for (size_t i = 0; i < Crypto::GCM_IV_SIZE; ++i)
+        iv[i] = static_cast<uint8_t>(i);
+
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    int len = 0;
+    ASSERT_EQ(EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, key.data(), iv), 1);
+    ASSERT_EQ(EVP_EncryptUpdate(ctx, nullptr, &len, aad.data(), static_cast<int>(aad.size())), 1);
+    ASSERT_EQ(EVP_EncryptUpdate(ctx, blob.data() + prefixSize, &len, data.data(), static_cast<int>(data.size())), 1);
+    ASSERT_EQ(EVP_EncryptFinal_ex(ctx, blob.data() + prefixSize + len, &len), 1);
+    ASSERT_EQ(EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, Crypto::GCM_TAG_SIZE,
+                                  blob.data() + prefixSize + data.size()), 1);
+    EVP_CIPHER_CTX_free(ctx);
+
+    EXPECT_EQ(data, crypto.decrypt(blob, key, name, target.size()));
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include "InternedString.hpp"
+#include "EntryStoragePool.hpp"
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+TEST(InternedStringTest, EqualStringsShareOneCopy)
+{
+    InternedString a("controller-a");
+    InternedString b(std::string("controller-") + "a");
+    InternedString c("controller-b");
+
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(&a.str(), &b.str());
+    EXPECT_NE(a, c);
+    EXPECT_EQ(a.str(), "controller-a");
+    EXPECT_EQ(InternedString(), InternedString(""));
+    EXPECT_TRUE(InternedString().empty());
+
+    const size_t before = InternedString::internedCount();
+    for (int i = 0; i < 100; ++i)
+        InternedString("controller-a");
+    EXPECT_EQ(InternedString::internedCount(), before);
+
+    std::unordered_set<InternedString> set{a, b, c};
+    EXPECT_EQ(set.size(), 2u);
+}
+
+TEST(InternedStringTest, ConcurrentInterningAgrees)
+{
+    constexpr int threadCount = 8;
+    constexpr int names = 200;
+    std::vector<std::vector<const std::string *>> seen(threadCount);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t)
+    {
+        threads.emplace_back([&, t]
+                             {
+            for (int i = 0; i < names; ++i)
+                seen[t].push_back(&InternedString("concurrent-" + std::to_string(i)).str()); });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    for (int t = 1; t < threadCount; ++t)
+        EXPECT_EQ(seen[t], seen[0]);
+}
+
+TEST(EntryStoragePoolTest, RecyclesBuffersAcrossThreads)
+{
+    std::vector<const uint8_t *> given;
+    std::thread writer([&]
+                       {
+        for (size_t i = 0; i < 4 * EntryStoragePool::MAGAZINE_SIZE; ++i)
+        {
+            std::vector<uint8_t> buffer(1024);
+            given.push_back(buffer.data());
+            EntryStoragePool::give(std::move(buffer));
+        } });
+    writer.join();
+
+    // The writer's magazines went to the depot when it exited.
+    std::unordered_set<const uint8_t *> givenSet(given.begin(), given.end());
+    size_t reused = 0;
+    for (size_t i = 0; i < given.size(); ++i)
+    {
+        std::vector<uint8_t> buffer = EntryStoragePool::takeBytes();
+        EXPECT_TRUE(buffer.empty());
+        if (buffer.capacity() >= 1024 && givenSet.count(buffer.data()))
+            ++reused;
+    }
+    EXPECT_GE(reused, 2 * EntryStoragePool::MAGAZINE_SIZE);
+
+    // Oversized and inline-only buffers are not kept.
+    EntryStoragePool::give(std::vector<uint8_t>(EntryStoragePool::MAX_RETAINED_CAPACITY + 1));
+    EntryStoragePool::give(std::string("short"));
+    EXPECT_EQ(EntryStoragePool::takeBytes().capacity(), 0u);
+    EXPECT_EQ(EntryStoragePool::takeString().capacity(), std::string().capacity());
+}
@@ -0,0 +1,231 @@
+#include <gtest/gtest.h>
+#include "HandoffRing.hpp"
+#include "IoStage.hpp"
+#include "SegmentedStorage.hpp"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <numeric>
+#include <set>
+#include <thread>
+#include <vector>
+
+TEST(HandoffRingTest, CapacityRoundsUpToPowerOfTwo)
+{
+    HandoffRing<int> ring(5);
+    EXPECT_EQ(ring.capacity(), 8u);
+    EXPECT_THROW(HandoffRing<int>(0), std::invalid_argument);
+}
+
+TEST(HandoffRingTest, FifoAndFullEmpty)
+{
+    HandoffRing<int> ring(4);
+    int v = 0;
+    EXPECT_FALSE(ring.tryPop(v));
+    for (int i = 0; i < 4; ++i)
+    {
+        int item = i;
+        EXPECT_TRUE(ring.tryPush(std::move(item)));
+    }
+    int overflow = 99;
+    EXPECT_FALSE(ring.tryPush(std::move(overflow)));
+    EXPECT_EQ(overflow, 99) << "failed push must leave the item intact";
+
+    for (int i = 0; i < 4; ++i)
+    {
+        ASSERT_TRUE(ring.tryPop(v));
+        EXPECT_EQ(v, i);
+    }
+    EXPECT_FALSE(ring.tryPop(v));
+}
+
+TEST(HandoffRingTest, ConcurrentProducersConsumersLoseNothing)
+{
+    HandoffRing<int> ring(64);
+    const int producers = 4;
+    const int perProducer = 20000;
+    std::atomic<int> consumed{0};
+    std::vector<std::vector<int>> seen(2);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([&, p]()
+                             {
+            for (int i = 0; i < perProducer; ++i)
+            {
+                int item = p * perProducer + i;
+                while (!ring.tryPush(std::move(item)))
+                    std::this_thread::yield();
+            } });
+    }
+    for (int c = 0; c < 2; ++c)
+    {
+        threads.emplace_back([&, c]()
+                             {
+            int v;
+            while (consumed.load() < producers * perProducer)
+            {
+                if (ring.tryPop(v))
+                {
+                    seen[c].push_back(v);
+                    consumed.fetch_add(1);
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            } });
+    }
+    for (auto &t : threads)
+        t.join();
+
+    std::set<int> all(seen[0].begin(), seen[0].end());
+    all.insert(seen[1].begin(), seen[1].end());
+    EXPECT_EQ(all.size(), static_cast<size_t>(producers * perProducer));
+    EXPECT_EQ(seen[0].size() + seen[1].size(), static_cast<size_t>(producers * perProducer));
+}
+
+class IoStageTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        testDir = "./test_io_stage_" +
+                  std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+        std::filesystem::create_directories(testDir);
+        storage = std::make_shared<SegmentedStorage>(testDir, "io_default", 1024 * 1024);
+    }
+
+    void TearDown() override
+    {
+        storage.reset();
+        std::filesystem::remove_all(testDir);
+    }
+
+    size_t bytesOnDisk()
+    {
+        size_t total = 0;
+        for (const auto &entry : std::filesystem::directory_iterator(testDir))
+            total += entry.file_size();
+        return total;
+    }
+
+    std::string testDir;
+    std::shared_ptr<SegmentedStorage> storage;
+};
+
+// stop() must drain every submitted request, even with a ring smaller than the
+// number of submissions (submit blocks until the I/O threads make room).
+TEST_F(IoStageTest, StopDrainsAllSubmissions)
+{
+    IoStage stage(storage, /*numThreads*/ 2, /*ringCapacity*/ 4);
+    stage.start();
+
+    const size_t requests = 200;
+    const size_t blobSize = 100;
+    for (size_t i = 0; i < requests; ++i)
+    {
+        IoRequest req;
+        req.targetFilename = (i % 2) ? std::optional<std::string>("io_target") : std::nullopt;
+        req.blobs.emplace_back(blobSize, static_cast<uint8_t>(i));
+        req.entryCount = 1;
+        stage.submit(std::move(req));
+    }
+    stage.stop();
+    storage->flush();
+
+    EXPECT_EQ(bytesOnDisk(), requests * blobSize);
+    EXPECT_EQ(stage.droppedEntries(), 0u);
+}
+
+TEST_F(IoStageTest, WriteFailuresAreCountedAndSpentBuffersRecycled)
+{
+    IoStage stage(storage, 1, 8);
+    stage.start();
+
+    IoRequest bad;
+    bad.targetFilename = "no_such_dir/nested/file";
+    bad.blobs.emplace_back(16, 0xAB);
+    bad.entryCount = 3;
+    stage.submit(std::move(bad));
+
+    IoRequest good;
+    good.blobs.emplace_back(16, 0xCD);
+    good.blobs.front().reserve(4096);
+    good.entryCount = 1;
+    stage.submit(std::move(good));
+
+    stage.stop();
+    EXPECT_EQ(stage.droppedEntries(), 3u);
+
+    std::vector<uint8_t> spent;
+    size_t recycled = 0;
+    while (stage.takeSpentBuffer(spent))
+    {
+        EXPECT_TRUE(spent.empty());
+        ++recycled;
+    }
+    EXPECT_EQ(recycled, 2u);
+}
+
+// A write that stops part-way fails only the tickets and entries of the blobs
+// it did not get to.
+TEST(IoRequestTest, SettleFailsOnlyUnwrittenBlobs)
+{
+    IoRequest req;
+    std::vector<std::shared_ptr<AppendTicket::State>> tickets;
+    for (size_t entries : {2u, 0u, 3u}) // the middle blob is a checkpoint
+    {
+        req.blobs.emplace_back(8, 0);
+        req.shares.push_back({entries, entries});
+        req.entryCount += entries;
+        for (size_t i = 0; i < entries; ++i)
+        {
+            tickets.push_back(std::make_shared<AppendTicket::State>());
+            req.completions.push_back(tickets.back());
+        }
+    }
+
+    EXPECT_EQ(req.settle(2), 3u);
+    EXPECT_TRUE(req.completions.empty());
+    for (size_t i = 0; i < tickets.size(); ++i)
+        EXPECT_EQ(tickets[i]->status(), i < 2 ? AppendTicket::Status::Persisted : AppendTicket::Status::Failed)
+            << "ticket " << i;
+
+    // Without shares the request is all or nothing.
+    IoRequest whole;
+    whole.blobs.emplace_back(8, 0);
+    whole.blobs.emplace_back(8, 0);
+    whole.entryCount = 4;
+    auto ticket = std::make_shared<AppendTicket::State>();
+    whole.completions.push_back(ticket);
+    EXPECT_EQ(whole.settle(1), 4u);
+    EXPECT_EQ(ticket->status(), AppendTicket::Status::Failed);
+}
+
+// A multi-blob request is written as one contiguous run, and every blob buffer
+// comes back for reuse.
+TEST_F(IoStageTest, MultiBlobRequestWrittenTogether)
+{
+    IoStage stage(storage, 1, 8);
+    stage.start();
+
+    IoRequest req;
+    req.targetFilename = "multi_blob";
+    req.blobs.emplace_back(10, 'a');
+    req.blobs.emplace_back(20, 'b');
+    req.blobs.emplace_back(30, 'c');
+    req.entryCount = 3;
+    stage.submit(std::move(req));
+    stage.stop();
+    storage->flush();
+
+    EXPECT_EQ(bytesOnDisk(), 60u);
+    EXPECT_EQ(stage.droppedEntries(), 0u);
+    std::vector<uint8_t> spent;
+    size_t recycled = 0;
+    while (stage.takeSpentBuffer(spent))
+        ++recycled;
+    EXPECT_EQ(recycled, 3u);
+}
@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+#include "KeyRing.hpp"
+#include "Crypto.hpp"
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST(KeyRingTest, AddAndActivateKeys)
+{
+    KeyRing ring;
+    EXPECT_FALSE(ring.hasKey(1));
+    EXPECT_THROW(ring.setActiveKey(1), std::invalid_argument);
+
+    ring.addKey(1, std::vector<uint8_t>(Crypto::KEY_SIZE, 0x01));
+    ring.addKey(2, std::vector<uint8_t>(Crypto::KEY_SIZE, 0x02));
+    EXPECT_EQ(ring.activeKeyId(), KeyRing::DEFAULT_KEY_ID);
+    ring.setActiveKey(2);
+    EXPECT_EQ(ring.activeKeyId(), 2u);
+
+    // Re-adding identical bytes is a no-op; different bytes under a used ID are not.
+    EXPECT_NO_THROW(ring.addKey(1, std::vector<uint8_t>(Crypto::KEY_SIZE, 0x01)));
+    EXPECT_THROW(ring.addKey(1, std::vector<uint8_t>(Crypto::KEY_SIZE, 0x03)), std::invalid_argument);
+    EXPECT_THROW(ring.addKey(3, std::vector<uint8_t>(16, 0x03)), std::invalid_argument);
+}
+
+TEST(KeyRingTest, ContextsCachedPerThread)
+{
+    KeyRing ring(5, std::vector<uint8_t>(Crypto::KEY_SIZE, 0x05));
+
+    EVP_CIPHER_CTX *enc = ring.encryptContext(5);
+    EXPECT_EQ(enc, ring.encryptContext(5));
+    EXPECT_NE(enc, ring.decryptContext(5));
+    EXPECT_THROW(ring.encryptContext(6), std::runtime_error);
+
+    EVP_CIPHER_CTX *other = nullptr;
+    std::thread t([&]()
+                  { other = ring.encryptContext(5); });
+    t.join();
+    EXPECT_NE(enc, other);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
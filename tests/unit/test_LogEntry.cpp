@@ -1,10 +1,13 @@
 #include <gtest/gtest.h>
+#include "Compression.hpp"
 #include "LogEntry.hpp"
+#include "LogEntryView.hpp"
 #include <vector>
 #include <iostream>
 #include <chrono>
 #include <cstring>
 #include <limits>
+#include <algorithm>
 
 // Test default constructor
 TEST(LogEntryTest1, DefaultConstructor_InitializesCorrectly)
@@ -236,4 +239,337 @@ TEST(LogEntryRegression, DeserializeRejectsOversizedPayload)
 
     LogEntry entry;
     EXPECT_FALSE(entry.deserialize(std::move(buf)));
-}
\ No newline at end of file
+}
+
+// BatchDecoder must reassemble entries split at any byte boundary.
+TEST(LogEntryBatchDecoder, ByteAtATimeMatchesDeserializeBatch)
+{
+    std::vector<LogEntry> entries;
+    for (int i = 0; i < 5; ++i)
+    {
+        entries.emplace_back(LogEntry::ActionType::UPDATE, "loc" + std::to_string(i), "ctrl", "proc",
+                             "subj" + std::to_string(i), std::vector<uint8_t>(i * 10, 0xAB));
+    }
+    std::vector<uint8_t> batch = LogEntry::serializeBatch(std::vector<LogEntry>(entries));
+
+    std::vector<LogEntry> decoded;
+    LogEntry::BatchDecoder decoder([&](LogEntry &&e)
+                                   { decoded.push_back(std::move(e)); });
+    for (uint8_t byte : batch)
+        decoder.feed(&byte, 1);
+    decoder.finish();
+
+    ASSERT_EQ(decoded.size(), entries.size());
+    for (size_t i = 0; i < entries.size(); ++i)
+        EXPECT_EQ(decoded[i].serialize(), entries[i].serialize());
+}
+
+TEST(LogEntryBatchDecoder, RejectsTruncatedAndTrailingData)
+{
+    std::vector<uint8_t> batch = LogEntry::serializeBatch(
+        std::vector<LogEntry>{LogEntry(LogEntry::ActionType::READ, "loc", "ctrl", "proc", "subj")});
+    auto ignore = [](LogEntry &&) {};
+
+    LogEntry::BatchDecoder truncated(ignore);
+    truncated.feed(batch.data(), batch.size() - 1);
+    EXPECT_THROW(truncated.finish(), std::runtime_error);
+
+    std::vector<uint8_t> trailing = batch;
+    trailing.push_back(0);
+    LogEntry::BatchDecoder extra(ignore);
+    EXPECT_THROW(extra.feed(trailing.data(), trailing.size()), std::runtime_error);
+
+    // numEntries=1, entrySize=UINT32_MAX.
+    std::vector<uint8_t> oversized(2 * sizeof(uint32_t), 0xFF);
+    oversized[0] = 1;
+    oversized[1] = oversized[2] = oversized[3] = 0;
+    LogEntry::BatchDecoder big(ignore);
+    EXPECT_THROW(big.feed(oversized.data(), oversized.size()), std::runtime_error);
+}
+
+// make() builds the same entry as the constructor; recycled buffers come back empty.
+TEST(LogEntryPooled, MakeMatchesConstructorAndReusesBuffers)
+{
+    const InternedString controller("controller123");
+    const InternedString processor("processor789");
+    const std::string location = "database/users/a/rather/long/location";
+    const std::vector<uint8_t> payload(256, 0xAB);
+
+    std::vector<LogEntry> spent;
+    spent.push_back(LogEntry::make(LogEntry::ActionType::UPDATE, location, controller, processor, "subject456",
+                                   payload.data(), payload.size()));
+    LogEntry reference(LogEntry::ActionType::UPDATE, location, "controller123", "processor789", "subject456", payload);
+    EXPECT_EQ(LogEntryView(spent[0]).getDataControllerId().data(), controller.str().data());
+    EXPECT_EQ(spent[0].getDataProcessorId(), reference.getDataProcessorId());
+    EXPECT_EQ(spent[0].getDataLocation(), location);
+    EXPECT_EQ(spent[0].getPayload(), payload);
+
+    const uint8_t *payloadBuffer = spent[0].getPayload().data();
+    LogEntry::recycle(spent);
+    EXPECT_TRUE(spent.empty());
+
+    LogEntry reused = LogEntry::make(LogEntry::ActionType::READ, "short", controller, processor, "", payload.data(), 16);
+    EXPECT_EQ(reused.getPayload().data(), payloadBuffer);
+    EXPECT_EQ(reused.getPayload(), std::vector<uint8_t>(16, 0xAB));
+    EXPECT_EQ(reused.getDataLocation(), "short");
+
+    // Only explicit InternedStrings are interned: IDs from the string constructor
+    // or from decoding are owned, so arbitrary IDs cannot grow the table.
+    const size_t internedBefore = InternedString::internedCount();
+    for (BatchEncoding encoding : {BatchEncoding::Rows, BatchEncoding::Columnar, BatchEncoding::Compact})
+    {
+        const std::string unique = "controller-seen-once-" + std::to_string(static_cast<int>(encoding));
+        LogEntry owned(LogEntry::ActionType::READ, "loc", unique, unique + "-processor", "subj");
+        auto decoded = LogEntry::deserializeBatch(
+            LogEntry::serializeBatch(std::vector<LogEntry>{owned, reference}, encoding));
+        ASSERT_EQ(decoded.size(), 2u);
+        EXPECT_EQ(decoded[0].getDataControllerId(), unique);
+        EXPECT_EQ(decoded[1].getDataControllerId(), controller.str());
+        EXPECT_EQ(decoded[1].getDataProcessorId(), processor.str());
+    }
+    EXPECT_EQ(InternedString::internedCount(), internedBefore);
+}
+
+// Columnar batches decode to the same entries, in order, through both readers.
+TEST(LogEntryColumnar, RoundTripMatchesRows)
+{
+    std::vector<LogEntry> entries;
+    for (int i = 0; i < 300; ++i)
+    {
+        entries.emplace_back(static_cast<LogEntry::ActionType>(i % 4),
+                             "/data/customers/" + std::to_string(i / 10) + "/record_" + std::to_string(i),
+                             "controller_" + std::to_string(i % 3), "processor_" + std::to_string(i % 700),
+                             i % 5 ? "subject_" + std::to_string(i % 40) : "",
+                             std::vector<uint8_t>(i % 7, static_cast<uint8_t>(i)));
+    }
+    entries.emplace_back(); // empty strings, epoch timestamp
+    const std::vector<uint8_t> rows = LogEntry::serializeBatch(std::vector<LogEntry>(entries));
+    const std::vector<uint8_t> columnar =
+        LogEntry::serializeBatch(std::vector<LogEntry>(entries), BatchEncoding::Columnar);
+    EXPECT_LT(columnar.size(), rows.size());
+
+    auto recovered = LogEntry::deserializeBatch(std::vector<uint8_t>(columnar));
+    ASSERT_EQ(recovered.size(), entries.size());
+    for (size_t i = 0; i < entries.size(); ++i)
+        EXPECT_EQ(recovered[i].serialize(), entries[i].serialize()) << "entry " << i;
+
+    std::vector<LogEntry> streamed;
+    LogEntry::BatchDecoder decoder([&](LogEntry &&e)
+                                   { streamed.push_back(std::move(e)); });
+    for (uint8_t byte : columnar)
+        decoder.feed(&byte, 1);
+    decoder.finish();
+    ASSERT_EQ(streamed.size(), entries.size());
+    EXPECT_EQ(LogEntry::serializeBatch(std::move(streamed)), rows);
+
+    EXPECT_TRUE(LogEntry::deserializeBatch(LogEntry::serializeBatch({}, BatchEncoding::Columnar)).empty());
+}
+
+TEST(LogEntryColumnar, RejectsMalformedBatches)
+{
+    const std::vector<uint8_t> batch = LogEntry::serializeBatch(
+        std::vector<LogEntry>{LogEntry(LogEntry::ActionType::READ, "loc", "ctrl", "proc", "subj", {1, 2, 3})},
+        BatchEncoding::Columnar);
+    auto ignore = [](LogEntry &&) {};
+
+    // Every truncation fails; deserializeBatch logs and returns nothing.
+    for (size_t cut = 0; cut < batch.size(); ++cut)
+    {
+        LogEntry::BatchDecoder truncated(ignore);
+        truncated.feed(batch.data(), cut);
+        EXPECT_THROW(truncated.finish(), std::runtime_error) << "cut at " << cut;
+        EXPECT_TRUE(LogEntry::deserializeBatch(std::vector<uint8_t>(batch.begin(), batch.begin() + cut)).empty());
+    }
+
+    std::vector<uint8_t> trailing = batch;
+    trailing.push_back(0);
+    LogEntry::BatchDecoder extra(ignore);
+    extra.feed(trailing.data(), trailing.size());
+    EXPECT_THROW(extra.finish(), std::runtime_error);
+
+    std::vector<uint8_t> unknown = batch;
+    unknown[sizeof(uint32_t)] = 0x7f;
+    LogEntry::BatchDecoder unknownEncoding(ignore);
+    unknownEncoding.feed(unknown.data(), unknown.size());
+    EXPECT_THROW(unknownEncoding.finish(), std::runtime_error);
+
+    // A count far beyond what the bytes could hold is refused before allocating.
+    std::vector<uint8_t> inflated = batch;
+    inflated[5] = inflated[6] = inflated[7] = inflated[8] = 0xF0;
+    LogEntry::BatchDecoder huge(ignore);
+    huge.feed(inflated.data(), inflated.size());
+    EXPECT_THROW(huge.finish(), std::runtime_error);
+
+    // A batch that has to be buffered whole stops growing at the zip-bomb cap.
+    LogEntry::BatchDecoder bomb(ignore);
+    bomb.feed(batch.data(), sizeof(uint32_t) + 1);
+    const std::vector<uint8_t> chunk(1 << 20, 0);
+    auto feedPastCap = [&]
+    {
+        for (size_t fed = 0; fed <= Compression::DEFAULT_MAX_DECOMPRESSED_SIZE; fed += chunk.size())
+            bomb.feed(chunk.data(), chunk.size());
+    };
+    EXPECT_THROW(feedPastCap(), std::runtime_error);
+}
+
+// Views read the same fields as a decoded entry, pointing into the batch buffer.
+TEST(LogEntryViewTest, BatchViewMatchesDeserializeBatch)
+{
+    std::vector<LogEntry> entries;
+    for (int i = 0; i < 20; ++i)
+    {
+        entries.emplace_back(static_cast<LogEntry::ActionType>(i % 4), "/data/record_" + std::to_string(i),
+                             "controller_" + std::to_string(i % 3), "processor", "subject_" + std::to_string(i % 5),
+                             std::vector<uint8_t>(i * 3, static_cast<uint8_t>(i)));
+    }
+
+    for (BatchEncoding encoding : {BatchEncoding::Rows, BatchEncoding::Columnar, BatchEncoding::Compact})
+    {
+        const std::vector<uint8_t> batch = LogEntry::serializeBatch(std::vector<LogEntry>(entries), encoding);
+        LogEntryBatchView view(batch.data(), batch.size());
+        ASSERT_EQ(view.size(), entries.size());
+        size_t i = 0;
+        for (const LogEntryView &entry : view)
+        {
+            ASSERT_LT(i, entries.size());
+            EXPECT_EQ(entry.getActionType(), entries[i].getActionType());
+            EXPECT_EQ(entry.getDataLocation(), entries[i].getDataLocation());
+            EXPECT_EQ(entry.getDataControllerId(), entries[i].getDataControllerId());
+            EXPECT_EQ(entry.getDataProcessorId(), entries[i].getDataProcessorId());
+            EXPECT_EQ(entry.getDataSubjectId(), entries[i].getDataSubjectId());
+            EXPECT_EQ(std::vector<uint8_t>(entry.getPayloadData(), entry.getPayloadData() + entry.getPayloadSize()),
+                      entries[i].getPayload());
+            EXPECT_EQ(entry.toLogEntry().serialize(), entries[i].serialize());
+            if (encoding != BatchEncoding::Columnar)
+            {
+                const auto *location = reinterpret_cast<const uint8_t *>(entry.getDataLocation().data());
+                EXPECT_TRUE(location >= batch.data() && location < batch.data() + batch.size());
+            }
+            ++i;
+        }
+        EXPECT_EQ(i, entries.size());
+    }
+
+    // A truncated row batch fails when the iterator reaches the damage.
+    const std::vector<uint8_t> rows = LogEntry::serializeBatch(std::vector<LogEntry>(entries));
+    LogEntryBatchView truncated(rows.data(), rows.size() - 1);
+    size_t seen = 0;
+    EXPECT_THROW(
+        {
+            for (const LogEntryView &entry : truncated)
+            {
+                (void)entry;
+                ++seen;
+            }
+        },
+        std::runtime_error);
+    EXPECT_EQ(seen, entries.size() - 1);
+    EXPECT_THROW(LogEntryBatchView(rows.data(), 3), std::runtime_error);
+}
+
+// forViews hands out the same entries whether or not they straddle feed() calls.
+TEST(LogEntryViewTest, DecoderViewsMatchEntries)
+{
+    std::vector<LogEntry> entries;
+    for (int i = 0; i < 8; ++i)
+    {
+        entries.emplace_back(LogEntry::ActionType::READ, "loc" + std::to_string(i), "ctrl", "proc",
+                             "subj", std::vector<uint8_t>(i * 7, 0xCD));
+    }
+    const std::vector<uint8_t> batch = LogEntry::serializeBatch(std::vector<LogEntry>(entries));
+
+    for (size_t piece : {size_t{1}, size_t{13}, batch.size()})
+    {
+        std::vector<std::vector<uint8_t>> decoded;
+        auto decoder = LogEntry::BatchDecoder::forViews([&](const LogEntryView &view)
+                                                        { decoded.push_back(view.toLogEntry().serialize()); });
+        for (size_t offset = 0; offset < batch.size(); offset += piece)
+            decoder.feed(batch.data() + offset, std::min(piece, batch.size() - offset));
+        decoder.finish();
+        ASSERT_EQ(decoded.size(), entries.size()) << "piece " << piece;
+        for (size_t i = 0; i < entries.size(); ++i)
+            EXPECT_EQ(decoded[i], entries[i].serialize()) << "piece " << piece << ", entry " << i;
+    }
+}
+
+// Compact (row format v2) decodes to the same entries through every reader and
+// is smaller than Rows for typical entries.
+TEST(LogEntryCompact, RoundTripMatchesRows)
+{
+    std::vector<LogEntry> entries;
+    for (int i = 0; i < 200; ++i)
+    {
+        entries.emplace_back(static_cast<LogEntry::ActionType>(i % 4), "/data/record_" + std::to_string(i),
+                             "controller_" + std::to_string(i % 3), "processor_" + std::to_string(i % 5),
+                             i % 4 ? "subject_" + std::to_string(i) : "",
+                             std::vector<uint8_t>(i % 90, static_cast<uint8_t>(i)));
+    }
+    entries.emplace_back(); // epoch timestamp: a large negative delta from the base
+    const std::vector<uint8_t> rows = LogEntry::serializeBatch(std::vector<LogEntry>(entries));
+    const std::vector<uint8_t> compact =
+        LogEntry::serializeBatch(std::vector<LogEntry>(entries), BatchEncoding::Compact);
+    // Rows spends 36 fixed bytes per entry on lengths, action and timestamp.
+    EXPECT_LT(compact.size() + entries.size() * 24, rows.size());
+
+    auto recovered = LogEntry::deserializeBatch(std::vector<uint8_t>(compact));
+    ASSERT_EQ(recovered.size(), entries.size());
+    EXPECT_EQ(LogEntry::serializeBatch(std::move(recovered)), rows);
+
+    // Streamed: every entry is out as soon as its last byte is fed.
+    for (bool views : {false, true})
+    {
+        for (size_t piece : {size_t{1}, size_t{97}})
+        {
+            std::vector<LogEntry> streamed;
+            auto decoder = views ? LogEntry::BatchDecoder::forViews([&](const LogEntryView &v)
+                                                                    { streamed.push_back(v.toLogEntry()); })
+                                 : LogEntry::BatchDecoder([&](LogEntry &&e)
+                                                          { streamed.push_back(std::move(e)); });
+            for (size_t offset = 0; offset < compact.size(); offset += piece)
+                decoder.feed(compact.data() + offset, std::min(piece, compact.size() - offset));
+            EXPECT_EQ(streamed.size(), entries.size()) << "views " << views << ", piece " << piece;
+            decoder.finish();
+            EXPECT_EQ(LogEntry::serializeBatch(std::move(streamed)), rows) << "views " << views << ", piece " << piece;
+        }
+    }
+
+    EXPECT_TRUE(LogEntry::deserializeBatch(LogEntry::serializeBatch({}, BatchEncoding::Compact)).empty());
+}
+
+TEST(LogEntryCompact, RejectsMalformedBatches)
+{
+    const std::vector<uint8_t> batch = LogEntry::serializeBatch(
+        std::vector<LogEntry>{LogEntry(LogEntry::ActionType::READ, "loc", "ctrl", "proc", "subj", {1, 2, 3}),
+                              LogEntry(LogEntry::ActionType::DELETE, "loc2", "ctrl", "proc", "subj", {})},
+        BatchEncoding::Compact);
+    auto ignore = [](LogEntry &&) {};
+
+    for (size_t cut = 0; cut < batch.size(); ++cut)
+    {
+        LogEntry::BatchDecoder truncated(ignore);
+        truncated.feed(batch.data(), cut);
+        EXPECT_THROW(truncated.finish(), std::runtime_error) << "cut at " << cut;
+        EXPECT_TRUE(LogEntry::deserializeBatch(std::vector<uint8_t>(batch.begin(), batch.begin() + cut)).empty());
+    }
+
+    std::vector<uint8_t> trailing = batch;
+    trailing.push_back(0);
+    LogEntry::BatchDecoder extra(ignore);
+    EXPECT_THROW(extra.feed(trailing.data(), trailing.size()), std::runtime_error);
+    EXPECT_THROW(
+        {
+            LogEntryBatchView view(trailing.data(), trailing.size());
+            for (const LogEntryView &entry : view)
+                (void)entry;
+        },
+        std::runtime_error);
+
+    // A count far beyond what the bytes could hold is refused up front.
+    std::vector<uint8_t> inflated = batch;
+    inflated[5] = 0x7f;
+    EXPECT_THROW(LogEntryBatchView(inflated.data(), inflated.size()), std::runtime_error);
+    LogEntry::BatchDecoder shortBatch(ignore);
+    shortBatch.feed(inflated.data(), inflated.size());
+    EXPECT_THROW(shortBatch.finish(), std::runtime_error);
+    EXPECT_TRUE(LogEntry::deserializeBatch(std::move(inflated)).empty());
+}
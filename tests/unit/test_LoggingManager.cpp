@@ -66,9 +66,16 @@ TEST_F(LoggingManagerTest, InvalidConfigRejected)
     bad([](LoggingConfig &c) { c.queueCapacity = 0; });
     bad([](LoggingConfig &c) { c.numWriterThreads = 0; });
     bad([](LoggingConfig &c) { c.batchSize = 0; });
+    bad([](LoggingConfig &c) { c.maxBatchLinger = std::chrono::milliseconds(-1); });
     bad([](LoggingConfig &c) { c.maxSegmentSize = 0; });
     bad([](LoggingConfig &c) { c.maxOpenFiles = 0; });
     bad([](LoggingConfig &c) { c.maxAttempts = 0; });
+    bad([](LoggingConfig &c) { c.usePipelinedWriter = true; c.numIoThreads = 0; });
+    bad([](LoggingConfig &c) { c.usePipelinedWriter = true; c.ioRingCapacity = 0; });
+    bad([](LoggingConfig &c) { c.writerPlacement = WriterPlacement::CpuList; c.writerCpuList = ""; });
+    bad([](LoggingConfig &c) { c.writerPlacement = WriterPlacement::CpuList; c.writerCpuList = "0-x"; });
+    bad([](LoggingConfig &c) { c.encryptionChunkSize = size_t(1) << 40; });
+    bad([](LoggingConfig &c) { c.durability.mode = DurabilityMode::Periodic; c.durability.syncInterval = std::chrono::milliseconds(0); });
 }
 
 TEST_F(LoggingManagerTest, AppendAfterStopRejected)
@@ -143,6 +150,77 @@ TEST_F(LoggingManagerTest, ExportEmptyDirectoryProducesEmptyFile)
     EXPECT_EQ(std::filesystem::file_size(outputPath), 0u);
 }
 
+// appendAsync tickets resolve once the writer has written the entry's blob.
+TEST_F(LoggingManagerTest, AppendAsyncTicketResolvesAfterWrite)
+{
+    LoggingConfig cfg = makeConfig();
+    cfg.durability.mode = DurabilityMode::GroupCommit;
+    LoggingManager mgr(cfg);
+    ASSERT_TRUE(mgr.start());
+    auto token = mgr.createProducerToken();
+
+    std::vector<AppendTicket> tickets;
+    for (int i = 0; i < 50; ++i)
+        tickets.push_back(mgr.appendAsync(makeEntry(), token, "async_target"));
+    tickets.push_back(mgr.appendBatchAsync(std::vector<LogEntry>(20, makeEntry()), token));
+
+    for (auto &ticket : tickets)
+    {
+        ASSERT_TRUE(ticket.valid());
+        EXPECT_EQ(ticket.waitFor(std::chrono::milliseconds(5000)), AppendTicket::Status::Persisted);
+    }
+    EXPECT_TRUE(mgr.stop());
+}
+
+TEST_F(LoggingManagerTest, AppendAsyncPipelinedAndLingering)
+{
+    LoggingConfig cfg = makeConfig();
+    cfg.usePipelinedWriter = true;
+    cfg.maxBatchLinger = std::chrono::milliseconds(20);
+    LoggingManager mgr(cfg);
+    ASSERT_TRUE(mgr.start());
+    auto token = mgr.createProducerToken();
+
+    AppendTicket ticket = mgr.appendAsync(makeEntry(), token);
+    EXPECT_EQ(ticket.waitFor(std::chrono::milliseconds(5000)), AppendTicket::Status::Persisted);
+    EXPECT_TRUE(mgr.stop());
+}
+
+TEST_F(LoggingManagerTest, AppendAsyncRejectedResolvesFailed)
+{
+    LoggingManager mgr(makeConfig());
+    ASSERT_TRUE(mgr.start());
+    auto token = mgr.createProducerToken();
+    ASSERT_TRUE(mgr.stop());
+
+    EXPECT_EQ(mgr.appendAsync(makeEntry(), token).wait(), AppendTicket::Status::Failed);
+    EXPECT_EQ(mgr.appendBatchAsync({makeEntry(), makeEntry()}, token).wait(), AppendTicket::Status::Failed);
+}
+
+// A batch ticket resolves only after its last entry, and any failure wins.
+TEST(AppendTicketTest, BatchStateResolvesOnLastEntry)
+{
+    auto state = std::make_shared<AppendTicket::State>(3);
+    AppendTicket ticket(state);
+
+    state->complete(true);
+    state->complete(false);
+    EXPECT_FALSE(ticket.isDone());
+    EXPECT_EQ(ticket.waitFor(std::chrono::milliseconds(1)), AppendTicket::Status::Pending);
+
+    std::thread completer([state]()
+                          {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        state->complete(true); });
+    EXPECT_EQ(ticket.wait(), AppendTicket::Status::Failed);
+    completer.join();
+
+    // Abandon after resolution is a no-op.
+    state->abandon();
+    EXPECT_EQ(ticket.status(), AppendTicket::Status::Failed);
+    EXPECT_FALSE(AppendTicket().valid());
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
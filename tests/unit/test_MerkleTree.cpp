@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include "MerkleTree.hpp"
+#include "SeqnumAllocator.hpp"
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+std::vector<merkle::Hash> makeLeaves(size_t count)
+{
+    std::vector<merkle::Hash> leaves;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const std::string blob = "blob_" + std::to_string(i);
+        leaves.push_back(merkle::leafHash(reinterpret_cast<const uint8_t *>(blob.data()), blob.size()));
+    }
+    return leaves;
+}
+
+// MTH from RFC 6962, section 2.1, written independently of the library's helpers.
+merkle::Hash referenceRoot(const std::vector<merkle::Hash> &leaves, size_t begin, size_t end)
+{
+    if (end - begin == 1)
+        return leaves[begin];
+    size_t k = 1;
+    while (k * 2 < end - begin)
+        k *= 2;
+    return merkle::nodeHash(referenceRoot(leaves, begin, begin + k),
+                            referenceRoot(leaves, begin + k, end));
+}
+} // namespace
+
+TEST(MerkleTreeTest, EmptyLeafMatchesKnownDigest)
+{
+    // SHA-256 of the single leaf-prefix byte 0x00.
+    const merkle::Hash leaf = merkle::leafHash(nullptr, 0);
+    const merkle::Hash expected = {0x6e, 0x34, 0x0b, 0x9c, 0xff, 0xb3, 0x7a, 0x98,
+                                   0x9c, 0xa5, 0x44, 0xe6, 0xbb, 0x78, 0x0a, 0x2c,
+                                   0x78, 0x90, 0x1d, 0x3f, 0xb3, 0x37, 0x38, 0x76,
+                                   0x85, 0x11, 0xa3, 0x06, 0x17, 0xaf, 0xa0, 0x1d};
+    EXPECT_EQ(leaf, expected);
+}
+
+TEST(MerkleTreeTest, FrontierRootMatchesReference)
+{
+    const auto leaves = makeLeaves(70);
+    merkle::Frontier frontier;
+    for (size_t n = 1; n <= leaves.size(); ++n)
+    {
+        frontier.append(leaves[n - 1]);
+        ASSERT_EQ(frontier.size(), n);
+        const merkle::Hash expected = referenceRoot(leaves, 0, n);
+        EXPECT_EQ(frontier.root(), expected) << "size " << n;
+        EXPECT_EQ(merkle::rootOf(leaves, n), expected) << "size " << n;
+    }
+}
+
+TEST(MerkleTreeTest, InclusionProofsVerify)
+{
+    const auto leaves = makeLeaves(33);
+    for (size_t size = 1; size <= leaves.size(); ++size)
+    {
+        const merkle::Hash root = merkle::rootOf(leaves, size);
+        for (size_t index = 0; index < size; ++index)
+        {
+            auto proof = merkle::inclusionProof(leaves, size, index);
+            EXPECT_LE(proof.size(), 6u);
+            EXPECT_TRUE(merkle::verifyInclusion(leaves[index], index, size, proof, root))
+                << "size " << size << ", index " << index;
+
+            // Wrong leaf, wrong position, or a corrupted path must not verify.
+            EXPECT_FALSE(merkle::verifyInclusion(leaves[(index + 1) % leaves.size()], index, size, proof, root));
+            if (size > 1)
+            {
+                EXPECT_FALSE(merkle::verifyInclusion(leaves[index], (index + 1) % size, size, proof, root));
+                proof.back()[0] ^= 0x01;
+                EXPECT_FALSE(merkle::verifyInclusion(leaves[index], index, size, proof, root));
+            }
+        }
+    }
+}
+
+TEST(MerkleTreeTest, CheckpointEncodingRoundTrip)
+{
+    const merkle::Hash root = makeLeaves(1).front();
+    const auto encoded = merkle::encodeCheckpoint(1234, root);
+    ASSERT_EQ(encoded.size(), merkle::CHECKPOINT_SIZE);
+
+    uint64_t leafCount = 0;
+    merkle::Hash decoded{};
+    ASSERT_TRUE(merkle::decodeCheckpoint(encoded.data(), encoded.size(), leafCount, decoded));
+    EXPECT_EQ(leafCount, 1234u);
+    EXPECT_EQ(decoded, root);
+
+    EXPECT_FALSE(merkle::decodeCheckpoint(encoded.data(), encoded.size() - 1, leafCount, decoded));
+    auto corrupted = encoded;
+    corrupted[0] ^= 0xFF;
+    EXPECT_FALSE(merkle::decodeCheckpoint(corrupted.data(), corrupted.size(), leafCount, decoded));
+}
+
+TEST(MerkleTreeTest, AccumulatorHandlesOutOfOrderLeaves)
+{
+    const size_t interval = 4;
+    const size_t dataBlobs = 37;
+    merkle::MerkleAccumulator accumulator(interval);
+    SeqnumAllocator seqnums;
+
+    // Writers allocate seqnums up front but finish their blobs in any order.
+    std::vector<uint64_t> order;
+    for (size_t i = 0; i < dataBlobs; ++i)
+        order.push_back(seqnums.next("t"));
+    std::shuffle(order.begin(), order.end(), std::mt19937(42));
+
+    std::map<uint64_t, merkle::Hash> bySeqnum;
+    std::vector<merkle::Checkpoint> checkpoints;
+    for (uint64_t seqnum : order)
+    {
+        const std::string blob = "data_" + std::to_string(seqnum);
+        const merkle::Hash leaf = merkle::leafHash(reinterpret_cast<const uint8_t *>(blob.data()), blob.size());
+        bySeqnum[seqnum] = leaf;
+        if (auto checkpoint = accumulator.add("t", seqnum, leaf, seqnums))
+        {
+            const auto encoded = merkle::encodeCheckpoint(checkpoint->leafCount, checkpoint->root);
+            const merkle::Hash cpLeaf = merkle::leafHash(encoded.data(), encoded.size());
+            bySeqnum[checkpoint->seqnum] = cpLeaf;
+            accumulator.addCheckpoint("t", checkpoint->seqnum, cpLeaf);
+            checkpoints.push_back(*checkpoint);
+        }
+    }
+    // None is due while the prefix is still empty, so shuffling can merge some.
+    EXPECT_GE(checkpoints.size(), 1u);
+    EXPECT_LE(checkpoints.size(), dataBlobs / interval);
+
+    auto final = accumulator.finalCheckpoint("t", seqnums);
+    ASSERT_TRUE(final.has_value());
+    checkpoints.push_back(*final);
+    EXPECT_FALSE(accumulator.finalCheckpoint("other", seqnums).has_value());
+
+    std::vector<merkle::Hash> leaves;
+    for (const auto &[seqnum, leaf] : bySeqnum)
+    {
+        ASSERT_EQ(seqnum, leaves.size());
+        leaves.push_back(leaf);
+    }
+    EXPECT_EQ(final->leafCount, leaves.size());
+
+    uint64_t previousCount = 0;
+    for (const auto &checkpoint : checkpoints)
+    {
+        EXPECT_GE(checkpoint.leafCount, previousCount);
+        EXPECT_LE(checkpoint.leafCount, checkpoint.seqnum);
+        EXPECT_EQ(checkpoint.root, merkle::rootOf(leaves, checkpoint.leafCount));
+        previousCount = checkpoint.leafCount;
+    }
+}
+
+TEST(MerkleTreeTest, AbandonedSeqnumStopsCheckpoints)
+{
+    const size_t interval = 2;
+    merkle::MerkleAccumulator accumulator(interval);
+    SeqnumAllocator seqnums;
+    auto leafOf = [](uint64_t seqnum)
+    {
+        const std::string blob = "data_" + std::to_string(seqnum);
+        return merkle::leafHash(reinterpret_cast<const uint8_t *>(blob.data()), blob.size());
+    };
+
+    // Seqnum 0 is allocated but never written, so every later leaf waits.
+    const uint64_t lost = seqnums.next("t");
+    for (int i = 0; i < 10; ++i)
+    {
+        const uint64_t seqnum = seqnums.next("t");
+        EXPECT_FALSE(accumulator.add("t", seqnum, leafOf(seqnum), seqnums).has_value());
+    }
+    EXPECT_EQ(accumulator.waitingLeaves("t"), 10u);
+
+    accumulator.abandon("t", lost);
+    EXPECT_EQ(accumulator.waitingLeaves("t"), 0u);
+    for (int i = 0; i < 10; ++i)
+    {
+        const uint64_t seqnum = seqnums.next("t");
+        EXPECT_FALSE(accumulator.add("t", seqnum, leafOf(seqnum), seqnums).has_value());
+    }
+    EXPECT_EQ(accumulator.waitingLeaves("t"), 0u);
+    EXPECT_FALSE(accumulator.finalCheckpoint("t", seqnums).has_value());
+
+    // Other targets are unaffected.
+    const uint64_t seqnum = seqnums.next("u");
+    accumulator.add("u", seqnum, leafOf(seqnum), seqnums);
+    EXPECT_TRUE(accumulator.finalCheckpoint("u", seqnums).has_value());
+}
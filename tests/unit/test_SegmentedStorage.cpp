@@ -729,6 +729,313 @@ TEST_F(SegmentedStorageTest, RotationOpenFailureRecovers)
     EXPECT_NO_THROW(storage.write(std::vector<uint8_t>(80, 'C')));
 }
 
+// Group commit: every write is synced before it returns, and concurrent writers
+// share sync rounds instead of paying one each.
+TEST_F(SegmentedStorageTest, GroupCommitSharesSyncRounds)
+{
+    DurabilityPolicy durability;
+    durability.mode = DurabilityMode::GroupCommit;
+    SegmentedStorage storage(testPath, baseFilename, 100 * 1024 * 1024, 5,
+                             std::chrono::milliseconds(1), 512, durability);
+
+    const size_t numThreads = 8;
+    const size_t writesPerThread = 50;
+    const size_t dataSize = 256;
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < numThreads; ++t)
+    {
+        threads.emplace_back([&]()
+                             {
+            for (size_t i = 0; i < writesPerThread; ++i)
+                storage.write(std::vector<uint8_t>(dataSize, 'G')); });
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+
+    const size_t totalWrites = numThreads * writesPerThread;
+    EXPECT_GT(storage.syncRounds(), 0u);
+    EXPECT_LE(storage.syncRounds(), totalWrites);
+
+    auto files = getSegmentFiles(testPath, baseFilename);
+    ASSERT_EQ(files.size(), 1);
+    EXPECT_EQ(getFileSize(files[0]), totalWrites * dataSize);
+}
+
+TEST_F(SegmentedStorageTest, GroupCommitAcrossRotation)
+{
+    DurabilityPolicy durability;
+    durability.mode = DurabilityMode::GroupCommit;
+    SegmentedStorage storage(testPath, baseFilename, 1000, 5,
+                             std::chrono::milliseconds(1), 512, durability);
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&]()
+                             {
+            for (size_t i = 0; i < 25; ++i)
+                storage.write(std::vector<uint8_t>(100, 'R')); });
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+
+    size_t total = 0;
+    for (const auto &file : getSegmentFiles(testPath, baseFilename))
+    {
+        total += getFileSize(file);
+    }
+    EXPECT_EQ(total, 4u * 25u * 100u);
+}
+
+// Periodic: dirty files are synced in the background, idle files are left alone.
+TEST_F(SegmentedStorageTest, PeriodicSyncOnlyWhenDirty)
+{
+    DurabilityPolicy durability;
+    durability.mode = DurabilityMode::Periodic;
+    durability.syncInterval = std::chrono::milliseconds(10);
+    SegmentedStorage storage(testPath, baseFilename, 100 * 1024 * 1024, 5,
+                             std::chrono::milliseconds(1), 512, durability);
+
+    storage.write(std::vector<uint8_t>(128, 'P'));
+    for (int i = 0; i < 100 && storage.syncRounds() == 0; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_EQ(storage.syncRounds(), 1u);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(storage.syncRounds(), 1u) << "clean files should not be re-synced";
+}
+
+TEST_F(SegmentedStorageTest, PeriodicSyncRejectsZeroInterval)
+{
+    DurabilityPolicy durability;
+    durability.mode = DurabilityMode::Periodic;
+    durability.syncInterval = std::chrono::milliseconds(0);
+    EXPECT_THROW(SegmentedStorage(testPath, baseFilename, 100 * 1024 * 1024, 5,
+                                  std::chrono::milliseconds(1), 512, durability),
+                 std::invalid_argument);
+}
+
+// Gather writes land back to back in one segment.
+TEST_F(SegmentedStorageTest, GatherWriteIsContiguous)
+{
+    SegmentedStorage storage(testPath, baseFilename);
+
+    auto a = generateRandomData(100);
+    auto b = generateRandomData(2000);
+    auto c = generateRandomData(7);
+    std::vector<struct iovec> iov = {{a.data(), a.size()}, {b.data(), b.size()}, {c.data(), c.size()}};
+    EXPECT_EQ(storage.writevToFile("gather", iov.data(), iov.size()), a.size() + b.size() + c.size());
+    storage.flush();
+
+    auto files = getSegmentFiles(testPath, "gather");
+    ASSERT_EQ(files.size(), 1);
+    std::vector<uint8_t> expected = a;
+    expected.insert(expected.end(), b.begin(), b.end());
+    expected.insert(expected.end(), c.begin(), c.end());
+    EXPECT_EQ(readFile(files[0]), expected);
+}
+
+// Concurrent gathers under rotation: each gather must stay within one segment, so
+// every segment is a whole number of (equal-sized) gathers.
+TEST_F(SegmentedStorageTest, GatherWriteNeverStraddlesSegments)
+{
+    const size_t blobSize = 100;
+    const size_t blobsPerGather = 3;
+    SegmentedStorage storage(testPath, baseFilename, /*maxSegmentSize*/ 1000);
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 6; ++t)
+    {
+        threads.emplace_back([&, t]()
+                             {
+            std::vector<std::vector<uint8_t>> blobs(blobsPerGather, std::vector<uint8_t>(blobSize, static_cast<uint8_t>(t)));
+            std::vector<struct iovec> iov;
+            for (auto &blob : blobs)
+                iov.push_back({blob.data(), blob.size()});
+            for (size_t i = 0; i < 20; ++i)
+                storage.writev(iov.data(), iov.size()); });
+    }
+    for (auto &t : threads)
+        t.join();
+    storage.flush();
+
+    size_t total = 0;
+    for (const auto &file : getSegmentFiles(testPath, baseFilename))
+    {
+        auto contents = readFile(file);
+        EXPECT_EQ(contents.size() % (blobSize * blobsPerGather), 0u) << file;
+        for (size_t off = 0; off < contents.size(); off += blobSize * blobsPerGather)
+        {
+            EXPECT_TRUE(std::all_of(contents.begin() + off, contents.begin() + off + blobSize * blobsPerGather,
+                                    [&](uint8_t byte)
+                                    { return byte == contents[off]; }))
+                << "interleaved gather in " << file;
+        }
+        total += contents.size();
+    }
+    EXPECT_EQ(total, 6u * 20u * blobSize * blobsPerGather);
+}
+
+// A gather bigger than a segment is split per buffer rather than spinning on rotation.
+TEST_F(SegmentedStorageTest, OversizedGatherFallsBackToPerBlobWrites)
+{
+    SegmentedStorage storage(testPath, baseFilename, /*maxSegmentSize*/ 1000);
+
+    std::vector<std::vector<uint8_t>> blobs(4, std::vector<uint8_t>(400, 'O'));
+    std::vector<struct iovec> iov;
+    for (auto &blob : blobs)
+        iov.push_back({blob.data(), blob.size()});
+    size_t blobsWritten = 0;
+    EXPECT_EQ(storage.writev(iov.data(), iov.size(), &blobsWritten), 1600u);
+    EXPECT_EQ(blobsWritten, blobs.size());
+    storage.flush();
+
+    size_t total = 0;
+    for (const auto &file : getSegmentFiles(testPath, baseFilename))
+    {
+        EXPECT_LE(getFileSize(file), 1000u);
+        total += getFileSize(file);
+    }
+    EXPECT_EQ(total, 1600u);
+}
+
+// io_uring backend: same contracts as pwrite. Skipped where the backend isn't
+// compiled in or the kernel refuses io_uring_setup (storage falls back to pwrite).
+class SegmentedStorageIoUringTest : public SegmentedStorageTest
+{
+protected:
+    std::unique_ptr<SegmentedStorage> makeStorage(size_t maxSegmentSize, size_t maxOpenFiles = 512,
+                                                  DurabilityPolicy durability = {})
+    {
+        return std::make_unique<SegmentedStorage>(testPath, baseFilename, maxSegmentSize, 5,
+                                                  std::chrono::milliseconds(1), maxOpenFiles,
+                                                  durability, StorageBackend::IoUring, 64);
+    }
+};
+
+#define SKIP_WITHOUT_IO_URING(storage)                                  \
+    if ((storage).backend() != StorageBackend::IoUring)                 \
+    {                                                                   \
+        GTEST_SKIP() << "io_uring backend unavailable in this build/kernel"; \
+    }
+
+TEST_F(SegmentedStorageIoUringTest, WriteAndReadBack)
+{
+    auto storage = makeStorage(100 * 1024 * 1024);
+    SKIP_WITHOUT_IO_URING(*storage);
+
+    auto data = generateRandomData(4096);
+    auto copy = data;
+    ASSERT_EQ(storage->write(std::move(data)), copy.size());
+    storage->flush();
+
+    auto files = getSegmentFiles(testPath, baseFilename);
+    ASSERT_EQ(files.size(), 1);
+    EXPECT_EQ(readFile(files[0]), copy);
+}
+
+TEST_F(SegmentedStorageIoUringTest, ConcurrentWritesWithRotation)
+{
+    auto storage = makeStorage(5000);
+    SKIP_WITHOUT_IO_URING(*storage);
+
+    const size_t numThreads = 8;
+    const size_t writesPerThread = 50;
+    const size_t dataSize = 700;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < numThreads; ++t)
+    {
+        threads.emplace_back([&]()
+                             {
+            for (size_t i = 0; i < writesPerThread; ++i)
+                storage->write(std::vector<uint8_t>(dataSize, 'U')); });
+    }
+    for (auto &t : threads)
+        t.join();
+    storage->flush();
+
+    auto files = getSegmentFiles(testPath, baseFilename);
+    EXPECT_GT(files.size(), 1u);
+    size_t total = 0;
+    for (const auto &file : files)
+        total += getFileSize(file);
+    EXPECT_EQ(total, numThreads * writesPerThread * dataSize);
+}
+
+// Eviction closes files in the background; flush() must wait for those fsyncs and
+// the registered-file slots must be recycled.
+TEST_F(SegmentedStorageIoUringTest, EvictionRecyclesFileSlots)
+{
+    auto storage = makeStorage(1024 * 1024, 2);
+    SKIP_WITHOUT_IO_URING(*storage);
+
+    const size_t numFilenames = 8; // < 10 so no name is a prefix of another
+    for (size_t round = 0; round < 3; ++round)
+    {
+        for (size_t i = 0; i < numFilenames; ++i)
+            storage->writeToFile("uring_file_" + std::to_string(i), std::vector<uint8_t>(64, 'E'));
+    }
+    storage->flush();
+
+    for (size_t i = 0; i < numFilenames; ++i)
+    {
+        size_t total = 0;
+        for (const auto &f : getSegmentFiles(testPath, "uring_file_" + std::to_string(i)))
+            total += getFileSize(f);
+        EXPECT_EQ(total, 3u * 64u) << "uring_file_" << i;
+    }
+}
+
+TEST_F(SegmentedStorageIoUringTest, GatherWrite)
+{
+    auto storage = makeStorage(100 * 1024 * 1024);
+    SKIP_WITHOUT_IO_URING(*storage);
+
+    auto a = generateRandomData(333);
+    auto b = generateRandomData(4444);
+    std::vector<struct iovec> iov = {{a.data(), a.size()}, {b.data(), b.size()}};
+    storage->writev(iov.data(), iov.size());
+    storage->flush();
+
+    auto files = getSegmentFiles(testPath, baseFilename);
+    ASSERT_EQ(files.size(), 1);
+    std::vector<uint8_t> expected = a;
+    expected.insert(expected.end(), b.begin(), b.end());
+    EXPECT_EQ(readFile(files[0]), expected);
+}
+
+TEST_F(SegmentedStorageIoUringTest, GroupCommitThroughRing)
+{
+    DurabilityPolicy durability;
+    durability.mode = DurabilityMode::GroupCommit;
+    auto storage = makeStorage(2000, 512, durability);
+    SKIP_WITHOUT_IO_URING(*storage);
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&]()
+                             {
+            for (size_t i = 0; i < 40; ++i)
+                storage->write(std::vector<uint8_t>(100, 'D')); });
+    }
+    for (auto &t : threads)
+        t.join();
+
+    EXPECT_GT(storage->syncRounds(), 0u);
+    size_t total = 0;
+    for (const auto &file : getSegmentFiles(testPath, baseFilename))
+        total += getFileSize(file);
+    EXPECT_EQ(total, 4u * 40u * 100u);
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include "WorkerPool.hpp"
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST(WorkerPoolTest, RunsEveryIndexOnce)
+{
+    WorkerPool pool(3);
+    std::vector<std::atomic<int>> hits(1000);
+    pool.parallelFor(hits.size(), [&](size_t i)
+                     { hits[i].fetch_add(1); });
+    for (const auto &hit : hits)
+        EXPECT_EQ(hit.load(), 1);
+}
+
+TEST(WorkerPoolTest, ZeroThreadsRunsOnCaller)
+{
+    WorkerPool pool(0);
+    const auto caller = std::this_thread::get_id();
+    size_t calls = 0;
+    pool.parallelFor(5, [&](size_t)
+                     {
+        EXPECT_EQ(std::this_thread::get_id(), caller);
+        ++calls; });
+    EXPECT_EQ(calls, 5u);
+}
+
+TEST(WorkerPoolTest, FirstExceptionRethrown)
+{
+    WorkerPool pool(2);
+    EXPECT_THROW(pool.parallelFor(64, [](size_t i)
+                                  { if (i == 17) throw std::runtime_error("boom"); }),
+                 std::runtime_error);
+
+    // The pool stays usable afterwards.
+    std::atomic<size_t> sum{0};
+    pool.parallelFor(10, [&](size_t i)
+                     { sum += i; });
+    EXPECT_EQ(sum.load(), 45u);
+}
+
+TEST(WorkerPoolTest, ConcurrentCallersShareThePool)
+{
+    WorkerPool pool(2);
+    std::atomic<size_t> total{0};
+    std::vector<std::thread> callers;
+    for (int t = 0; t < 4; ++t)
+    {
+        callers.emplace_back([&]()
+                             {
+            for (int round = 0; round < 50; ++round)
+                pool.parallelFor(16, [&](size_t) { total.fetch_add(1); }); });
+    }
+    for (auto &caller : callers)
+        caller.join();
+    EXPECT_EQ(total.load(), 4u * 50u * 16u);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
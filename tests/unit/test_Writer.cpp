@@ -80,7 +80,9 @@ TEST_F(WriterTest, ProcessBatchEntries)
     queue->enqueueBatchBlocking(testItems, producerToken, std::chrono::milliseconds(100));
 
     // Instantiate writer with a batch size equal to number of test items
-    writer = std::make_unique<Writer>(*queue, storage, testItems.size());
+    WriterOptions options;
+    options.batchSize = testItems.size();
+    writer = std::make_unique<Writer>(*queue, storage, options);
     writer->start();
 
     // Give some time for the writer thread to process the entries.
@@ -111,7 +113,11 @@ TEST_F(WriterTest, EmptyQueue)
 // get written, and the dropped entries are counted.
 TEST_F(WriterTest, WriterSurvivesBatchFailure)
 {
-    writer = std::make_unique<Writer>(*queue, storage, /*batchSize*/ 10, /*useEncryption*/ false, /*compressionLevel*/ 0);
+    WriterOptions options;
+    options.batchSize = 10;
+    options.useEncryption = false;
+    options.compressionLevel = 0;
+    writer = std::make_unique<Writer>(*queue, storage, options);
     writer->start();
 
     BufferQueue::ProducerToken token = queue->createProducerToken();
@@ -152,4 +158,139 @@ TEST_F(WriterTest, WriterSurvivesBatchFailure)
     EXPECT_EQ(writer->droppedEntries(), badCount);
 
     writer->stop();
-}
\ No newline at end of file
+}
+
+// Every idle strategy must pick up entries that arrive after the writer went idle.
+class WriterIdleStrategyTest : public WriterTest,
+                               public ::testing::WithParamInterface<WriterIdleStrategy>
+{
+};
+
+TEST_P(WriterIdleStrategyTest, ProcessesEntriesEnqueuedWhileIdle)
+{
+    WriterOptions options;
+    options.batchSize = 10;
+    options.useEncryption = false;
+    options.compressionLevel = 0;
+    options.idleStrategy = GetParam();
+    writer = std::make_unique<Writer>(*queue, storage, options);
+    writer->start();
+
+    // Let the writer go idle first.
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    BufferQueue::ProducerToken token = queue->createProducerToken();
+    queue->enqueueBlocking(QueueItem{LogEntry{LogEntry::ActionType::READ, "loc", "ctrl", "proc", "subj"}},
+                           token, std::chrono::milliseconds(100));
+
+    for (int i = 0; i < 100 && queue->size() > 0; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(queue->size(), 0);
+
+    writer->stop();
+    EXPECT_FALSE(writer->isRunning());
+}
+
+INSTANTIATE_TEST_SUITE_P(AllStrategies, WriterIdleStrategyTest,
+                         ::testing::Values(WriterIdleStrategy::BusySpin,
+                                           WriterIdleStrategy::SpinYield,
+                                           WriterIdleStrategy::Park));
+
+// Linger accumulation: with encryption on, each flushed blob consumes one seqnum,
+// so the shared allocator's count is the number of blobs written for a target.
+class WriterLingerTest : public WriterTest
+{
+protected:
+    std::unique_ptr<Writer> makeWriter(size_t batchSize, size_t maxBatchBytes,
+                                       std::chrono::milliseconds linger)
+    {
+        WriterOptions options;
+        options.batchSize = batchSize;
+        options.maxBatchBytes = maxBatchBytes;
+        options.maxBatchLinger = linger;
+        options.compressionLevel = 0;
+        options.seqnumAllocator = allocator;
+        options.baseFilename = "test_logsegment";
+        return std::make_unique<Writer>(*queue, storage, options);
+    }
+
+    void enqueueOne(BufferQueue::ProducerToken &token)
+    {
+        queue->enqueueBlocking(QueueItem(LogEntry{LogEntry::ActionType::READ, "loc", "ctrl", "proc", "subj"},
+                                         std::optional<std::string>(TARGET)),
+                               token, std::chrono::milliseconds(100));
+    }
+
+    uint64_t blobsWritten() { return allocator->peek(TARGET); }
+
+    const std::string TARGET = "linger_target";
+    std::shared_ptr<SeqnumAllocator> allocator = std::make_shared<SeqnumAllocator>();
+};
+
+TEST_F(WriterLingerTest, TrickleIsCoalescedIntoOneBlob)
+{
+    writer = makeWriter(1000, 0, std::chrono::milliseconds(300));
+    writer->start();
+
+    auto token = queue->createProducerToken();
+    for (int i = 0; i < 10; ++i)
+    {
+        enqueueOne(token);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    for (int i = 0; i < 100 && blobsWritten() == 0; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(blobsWritten(), 1u);
+    writer->stop();
+}
+
+TEST_F(WriterLingerTest, EntryCountBoundFlushesBeforeLinger)
+{
+    writer = makeWriter(4, 0, std::chrono::seconds(30));
+    writer->start();
+
+    auto token = queue->createProducerToken();
+    for (int i = 0; i < 8; ++i)
+        enqueueOne(token);
+
+    for (int i = 0; i < 100 && blobsWritten() < 2; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(blobsWritten(), 2u);
+    writer->stop();
+}
+
+TEST_F(WriterLingerTest, ByteBoundFlushesBeforeLinger)
+{
+    const size_t entryBytes = LogEntry{LogEntry::ActionType::READ, "loc", "ctrl", "proc", "subj"}.serializedSize();
+    writer = makeWriter(1000, 3 * entryBytes, std::chrono::seconds(30));
+    writer->start();
+
+    auto token = queue->createProducerToken();
+    for (int i = 0; i < 9; ++i)
+        enqueueOne(token);
+
+    for (int i = 0; i < 100 && blobsWritten() < 3; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(blobsWritten(), 3u);
+    writer->stop();
+}
+
+TEST_F(WriterLingerTest, StopFlushesLingeringEntries)
+{
+    writer = makeWriter(1000, 0, std::chrono::seconds(30));
+    writer->start();
+
+    auto token = queue->createProducerToken();
+    for (int i = 0; i < 3; ++i)
+        enqueueOne(token);
+    for (int i = 0; i < 50 && queue->size() > 0; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(blobsWritten(), 0u) << "entries should still be lingering";
+
+    writer->stop();
+    EXPECT_EQ(blobsWritten(), 1u);
+    EXPECT_EQ(writer->droppedEntries(), 0u);
+}